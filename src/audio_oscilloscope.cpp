@@ -0,0 +1,124 @@
+#include "audio_oscilloscope.hpp"
+
+#include <QPainter>
+#include <QVBoxLayout>
+#include <QFontDatabase>
+
+#include "game_window.hpp"
+
+static const char *TRACE_NAMES[GameInstance::OSCILLOSCOPE_TRACE_COUNT] = { "Pulse 1", "Pulse 2", "Wave", "Noise", "Mix" };
+
+class AudioOscilloscope::OscilloscopeView : public QWidget {
+public:
+    OscilloscopeView(AudioOscilloscope *parent) : QWidget(parent), oscilloscope(parent) {
+        this->setMinimumSize(AudioOscilloscope::HISTORY_LENGTH, 80 * GameInstance::OSCILLOSCOPE_TRACE_COUNT);
+        this->setAttribute(Qt::WA_OpaquePaintEvent);
+    }
+
+private:
+    AudioOscilloscope *oscilloscope;
+
+    void paintEvent(QPaintEvent *) override {
+        QPainter painter(this);
+        painter.fillRect(this->rect(), Qt::black);
+
+        auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+        font.setPixelSize(11);
+        painter.setFont(font);
+
+        int width = this->width();
+        int lane_height = this->height() / static_cast<int>(GameInstance::OSCILLOSCOPE_TRACE_COUNT);
+        if(width <= 0 || lane_height <= 0) {
+            return;
+        }
+
+        for(std::size_t t = 0; t < GameInstance::OSCILLOSCOPE_TRACE_COUNT; t++) {
+            int lane_top = lane_height * static_cast<int>(t);
+            int lane_center = lane_top + lane_height / 2;
+
+            // Center line and label
+            painter.setPen(QColor::fromRgb(48, 48, 48));
+            painter.drawLine(0, lane_center, width, lane_center);
+            painter.setPen(QColor::fromRgb(128, 128, 128));
+            painter.drawText(4, lane_top + 12, TRACE_NAMES[t]);
+
+            // Draw one vertical line per column covering the min/max of every record that lands in it
+            painter.setPen(t + 1 == GameInstance::OSCILLOSCOPE_TRACE_COUNT ? QColor::fromRgb(255, 255, 0) : QColor::fromRgb(0, 255, 128));
+            auto to_y = [&lane_center, &lane_height](int sample) {
+                return lane_center - sample * (lane_height / 2 - 1) / 32768;
+            };
+
+            for(int x = 0; x < width; x++) {
+                std::size_t first = static_cast<std::size_t>(x) * AudioOscilloscope::HISTORY_LENGTH / width;
+                std::size_t last = std::max(first + 1, static_cast<std::size_t>(x + 1) * AudioOscilloscope::HISTORY_LENGTH / width);
+
+                int low = INT16_MAX, high = INT16_MIN;
+                for(std::size_t r = first; r < last; r++) {
+                    auto &record = this->oscilloscope->get_record(r);
+                    low = std::min(low, static_cast<int>(record.min[t]));
+                    high = std::max(high, static_cast<int>(record.max[t]));
+                }
+
+                painter.drawLine(x, to_y(high), x, to_y(low));
+            }
+        }
+    }
+};
+
+AudioOscilloscope::AudioOscilloscope(GameWindow *window) : QMainWindow(window), window(window) {
+    this->setWindowTitle("Audio Oscilloscope");
+
+    auto *central_w = new QWidget(this);
+    this->setCentralWidget(central_w);
+    auto *layout = new QVBoxLayout(central_w);
+    layout->setContentsMargins(0,0,0,0);
+    central_w->setLayout(layout);
+
+    this->view = new OscilloscopeView(this);
+    layout->addWidget(this->view);
+
+    this->read_buffer.resize(4096);
+    this->clear_history();
+}
+
+AudioOscilloscope::~AudioOscilloscope() {}
+
+void AudioOscilloscope::clear_history() noexcept {
+    this->history = std::vector<GameInstance::OscilloscopeRecord>(HISTORY_LENGTH, GameInstance::OscilloscopeRecord {});
+    this->history_position = 0;
+}
+
+void AudioOscilloscope::refresh_view() {
+    auto &instance = this->window->get_instance();
+
+    // Don't make the emulation thread do any work if nobody is looking
+    if(this->isHidden()) {
+        if(instance.is_oscilloscope_enabled()) {
+            instance.set_oscilloscope_enabled(false);
+        }
+        return;
+    }
+
+    // If we just opened, throw away anything stale
+    if(!instance.is_oscilloscope_enabled()) {
+        while(instance.read_oscilloscope(this->read_buffer.data(), this->read_buffer.size()) > 0) {}
+        this->clear_history();
+        instance.set_oscilloscope_enabled(true);
+    }
+
+    // Take everything that's there, even if we aren't going to repaint yet, so the ring buffer doesn't fill up
+    std::size_t count;
+    while((count = instance.read_oscilloscope(this->read_buffer.data(), this->read_buffer.size())) > 0) {
+        for(std::size_t i = 0; i < count; i++) {
+            this->history[this->history_position] = this->read_buffer[i];
+            this->history_position = (this->history_position + 1) % HISTORY_LENGTH;
+        }
+    }
+
+    // Repaint at roughly display rate
+    auto now = clock::now();
+    if(now >= this->next_repaint) {
+        this->next_repaint = now + std::chrono::microseconds(16667);
+        this->view->update();
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef AUDIO_OSCILLOSCOPE_HPP
+#define AUDIO_OSCILLOSCOPE_HPP
+
+#include <QMainWindow>
+#include <vector>
+#include <chrono>
+
+class GameWindow;
+
+#include "game_instance.hpp"
+
+class AudioOscilloscope : public QMainWindow {
+public:
+    AudioOscilloscope(GameWindow *window);
+    ~AudioOscilloscope() override;
+
+    void refresh_view();
+
+    /** Number of records shown at once (about 128 ms of audio) */
+    static constexpr const std::size_t HISTORY_LENGTH = 512;
+
+    /**
+     * Get the record at the given index, where 0 is the oldest shown
+     *
+     * @param index index of the record
+     * @return      record
+     */
+    const GameInstance::OscilloscopeRecord &get_record(std::size_t index) const noexcept {
+        return this->history[(this->history_position + index) % HISTORY_LENGTH];
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    class OscilloscopeView;
+    OscilloscopeView *view;
+    GameWindow *window;
+
+    std::vector<GameInstance::OscilloscopeRecord> history;
+    std::size_t history_position = 0;
+    std::vector<GameInstance::OscilloscopeRecord> read_buffer;
+    clock::time_point next_repaint;
+
+    void clear_history() noexcept;
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include "audio_recorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Enough for a couple seconds at typical sample rates
+static constexpr const std::size_t RING_CAPACITY = 1 << 17;
+
+// Maximum frames written per fwrite() call
+static constexpr const std::size_t WRITE_CHUNK = 4096;
+
+static constexpr const std::size_t WAV_HEADER_SIZE = 44;
+
+static const char *STEM_NAMES[AudioRecorder::STEM_COUNT] = { "pulse1", "pulse2", "wave", "noise" };
+
+static void write_le32(std::uint8_t *to, std::uint32_t value) {
+    to[0] = value & 0xFF;
+    to[1] = (value >> 8) & 0xFF;
+    to[2] = (value >> 16) & 0xFF;
+    to[3] = (value >> 24) & 0xFF;
+}
+
+static void write_le16(std::uint8_t *to, std::uint16_t value) {
+    to[0] = value & 0xFF;
+    to[1] = (value >> 8) & 0xFF;
+}
+
+// Write a WAV header; the sizes are filled in once we know how much data there is
+static bool write_wav_header(std::FILE *file, std::uint32_t sample_rate, std::uint16_t channels, std::uint32_t data_size) {
+    std::uint8_t header[WAV_HEADER_SIZE];
+    std::uint16_t block_align = channels * sizeof(std::int16_t);
+
+    std::memcpy(header + 0, "RIFF", 4);
+    write_le32(header + 4, data_size + WAV_HEADER_SIZE - 8);
+    std::memcpy(header + 8, "WAVE", 4);
+    std::memcpy(header + 12, "fmt ", 4);
+    write_le32(header + 16, 16);
+    write_le16(header + 20, 1); // PCM
+    write_le16(header + 22, channels);
+    write_le32(header + 24, sample_rate);
+    write_le32(header + 28, sample_rate * block_align);
+    write_le16(header + 32, block_align);
+    write_le16(header + 34, 16);
+    std::memcpy(header + 36, "data", 4);
+    write_le32(header + 40, data_size);
+
+    return std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(header, sizeof(header), 1, file) == 1;
+}
+
+// WAV data is little endian
+static bool write_samples(std::FILE *file, std::int16_t *samples, std::size_t count) {
+    std::uint8_t *bytes = reinterpret_cast<std::uint8_t *>(samples);
+    for(std::size_t i = 0; i < count; i++) {
+        write_le16(bytes + i * 2, static_cast<std::uint16_t>(samples[i]));
+    }
+    return std::fwrite(samples, sizeof(*samples), count, file) == count;
+}
+
+AudioRecorder::AudioRecorder(const std::filesystem::path &path, std::uint32_t sample_rate, bool stems, bool block_when_full) :
+    ring(RING_CAPACITY), sample_rate(sample_rate), stems_enabled(stems), block_when_full(block_when_full) {
+
+    this->mix_file = std::fopen(path.string().c_str(), "wb");
+    if(this->mix_file == nullptr) {
+        std::fprintf(stderr, "Failed to open %s for audio recording\n", path.string().c_str());
+        return;
+    }
+    if(!write_wav_header(this->mix_file, sample_rate, 2, 0)) {
+        this->write_failed = true;
+    }
+
+    if(stems) {
+        for(std::size_t c = 0; c < STEM_COUNT; c++) {
+            auto stem_path = path;
+            stem_path.replace_extension(std::string(".") + STEM_NAMES[c] + path.extension().string());
+
+            this->stem_files[c] = std::fopen(stem_path.string().c_str(), "wb");
+            if(this->stem_files[c] == nullptr) {
+                std::fprintf(stderr, "Failed to open %s for audio recording\n", stem_path.string().c_str());
+                this->close_files();
+                return;
+            }
+            if(!write_wav_header(this->stem_files[c], sample_rate, 1, 0)) {
+                this->write_failed = true;
+            }
+        }
+    }
+
+    this->writer = std::thread(&AudioRecorder::writer_loop, this);
+}
+
+AudioRecorder::~AudioRecorder() {
+    this->finish();
+}
+
+void AudioRecorder::finish() noexcept {
+    if(this->writer.joinable()) {
+        this->finishing = true;
+        this->writer.join();
+    }
+    this->close_files();
+}
+
+void AudioRecorder::push(const Frame &frame) noexcept {
+    if(!this->is_open()) {
+        return;
+    }
+
+    while(!this->ring.push(frame)) {
+        if(!this->block_when_full) {
+            this->frames_dropped++;
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void AudioRecorder::writer_loop() noexcept {
+    std::vector<Frame> scratch(WRITE_CHUNK);
+    std::vector<std::int16_t> interleaved(WRITE_CHUNK * 2);
+
+    while(!this->finishing) {
+        if(this->flush_pending(scratch, interleaved) == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    // Get whatever was pushed before we were told to stop
+    while(this->flush_pending(scratch, interleaved) > 0) {}
+}
+
+std::size_t AudioRecorder::flush_pending(std::vector<Frame> &scratch, std::vector<std::int16_t> &interleaved) noexcept {
+    std::size_t total = 0;
+
+    while(true) {
+        auto count = this->ring.pop(scratch.data(), scratch.size());
+        if(count == 0) {
+            break;
+        }
+
+        total += count;
+
+        // Once a write fails, keep draining so the emulation thread doesn't block, but stop writing
+        if(this->write_failed) {
+            continue;
+        }
+
+        for(std::size_t i = 0; i < count; i++) {
+            interleaved[i * 2] = scratch[i].left;
+            interleaved[i * 2 + 1] = scratch[i].right;
+        }
+        bool written = write_samples(this->mix_file, interleaved.data(), count * 2);
+
+        if(this->stems_enabled) {
+            for(std::size_t c = 0; c < STEM_COUNT; c++) {
+                for(std::size_t i = 0; i < count; i++) {
+                    interleaved[i] = scratch[i].stems[c];
+                }
+                written = write_samples(this->stem_files[c], interleaved.data(), count) && written;
+            }
+        }
+
+        if(!written) {
+            std::fprintf(stderr, "Failed to write audio recording\n");
+            this->write_failed = true;
+            continue;
+        }
+
+        this->frames_written += count;
+    }
+
+    return total;
+}
+
+void AudioRecorder::close_files() noexcept {
+    // WAV sizes are 32-bit, so clamp in the unlikely case we recorded more than that
+    std::uint64_t frames = this->frames_written;
+
+    if(this->mix_file != nullptr) {
+        std::uint64_t data_size = frames * 2 * sizeof(std::int16_t);
+        bool closed = write_wav_header(this->mix_file, this->sample_rate, 2, static_cast<std::uint32_t>(std::min<std::uint64_t>(data_size, UINT32_MAX - WAV_HEADER_SIZE)));
+        if(std::fclose(this->mix_file) != 0 || !closed) {
+            this->write_failed = true;
+        }
+        this->mix_file = nullptr;
+    }
+
+    for(auto *&f : this->stem_files) {
+        if(f != nullptr) {
+            std::uint64_t data_size = frames * sizeof(std::int16_t);
+            bool closed = write_wav_header(f, this->sample_rate, 1, static_cast<std::uint32_t>(std::min<std::uint64_t>(data_size, UINT32_MAX - WAV_HEADER_SIZE)));
+            if(std::fclose(f) != 0 || !closed) {
+                this->write_failed = true;
+            }
+            f = nullptr;
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef AUDIO_RECORDER_HPP
+#define AUDIO_RECORDER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "spsc_ring_buffer.hpp"
+
+/**
+ * Writes audio to 16-bit PCM WAV files on a background thread.
+ *
+ * Samples are handed off through a lock-free ring buffer, so pushing never touches the disk. If the writer falls behind,
+ * frames are dropped (and counted) unless the recorder was created with block_when_full, in which case the producer waits.
+ */
+class AudioRecorder {
+public:
+    /** Number of per-channel stems (pulse 1, pulse 2, wave, noise) */
+    static constexpr const std::size_t STEM_COUNT = 4;
+
+    struct Frame {
+        /** Mixed output */
+        std::int16_t left, right;
+
+        /** Per-channel output (before panning and master volume) */
+        std::int16_t stems[STEM_COUNT];
+    };
+
+    /**
+     * Start recording
+     *
+     * @param path            path to the mixed WAV file (stems get written next to it as <name>.<channel>.wav)
+     * @param sample_rate     sample rate in Hz
+     * @param stems           also write per-channel stems
+     * @param block_when_full wait for the writer instead of dropping frames (for capturing faster than real time)
+     */
+    AudioRecorder(const std::filesystem::path &path, std::uint32_t sample_rate, bool stems, bool block_when_full);
+
+    /**
+     * Stop recording, flushing anything still pending
+     */
+    ~AudioRecorder();
+
+    /**
+     * Stop recording now, flushing anything still pending. Nothing else can be pushed afterwards.
+     */
+    void finish() noexcept;
+
+    /**
+     * Get whether or not the output files were opened successfully
+     *
+     * @return files are open
+     */
+    bool is_open() const noexcept { return this->mix_file != nullptr; }
+
+    /**
+     * Get whether or not stems are being recorded
+     *
+     * @return stems are recorded
+     */
+    bool is_recording_stems() const noexcept { return this->stems_enabled; }
+
+    /**
+     * Get the sample rate
+     *
+     * @return sample rate in Hz
+     */
+    std::uint32_t get_sample_rate() const noexcept { return this->sample_rate; }
+
+    /**
+     * Queue a frame to be written. Call this from the emulation thread only.
+     *
+     * @param frame frame to write
+     */
+    void push(const Frame &frame) noexcept;
+
+    /**
+     * Get the number of frames written to disk so far
+     *
+     * @return frames written
+     */
+    std::uint64_t get_frames_written() const noexcept { return this->frames_written; }
+
+    /**
+     * Get the number of frames dropped because the writer could not keep up
+     *
+     * @return frames dropped
+     */
+    std::uint64_t get_frames_dropped() const noexcept { return this->frames_dropped; }
+
+    /**
+     * Get whether or not anything failed to be written. Once this happens, the recording stops being written to.
+     *
+     * @return write failed
+     */
+    bool has_failed() const noexcept { return this->write_failed; }
+
+private:
+    SPSCRingBuffer<Frame> ring;
+    std::uint32_t sample_rate;
+    bool stems_enabled;
+    bool block_when_full;
+
+    std::FILE *mix_file = nullptr;
+    std::FILE *stem_files[STEM_COUNT] = {};
+
+    std::atomic_bool finishing = false;
+    std::atomic<std::uint64_t> frames_written = 0;
+    std::atomic<std::uint64_t> frames_dropped = 0;
+    std::atomic_bool write_failed = false;
+    std::thread writer;
+
+    // Drain the ring buffer until we're told to finish
+    void writer_loop() noexcept;
+
+    // Write whatever is in the ring buffer right now; returns number of frames written
+    std::size_t flush_pending(std::vector<Frame> &scratch, std::vector<std::int16_t> &interleaved) noexcept;
+
+    // Close all files, fixing up the headers
+    void close_files() noexcept;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "background_io.hpp"
+
+BackgroundIO::BackgroundIO() {
+    this->worker = std::thread(&BackgroundIO::worker_loop, this);
+}
+
+BackgroundIO::~BackgroundIO() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->finishing = true;
+    lock.unlock();
+
+    this->task_available.notify_all();
+    this->worker.join();
+}
+
+void BackgroundIO::enqueue(Task task) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->tasks.emplace_back(std::move(task));
+    lock.unlock();
+
+    this->task_available.notify_one();
+}
+
+std::vector<BackgroundIO::Completion> BackgroundIO::pop_completions() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    auto completions = std::move(this->completions);
+    this->completions.clear();
+    return completions;
+}
+
+void BackgroundIO::wait_until_idle() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle.wait(lock, [this]() { return this->tasks.empty() && !this->running_task; });
+}
+
+bool BackgroundIO::is_busy() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return !this->tasks.empty() || this->running_task;
+}
+
+void BackgroundIO::worker_loop() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while(true) {
+        this->task_available.wait(lock, [this]() { return this->finishing || !this->tasks.empty(); });
+
+        // Drain everything before exiting so nothing queued gets lost
+        if(this->tasks.empty()) {
+            break;
+        }
+
+        auto task = std::move(this->tasks.front());
+        this->tasks.pop_front();
+        this->running_task = true;
+
+        // Don't hold the lock while doing the actual work
+        lock.unlock();
+        auto completion = task();
+        lock.lock();
+
+        this->running_task = false;
+        this->completions.emplace_back(std::move(completion));
+
+        if(this->tasks.empty()) {
+            this->idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef BACKGROUND_IO_HPP
+#define BACKGROUND_IO_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+/**
+ * Runs file I/O on a single worker thread so the UI and emulation threads never wait on the disk.
+ *
+ * Tasks run in the order they were queued. Each task returns a message that can be picked up later with pop_completions(), along
+ * with anything that should be done on the caller's thread once the task is finished.
+ */
+class BackgroundIO {
+public:
+    struct Completion {
+        /** Whether or not the task succeeded */
+        bool success;
+
+        /** Message to show the user (empty if nothing should be shown) */
+        std::string message;
+
+        /** Run by whoever picks this up with pop_completions(), for updating state that belongs to that thread (can be empty) */
+        std::function<void()> then;
+    };
+
+    using Task = std::function<Completion()>;
+
+    BackgroundIO();
+
+    /**
+     * Finish all queued tasks and stop the worker
+     */
+    ~BackgroundIO();
+
+    /**
+     * Queue a task
+     *
+     * @param task task to run on the worker thread
+     */
+    void enqueue(Task task);
+
+    /**
+     * Take all completions that have been reported since the last call
+     *
+     * @return completions
+     */
+    std::vector<Completion> pop_completions();
+
+    /**
+     * Block until every queued task has finished
+     */
+    void wait_until_idle();
+
+    /**
+     * Get whether or not there are tasks queued or running
+     *
+     * @return true if busy
+     */
+    bool is_busy();
+
+private:
+    std::mutex mutex;
+    std::condition_variable task_available;
+    std::condition_variable idle;
+    std::deque<Task> tasks;
+    std::vector<Completion> completions;
+    bool running_task = false;
+    bool finishing = false;
+    std::thread worker;
+
+    void worker_loop();
+};
+
+#endif
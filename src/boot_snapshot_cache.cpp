@@ -0,0 +1,118 @@
+#include "boot_snapshot_cache.hpp"
+#include "background_io.hpp"
+#include "file_io.hpp"
+#include "hash.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef SAMEBOY_SOURCE_HASH
+#define SAMEBOY_SOURCE_HASH "unknown"
+#endif
+
+static constexpr const char SNAPSHOT_MAGIC[4] = { 'S', 'D', 'X', 'B' };
+static constexpr const std::uint32_t SNAPSHOT_VERSION = 1;
+
+// Magic, version, core hash, model, boot ROM hash, header hash, skip intro
+static constexpr const std::size_t SNAPSHOT_HEADER_SIZE = sizeof(SNAPSHOT_MAGIC) + 4 + 8 + 4 + 8 + 8 + 1;
+
+// States from a different build of SameBoy may not load the same way (if at all), so they're part of the key too
+static void encode_key(const BootSnapshotCache::Key &key, std::uint8_t *output) {
+    static const std::uint64_t core_hash = fnv1a_64(SAMEBOY_SOURCE_HASH, sizeof(SAMEBOY_SOURCE_HASH) - 1);
+
+    std::memcpy(output, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    output += sizeof(SNAPSHOT_MAGIC);
+    for(std::size_t i = 0; i < 4; i++) {
+        *(output++) = static_cast<std::uint8_t>(SNAPSHOT_VERSION >> (i * 8));
+    }
+    for(std::size_t i = 0; i < 8; i++) {
+        *(output++) = static_cast<std::uint8_t>(core_hash >> (i * 8));
+    }
+    for(std::size_t i = 0; i < 4; i++) {
+        *(output++) = static_cast<std::uint8_t>(key.model >> (i * 8));
+    }
+    for(std::size_t i = 0; i < 8; i++) {
+        *(output++) = static_cast<std::uint8_t>(key.boot_rom_hash >> (i * 8));
+    }
+    for(std::size_t i = 0; i < 8; i++) {
+        *(output++) = static_cast<std::uint8_t>(key.header_hash >> (i * 8));
+    }
+    *output = key.skip_intro ? 1 : 0;
+}
+
+bool BootSnapshotCache::get(const Key &key, std::vector<std::uint8_t> &snapshot) {
+    auto found = this->snapshots.find(key);
+    if(found != this->snapshots.end()) {
+        snapshot.assign(found->second.begin(), found->second.end());
+        return true;
+    }
+
+    if(!this->directory.has_value()) {
+        return false;
+    }
+
+    // The file starts with the whole key, so a hash collision in the file name can't give us the wrong snapshot
+    std::vector<std::uint8_t> file;
+    std::uint8_t header[SNAPSHOT_HEADER_SIZE];
+    encode_key(key, header);
+    auto path = this->get_snapshot_path(key);
+    std::error_code ec;
+    if(!std::filesystem::is_regular_file(path, ec) || !read_file(path, file) || file.size() <= sizeof(header) || std::memcmp(file.data(), header, sizeof(header)) != 0) {
+        return false;
+    }
+
+    snapshot.assign(file.begin() + sizeof(header), file.end());
+    this->store_in_memory(key, snapshot);
+    return true;
+}
+
+void BootSnapshotCache::put(const Key &key, const std::vector<std::uint8_t> &snapshot) {
+    this->store_in_memory(key, snapshot);
+
+    if(this->directory.has_value() && this->io != nullptr) {
+        std::vector<std::uint8_t> file(SNAPSHOT_HEADER_SIZE);
+        encode_key(key, file.data());
+        file.insert(file.end(), snapshot.begin(), snapshot.end());
+
+        this->io->enqueue([directory = *this->directory, path = this->get_snapshot_path(key), file = std::move(file)]() {
+            std::error_code ec;
+            std::filesystem::create_directories(directory, ec);
+
+            // Nothing to tell the user either way; if it failed, the snapshot just gets taken again next run
+            BackgroundIO::Completion completion;
+            completion.success = write_file_atomically(path, file.data(), file.size());
+            return completion;
+        });
+    }
+}
+
+void BootSnapshotCache::clear() noexcept {
+    this->snapshots.clear();
+    this->order.clear();
+}
+
+void BootSnapshotCache::store_in_memory(const Key &key, const std::vector<std::uint8_t> &snapshot) {
+    if(this->max_snapshots == 0) {
+        return;
+    }
+
+    auto &stored = this->snapshots[key];
+    if(stored.empty()) {
+        this->order.emplace_back(key);
+    }
+    stored.assign(snapshot.begin(), snapshot.end());
+
+    while(this->order.size() > this->max_snapshots) {
+        this->snapshots.erase(this->order.front());
+        this->order.pop_front();
+    }
+}
+
+std::filesystem::path BootSnapshotCache::get_snapshot_path(const Key &key) const {
+    std::uint8_t header[SNAPSHOT_HEADER_SIZE];
+    encode_key(key, header);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.boot", static_cast<unsigned long long>(fnv1a_64(header, sizeof(header))));
+    return *this->directory / name;
+}
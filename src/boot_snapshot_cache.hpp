@@ -0,0 +1,94 @@
+#ifndef BOOT_SNAPSHOT_CACHE_HPP
+#define BOOT_SNAPSHOT_CACHE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <map>
+#include <optional>
+#include <filesystem>
+
+class BackgroundIO;
+
+/**
+ * Save states taken right as the boot ROM hands off to the cartridge.
+ *
+ * Nothing the cartridge does can affect the boot ROM except through its header, so for a given model, boot ROM, and
+ * header, every boot ends in the same state. Restoring that state skips running the boot ROM again. Snapshots are kept
+ * in memory and can also be kept in a directory so they survive between runs (snapshots written by a different build of
+ * SameBoy are ignored). Writing them there is done in the background
+ * so the emulation thread never waits on the disk.
+ *
+ * This is not thread-safe; the owner has to synchronize access.
+ */
+class BootSnapshotCache {
+public:
+    struct Key {
+        /** Model being emulated */
+        std::uint32_t model;
+
+        /** Hash of the boot ROM that was loaded */
+        std::uint64_t boot_rom_hash;
+
+        /** Hash of the cartridge header (0x100-0x14F) */
+        std::uint64_t header_hash;
+
+        /** Whether the intro is skipped */
+        bool skip_intro;
+
+        auto operator<=>(const Key &) const = default;
+    };
+
+    /**
+     * Instantiate a cache
+     *
+     * @param max_snapshots maximum number of snapshots to keep in memory (the oldest is dropped first)
+     */
+    BootSnapshotCache(std::size_t max_snapshots = 16) : max_snapshots(max_snapshots) {}
+
+    /**
+     * Set where snapshots are kept on disk
+     *
+     * @param directory directory (or nullopt to only keep them in memory)
+     * @param io        where to queue writes to the directory (must outlive the cache, or at least any calls to put())
+     */
+    void set_directory(const std::optional<std::filesystem::path> &directory, BackgroundIO *io) {
+        this->directory = directory;
+        this->io = io;
+    }
+
+    /**
+     * Get a snapshot, checking memory and then disk
+     *
+     * @param key      key
+     * @param snapshot where to put the snapshot
+     * @return         true if found
+     */
+    bool get(const Key &key, std::vector<std::uint8_t> &snapshot);
+
+    /**
+     * Store a snapshot, also queueing it to be written to disk if a directory is set
+     *
+     * @param key      key
+     * @param snapshot snapshot
+     */
+    void put(const Key &key, const std::vector<std::uint8_t> &snapshot);
+
+    /**
+     * Drop every snapshot held in memory
+     */
+    void clear() noexcept;
+
+private:
+    std::size_t max_snapshots;
+    std::optional<std::filesystem::path> directory;
+    BackgroundIO *io = nullptr;
+    std::map<Key, std::vector<std::uint8_t>> snapshots;
+    std::deque<Key> order;
+
+    // Keep it in memory, dropping the oldest if needed
+    void store_in_memory(const Key &key, const std::vector<std::uint8_t> &snapshot);
+    std::filesystem::path get_snapshot_path(const Key &key) const;
+};
+
+#endif
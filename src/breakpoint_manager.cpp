@@ -0,0 +1,177 @@
+#include "breakpoint_manager.hpp"
+
+#include <algorithm>
+
+static std::uint32_t breakpoint_key(std::uint16_t address, std::uint16_t bank) noexcept {
+    return (static_cast<std::uint32_t>(address) << 16) | bank;
+}
+
+static std::uint32_t breakpoint_key(const Breakpoint &breakpoint) noexcept {
+    return breakpoint_key(breakpoint.address, breakpoint.bank);
+}
+
+std::vector<Breakpoint>::iterator BreakpointManager::lower_bound(std::uint16_t address, std::uint16_t bank) noexcept {
+    auto key = breakpoint_key(address, bank);
+    return std::lower_bound(this->breakpoints.begin(), this->breakpoints.end(), key, [](const Breakpoint &b, std::uint32_t key) { return breakpoint_key(b) < key; });
+}
+
+void BreakpointManager::update_bitmaps(std::uint16_t address) noexcept {
+    // Breakpoints are sorted by address first, so every bank for this address is next to each other
+    bool present = false;
+    bool enabled = false;
+    for(auto b = this->lower_bound(address, 0); b != this->breakpoints.end() && b->address == address; b++) {
+        present = true;
+        enabled = enabled || b->enabled;
+    }
+    this->present.set(address, present);
+    this->enabled.set(address, enabled);
+}
+
+bool BreakpointManager::add(std::uint16_t address, std::uint16_t bank) {
+    auto b = this->lower_bound(address, bank);
+    bool added = b == this->breakpoints.end() || b->address != address || b->bank != bank;
+
+    if(added) {
+        this->breakpoints.insert(b, Breakpoint { address, bank });
+    }
+    else if(b->enabled) {
+        return false;
+    }
+    else {
+        b->enabled = true;
+    }
+
+    this->update_bitmaps(address);
+    this->changed();
+    return added;
+}
+
+std::size_t BreakpointManager::add(const std::vector<Breakpoint> &breakpoints) {
+    // Update the ones we have, then sort the new ones and merge them in all at once
+    auto existing = this->breakpoints.size();
+    for(auto &n : breakpoints) {
+        auto b = std::lower_bound(this->breakpoints.begin(), this->breakpoints.begin() + existing, breakpoint_key(n), [](const Breakpoint &b, std::uint32_t key) { return breakpoint_key(b) < key; });
+        if(b != this->breakpoints.begin() + existing && breakpoint_key(*b) == breakpoint_key(n)) {
+            b->enabled = n.enabled;
+        }
+        else {
+            this->breakpoints.emplace_back(n);
+        }
+    }
+
+    auto new_begin = this->breakpoints.begin() + existing;
+    auto by_key = [](const Breakpoint &a, const Breakpoint &b) { return breakpoint_key(a) < breakpoint_key(b); };
+    std::stable_sort(new_begin, this->breakpoints.end(), by_key);
+    this->breakpoints.erase(std::unique(new_begin, this->breakpoints.end(), [](const Breakpoint &a, const Breakpoint &b) { return breakpoint_key(a) == breakpoint_key(b); }), this->breakpoints.end());
+
+    std::size_t added = this->breakpoints.size() - existing;
+    std::inplace_merge(this->breakpoints.begin(), this->breakpoints.begin() + existing, this->breakpoints.end(), by_key);
+
+    for(auto &n : breakpoints) {
+        this->update_bitmaps(n.address);
+    }
+    this->changed();
+    return added;
+}
+
+bool BreakpointManager::remove(std::uint16_t address, std::uint16_t bank) {
+    auto b = this->lower_bound(address, bank);
+    if(b == this->breakpoints.end() || b->address != address || b->bank != bank) {
+        return false;
+    }
+
+    this->breakpoints.erase(b);
+    this->update_bitmaps(address);
+    this->changed();
+    return true;
+}
+
+std::size_t BreakpointManager::remove_all_at(std::uint16_t address) {
+    if(!this->present.test(address)) {
+        return 0;
+    }
+
+    auto first = this->lower_bound(address, 0);
+    auto last = first;
+    while(last != this->breakpoints.end() && last->address == address) {
+        last++;
+    }
+
+    std::size_t removed = last - first;
+    this->breakpoints.erase(first, last);
+    this->present.reset(address);
+    this->enabled.reset(address);
+    this->changed();
+    return removed;
+}
+
+std::size_t BreakpointManager::remove(const std::vector<Breakpoint> &breakpoints) {
+    std::vector<std::uint32_t> keys;
+    keys.reserve(breakpoints.size());
+    for(auto &b : breakpoints) {
+        keys.emplace_back(breakpoint_key(b));
+    }
+    std::sort(keys.begin(), keys.end());
+
+    // Remove everything in one pass rather than shifting the vector for each one
+    auto old_size = this->breakpoints.size();
+    this->breakpoints.erase(std::remove_if(this->breakpoints.begin(), this->breakpoints.end(), [&keys](const Breakpoint &b) { return std::binary_search(keys.begin(), keys.end(), breakpoint_key(b)); }), this->breakpoints.end());
+
+    for(auto &b : breakpoints) {
+        this->update_bitmaps(b.address);
+    }
+    this->changed();
+    return old_size - this->breakpoints.size();
+}
+
+void BreakpointManager::clear() noexcept {
+    this->breakpoints.clear();
+    this->present.reset();
+    this->enabled.reset();
+    this->changed();
+}
+
+bool BreakpointManager::set_enabled(std::uint16_t address, std::uint16_t bank, bool enabled) {
+    auto b = this->lower_bound(address, bank);
+    if(b == this->breakpoints.end() || b->address != address || b->bank != bank) {
+        return false;
+    }
+
+    if(b->enabled != enabled) {
+        b->enabled = enabled;
+        this->update_bitmaps(address);
+        this->changed();
+    }
+    return true;
+}
+
+bool BreakpointManager::set_condition(std::uint16_t address, std::uint16_t bank, std::shared_ptr<const SM83Expression> condition) {
+    auto b = this->lower_bound(address, bank);
+    if(b == this->breakpoints.end() || b->address != address || b->bank != bank) {
+        return false;
+    }
+
+    // SameBoy still stops here either way, so the enabled set hasn't changed
+    b->condition = std::move(condition);
+    this->generation++;
+    return true;
+}
+
+bool BreakpointManager::record_hit(std::uint16_t address, std::uint16_t bank, const SM83ExpressionState &state, SM83Expression::ReadMemory read, void *user_data) noexcept {
+    if(!this->enabled.test(address)) {
+        return false;
+    }
+
+    bool hit = false;
+    for(auto b = this->lower_bound(address, 0); b != this->breakpoints.end() && b->address == address; b++) {
+        if(b->enabled && (b->bank == bank || b->bank == BREAKPOINT_ANY_BANK) && (b->condition == nullptr || b->condition->evaluate(state, read, user_data) != 0)) {
+            b->hit_count++;
+            hit = true;
+        }
+    }
+
+    if(hit) {
+        this->generation++;
+    }
+    return hit;
+}
@@ -0,0 +1,193 @@
+#ifndef BREAKPOINT_MANAGER_HPP
+#define BREAKPOINT_MANAGER_HPP
+
+#include <cstdint>
+#include <bitset>
+#include <vector>
+#include <memory>
+
+#include "sm83_expression.hpp"
+
+/** Bank value for a breakpoint that applies regardless of what bank is mapped (same as SameBoy's) */
+static constexpr const std::uint16_t BREAKPOINT_ANY_BANK = 0xFFFF;
+
+struct Breakpoint {
+    /** Address */
+    std::uint16_t address;
+
+    /** Bank, or BREAKPOINT_ANY_BANK for any bank */
+    std::uint16_t bank = BREAKPOINT_ANY_BANK;
+
+    /** Disabled breakpoints are kept but never break */
+    bool enabled = true;
+
+    /** Number of times execution stopped here */
+    std::uint64_t hit_count = 0;
+
+    /** Only stop if this is nonzero (or nullptr to always stop) */
+    std::shared_ptr<const SM83Expression> condition = nullptr;
+};
+
+/**
+ * Holds breakpoints sorted by address and bank, with a bitmap of every address so checking an address is O(1) no matter
+ * how many breakpoints there are.
+ *
+ * Generation counters let the owner skip copying or syncing breakpoints when nothing changed.
+ *
+ * This is not thread-safe; the owner has to synchronize access.
+ */
+class BreakpointManager {
+public:
+    using Bitmap = std::bitset<0x10000>;
+
+    /**
+     * Add a breakpoint. If it already exists, it is enabled and its hit count is kept.
+     *
+     * @param address address
+     * @param bank    bank (or BREAKPOINT_ANY_BANK)
+     * @return        true if it was added
+     */
+    bool add(std::uint16_t address, std::uint16_t bank = BREAKPOINT_ANY_BANK);
+
+    /**
+     * Add many breakpoints at once. This is much faster than calling add() for each one.
+     *
+     * @param breakpoints breakpoints to add (enabled state and hit count are taken from these)
+     * @return            number of breakpoints that were added (not counting ones that already existed)
+     */
+    std::size_t add(const std::vector<Breakpoint> &breakpoints);
+
+    /**
+     * Remove a breakpoint
+     *
+     * @param address address
+     * @param bank    bank (or BREAKPOINT_ANY_BANK)
+     * @return        true if it was removed
+     */
+    bool remove(std::uint16_t address, std::uint16_t bank);
+
+    /**
+     * Remove every breakpoint at an address, regardless of bank
+     *
+     * @param address address
+     * @return        number of breakpoints removed
+     */
+    std::size_t remove_all_at(std::uint16_t address);
+
+    /**
+     * Remove many breakpoints at once
+     *
+     * @param breakpoints breakpoints to remove (only the address and bank are used)
+     * @return            number of breakpoints removed
+     */
+    std::size_t remove(const std::vector<Breakpoint> &breakpoints);
+
+    /**
+     * Remove every breakpoint
+     */
+    void clear() noexcept;
+
+    /**
+     * Enable or disable a breakpoint without removing it
+     *
+     * @param address address
+     * @param bank    bank (or BREAKPOINT_ANY_BANK)
+     * @param enabled enable it
+     * @return        true if the breakpoint exists
+     */
+    bool set_enabled(std::uint16_t address, std::uint16_t bank, bool enabled);
+
+    /**
+     * Set the condition of a breakpoint
+     *
+     * @param address   address
+     * @param bank      bank (or BREAKPOINT_ANY_BANK)
+     * @param condition condition (or nullptr to always stop)
+     * @return          true if the breakpoint exists
+     */
+    bool set_condition(std::uint16_t address, std::uint16_t bank, std::shared_ptr<const SM83Expression> condition);
+
+    /**
+     * Count a hit on every enabled breakpoint that matches the address and the bank mapped there and whose condition is met
+     *
+     * @param address   address execution stopped at
+     * @param bank      bank mapped to the address
+     * @param state     registers for evaluating conditions
+     * @param read      function to read memory for evaluating conditions
+     * @param user_data passed to read
+     * @return          true if any breakpoint matched
+     */
+    bool record_hit(std::uint16_t address, std::uint16_t bank, const SM83ExpressionState &state, SM83Expression::ReadMemory read, void *user_data) noexcept;
+
+    /**
+     * Get whether or not there is a breakpoint (enabled or not) at the address in any bank
+     *
+     * @param address address
+     * @return        true if so
+     */
+    bool has_breakpoint(std::uint16_t address) const noexcept { return this->present.test(address); }
+
+    /**
+     * Get whether or not there is an enabled breakpoint at the address in any bank
+     *
+     * @param address address
+     * @return        true if so
+     */
+    bool has_enabled_breakpoint(std::uint16_t address) const noexcept { return this->enabled.test(address); }
+
+    /**
+     * Get the bitmap of addresses with an enabled breakpoint
+     *
+     * @return bitmap
+     */
+    const Bitmap &get_enabled_bitmap() const noexcept { return this->enabled; }
+
+    /**
+     * Get all breakpoints sorted by address and bank
+     *
+     * @return breakpoints
+     */
+    const std::vector<Breakpoint> &get_breakpoints() const noexcept { return this->breakpoints; }
+
+    /**
+     * Get the number of breakpoints
+     *
+     * @return number of breakpoints
+     */
+    std::size_t size() const noexcept { return this->breakpoints.size(); }
+
+    /**
+     * Get a number that changes whenever anything changes, including hit counts
+     *
+     * @return generation
+     */
+    std::uint64_t get_generation() const noexcept { return this->generation; }
+
+    /**
+     * Get a number that changes whenever the set of enabled breakpoints changes
+     *
+     * @return generation
+     */
+    std::uint64_t get_enabled_generation() const noexcept { return this->enabled_generation; }
+
+private:
+    std::vector<Breakpoint> breakpoints;
+    Bitmap present;
+    Bitmap enabled;
+    std::uint64_t generation = 0;
+    std::uint64_t enabled_generation = 0;
+
+    // Note that the enabled breakpoints changed
+    void changed() noexcept {
+        this->generation++;
+        this->enabled_generation++;
+    }
+
+    // Find where a breakpoint is (or would go)
+    std::vector<Breakpoint>::iterator lower_bound(std::uint16_t address, std::uint16_t bank) noexcept;
+
+    // Recalculate the bits for an address
+    void update_bitmaps(std::uint16_t address) noexcept;
+};
+
+#endif
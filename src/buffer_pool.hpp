@@ -0,0 +1,60 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <cstdint>
+#include <vector>
+#include <mutex>
+
+/**
+ * Thread-safe pool of byte buffers. Buffers keep their capacity when returned, so reusing them avoids reallocating large
+ * blocks (such as save states) over and over.
+ */
+class BufferPool {
+public:
+    /**
+     * Instantiate a pool
+     *
+     * @param max_buffers maximum number of idle buffers to hold onto
+     */
+    BufferPool(std::size_t max_buffers = 4) : max_buffers(max_buffers) {}
+
+    /**
+     * Take a buffer from the pool (or make a new one if the pool is empty)
+     *
+     * @param size size to resize the buffer to
+     * @return     buffer
+     */
+    std::vector<std::uint8_t> acquire(std::size_t size = 0) {
+        std::vector<std::uint8_t> buffer;
+
+        this->mutex.lock();
+        if(!this->buffers.empty()) {
+            buffer = std::move(this->buffers.back());
+            this->buffers.pop_back();
+        }
+        this->mutex.unlock();
+
+        buffer.resize(size);
+        return buffer;
+    }
+
+    /**
+     * Return a buffer to the pool. If the pool is full, the buffer is freed.
+     *
+     * @param buffer buffer to return
+     */
+    void release(std::vector<std::uint8_t> &&buffer) {
+        this->mutex.lock();
+        if(this->buffers.size() < this->max_buffers) {
+            this->buffers.emplace_back(std::move(buffer));
+        }
+        this->mutex.unlock();
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::vector<std::uint8_t>> buffers;
+    std::size_t max_buffers;
+};
+
+#endif
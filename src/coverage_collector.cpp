@@ -0,0 +1,48 @@
+#include "coverage_collector.hpp"
+
+#include <new>
+
+std::vector<CoverageEntry> CoverageCollector::get_entries() const {
+    std::vector<CoverageEntry> entries;
+
+    // Pages are indexed by bank and then address, so going through them in order keeps everything sorted
+    for(std::size_t index = 0; index < this->pages.size(); index++) {
+        auto &page = this->pages[index];
+        if(page == nullptr) {
+            continue;
+        }
+
+        auto bank = static_cast<std::uint16_t>(index >> 2);
+        auto base = static_cast<std::uint16_t>((index & 3) * PAGE_SIZE);
+        for(std::size_t offset = 0; offset < PAGE_SIZE; offset++) {
+            auto count = (*page)[offset];
+            if(count != 0) {
+                entries.emplace_back(CoverageEntry { bank, static_cast<std::uint16_t>(base + offset), count });
+            }
+        }
+    }
+
+    return entries;
+}
+
+void CoverageCollector::clear() noexcept {
+    this->pages.clear();
+    this->pages.shrink_to_fit();
+    this->max_count = 0;
+    this->total = 0;
+    this->opcode_counts = {};
+}
+
+CoverageCollector::Page *CoverageCollector::allocate_page(std::size_t index) noexcept {
+    try {
+        if(index >= this->pages.size()) {
+            this->pages.resize(index + 1);
+        }
+        auto &page = this->pages[index];
+        page = std::make_unique<Page>();
+        return page.get();
+    }
+    catch(std::bad_alloc &) {
+        return &this->discarded;
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef COVERAGE_COLLECTOR_HPP
+#define COVERAGE_COLLECTOR_HPP
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <memory>
+
+/**
+ * An address that was executed and how many times it ran
+ */
+struct CoverageEntry {
+    /** Bank that was mapped to the address */
+    std::uint16_t bank;
+
+    /** Address of the instruction */
+    std::uint16_t address;
+
+    /** Number of times it ran (saturates at UINT32_MAX) */
+    std::uint32_t count;
+};
+
+/**
+ * How many times each opcode ran
+ */
+struct OpcodeCounts {
+    /** Unprefixed opcodes */
+    std::array<std::uint64_t, 256> opcodes = {};
+
+    /** Opcodes prefixed with $CB */
+    std::array<std::uint64_t, 256> cb_opcodes = {};
+};
+
+/**
+ * Counts how many times every (bank, address) was executed, along with how many times every opcode ran.
+ *
+ * Counters are kept in pages covering one bank in one quarter of the address space. Pages are only allocated the first time
+ * something runs in them, so a ROM with hundreds of banks only pays for the code that actually runs, and recording an
+ * instruction is just an index and two increments.
+ *
+ * This is not thread-safe; the owner has to synchronize access.
+ */
+class CoverageCollector {
+public:
+    /** Number of addresses in each page */
+    static constexpr const std::size_t PAGE_SIZE = 0x4000;
+
+    /**
+     * Count an executed instruction
+     *
+     * @param bank      bank mapped to the address
+     * @param address   address of the instruction
+     * @param opcode    opcode
+     * @param cb_opcode second byte if opcode is $CB (ignored otherwise)
+     */
+    void record(std::uint16_t bank, std::uint16_t address, std::uint8_t opcode, std::uint8_t cb_opcode) noexcept {
+        auto index = page_index(bank, address);
+        auto *page = index < this->pages.size() ? this->pages[index].get() : nullptr;
+        if(page == nullptr) {
+            page = this->allocate_page(index);
+        }
+
+        auto &count = (*page)[address % PAGE_SIZE];
+        if(count != UINT32_MAX) {
+            count++;
+            this->max_count = count > this->max_count ? count : this->max_count;
+        }
+
+        this->opcode_counts.opcodes[opcode]++;
+        if(opcode == 0xCB) {
+            this->opcode_counts.cb_opcodes[cb_opcode]++;
+        }
+        this->total++;
+    }
+
+    /**
+     * Get how many times an address ran
+     *
+     * @param bank    bank mapped to the address
+     * @param address address
+     * @return        number of times
+     */
+    std::uint32_t get_count(std::uint16_t bank, std::uint16_t address) const noexcept {
+        auto index = page_index(bank, address);
+        if(index >= this->pages.size() || this->pages[index] == nullptr) {
+            return 0;
+        }
+        return (*this->pages[index])[address % PAGE_SIZE];
+    }
+
+    /**
+     * Get the highest count of any address
+     *
+     * @return highest count
+     */
+    std::uint32_t get_max_count() const noexcept { return this->max_count; }
+
+    /**
+     * Get the total number of instructions recorded
+     *
+     * @return total
+     */
+    std::uint64_t get_total() const noexcept { return this->total; }
+
+    /**
+     * Get how many times each opcode ran
+     *
+     * @return opcode counts
+     */
+    const OpcodeCounts &get_opcode_counts() const noexcept { return this->opcode_counts; }
+
+    /**
+     * Get every address that ran at least once, sorted by bank and then address
+     *
+     * @return entries
+     */
+    std::vector<CoverageEntry> get_entries() const;
+
+    /**
+     * Forget everything that was recorded
+     */
+    void clear() noexcept;
+
+private:
+    using Page = std::array<std::uint32_t, PAGE_SIZE>;
+    std::vector<std::unique_ptr<Page>> pages;
+
+    // Where counts go if a page can't be allocated, since record() can't fail
+    Page discarded = {};
+
+    std::uint32_t max_count = 0;
+    std::uint64_t total = 0;
+    OpcodeCounts opcode_counts;
+
+    static std::size_t page_index(std::uint16_t bank, std::uint16_t address) noexcept {
+        return (static_cast<std::size_t>(bank) << 2) | (address / PAGE_SIZE);
+    }
+    Page *allocate_page(std::size_t index) noexcept;
+};
+
+#endif
@@ -6,6 +6,8 @@
 #include <QLineEdit>
 #include <QHeaderView>
 #include <QTableWidget>
+#include <QTableView>
+#include <QAbstractTableModel>
 #include <QTableWidgetItem>
 #include <QCoreApplication>
 #include <QCheckBox>
@@ -20,24 +22,113 @@
 #include <QGroupBox>
 #include <QScrollBar>
 #include <QMouseEvent>
+#include <QFileDialog>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QStatusBar>
+#include <QMenu>
+#include <QToolButton>
+
+#include <thread>
 
 #include "debugger_break_and_trace_results_dialog.hpp"
+#include "debugger_trace_viewer.hpp"
+#include "debugger_watchpoints_dialog.hpp"
+#include "debugger_profiler_dialog.hpp"
+#include "table_export.hpp"
 #include "gb_proxy.h"
 
-class Debugger::BacktraceTable : public QTableWidget {
+class Debugger::BacktraceTable : public QTableView {
 public:
-    BacktraceTable(QWidget *parent, Debugger *window) : QTableWidget(parent), window(window) {}
+    BacktraceTable(QWidget *parent, Debugger *window) : QTableView(parent), model(new Model(this)), window(window) {
+        this->setModel(this->model);
+    }
     
     // Double click = goto address in debugger
     void mouseDoubleClickEvent(QMouseEvent *event) override {
-        auto *item = this->itemAt(event->pos());
-        if(item) {
-            unsigned int r = item->data(Qt::UserRole).toUInt();
-            this->window->disassembler->go_to(r);
+        auto index = this->indexAt(event->pos());
+        if(index.isValid()) {
+            this->window->disassembler->go_to(this->model->get_address(index.row()));
         }
     }
     
+    // Show the backtrace, only signaling rows that changed
+    void set_backtrace(const std::vector<GameInstance::BacktraceFrame> &backtrace) {
+        this->model->update(backtrace);
+    }
+    
+    void clear() {
+        this->model->update({});
+    }
+    
 private:
+    class Model : public QAbstractTableModel {
+    public:
+        Model(QObject *parent) : QAbstractTableModel(parent) {}
+        
+        int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+            return parent.isValid() ? 0 : static_cast<int>(this->rows.size());
+        }
+        
+        int columnCount(const QModelIndex &parent = QModelIndex()) const override {
+            return parent.isValid() ? 0 : 1;
+        }
+        
+        QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+            if(!index.isValid() || (role != Qt::DisplayRole && role != Qt::ToolTipRole)) {
+                return QVariant();
+            }
+            return this->rows[index.row()].text;
+        }
+        
+        std::uint16_t get_address(int row) const noexcept {
+            return this->rows[row].address;
+        }
+        
+        void update(const std::vector<GameInstance::BacktraceFrame> &backtrace) {
+            int old_count = static_cast<int>(this->rows.size());
+            int new_count = static_cast<int>(backtrace.size());
+            
+            if(new_count < old_count) {
+                this->beginRemoveRows(QModelIndex(), new_count, old_count - 1);
+                this->rows.resize(new_count);
+                this->endRemoveRows();
+            }
+            
+            for(int row = 0; row < new_count; row++) {
+                auto &frame = backtrace[row];
+                char text[256];
+                int length = std::snprintf(text, sizeof(text), "%3d. %02x:%04x", row + 1, frame.bank, frame.address);
+                if(!frame.symbol.empty() && length > 0 && static_cast<std::size_t>(length) < sizeof(text)) {
+                    if(frame.symbol_offset == 0) {
+                        std::snprintf(text + length, sizeof(text) - length, " (%s)", frame.symbol.c_str());
+                    }
+                    else {
+                        std::snprintf(text + length, sizeof(text) - length, " (%s+$%x)", frame.symbol.c_str(), frame.symbol_offset);
+                    }
+                }
+                
+                if(row >= old_count) {
+                    this->beginInsertRows(QModelIndex(), row, row);
+                    this->rows.push_back({ QString(text), frame.address });
+                    this->endInsertRows();
+                }
+                else if(this->rows[row].address != frame.address || this->rows[row].text != text) {
+                    this->rows[row] = { QString(text), frame.address };
+                    emit this->dataChanged(this->index(row, 0), this->index(row, 0));
+                }
+            }
+        }
+        
+    private:
+        struct Row {
+            QString text;
+            std::uint16_t address;
+        };
+        std::vector<Row> rows;
+    };
+    
+    Model *model;
     Debugger *window;
 };
 
@@ -76,6 +167,31 @@ Debugger::Debugger(GameWindow *window) : game_window(window) {
     this->clear_breakpoints_button->setEnabled(false);
     connect(this->clear_breakpoints_button, &QAction::triggered, this, &Debugger::action_clear_breakpoints);
     
+    bar->addSeparator();
+    
+    this->open_trace_button = bar->addAction("Open Trace...");
+    connect(this->open_trace_button, &QAction::triggered, this, &Debugger::action_open_trace);
+    
+    this->watchpoints_button = bar->addAction("Watchpoints...");
+    connect(this->watchpoints_button, &QAction::triggered, this, &Debugger::action_show_watchpoints);
+    
+    // Coverage is collected while running and shown as heat in the disassembler
+    auto *coverage_menu = new QMenu(this);
+    this->collect_coverage_button = coverage_menu->addAction("Collect Coverage");
+    this->collect_coverage_button->setCheckable(true);
+    connect(this->collect_coverage_button, &QAction::toggled, this, &Debugger::action_toggle_coverage);
+    connect(coverage_menu->addAction("Clear Coverage"), &QAction::triggered, this, &Debugger::action_clear_coverage);
+    coverage_menu->addSeparator();
+    connect(coverage_menu->addAction("Export Coverage..."), &QAction::triggered, this, &Debugger::action_export_coverage);
+    connect(coverage_menu->addAction("Export Opcode Counts..."), &QAction::triggered, this, &Debugger::action_export_opcode_counts);
+    
+    this->coverage_button = bar->addAction("Coverage");
+    this->coverage_button->setMenu(coverage_menu);
+    qobject_cast<QToolButton *>(bar->widgetForAction(this->coverage_button))->setPopupMode(QToolButton::InstantPopup);
+    
+    this->profiler_button = bar->addAction("Profiler...");
+    connect(this->profiler_button, &QAction::triggered, this, &Debugger::action_show_profiler);
+    
     auto *central_widget = new QWidget(this);
     auto *layout = new QHBoxLayout(central_widget);
     layout->addWidget((this->disassembler = new DebuggerDisassembler(this)));
@@ -87,8 +203,14 @@ Debugger::Debugger(GameWindow *window) : game_window(window) {
     this->right_view->setLayout(right_view_layout);
     right_view_layout->setContentsMargins(0,0,0,0);
     
+    // Registers and backtrace are only usable while paused
+    this->paused_view = new QWidget(this->right_view);
+    auto *paused_view_layout = new QVBoxLayout(this->paused_view);
+    this->paused_view->setLayout(paused_view_layout);
+    paused_view_layout->setContentsMargins(0,0,0,0);
+    
     // Add registers
-    auto *register_view = new QGroupBox(this->right_view);
+    auto *register_view = new QGroupBox(this->paused_view);
     reinterpret_cast<QGroupBox *>(register_view)->setTitle("CPU Registers");
     auto *register_view_layout = new QVBoxLayout(register_view);
     register_view->setLayout(register_view_layout);
@@ -140,25 +262,58 @@ Debugger::Debugger(GameWindow *window) : game_window(window) {
 
 
     register_view->setSizePolicy(QSizePolicy::Policy::Expanding, QSizePolicy::Policy::Fixed);
-    right_view_layout->addWidget(register_view);
+    paused_view_layout->addWidget(register_view);
     
     // Backtrace
-    auto *backtrace_frame = new QGroupBox(this->right_view);
+    auto *backtrace_frame = new QGroupBox(this->paused_view);
     backtrace_frame->setTitle("Backtrace");
     auto *backtrace_layout = new QVBoxLayout();
     this->backtrace = new BacktraceTable(this->right_view, this);
     this->format_table(this->backtrace);
-    this->backtrace->setColumnCount(1);
     this->backtrace->setTextElideMode(Qt::ElideNone);
     backtrace_layout->addWidget(this->backtrace);
     backtrace_frame->setLayout(backtrace_layout);
-    right_view_layout->addWidget(backtrace_frame);
+    paused_view_layout->addWidget(backtrace_frame);
+    right_view_layout->addWidget(this->paused_view);
+    
+    // Watch expressions (these update while running, so they aren't in the paused view)
+    auto *watch_frame = new QGroupBox(this->right_view);
+    watch_frame->setTitle("Watch");
+    auto *watch_layout = new QVBoxLayout();
+    this->watch_table = new QTableWidget(watch_frame);
+    this->format_table(this->watch_table);
+    this->watch_table->setColumnCount(2);
+    this->watch_table->setColumnWidth(0, 180);
+    this->watch_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    this->watch_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    this->watch_table->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    this->watch_table->verticalScrollBar()->show();
+    watch_layout->addWidget(this->watch_table);
+    
+    auto *watch_input_row = new QWidget(watch_frame);
+    auto *watch_input_layout = new QHBoxLayout(watch_input_row);
+    watch_input_layout->setContentsMargins(0,0,0,0);
+    this->watch_input = new QLineEdit(watch_input_row);
+    this->watch_input->setPlaceholderText("Expression (e.g. [hl] + a)");
+    this->watch_input->setFont(this->table_font);
+    connect(this->watch_input, &QLineEdit::returnPressed, this, &Debugger::action_add_watch);
+    watch_input_layout->addWidget(this->watch_input);
+    auto *remove_watch_button = new QPushButton("Remove", watch_input_row);
+    connect(remove_watch_button, &QPushButton::clicked, this, &Debugger::action_remove_watch);
+    watch_input_layout->addWidget(remove_watch_button);
+    watch_layout->addWidget(watch_input_row);
+    
+    watch_frame->setLayout(watch_layout);
+    right_view_layout->addWidget(watch_frame);
     
     // Done
     layout->addWidget(this->right_view);
     this->right_view->setMaximumWidth(300);
     this->right_view->setMinimumWidth(300);
-    this->right_view->setEnabled(false);
+    this->paused_view->setEnabled(false);
+    
+    this->watchpoints_dialog = new WatchpointsDialog(this);
+    this->profiler_dialog = new ProfilerDialog(this);
     
     this->setWindowTitle("Debugger");
 }
@@ -190,7 +345,7 @@ void Debugger::action_finish() {
 void Debugger::set_known_breakpoint(bool known_breakpoint) {
     if(this->known_breakpoint != known_breakpoint) {
         this->known_breakpoint = known_breakpoint;
-        this->right_view->setEnabled(known_breakpoint);
+        this->paused_view->setEnabled(known_breakpoint);
         this->break_button->setEnabled(!known_breakpoint);
         this->continue_button->setEnabled(known_breakpoint);
         this->step_button->setEnabled(known_breakpoint);
@@ -200,6 +355,9 @@ void Debugger::set_known_breakpoint(bool known_breakpoint) {
         if(known_breakpoint) {
             this->disassembler->go_to(this->get_instance().get_register_value(GameInstance::SM83Register::SM83_REG_PC));
         }
+        else {
+            this->statusBar()->clearMessage();
+        }
     }
 }
 
@@ -221,27 +379,38 @@ void Debugger::refresh_flags() {
 }
 
 void Debugger::refresh_registers() {
-    auto &instance = this->get_instance();
+    auto registers = this->get_instance().get_registers();
 
-    #define PROCESS_REGISTER_FIELD(name, field, fmt) {\
+    // Only touch fields whose registers changed
+    #define PROCESS_REGISTER_FIELD(name, field, fmt) if(!this->registers_copy.has_value() || this->registers_copy->name != registers.name) {\
         char str[8]; \
-        std::snprintf(str, sizeof(str), fmt, instance.get_register_value(GameInstance::SM83Register::SM83_REG_##name)); \
+        std::snprintf(str, sizeof(str), fmt, registers.name); \
         this->field->blockSignals(true); \
         this->field->setText(str); \
         this->field->blockSignals(false); \
     }
 
-    PROCESS_REGISTER_FIELD(AF, register_af, "$%04x");
-    PROCESS_REGISTER_FIELD(BC, register_bc, "$%04x");
-    PROCESS_REGISTER_FIELD(DE, register_de, "$%04x");
-    PROCESS_REGISTER_FIELD(HL, register_hl, "$%04x");
-    PROCESS_REGISTER_FIELD(SP, register_sp, "$%04x");
-    PROCESS_REGISTER_FIELD(PC, register_pc, "$%04x");
+    PROCESS_REGISTER_FIELD(af, register_af, "$%04x");
+    PROCESS_REGISTER_FIELD(bc, register_bc, "$%04x");
+    PROCESS_REGISTER_FIELD(de, register_de, "$%04x");
+    PROCESS_REGISTER_FIELD(hl, register_hl, "$%04x");
+    PROCESS_REGISTER_FIELD(sp, register_sp, "$%04x");
+    PROCESS_REGISTER_FIELD(pc, register_pc, "$%04x");
 
     #undef PROCESS_REGISTER_FIELD
+
+    this->registers_copy = registers;
 }
 
 void Debugger::refresh_view() {
+    // Keep draining the access log even when hidden so the emulator doesn't have to drop anything
+    this->drain_memory_access_log();
+
+    // The profiler can be watched without the debugger open
+    if(this->profiler_dialog->isVisible()) {
+        this->profiler_dialog->refresh_summary();
+    }
+
     // If we aren't visible, go away
     if(!this->isVisible()) {
         return;
@@ -251,9 +420,37 @@ void Debugger::refresh_view() {
     bool bp_pause = instance.is_paused_from_breakpoint();
     
     this->disassembler->refresh_view();
-    this->breakpoints_copy = instance.get_breakpoints();
+
+    // Only copy breakpoints if they changed, since there can be a lot of them
+    auto breakpoint_generation = instance.get_breakpoint_generation();
+    if(breakpoint_generation != this->breakpoint_generation) {
+        this->breakpoint_generation = breakpoint_generation;
+        this->breakpoints_copy = instance.get_breakpoints();
+        this->enabled_breakpoints.reset();
+        for(auto &b : this->breakpoints_copy) {
+            if(b.enabled) {
+                this->enabled_breakpoints.set(b.address);
+            }
+        }
+    }
     this->clear_breakpoints_button->setEnabled(this->breakpoints_copy.size() > 0);
-    this->backtrace_copy = instance.get_backtrace();
+
+    // Show any traces that finished being written to disk
+    while(auto trace_path = instance.pop_finished_trace_file()) {
+        this->open_trace(*trace_path);
+    }
+
+    // Say why we stopped if a watchpoint broke
+    if(auto access = instance.pop_watchpoint_break()) {
+        char message[128];
+        if(access->type == WATCHPOINT_WRITE) {
+            std::snprintf(message, sizeof(message), "Watchpoint: $%04x wrote $%02x to $%04x", access->pc, access->value, access->address);
+        }
+        else {
+            std::snprintf(message, sizeof(message), "Watchpoint: $%04x read $%02x from $%04x", access->pc, access->value, access->address);
+        }
+        this->statusBar()->showMessage(message);
+    }
 
     // Update debugger at 20 Hz
     auto now = std::chrono::steady_clock::now();
@@ -262,25 +459,13 @@ void Debugger::refresh_view() {
     }
     this->last_update = now;
 
+    this->refresh_watches();
+
     // If paused from breakpoint, update this information
     if(bp_pause) {
         this->refresh_registers();
         this->refresh_flags();
-
-        int row = 0;
-        this->backtrace->setRowCount(this->backtrace_copy.size());
-        for(auto &l : this->backtrace_copy) {
-            auto l_trimmed = QString::fromStdString(l.first).trimmed();
-            if(l_trimmed.isEmpty()) {
-                continue;
-            }
-            auto *item = new QTableWidgetItem(l_trimmed);
-            item->setToolTip(l_trimmed);
-            item->setFlags(item->flags() & ~Qt::ItemIsEditable);
-            this->backtrace->setItem(row, 0, item);
-            item->setData(Qt::UserRole, l.second);
-            row++;
-        }
+        this->refresh_backtrace();
     }
     
     if(!bp_pause || this->known_breakpoint != bp_pause) {
@@ -294,52 +479,22 @@ void Debugger::refresh_view() {
             auto bnt = instance.pop_break_and_trace_results().value();
             std::vector<ProcessedBNTResult> results;
 
-            // Strip address pointer, newlines, and comment from instruction
-            for(auto &b : bnt) {
+            auto instructions = instance.decode_trace(bnt);
+            results.reserve(bnt.size());
+
+            // Work out where calls and returns happen so we can nest the results
+            for(std::size_t i = 0; i < bnt.size(); i++) {
                 auto &r = results.emplace_back();
-                static_cast<GameInstance::BreakAndTraceResult &>(r) = b;
-
-                auto d = QString(b.disassembly.c_str()).split("\n");
-                auto d_second_to_last = d.at(d.size() - 2);
-                d_second_to_last.replace("->", "");
-                d_second_to_last = d_second_to_last.mid(d_second_to_last.indexOf(":") + 1);
-                d_second_to_last = d_second_to_last.mid(0, d_second_to_last.indexOf(" ;")).trimmed();
-                r.instruction = d_second_to_last.toStdString();
-
-                auto comma_index = d_second_to_last.indexOf(",");
-
-                bool is_call = !r.step_over && d_second_to_last.startsWith("CALL "); // ignore calls if stepping over
-                bool is_call_conditional = is_call && comma_index > 0;
-
-                bool is_ret = d_second_to_last.startsWith("RET"); // never ignore returning
-                bool is_ret_conditional = is_ret && d_second_to_last.startsWith("RET ");
-
-                if(is_call || is_ret) {
-                    if(is_call_conditional || is_ret_conditional) {
-                        QString condition;
-                        if(is_call) {
-                            condition = d_second_to_last.mid(0, comma_index).replace("CALL ", "").toLower();
-                        }
-                        else if(is_ret) {
-                            condition = d_second_to_last.replace("RET ", "").toLower();
-                        }
-
-                        auto condition_met = (condition == "z" && r.zero) &&
-                                             (condition == "nz" && !r.zero) &&
-                                             (condition == "c" && r.carry) &&
-                                             (condition == "nc" && !r.carry);
-                        if(!condition_met) {
-                            is_call = false;
-                            is_ret = false;
-                        }
-                    }
+                auto &instruction = instructions[i];
+                static_cast<GameInstance::BreakAndTraceResult &>(r) = bnt[i];
+                r.instruction = format_sm83_instruction(instruction);
 
-                    if(is_call) {
-                        r.direction = 1;
-                    }
-                    else if(is_ret) {
-                        r.direction = -1;
-                    }
+                bool is_call = !(r.flags & TRACE_RECORD_STEP_OVER) && instruction.flow == SM83_FLOW_CALL; // ignore calls if stepping over
+                bool is_ret = instruction.flow == SM83_FLOW_RETURN; // never ignore returning
+
+                // Registers were recorded before the instruction ran, so we can tell if it was taken
+                if((is_call || is_ret) && is_sm83_condition_met(instruction.condition, r.f)) {
+                    r.direction = is_call ? 1 : -1;
                 }
             }
 
@@ -380,6 +535,228 @@ void Debugger::action_clear_breakpoints() noexcept {
     this->get_instance().remove_all_breakpoints();
 }
 
+void Debugger::refresh_watches() {
+    auto watches = this->get_instance().get_watches();
+    this->watch_table->setRowCount(watches.size());
+
+    int row = 0;
+    for(auto &[expression, value] : watches) {
+        char value_text[32];
+        std::snprintf(value_text, sizeof(value_text), "$%04x (%u)", value, value);
+
+        // Reuse items so the selection doesn't get lost every refresh
+        auto set_text = [this, &row](int column, const QString &text) {
+            auto *item = this->watch_table->item(row, column);
+            if(item == nullptr) {
+                item = new QTableWidgetItem();
+                this->watch_table->setItem(row, column, item);
+            }
+            if(item->text() != text) {
+                item->setText(text);
+                item->setToolTip(text);
+            }
+        };
+        set_text(0, QString::fromStdString(expression));
+        set_text(1, value_text);
+        row++;
+    }
+}
+
+void Debugger::action_add_watch() {
+    auto text = this->watch_input->text().trimmed();
+    if(text.isEmpty()) {
+        return;
+    }
+
+    std::string error;
+    if(!this->get_instance().add_watch(text.toStdString(), error)) {
+        QMessageBox(QMessageBox::Icon::Critical, "Invalid Expression", QString("The expression could not be compiled: ") + error.c_str(), QMessageBox::StandardButton::Ok).exec();
+        return;
+    }
+
+    this->watch_input->clear();
+    this->refresh_watches();
+}
+
+void Debugger::action_remove_watch() {
+    auto row = this->watch_table->currentRow();
+    if(row >= 0) {
+        this->get_instance().remove_watch(row);
+        this->refresh_watches();
+    }
+}
+
+void Debugger::action_open_trace() {
+    QFileDialog file_dialog(this);
+    file_dialog.setFileMode(QFileDialog::FileMode::ExistingFile);
+    file_dialog.setNameFilters(QStringList { "Trace Files (*.sdxt)", "All Files (*)" });
+    file_dialog.setWindowTitle("Open a Trace");
+
+    if(file_dialog.exec() == QFileDialog::Accepted) {
+        this->open_trace(std::filesystem::path(file_dialog.selectedFiles()[0].toStdString()));
+    }
+}
+
+void Debugger::action_show_watchpoints() {
+    this->watchpoints_dialog->refresh_watchpoints();
+    this->watchpoints_dialog->refresh_log();
+    this->watchpoints_dialog->show();
+    this->watchpoints_dialog->activateWindow();
+}
+
+void Debugger::action_show_profiler() {
+    this->profiler_dialog->refresh_report();
+    this->profiler_dialog->show();
+    this->profiler_dialog->activateWindow();
+}
+
+void Debugger::action_toggle_coverage(bool enabled) {
+    this->get_instance().set_coverage_enabled(enabled);
+}
+
+void Debugger::action_clear_coverage() {
+    this->get_instance().clear_coverage();
+    this->disassembler->refresh_view();
+}
+
+void Debugger::action_export_coverage() {
+    auto coverage = std::make_shared<const std::vector<CoverageEntry>>(this->get_instance().get_coverage());
+
+    // Sorted by bank and address so exports from different runs can be diffed
+    export_table(this, { "bank", "address", "count" }, coverage->size(), [coverage](std::uint64_t row, std::vector<std::string> &fields) {
+        auto &entry = (*coverage)[row];
+
+        char text[16];
+        std::snprintf(text, sizeof(text), "$%02x", entry.bank);
+        fields[0] = text;
+        std::snprintf(text, sizeof(text), "$%04x", entry.address);
+        fields[1] = text;
+        fields[2] = std::to_string(entry.count);
+    });
+}
+
+void Debugger::action_export_opcode_counts() {
+    auto counts = this->get_instance().get_opcode_counts();
+
+    // Only list opcodes that ran; $CB-prefixed ones come after the rest
+    auto rows = std::make_shared<std::vector<std::vector<std::string>>>();
+    auto add_rows = [&rows](const std::array<std::uint64_t, 256> &opcodes, bool prefixed) {
+        for(unsigned int opcode = 0; opcode < opcodes.size(); opcode++) {
+            if(opcodes[opcode] == 0) {
+                continue;
+            }
+
+            std::uint8_t bytes[3] = {};
+            bytes[0] = prefixed ? 0xCB : static_cast<std::uint8_t>(opcode);
+            bytes[1] = prefixed ? static_cast<std::uint8_t>(opcode) : 0;
+            SM83Instruction instruction;
+            decode_sm83_instruction(0, bytes, instruction);
+
+            char text[16];
+            std::snprintf(text, sizeof(text), prefixed ? "$cb%02x" : "$%02x", opcode);
+            rows->emplace_back(std::vector<std::string> { text, format_sm83_instruction(instruction), std::to_string(opcodes[opcode]) });
+        }
+    };
+    add_rows(counts.opcodes, false);
+    add_rows(counts.cb_opcodes, true);
+
+    export_table(this, { "opcode", "instruction", "count" }, rows->size(), [rows](std::uint64_t row, std::vector<std::string> &fields) {
+        fields = (*rows)[row];
+    });
+}
+
+void Debugger::drain_memory_access_log() {
+    auto &instance = this->get_instance();
+    if(instance.drain_memory_access_log(this->memory_access_drain) == 0) {
+        return;
+    }
+
+    auto keep = std::min(this->memory_access_drain.size(), MAX_MEMORY_ACCESS_LOG - this->memory_access_log.size());
+    this->memory_access_log.insert(this->memory_access_log.end(), this->memory_access_drain.begin(), this->memory_access_drain.begin() + keep);
+    this->memory_accesses_not_kept += this->memory_access_drain.size() - keep;
+    this->memory_access_drain.clear();
+
+    if(this->watchpoints_dialog->isVisible()) {
+        this->watchpoints_dialog->refresh_log();
+    }
+}
+
+void Debugger::open_trace(const std::filesystem::path &path) {
+    auto reader = std::make_shared<TraceFileReader>(path);
+    if(!reader->is_open()) {
+        QMessageBox(QMessageBox::Icon::Critical, "Failed to open trace", QString("Failed to open ") + path.string().c_str() + " as a trace file.").exec();
+        return;
+    }
+
+    // Instructions are decoded from the loaded ROM, so they'd be garbage if the trace came from a different one
+    auto rom_hash = reader->get_rom_hash();
+    if(rom_hash.has_value() && *rom_hash != this->get_instance().get_rom_hash()) {
+        QMessageBox qmb(QMessageBox::Icon::Warning, "Different ROM", "This trace was recorded with a different ROM than the one loaded, so the instructions shown may be wrong.\n\nOpen it anyway?", QMessageBox::Cancel | QMessageBox::Open, this);
+        qmb.setDefaultButton(QMessageBox::Cancel);
+        if(qmb.exec() != QMessageBox::Open) {
+            return;
+        }
+    }
+
+    // The viewer keeps the file mapped, so get rid of it when it's closed
+    auto *viewer = new TraceViewer(this, this, path, std::move(reader));
+    viewer->setAttribute(Qt::WA_DeleteOnClose);
+    viewer->show();
+}
+
+void Debugger::export_table(QWidget *parent, const std::vector<std::string> &header, std::uint64_t row_count, const std::function<void (std::uint64_t row, std::vector<std::string> &fields)> &get_row) {
+    QFileDialog file_dialog(parent);
+    file_dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+    file_dialog.setNameFilters(QStringList { "Comma-Separated Values (*.csv)", "Tab-Separated Values (*.tsv)" });
+    file_dialog.setWindowTitle("Export");
+    file_dialog.setDefaultSuffix(".csv");
+    file_dialog.setAcceptMode(QFileDialog::AcceptSave);
+    connect(&file_dialog, &QFileDialog::filterSelected, &file_dialog, [&file_dialog](const QString &filter) {
+        file_dialog.setDefaultSuffix(filter.contains("*.tsv") ? ".tsv" : ".csv");
+    });
+
+    if(file_dialog.exec() != QFileDialog::Accepted) {
+        return;
+    }
+
+    auto output = std::filesystem::path(file_dialog.selectedFiles()[0].toStdString());
+    char separator = (file_dialog.selectedNameFilter().contains("*.tsv") || output.extension() == ".tsv") ? '\t' : ',';
+
+    // Write it on a worker thread so a big table doesn't freeze everything
+    std::atomic<std::uint64_t> progress = 0;
+    std::atomic_bool cancel = false;
+    std::atomic_bool done = false;
+    bool success = false;
+
+    std::thread worker([&]() {
+        success = export_delimited_table(output, separator, header, row_count, get_row, progress, cancel);
+        done = true;
+    });
+
+    QProgressDialog progress_dialog("Exporting...", "Cancel", 0, 1000, parent);
+    progress_dialog.setWindowTitle("Export");
+    progress_dialog.setWindowModality(Qt::ApplicationModal);
+    progress_dialog.setAutoClose(false);
+    progress_dialog.setAutoReset(false);
+    progress_dialog.setMinimumDuration(500);
+
+    while(!done) {
+        progress_dialog.setValue(row_count == 0 ? 0 : static_cast<int>(progress * 1000 / row_count));
+        if(progress_dialog.wasCanceled()) {
+            cancel = true;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 16);
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+
+    worker.join();
+    progress_dialog.close();
+
+    if(!success && !cancel) {
+        QMessageBox(QMessageBox::Icon::Critical, "Failed to save", QString("Failed to write to ") + output.string().c_str() + ".").exec();
+    }
+}
+
 void Debugger::action_update_registers() noexcept {
     auto &instance = this->get_instance();
     
@@ -403,17 +780,33 @@ void Debugger::action_update_registers() noexcept {
     
     #undef PROCESS_REGISTER_FIELD
 
+    // What's being typed is what's shown now, so don't replace it while it's being typed
+    this->registers_copy = instance.get_registers();
+
     this->refresh_flags();
 }
 
+void Debugger::refresh_backtrace() {
+    // Only rebuild the table if the stack actually changed
+    auto &instance = this->get_instance();
+    auto backtrace_generation = instance.get_backtrace_generation();
+    if(backtrace_generation == this->backtrace_generation) {
+        return;
+    }
+    this->backtrace_generation = backtrace_generation;
+    this->backtrace_copy = instance.get_backtrace();
+    this->backtrace->set_backtrace(this->backtrace_copy);
+}
+
 void Debugger::closeEvent(QCloseEvent *) {
     this->disassembler->clear();
     this->backtrace->clear();
+    this->backtrace_generation = UINT64_MAX;
 }
 
 Debugger::~Debugger() {}
 
-void Debugger::format_table(QTableWidget *widget) {
+void Debugger::format_table(QTableView *widget) {
     widget->horizontalHeader()->setStretchLastSection(true);
     widget->horizontalHeader()->hide();
     widget->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
@@ -10,6 +10,8 @@ extern "C" {
 #include <vector>
 #include <optional>
 #include <chrono>
+#include <functional>
+#include <filesystem>
 
 #include "game_window.hpp"
 
@@ -17,6 +19,7 @@ class DebuggerDisassembler;
 class QLineEdit;
 class GameWindow;
 class QTableWidget;
+class QTableView;
 class QCheckBox;
 
 class Debugger : public QMainWindow {
@@ -44,7 +47,7 @@ public:
     }
     
     /** Format the table for use with the debugger */
-    void format_table(QTableWidget *widget);
+    void format_table(QTableView *widget);
     
     /** Get the font used for tables */
     const QFont &get_table_font() const noexcept {
@@ -52,21 +55,66 @@ public:
     }
     
     /** Get all breakpoints */
-    const std::vector<std::uint16_t> get_breakpoints() {
+    const std::vector<Breakpoint> &get_breakpoints() const noexcept {
         return this->breakpoints_copy;
     }
     
+    /** Get a number that changes whenever the breakpoints from get_breakpoints() change */
+    std::uint64_t get_breakpoint_generation() const noexcept {
+        return this->breakpoint_generation;
+    }
+    
+    /** Get whether or not an enabled breakpoint is at the address */
+    bool is_breakpoint_enabled(std::uint16_t address) const noexcept {
+        return this->enabled_breakpoints.test(address);
+    }
+    
     /** Refresh the information in view */
     void refresh_view();
+
+    /**
+     * Ask where to export a table to (CSV or TSV), then write it on a worker thread while showing progress
+     *
+     * @param parent    parent of the dialogs
+     * @param header    column names
+     * @param row_count number of rows
+     * @param get_row   function to set the fields of a row; this is called from the worker thread
+     */
+    static void export_table(QWidget *parent, const std::vector<std::string> &header, std::uint64_t row_count, const std::function<void (std::uint64_t row, std::vector<std::string> &fields)> &get_row);
+
+    /**
+     * Open a trace file in a new window
+     *
+     * @param path path to the trace file
+     */
+    void open_trace(const std::filesystem::path &path);
 private:
     DebuggerDisassembler *disassembler;
     
     class BacktraceTable;
     class BreakAndTraceResultsDialog;
+    class TraceViewer;
+    class WatchpointsDialog;
+    class ProfilerDialog;
     
     // Copy of breakpoints and backtrace
-    std::vector<std::pair<std::string, std::uint16_t>> backtrace_copy;
-    std::vector<std::uint16_t> breakpoints_copy;
+    std::vector<GameInstance::BacktraceFrame> backtrace_copy;
+    std::uint64_t backtrace_generation = UINT64_MAX;
+    std::vector<Breakpoint> breakpoints_copy;
+    BreakpointManager::Bitmap enabled_breakpoints;
+    std::uint64_t breakpoint_generation = UINT64_MAX;
+    
+    // Registers as of when the fields were last set, so only the ones that change are touched
+    std::optional<SM83ExpressionState> registers_copy;
+    
+    // Accesses logged by watchpoints; anything past the limit is counted instead of kept
+    static constexpr const std::size_t MAX_MEMORY_ACCESS_LOG = 4 * 1024 * 1024;
+    std::vector<MemoryAccess> memory_access_log;
+    std::vector<MemoryAccess> memory_access_drain;
+    std::uint64_t memory_accesses_not_kept = 0;
+    void drain_memory_access_log();
+    WatchpointsDialog *watchpoints_dialog;
+    ProfilerDialog *profiler_dialog;
     
     // Did we check if breakpoint
     bool known_breakpoint = false;
@@ -81,13 +129,27 @@ private:
     void action_step_over();
     void action_finish();
     void action_clear_breakpoints() noexcept;
+    void action_open_trace();
+    void action_show_watchpoints();
+    void action_toggle_coverage(bool enabled);
+    void action_clear_coverage();
+    void action_export_coverage();
+    void action_export_opcode_counts();
+    void action_show_profiler();
+    void action_add_watch();
+    void action_remove_watch();
     void action_update_registers() noexcept;
     void action_register_flag_state_changed(int) noexcept;
 
     void refresh_registers();
     void refresh_flags();
+    void refresh_watches();
+    void refresh_backtrace();
     
     QWidget *right_view;
+    QWidget *paused_view;
+    QTableWidget *watch_table;
+    QLineEdit *watch_input;
     
     QAction *break_button;
     QAction *continue_button;
@@ -95,6 +157,11 @@ private:
     QAction *step_over_button;
     QAction *finish_fn_button;
     QAction *clear_breakpoints_button;
+    QAction *open_trace_button;
+    QAction *watchpoints_button;
+    QAction *coverage_button;
+    QAction *collect_coverage_button;
+    QAction *profiler_button;
     
     QLineEdit *register_af, *register_bc, *register_de, *register_hl, *register_sp, *register_pc;
     QCheckBox *flag_carry, *flag_half_carry, *flag_subtract, *flag_zero;
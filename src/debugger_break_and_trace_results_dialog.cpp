@@ -7,8 +7,6 @@
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
 #include <QPushButton>
-#include <QFileDialog>
-#include <QMessageBox>
 
 Debugger::BreakAndTraceResultsDialog::BreakAndTraceResultsDialog(QWidget *parent, Debugger *window, ProcessedBNTResultNode::directory_t &&results) : QDialog(parent), window(window), results(results) {
     this->setWindowTitle("Break and Trace Results");
@@ -69,7 +67,7 @@ Debugger::BreakAndTraceResultsDialog::BreakAndTraceResultsDialog(QWidget *parent
     this->show_info_for_register(nullptr, nullptr);
     right_layout->addWidget(this->register_info);
 
-    auto *export_results_button = new QPushButton("Export to CSV...", right_widget);
+    auto *export_results_button = new QPushButton("Export...", right_widget);
     connect(export_results_button, &QPushButton::clicked, this, &BreakAndTraceResultsDialog::export_results);
     right_layout->addWidget(export_results_button);
     inner_layout->addWidget(right_widget);
@@ -126,58 +124,37 @@ void Debugger::BreakAndTraceResultsDialog::show_info_for_register(QTreeWidgetIte
 }
 
 void Debugger::BreakAndTraceResultsDialog::export_results() {
-    QFileDialog file_dialog;
-    file_dialog.setFileMode(QFileDialog::FileMode::AnyFile);
-    file_dialog.setNameFilters(QStringList { "Comma-Separated Values (*.csv)" });
-    file_dialog.setWindowTitle("Save a CSV");
-    file_dialog.setDefaultSuffix(".csv");
-    file_dialog.setAcceptMode(QFileDialog::AcceptSave);
-
-    if(file_dialog.exec() == QFileDialog::Accepted) {
-        auto output = std::filesystem::path(file_dialog.selectedFiles()[0].toStdString());
-
-        // Open for writing
-        FILE *f = std::fopen(output.string().c_str(), "w");
-        if(!f) {
-            QMessageBox(QMessageBox::Icon::Critical, "Failed to save", QString("Failed to open ") + output.string().c_str() + " for writing.").exec();
-            return;
+    // Flatten the tree first so the rows can be written in any order from the worker thread
+    std::vector<std::pair<int, const ProcessedBNTResult *>> rows;
+    auto flatten_directory = [&rows](const ProcessedBNTResultNode::directory_t &directory, int depth, auto &flatten_directory) -> void {
+        for(auto &d : directory) {
+            rows.emplace_back(depth, &d.result);
+            flatten_directory(d.children, depth + 1, flatten_directory);
         }
-
-        // Print the header
-        std::fprintf(f, "depth,instruction,af,bc,de,hl,sp,pc,carry,halfcarry,subtract,zero\n");
-
-        // Let's do this
-        auto export_directory = [&f](const ProcessedBNTResultNode::directory_t &directory, int depth, auto &export_directory) -> void {
-            auto directory_size = directory.size();
-            auto d = directory.begin();
-            for(std::size_t i = 0; i < directory_size; i++, d++) {
-                auto af = d->result.a << 8 | d->result.f;
-                auto bc = d->result.b << 8 | d->result.c;
-                auto de = d->result.d << 8 | d->result.e;
-                auto hl = d->result.h << 8 | d->result.l;
-
-                std::fprintf(f, "%i,\"%s\",$%04x,$%04x,$%04x,$%04x,$%04x,$%04x,%i,%i,%i,%i\n",
-                                depth,
-                                d->result.instruction.c_str(),
-                                af,
-                                bc,
-                                de,
-                                hl,
-                                d->result.sp,
-                                d->result.pc,
-                                (d->result.f & GB_CARRY_FLAG) != 0,
-                                (d->result.f & GB_HALF_CARRY_FLAG) != 0,
-                                (d->result.f & GB_SUBTRACT_FLAG) != 0,
-                                (d->result.f & GB_ZERO_FLAG) != 0);
-
-                if(!d->children.empty()) {
-                    export_directory(d->children, depth + 1, export_directory);
-                }
-            }
-        };
-        export_directory(this->results, 0, export_directory);
-
-        // Done!
-        std::fclose(f);
-    }
+    };
+    flatten_directory(this->results, 0, flatten_directory);
+
+    export_table(this, { "depth", "instruction", "af", "bc", "de", "hl", "sp", "pc", "carry", "halfcarry", "subtract", "zero" }, rows.size(),
+        [&rows](std::uint64_t row, std::vector<std::string> &fields) {
+            auto &[depth, result] = rows[row];
+
+            char text[16];
+            auto hex = [&text](unsigned int value) -> const char * {
+                std::snprintf(text, sizeof(text), "$%04x", value);
+                return text;
+            };
+
+            fields[0] = std::to_string(depth);
+            fields[1] = result->instruction;
+            fields[2] = hex(result->a << 8 | result->f);
+            fields[3] = hex(result->b << 8 | result->c);
+            fields[4] = hex(result->d << 8 | result->e);
+            fields[5] = hex(result->h << 8 | result->l);
+            fields[6] = hex(result->sp);
+            fields[7] = hex(result->pc);
+            fields[8] = (result->f & GB_CARRY_FLAG) ? "1" : "0";
+            fields[9] = (result->f & GB_HALF_CARRY_FLAG) ? "1" : "0";
+            fields[10] = (result->f & GB_SUBTRACT_FLAG) ? "1" : "0";
+            fields[11] = (result->f & GB_ZERO_FLAG) ? "1" : "0";
+        });
 }
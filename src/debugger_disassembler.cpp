@@ -14,11 +14,16 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QFileDialog>
+#include <QAbstractTableModel>
 
 #include "gb_proxy.h"
 #include "debugger_disassembler.hpp"
 #include "debugger.hpp"
 
+#include <cmath>
+#include <algorithm>
+
 static std::optional<std::uint16_t> evaluate_address_with_error_message(GameInstance &gb, const char *expression) {
     auto rval = gb.evaluate_expression(expression);
     if(!rval.has_value()) {
@@ -29,8 +34,131 @@ static std::optional<std::uint16_t> evaluate_address_with_error_message(GameInst
     return rval;
 }
 
-DebuggerDisassembler::DebuggerDisassembler(Debugger *parent) : QTableWidget(parent), debugger(parent) {
-    this->setColumnCount(1);
+class DebuggerDisassembler::Model : public QAbstractTableModel {
+public:
+    Model(DebuggerDisassembler *disassembler) : QAbstractTableModel(disassembler), disassembler(disassembler) {}
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : static_cast<int>(this->disassembler->disassembly.size());
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : 1;
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        if(!index.isValid()) {
+            return QVariant();
+        }
+
+        // If anything has a breakpoint set, highlight it; otherwise show how hot it is
+        auto row = static_cast<std::size_t>(index.row());
+        bool highlighted = this->highlighted[row];
+        std::uint8_t heat = row < this->heat.size() ? this->heat[row] : 0;
+        switch(role) {
+            case Qt::DisplayRole:
+                return this->disassembler->disassembly[row].raw_result;
+            case Qt::ForegroundRole:
+                return highlighted ? this->disassembler->text_highlight_color : this->disassembler->text_default_color;
+            case Qt::BackgroundRole:
+                if(highlighted) {
+                    return this->disassembler->bg_highlight_color;
+                }
+                return heat > 0 ? this->disassembler->bg_heat_colors[heat - 1] : this->disassembler->bg_default_color;
+            case Qt::ToolTipRole:
+                if(this->max_count > 0 && row < this->counts.size() && this->disassembler->disassembly[row].address.has_value()) {
+                    auto count = this->counts[row];
+                    return QString("Ran ") + QString::number(count) + (count == 1 ? " time" : " times");
+                }
+                return QVariant();
+            default:
+                return QVariant();
+        }
+    }
+
+    /** Set how many times each row ran and how hot each row is, only signaling the rows whose heat changed */
+    void update_heat(std::vector<std::uint32_t> &&counts, std::vector<std::uint8_t> &&heat, std::uint32_t max_count) {
+        int changed_start = -1;
+        int row_count = static_cast<int>(heat.size());
+        for(int row = 0; row <= row_count; row++) {
+            bool changed = row < row_count && (static_cast<std::size_t>(row) >= this->heat.size() || this->heat[row] != heat[row]);
+            if(changed && changed_start < 0) {
+                changed_start = row;
+            }
+            else if(!changed && changed_start >= 0) {
+                emit this->dataChanged(this->index(changed_start, 0), this->index(row - 1, 0));
+                changed_start = -1;
+            }
+        }
+
+        this->counts = std::move(counts);
+        this->heat = std::move(heat);
+        this->max_count = max_count;
+    }
+
+    /** Replace the rows, only signaling the ones that actually changed */
+    void update(std::vector<Disassembly> &&disassembly, std::vector<bool> &&highlighted) {
+        auto &rows = this->disassembler->disassembly;
+        int old_count = static_cast<int>(rows.size());
+        int new_count = static_cast<int>(disassembly.size());
+
+        if(new_count < old_count) {
+            this->beginRemoveRows(QModelIndex(), new_count, old_count - 1);
+            rows.resize(new_count);
+            this->highlighted.resize(new_count);
+            this->endRemoveRows();
+        }
+
+        // Group changed rows together so scrolling by one line doesn't send a signal for every row
+        int changed_start = -1;
+        int common = std::min(old_count, new_count);
+        for(int row = 0; row <= common; row++) {
+            bool changed = row < common && (rows[row].raw_result != disassembly[row].raw_result || this->highlighted[row] != highlighted[row]);
+            if(row < common) {
+                rows[row] = std::move(disassembly[row]);
+                this->highlighted[row] = highlighted[row];
+            }
+
+            if(changed && changed_start < 0) {
+                changed_start = row;
+            }
+            else if(!changed && changed_start >= 0) {
+                emit this->dataChanged(this->index(changed_start, 0), this->index(row - 1, 0));
+                changed_start = -1;
+            }
+        }
+
+        if(new_count > old_count) {
+            this->beginInsertRows(QModelIndex(), old_count, new_count - 1);
+            for(int row = old_count; row < new_count; row++) {
+                rows.emplace_back(std::move(disassembly[row]));
+                this->highlighted.emplace_back(highlighted[row]);
+            }
+            this->endInsertRows();
+        }
+    }
+
+    /** Remove every row */
+    void clear() {
+        this->beginResetModel();
+        this->disassembler->disassembly.clear();
+        this->highlighted.clear();
+        this->counts.clear();
+        this->heat.clear();
+        this->endResetModel();
+    }
+
+private:
+    DebuggerDisassembler *disassembler;
+    std::vector<bool> highlighted;
+    std::vector<std::uint32_t> counts;
+    std::vector<std::uint8_t> heat;
+    std::uint32_t max_count = 0;
+};
+
+DebuggerDisassembler::DebuggerDisassembler(Debugger *parent) : QTableView(parent), debugger(parent) {
+    this->model = new Model(this);
+    this->setModel(this->model);
     this->debugger->format_table(this);
     this->setSelectionMode(QAbstractItemView::NoSelection);
     this->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -45,6 +173,17 @@ DebuggerDisassembler::DebuggerDisassembler(Debugger *parent) : QTableWidget(pare
     this->text_highlight_color = palette.color(QPalette::ColorRole::HighlightedText);
     this->bg_highlight_color = palette.color(QPalette::ColorRole::Highlight);
 
+    // Fade from the background to red as code gets hotter
+    QColor hottest(255, 64, 0);
+    for(int level = 1; level <= HEAT_LEVELS; level++) {
+        double amount = 0.5 * level / HEAT_LEVELS;
+        this->bg_heat_colors[level - 1] = QColor::fromRgbF(
+            this->bg_default_color.redF() + (hottest.redF() - this->bg_default_color.redF()) * amount,
+            this->bg_default_color.greenF() + (hottest.greenF() - this->bg_default_color.greenF()) * amount,
+            this->bg_default_color.blueF() + (hottest.blueF() - this->bg_default_color.blueF()) * amount
+        );
+    }
+
     this->setMinimumHeight(400);
     this->setMinimumWidth(400);
 }
@@ -119,6 +258,31 @@ void DebuggerDisassembler::add_break_and_trace_breakpoint() {
     break_when_done->setMinimumHeight(amt->sizeHint().height());
     input_grid->addWidget(break_when_done, 3, 1);
 
+    // Leave this blank to keep the trace in memory
+    input_grid->addWidget(new QLabel("Save To:", input_grid_w), 4, 0);
+    auto *save_to_w = new QWidget(input_grid_w);
+    auto *save_to_l = new QHBoxLayout(save_to_w);
+    save_to_l->setContentsMargins(0,0,0,0);
+    auto *save_to = new QLineEdit(save_to_w);
+    save_to->setPlaceholderText("Keep in memory");
+    save_to_l->addWidget(save_to);
+    auto *save_to_browse = new QPushButton("Browse...", save_to_w);
+    save_to_l->addWidget(save_to_browse);
+    input_grid->addWidget(save_to_w, 4, 1);
+
+    connect(save_to_browse, &QPushButton::clicked, &dialog, [&dialog, save_to]() {
+        QFileDialog file_dialog(&dialog);
+        file_dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+        file_dialog.setNameFilters(QStringList { "Trace Files (*.sdxt)" });
+        file_dialog.setWindowTitle("Save Trace To");
+        file_dialog.setDefaultSuffix(".sdxt");
+        file_dialog.setAcceptMode(QFileDialog::AcceptSave);
+
+        if(file_dialog.exec() == QFileDialog::Accepted) {
+            save_to->setText(file_dialog.selectedFiles()[0]);
+        }
+    });
+
     layout->addWidget(input_grid_w);
 
     auto *ok_button_row = new QWidget(&dialog);
@@ -143,13 +307,24 @@ void DebuggerDisassembler::add_break_and_trace_breakpoint() {
     while(true) {
         if(dialog.exec() == QDialog::Accepted) {
             auto address_maybe = evaluate_address_with_error_message(this->debugger->get_instance(), address->text().toUtf8().data());
-            auto count_maybe = evaluate_address_with_error_message(this->debugger->get_instance(), amt->text().toUtf8().data());
+
+            // Traces saved to a file can be much longer than 16 bits, so take a plain number as-is
+            bool count_is_number = false;
+            std::optional<std::size_t> count_maybe = amt->text().toULongLong(&count_is_number);
+            if(!count_is_number) {
+                count_maybe = evaluate_address_with_error_message(this->debugger->get_instance(), amt->text().toUtf8().data());
+            }
 
             if(!address_maybe.has_value() || !count_maybe.has_value()) {
                 continue;
             }
 
-            this->debugger->get_instance().break_and_trace_at(*address_maybe, *count_maybe, step_over->isChecked(), break_when_done->isChecked());
+            std::optional<std::filesystem::path> trace_path;
+            if(!save_to->text().isEmpty()) {
+                trace_path = std::filesystem::path(save_to->text().toStdString());
+            }
+
+            this->debugger->get_instance().break_and_trace_at(*address_maybe, *count_maybe, step_over->isChecked(), break_when_done->isChecked(), trace_path);
         }
         break;
     }
@@ -159,6 +334,47 @@ void DebuggerDisassembler::delete_breakpoint() {
     this->debugger->get_instance().remove_breakpoint(*this->last_disassembly->address);
 }
 
+void DebuggerDisassembler::toggle_breakpoint_enabled() {
+    // Disable every breakpoint here if any are enabled; otherwise enable them all
+    auto address = *this->last_disassembly->address;
+    bool enable = !this->debugger->is_breakpoint_enabled(address);
+    for(auto &b : this->debugger->get_breakpoints()) {
+        if(b.address == address) {
+            this->debugger->get_instance().set_breakpoint_enabled(b.address, b.bank, enable);
+        }
+    }
+}
+
+void DebuggerDisassembler::set_breakpoint_condition() {
+    auto address = *this->last_disassembly->address;
+
+    // Start with the condition it already has, if any
+    QString condition;
+    for(auto &b : this->debugger->get_breakpoints()) {
+        if(b.address == address && b.bank == BREAKPOINT_ANY_BANK && b.condition != nullptr) {
+            condition = QString::fromStdString(b.condition->get_text());
+        }
+    }
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "Break at $%04x only when this is true (e.g. a == $3 && [hl] > 10), or leave blank to always break:", address);
+
+    QInputDialog dialog;
+    dialog.setLabelText(label);
+    dialog.setWindowTitle("Conditional Breakpoint");
+    dialog.setTextValue(condition);
+
+    // Keep asking until it compiles or the user gives up
+    while(dialog.exec() == QInputDialog::Accepted) {
+        std::string error;
+        if(this->debugger->get_instance().set_breakpoint_condition(address, BREAKPOINT_ANY_BANK, dialog.textValue().trimmed().toStdString(), error)) {
+            break;
+        }
+
+        QMessageBox(QMessageBox::Icon::Critical, "Invalid Expression", QString("The condition could not be compiled: ") + error.c_str(), QMessageBox::StandardButton::Ok).exec();
+    }
+}
+
 void DebuggerDisassembler::show_context_menu(const QPoint &point) {
     this->last_disassembly = std::nullopt;
     
@@ -177,10 +393,10 @@ void DebuggerDisassembler::show_context_menu(const QPoint &point) {
     }
     
     // Get the item at the point
-    auto *item = this->itemAt(point);
-    if(item) {
-        auto index = item->data(Qt::UserRole).toUInt();
-        if(index <= this->disassembly.size()) {
+    auto item = this->indexAt(point);
+    if(item.isValid()) {
+        auto index = static_cast<std::size_t>(item.row());
+        if(index < this->disassembly.size()) {
             this->last_disassembly = this->disassembly[index];
             
             // Add a follow option if possible
@@ -195,12 +411,33 @@ void DebuggerDisassembler::show_context_menu(const QPoint &point) {
             auto &address = this->last_disassembly->address;
             if(address.has_value()) {
                 char breakpoint_text[512];
-                bool create = !address_is_breakpoint(*address);
+
+                // Count hits across every bank's breakpoint here
+                bool create = true;
+                bool enabled = false;
+                std::uint64_t hits = 0;
+                for(auto &b : this->debugger->get_breakpoints()) {
+                    if(b.address == *address) {
+                        create = false;
+                        enabled = enabled || b.enabled;
+                        hits += b.hit_count;
+                    }
+                }
                 
                 std::snprintf(breakpoint_text, sizeof(breakpoint_text), "%s breakpoint at $%04X", create ? "Set" : "Unset", *address);
                 auto *set_breakpoint = menu.addAction(breakpoint_text);
                 connect(set_breakpoint, &QAction::triggered, this, create ? &DebuggerDisassembler::add_breakpoint : &DebuggerDisassembler::delete_breakpoint);
 
+                std::snprintf(breakpoint_text, sizeof(breakpoint_text), "Conditional breakpoint at $%04X...", *address);
+                auto *set_condition = menu.addAction(breakpoint_text);
+                connect(set_condition, &QAction::triggered, this, &DebuggerDisassembler::set_breakpoint_condition);
+
+                if(!create) {
+                    std::snprintf(breakpoint_text, sizeof(breakpoint_text), "%s breakpoint at $%04X (%llu hit%s)", enabled ? "Disable" : "Enable", *address, static_cast<unsigned long long>(hits), hits == 1 ? "" : "s");
+                    auto *toggle_breakpoint = menu.addAction(breakpoint_text);
+                    connect(toggle_breakpoint, &QAction::triggered, this, &DebuggerDisassembler::toggle_breakpoint_enabled);
+                }
+
                 if(create) {
                     std::snprintf(breakpoint_text, sizeof(breakpoint_text), "Break-and-trace at $%04X", *address);
                     auto *set_bnt_breakpoint = menu.addAction(breakpoint_text);
@@ -214,13 +451,7 @@ void DebuggerDisassembler::show_context_menu(const QPoint &point) {
 }
 
 bool DebuggerDisassembler::address_is_breakpoint(std::uint16_t address) {
-    for(auto &i : this->debugger->get_breakpoints()) {
-        if(i == address) {
-            return true;
-        }
-    }
-    
-    return false;
+    return this->debugger->is_breakpoint_enabled(address);
 }
 
 void DebuggerDisassembler::jump_to_address_window() {
@@ -289,22 +520,42 @@ void DebuggerDisassembler::keyPressEvent(QKeyEvent *event) {
 }
 
 void DebuggerDisassembler::refresh_view() {
-    // Clear the table if we changed addresses
-    if(this->current_address != this->last_address) {
-        this->last_address = this->current_address;
-    }
-    
     // Disassemble based on the number of rows that are visible (plus one in case there is a partial row on the bottom)
     auto query_rows = static_cast<std::uint8_t>(std::min(255, this->height() / this->debugger->get_table_font().pixelSize() + 1));
-    this->setRowCount(query_rows);
-    this->disassembly = this->disassemble_at_address(this->current_address, query_rows);
+
+    // Instructions are at most 3 bytes, so that's as far as we can show
+    auto &instance = this->debugger->get_instance();
+    std::size_t length = static_cast<std::size_t>(query_rows) * 3;
+    auto memory_generation = instance.get_memory_generation(this->current_address, length);
+    auto breakpoint_generation = this->debugger->get_breakpoint_generation();
+
+    // The PC only matters if it's in view, since that's the only place it's shown
+    std::optional<std::uint16_t> pc = instance.get_register_value(GameInstance::SM83Register::SM83_REG_PC);
+    if(static_cast<std::uint16_t>(*pc - this->current_address) >= length) {
+        pc = std::nullopt;
+    }
+
+    // Nothing changed, so only coverage needs to be looked at
+    if(!this->stale && this->current_address == this->last_address && query_rows == this->last_row_count && pc == this->last_pc && memory_generation == this->last_memory_generation && breakpoint_generation == this->last_breakpoint_generation) {
+        this->refresh_heat();
+        return;
+    }
+
+    this->stale = false;
+    this->last_address = this->current_address;
+    this->last_row_count = query_rows;
+    this->last_pc = pc;
+    this->last_memory_generation = memory_generation;
+    this->last_breakpoint_generation = breakpoint_generation;
+
+    auto disassembly = this->disassemble_at_address(this->current_address, query_rows);
     this->next_address_short = this->current_address;
     this->next_address_medium = this->current_address;
     this->next_address_far = this->current_address;
     
     // Calculate how far to scroll down if we scroll down
     int next_addresses_found = 0;
-    for(auto &i : this->disassembly) {
+    for(auto &i : disassembly) {
         if(i.address.has_value() && *i.address > this->current_address) {
             next_addresses_found++;
             
@@ -320,88 +571,90 @@ void DebuggerDisassembler::refresh_view() {
         }
     }
     
-    // If anything has a breakpoint set, highlight it
-    auto disassembly_count = this->disassembly.size();
-    for(std::size_t row = 0; row < disassembly_count && row < query_rows; row++) {
-        auto &d = this->disassembly[row];
-        bool is_breakpoint = d.address.has_value() ? this->address_is_breakpoint(*d.address) : false;
-        
-        auto *item = new QTableWidgetItem(d.raw_result);
-        item->setData(Qt::UserRole, static_cast<unsigned int>(row));
-        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
-        
-        if(is_breakpoint) {
-            item->setForeground(this->text_highlight_color);
-            item->setBackground(this->bg_highlight_color);
-        }
-        else {
-            item->setForeground(this->text_default_color);
-            item->setBackground(this->bg_default_color);
+    // Only show as many rows as fit
+    if(disassembly.size() > query_rows) {
+        disassembly.resize(query_rows);
+    }
+
+    std::vector<bool> highlighted(disassembly.size());
+    for(std::size_t row = 0; row < disassembly.size(); row++) {
+        auto &d = disassembly[row];
+        highlighted[row] = d.address.has_value() ? this->address_is_breakpoint(*d.address) : false;
+    }
+
+    this->model->update(std::move(disassembly), std::move(highlighted));
+    this->refresh_heat();
+}
+
+void DebuggerDisassembler::refresh_heat() {
+    std::vector<std::uint16_t> addresses;
+    addresses.reserve(this->disassembly.size());
+    for(auto &d : this->disassembly) {
+        addresses.emplace_back(d.address.value_or(0));
+    }
+
+    std::uint32_t max_count = 0;
+    auto counts = this->debugger->get_instance().get_coverage_counts(addresses, max_count);
+
+    // Use a log scale, since a hot loop can easily run millions of times more than the code around it
+    std::vector<std::uint8_t> heat(counts.size());
+    double max_log = std::log2(static_cast<double>(max_count) + 1.0);
+    for(std::size_t row = 0; row < counts.size(); row++) {
+        if(counts[row] == 0 || !this->disassembly[row].address.has_value()) {
+            continue;
         }
-        
-        this->setItem(row, 0, item);
+        auto level = static_cast<int>(std::ceil(std::log2(static_cast<double>(counts[row]) + 1.0) / max_log * HEAT_LEVELS));
+        heat[row] = static_cast<std::uint8_t>(std::clamp(level, 1, HEAT_LEVELS));
     }
+
+    this->model->update_heat(std::move(counts), std::move(heat), max_count);
+}
+
+void DebuggerDisassembler::clear() {
+    this->model->clear();
+    this->stale = true;
 }
 
 std::vector<DebuggerDisassembler::Disassembly> DebuggerDisassembler::disassemble_at_address(std::uint16_t address, std::uint8_t count) {
-    // Tell sameboy to disassemble at the address and capture its output.
-    // Doing it this way is horrible. Let's do it anyway.
-    QStringList lines;
-    
-    lines = QString::fromStdString(this->debugger->get_instance().disassemble_address(address, count)).split("\n");
-    
+    auto &instance = this->debugger->get_instance();
+    auto pc = instance.get_register_value(GameInstance::SM83Register::SM83_REG_PC);
+    auto decoded = instance.disassemble_instructions(address, count);
+
     std::vector<Disassembly> returned_instructions;
-    for(auto &l : lines) {
-        int colon_offset = l.indexOf(':');
-        if(colon_offset == -1) {
-            continue;
+    returned_instructions.reserve(decoded.size() * 2);
+
+    for(auto &d : decoded) {
+        // Put symbols on their own line above the instruction
+        if(!d.symbol.empty()) {
+            auto &marker = returned_instructions.emplace_back();
+            marker.is_marker = true;
+            marker.current_location = false;
+            marker.instruction = QString::fromStdString(d.symbol);
+            marker.raw_result = marker.instruction + ":";
         }
-        
+
         auto &instruction = returned_instructions.emplace_back();
-        
-        if(l[0] == ' ') {
-            instruction.address = l.mid(4, 4).toUInt(nullptr, 16);
-            instruction.current_location = l[0] == '-';
-            
-            int semicolon_offset = l.indexOf(';', 8);
-            if(semicolon_offset >= 0) {
-                instruction.comment = l.mid(semicolon_offset).trimmed();
-                instruction.instruction = l.mid(colon_offset + 1, semicolon_offset - colon_offset - 1).trimmed();
-            }
-            else {
-                instruction.instruction = l.mid(colon_offset + 1).trimmed();
-            }
-            
-            // Handle following
-            auto add_follow = [&instruction](const QString &prefix, bool use_after_comma) {
-                auto &instruction_str = instruction.instruction;
-                if(instruction_str.startsWith(prefix)) {
-                    int start = prefix.length();
-                    int ending = instruction_str.indexOf(',');
-                    if(ending != -1) {
-                        if(use_after_comma) {
-                            start = ending + 1;
-                            ending = -1;
-                        }
-                        else {
-                            ending = instruction_str.length() - ending - prefix.length();
-                        }
-                    }
-                    instruction.follow_address = instruction.instruction.mid(start, ending).trimmed();
-                    return true;
-                }
-                return false;
-            };
-            
-            add_follow("CALL ", true) || add_follow("RST ", false) || add_follow("JP ", true) || add_follow("JR ", true);
+        instruction.address = d.address;
+        instruction.current_location = d.address == pc;
+        instruction.is_marker = false;
+        instruction.instruction = QString::fromStdString(format_sm83_instruction(d));
+
+        if(d.target.has_value()) {
+            char follow[6];
+            std::snprintf(follow, sizeof(follow), "$%04x", *d.target);
+            instruction.follow_address = follow;
+        }
+        if(!d.target_symbol.empty()) {
+            instruction.comment = QString("; ") + QString::fromStdString(d.target_symbol);
         }
-        else {
-            instruction.is_marker = true;
-            instruction.instruction = l.mid(0, colon_offset);
+
+        char prefix[16];
+        std::snprintf(prefix, sizeof(prefix), "%s%04x: ", instruction.current_location ? "  ->" : "    ", d.address);
+        instruction.raw_result = QString(prefix) + instruction.instruction;
+        if(!instruction.comment.isEmpty()) {
+            instruction.raw_result += " " + instruction.comment;
         }
-        
-        instruction.raw_result = l;
     }
-    
+
     return returned_instructions;
 }
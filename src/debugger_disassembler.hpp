@@ -1,12 +1,12 @@
 #ifndef DEBUGGER_DISASSEMBLER_HPP
 #define DEBUGGER_DISASSEMBLER_HPP
 
-#include <QTableWidget>
+#include <QTableView>
 #include <optional>
 
 class Debugger;
 
-class DebuggerDisassembler : public QTableWidget {
+class DebuggerDisassembler : public QTableView {
     Q_OBJECT
 public:
     DebuggerDisassembler(Debugger *parent);
@@ -14,7 +14,7 @@ public:
     
     // Used for navigation
     
-    // If last_address is not equal to current_address, clear the table when refresh_view() is called
+    // If last_address is not equal to current_address, disassemble again when refresh_view() is called
     std::uint16_t last_address = 0;
     
     // Address to inspect
@@ -47,7 +47,10 @@ public:
     void add_breakpoint();
     void add_break_and_trace_breakpoint();
     void delete_breakpoint();
+    void toggle_breakpoint_enabled();
+    void set_breakpoint_condition();
     void refresh_view();
+    void clear();
     bool address_is_breakpoint(std::uint16_t address);
     void set_address_to_current_breakpoint();
     
@@ -62,8 +65,24 @@ public:
     QColor bg_default_color;
     QColor bg_highlight_color;
     
+    // Backgrounds for code that ran, from coldest to hottest
+    static constexpr const int HEAT_LEVELS = 8;
+    QColor bg_heat_colors[HEAT_LEVELS];
+    
 private:
+    class Model;
+    Model *model;
     Debugger *debugger;
+
+    // What the disassembly was made from; it's only made again if one of these changes
+    bool stale = true;
+    std::uint8_t last_row_count = 0;
+    std::optional<std::uint16_t> last_pc;
+    std::uint64_t last_memory_generation = 0;
+    std::uint64_t last_breakpoint_generation = 0;
+
+    // Shade rows by how many times they ran
+    void refresh_heat();
 };
 
 #endif
@@ -0,0 +1,207 @@
+#include "debugger_profiler_dialog.hpp"
+#include "debugger_disassembler.hpp"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QScrollBar>
+#include <QFileDialog>
+#include <QMessageBox>
+
+static QString format_percent(std::uint64_t samples, std::uint64_t total) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.2f%%", total == 0 ? 0.0 : 100.0 * samples / total);
+    return text;
+}
+
+Debugger::ProfilerDialog::ProfilerDialog(Debugger *window) : QDialog(window), window(window) {
+    this->setWindowTitle("Profiler");
+
+    auto *layout = new QVBoxLayout(this);
+
+    // Controls for sampling
+    auto *control_row = new QWidget(this);
+    auto *control_row_l = new QHBoxLayout(control_row);
+    control_row_l->setContentsMargins(0,0,0,0);
+    control_row_l->addWidget(new QLabel("Sample every:", control_row));
+    this->interval_input = new QLineEdit(control_row);
+    this->interval_input->setFont(window->get_table_font());
+    this->interval_input->setText("4096");
+    this->interval_input->setToolTip("Cycles between samples, in 8 MiHz ticks (about 2000 samples per second at 4096)");
+    control_row_l->addWidget(this->interval_input);
+    control_row_l->addWidget(new QLabel("cycles", control_row));
+    this->start_button = new QPushButton("Start", control_row);
+    connect(this->start_button, &QPushButton::clicked, this, &ProfilerDialog::toggle_profiling);
+    control_row_l->addWidget(this->start_button);
+    layout->addWidget(control_row);
+
+    this->summary = new QLabel(this);
+    layout->addWidget(this->summary);
+
+    // Flat report, hottest first
+    auto *tabs = new QTabWidget(this);
+    this->function_table = new QTableWidget(tabs);
+    window->format_table(this->function_table);
+    this->function_table->setColumnCount(5);
+    this->function_table->setHorizontalHeaderLabels(QStringList { "Function", "Self", "Self %", "Total", "Total %" });
+    this->function_table->horizontalHeader()->show();
+    this->function_table->horizontalHeader()->setStretchLastSection(false);
+    this->function_table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    this->function_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    this->function_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    this->function_table->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    this->function_table->verticalScrollBar()->show();
+    connect(this->function_table, &QTableWidget::cellDoubleClicked, this, &ProfilerDialog::double_clicked_function);
+    tabs->addTab(this->function_table, "Functions");
+
+    // Hierarchical report
+    this->call_tree = new QTreeWidget(tabs);
+    this->call_tree->setFont(window->get_table_font());
+    this->call_tree->setColumnCount(4);
+    this->call_tree->setHeaderLabels(QStringList { "Function", "Self", "Total", "Total %" });
+    this->call_tree->header()->setStretchLastSection(false);
+    this->call_tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    tabs->addTab(this->call_tree, "Call Tree");
+
+    tabs->setMinimumWidth(600);
+    tabs->setMinimumHeight(400);
+    layout->addWidget(tabs);
+
+    auto *button_row = new QWidget(this);
+    auto *button_row_l = new QHBoxLayout(button_row);
+    button_row_l->setContentsMargins(0,0,0,0);
+    button_row_l->addStretch(1);
+    auto *refresh_button = new QPushButton("Refresh", button_row);
+    connect(refresh_button, &QPushButton::clicked, this, &ProfilerDialog::refresh_report);
+    button_row_l->addWidget(refresh_button);
+    auto *clear_button = new QPushButton("Clear", button_row);
+    connect(clear_button, &QPushButton::clicked, this, &ProfilerDialog::clear_profile);
+    button_row_l->addWidget(clear_button);
+    auto *export_button = new QPushButton("Export...", button_row);
+    connect(export_button, &QPushButton::clicked, this, &ProfilerDialog::export_profile);
+    button_row_l->addWidget(export_button);
+    layout->addWidget(button_row);
+
+    this->setLayout(layout);
+}
+
+void Debugger::ProfilerDialog::refresh_summary() {
+    auto &instance = this->window->get_instance();
+    this->start_button->setText(instance.is_profiling() ? "Stop" : "Start");
+
+    std::uint64_t dropped;
+    auto samples = instance.get_profile_sample_count(dropped);
+
+    char text[256];
+    std::snprintf(text, sizeof(text), "%llu samples (%llu dropped)", static_cast<unsigned long long>(samples), static_cast<unsigned long long>(dropped));
+    this->summary->setText(text);
+}
+
+void Debugger::ProfilerDialog::refresh_report() {
+    auto report = this->window->get_instance().get_profile_report();
+    auto total = report.sample_count;
+
+    this->function_table->setRowCount(report.functions.size());
+    int row = 0;
+    for(auto &f : report.functions) {
+        this->function_table->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(f.name)));
+        this->function_table->setItem(row, 1, new QTableWidgetItem(QString::number(f.self_samples)));
+        this->function_table->setItem(row, 2, new QTableWidgetItem(format_percent(f.self_samples, total)));
+        this->function_table->setItem(row, 3, new QTableWidgetItem(QString::number(f.total_samples)));
+        this->function_table->setItem(row, 4, new QTableWidgetItem(format_percent(f.total_samples, total)));
+        row++;
+    }
+
+    // Build the tree from the top down, expanding the hottest path so it's visible right away
+    this->call_tree->clear();
+    std::vector<std::pair<std::size_t, QTreeWidgetItem *>> pending;
+    for(auto child : report.nodes[0].children) {
+        pending.emplace_back(child, nullptr);
+    }
+    while(!pending.empty()) {
+        auto [index, parent] = pending.back();
+        pending.pop_back();
+
+        auto &node = report.nodes[index];
+        auto *item = parent == nullptr ? new QTreeWidgetItem(this->call_tree) : new QTreeWidgetItem(parent);
+        item->setText(0, QString::fromStdString(node.name));
+        item->setText(1, QString::number(node.self_samples));
+        item->setText(2, QString::number(node.total_samples));
+        item->setText(3, format_percent(node.total_samples, total));
+
+        auto *first_sibling = parent == nullptr ? this->call_tree->topLevelItem(0) : parent->child(0);
+        item->setExpanded(item == first_sibling && (parent == nullptr || parent->isExpanded()));
+
+        // Children are hottest first, so push them in reverse to add them in order
+        for(auto c = node.children.rbegin(); c != node.children.rend(); c++) {
+            pending.emplace_back(*c, item);
+        }
+    }
+
+    this->refresh_summary();
+}
+
+void Debugger::ProfilerDialog::toggle_profiling() {
+    auto &instance = this->window->get_instance();
+    if(instance.is_profiling()) {
+        instance.stop_profiler();
+        this->refresh_report();
+        return;
+    }
+
+    bool ok = false;
+    auto interval = this->interval_input->text().trimmed().toUInt(&ok);
+    if(!ok || interval == 0) {
+        QMessageBox(QMessageBox::Icon::Critical, "Invalid Interval", "The interval needs to be a positive number of cycles.", QMessageBox::StandardButton::Ok).exec();
+        return;
+    }
+
+    instance.start_profiler(interval);
+    this->refresh_summary();
+}
+
+void Debugger::ProfilerDialog::clear_profile() {
+    this->window->get_instance().clear_profile();
+    this->refresh_report();
+}
+
+void Debugger::ProfilerDialog::export_profile() {
+    QFileDialog file_dialog(this);
+    file_dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+    file_dialog.setNameFilters(QStringList { "Collapsed Stacks (*.folded)", "Text Files (*.txt)" });
+    file_dialog.setWindowTitle("Export Profile");
+    file_dialog.setDefaultSuffix(".folded");
+    file_dialog.setAcceptMode(QFileDialog::AcceptSave);
+
+    if(file_dialog.exec() != QFileDialog::Accepted) {
+        return;
+    }
+
+    if(!this->window->get_instance().export_profile(std::filesystem::path(file_dialog.selectedFiles()[0].toStdString()))) {
+        QMessageBox(QMessageBox::Icon::Critical, "Export Failed", "The profile could not be written.", QMessageBox::StandardButton::Ok).exec();
+    }
+}
+
+void Debugger::ProfilerDialog::double_clicked_function(int row, int) {
+    auto *item = this->function_table->item(row, 0);
+    if(item == nullptr) {
+        return;
+    }
+
+    // Functions without symbols are named by their bank and address, so only go to the address part
+    auto name = item->text();
+    if(name.startsWith('$') && name.contains(':')) {
+        name = "$" + name.mid(name.indexOf(':') + 1);
+    }
+
+    auto address = this->window->get_instance().evaluate_expression(name.toUtf8().data());
+    if(address.has_value()) {
+        this->window->disassembler->go_to(*address);
+    }
+}
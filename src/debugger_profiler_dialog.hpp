@@ -0,0 +1,37 @@
+#ifndef DEBUGGER_PROFILER_DIALOG_HPP
+#define DEBUGGER_PROFILER_DIALOG_HPP
+
+#include <QDialog>
+
+#include "debugger.hpp"
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+class Debugger::ProfilerDialog : public QDialog {
+public:
+    ProfilerDialog(Debugger *window);
+
+    /** Show how many samples were taken so far */
+    void refresh_summary();
+
+    /** Show where the CPU spent its time */
+    void refresh_report();
+
+private:
+    QLineEdit *interval_input;
+    QPushButton *start_button;
+    QLabel *summary;
+    QTableWidget *function_table;
+    QTreeWidget *call_tree;
+    Debugger *window;
+
+    void toggle_profiling();
+    void clear_profile();
+    void export_profile();
+    void double_clicked_function(int row, int column);
+};
+
+#endif
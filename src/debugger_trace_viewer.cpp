@@ -0,0 +1,241 @@
+#include "debugger_trace_viewer.hpp"
+#include "debugger_disassembler.hpp"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableView>
+#include <QHeaderView>
+#include <QAbstractTableModel>
+
+#include <climits>
+#include <cstring>
+
+static std::uint64_t instruction_key(const TraceRecord &record) noexcept {
+    return (static_cast<std::uint64_t>(record.flags & TRACE_RECORD_BOOT_ROM) << 32) | (static_cast<std::uint64_t>(record.bank) << 16) | record.pc;
+}
+
+static std::uint32_t symbol_key(const TraceRecord &record) noexcept {
+    return (static_cast<std::uint32_t>(record.bank) << 16) | record.pc;
+}
+
+static void format_flags(std::uint8_t f, char (&flags)[5]) noexcept {
+    std::snprintf(flags, sizeof(flags), "%c%c%c%c",
+                  (f & GB_CARRY_FLAG) ? 'C' : '_',
+                  (f & GB_HALF_CARRY_FLAG) ? 'H' : '_',
+                  (f & GB_SUBTRACT_FLAG) ? 'N' : '_',
+                  (f & GB_ZERO_FLAG) ? 'Z' : '_');
+}
+
+class Debugger::TraceViewer::Model : public QAbstractTableModel {
+public:
+    enum Column {
+        COLUMN_INDEX,
+        COLUMN_CYCLE,
+        COLUMN_ADDRESS,
+        COLUMN_INSTRUCTION,
+        COLUMN_AF,
+        COLUMN_BC,
+        COLUMN_DE,
+        COLUMN_HL,
+        COLUMN_SP,
+        COLUMN_FLAGS,
+        COLUMN_SYMBOL,
+
+        COLUMN_COUNT
+    };
+
+    Model(TraceViewer *viewer) : QAbstractTableModel(viewer), viewer(viewer) {}
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        // Qt can't show more rows than fit in an int; the rest can still be exported
+        return parent.isValid() ? 0 : static_cast<int>(std::min<std::uint64_t>(this->viewer->reader->size(), INT_MAX));
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : COLUMN_COUNT;
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override {
+        if(orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+            return QVariant();
+        }
+
+        static const char *const NAMES[COLUMN_COUNT] = { "#", "Cycle", "Address", "Instruction", "AF", "BC", "DE", "HL", "SP", "Flags", "Symbol" };
+        return section >= 0 && section < COLUMN_COUNT ? NAMES[section] : QVariant();
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        if(!index.isValid() || role != Qt::DisplayRole) {
+            return QVariant();
+        }
+
+        // Only the rows in view get read from the file
+        auto record = this->viewer->reader->get(index.row());
+        char text[64];
+
+        switch(index.column()) {
+            case COLUMN_INDEX:
+                return QString::number(index.row());
+            case COLUMN_CYCLE:
+                return QString::number(record.cycle);
+            case COLUMN_ADDRESS:
+                std::snprintf(text, sizeof(text), "%02x:%04x", record.bank, record.pc);
+                return text;
+            case COLUMN_INSTRUCTION:
+                return QString::fromStdString(this->viewer->instruction_for(record));
+            case COLUMN_AF:
+                std::snprintf(text, sizeof(text), "$%04x", record.a << 8 | record.f);
+                return text;
+            case COLUMN_BC:
+                std::snprintf(text, sizeof(text), "$%04x", record.b << 8 | record.c);
+                return text;
+            case COLUMN_DE:
+                std::snprintf(text, sizeof(text), "$%04x", record.d << 8 | record.e);
+                return text;
+            case COLUMN_HL:
+                std::snprintf(text, sizeof(text), "$%04x", record.h << 8 | record.l);
+                return text;
+            case COLUMN_SP:
+                std::snprintf(text, sizeof(text), "$%04x", record.sp);
+                return text;
+            case COLUMN_FLAGS: {
+                char flags[5];
+                format_flags(record.f, flags);
+                return flags;
+            }
+            case COLUMN_SYMBOL: {
+                auto s = this->viewer->symbols->find(symbol_key(record));
+                return s == this->viewer->symbols->end() ? QString() : QString::fromStdString(s->second);
+            }
+            default:
+                return QVariant();
+        }
+    }
+
+private:
+    TraceViewer *viewer;
+};
+
+Debugger::TraceViewer::TraceViewer(QWidget *parent, Debugger *window, const std::filesystem::path &path, std::shared_ptr<TraceFileReader> reader) : QDialog(parent), reader(std::move(reader)), window(window) {
+    this->setWindowTitle(QString("Trace - ") + path.filename().string().c_str());
+
+    // Index the symbol names so we don't have to search for them
+    auto symbols = std::make_shared<std::unordered_map<std::uint32_t, std::string>>();
+    for(auto &i : this->reader->get_index()) {
+        if(!i.name.empty()) {
+            (*symbols)[(static_cast<std::uint32_t>(i.bank) << 16) | i.address] = i.name;
+        }
+    }
+    this->symbols = std::move(symbols);
+
+    auto *layout = new QVBoxLayout(this);
+
+    // Summarize what's in the file
+    char summary[256];
+    if(this->reader->get_index().empty()) {
+        std::snprintf(summary, sizeof(summary), "%llu instructions (trace was not finished)", static_cast<unsigned long long>(this->reader->size()));
+    }
+    else {
+        std::snprintf(summary, sizeof(summary), "%llu instructions at %zu addresses", static_cast<unsigned long long>(this->reader->size()), this->reader->get_index().size());
+    }
+    if(this->reader->get_records_dropped() > 0) {
+        auto length = std::strlen(summary);
+        std::snprintf(summary + length, sizeof(summary) - length, " - %llu dropped because the disk couldn't keep up", static_cast<unsigned long long>(this->reader->get_records_dropped()));
+    }
+    layout->addWidget(new QLabel(summary, this));
+
+    // Make the table
+    this->model = new Model(this);
+    this->table_view = new QTableView(this);
+    this->table_view->setModel(this->model);
+    this->table_view->setFont(window->get_table_font());
+    this->table_view->setAlternatingRowColors(true);
+    this->table_view->setShowGrid(false);
+    this->table_view->setWordWrap(false);
+    this->table_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    this->table_view->setSelectionMode(QAbstractItemView::SingleSelection);
+    this->table_view->verticalHeader()->hide();
+    this->table_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    this->table_view->verticalHeader()->setDefaultSectionSize(window->get_table_font().pixelSize() + 4);
+    this->table_view->horizontalHeader()->setStretchLastSection(true);
+    this->table_view->setMinimumWidth(900);
+    this->table_view->setMinimumHeight(400);
+    connect(this->table_view, &QTableView::doubleClicked, this, &TraceViewer::double_clicked_item);
+    layout->addWidget(this->table_view);
+
+    // Add the export button
+    auto *button_row = new QWidget(this);
+    auto *button_row_l = new QHBoxLayout(button_row);
+    button_row_l->setContentsMargins(0,0,0,0);
+    button_row_l->addStretch(1);
+    auto *export_button = new QPushButton("Export...", button_row);
+    connect(export_button, &QPushButton::clicked, this, &TraceViewer::export_trace);
+    button_row_l->addWidget(export_button);
+    layout->addWidget(button_row);
+
+    this->setLayout(layout);
+}
+
+Debugger::TraceViewer::~TraceViewer() {}
+
+const std::string &Debugger::TraceViewer::instruction_for(const TraceRecord &record) {
+    auto key = instruction_key(record);
+    auto i = this->instructions.find(key);
+    if(i == this->instructions.end()) {
+        auto decoded = this->window->get_instance().decode_trace({ record });
+        i = this->instructions.emplace(key, format_sm83_instruction(decoded[0])).first;
+    }
+    return i->second;
+}
+
+void Debugger::TraceViewer::double_clicked_item(const QModelIndex &index) {
+    if(index.isValid()) {
+        this->window->disassembler->go_to(this->reader->get(index.row()).pc);
+    }
+}
+
+void Debugger::TraceViewer::export_trace() {
+    // The worker gets its own copies of everything so it doesn't touch anything the UI thread uses (the instance locks itself)
+    auto reader = this->reader;
+    auto symbols = this->symbols;
+    auto *instance = &this->window->get_instance();
+    std::unordered_map<std::uint64_t, std::string> instructions;
+
+    export_table(this, { "index", "cycle", "bank", "pc", "instruction", "af", "bc", "de", "hl", "sp", "carry", "halfcarry", "subtract", "zero", "stepover", "symbol" }, reader->size(),
+        [reader, symbols, instance, instructions](std::uint64_t row, std::vector<std::string> &fields) mutable {
+            auto record = reader->get(row);
+
+            auto key = instruction_key(record);
+            auto i = instructions.find(key);
+            if(i == instructions.end()) {
+                i = instructions.emplace(key, format_sm83_instruction(instance->decode_trace({ record })[0])).first;
+            }
+
+            auto s = symbols->find(symbol_key(record));
+
+            char text[16];
+            auto hex = [&text](unsigned int value) -> const char * {
+                std::snprintf(text, sizeof(text), "$%04x", value);
+                return text;
+            };
+
+            fields[0] = std::to_string(row);
+            fields[1] = std::to_string(record.cycle);
+            fields[2] = std::to_string(record.bank);
+            fields[3] = hex(record.pc);
+            fields[4] = i->second;
+            fields[5] = hex(record.a << 8 | record.f);
+            fields[6] = hex(record.b << 8 | record.c);
+            fields[7] = hex(record.d << 8 | record.e);
+            fields[8] = hex(record.h << 8 | record.l);
+            fields[9] = hex(record.sp);
+            fields[10] = (record.f & GB_CARRY_FLAG) ? "1" : "0";
+            fields[11] = (record.f & GB_HALF_CARRY_FLAG) ? "1" : "0";
+            fields[12] = (record.f & GB_SUBTRACT_FLAG) ? "1" : "0";
+            fields[13] = (record.f & GB_ZERO_FLAG) ? "1" : "0";
+            fields[14] = (record.flags & TRACE_RECORD_STEP_OVER) ? "1" : "0";
+            fields[15] = s == symbols->end() ? std::string() : s->second;
+        });
+}
@@ -0,0 +1,40 @@
+#ifndef DEBUGGER_TRACE_VIEWER_HPP
+#define DEBUGGER_TRACE_VIEWER_HPP
+
+#include <QDialog>
+
+#include <memory>
+#include <unordered_map>
+
+#include "debugger.hpp"
+#include "trace_file.hpp"
+
+class QTableView;
+
+class Debugger::TraceViewer : public QDialog {
+public:
+    TraceViewer(QWidget *parent, Debugger *window, const std::filesystem::path &path, std::shared_ptr<TraceFileReader> reader);
+    ~TraceViewer() override;
+
+private:
+    class Model;
+
+    // Shared with the export thread
+    std::shared_ptr<TraceFileReader> reader;
+
+    // Symbol names from the file's index, by bank and address
+    std::shared_ptr<const std::unordered_map<std::uint32_t, std::string>> symbols;
+
+    // Decoded instructions, by boot ROM flag, bank, and address
+    std::unordered_map<std::uint64_t, std::string> instructions;
+
+    Model *model;
+    QTableView *table_view;
+    Debugger *window;
+
+    const std::string &instruction_for(const TraceRecord &record);
+    void double_clicked_item(const QModelIndex &index);
+    void export_trace();
+};
+
+#endif
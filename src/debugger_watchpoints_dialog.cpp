@@ -0,0 +1,310 @@
+#include "debugger_watchpoints_dialog.hpp"
+#include "debugger_disassembler.hpp"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QTableView>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QScrollBar>
+#include <QMessageBox>
+#include <QAbstractTableModel>
+
+#include <memory>
+
+static const char *access_type_name(std::uint8_t type) noexcept {
+    return type == WATCHPOINT_WRITE ? "Write" : "Read";
+}
+
+class Debugger::WatchpointsDialog::Model : public QAbstractTableModel {
+public:
+    enum Column {
+        COLUMN_INDEX,
+        COLUMN_CYCLE,
+        COLUMN_PC,
+        COLUMN_ACCESS,
+        COLUMN_ADDRESS,
+        COLUMN_VALUE,
+
+        COLUMN_COUNT
+    };
+
+    Model(WatchpointsDialog *dialog, Debugger *window) : QAbstractTableModel(dialog), window(window) {}
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : this->shown_rows;
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : COLUMN_COUNT;
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override {
+        if(orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+            return QVariant();
+        }
+
+        static const char *const NAMES[COLUMN_COUNT] = { "#", "Cycle", "PC", "Access", "Address", "Value" };
+        return section >= 0 && section < COLUMN_COUNT ? NAMES[section] : QVariant();
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        if(!index.isValid() || role != Qt::DisplayRole) {
+            return QVariant();
+        }
+
+        auto &access = this->window->memory_access_log[index.row()];
+        char text[16];
+
+        switch(index.column()) {
+            case COLUMN_INDEX:
+                return QString::number(index.row());
+            case COLUMN_CYCLE:
+                return QString::number(access.cycle);
+            case COLUMN_PC:
+                std::snprintf(text, sizeof(text), "$%04x", access.pc);
+                return text;
+            case COLUMN_ACCESS:
+                return access_type_name(access.type);
+            case COLUMN_ADDRESS:
+                std::snprintf(text, sizeof(text), "$%04x", access.address);
+                return text;
+            case COLUMN_VALUE:
+                std::snprintf(text, sizeof(text), "$%02x", access.value);
+                return text;
+            default:
+                return QVariant();
+        }
+    }
+
+    /** Add rows for anything appended to the log */
+    void update_rows() {
+        int rows = static_cast<int>(this->window->memory_access_log.size());
+        if(rows > this->shown_rows) {
+            this->beginInsertRows(QModelIndex(), this->shown_rows, rows - 1);
+            this->shown_rows = rows;
+            this->endInsertRows();
+        }
+    }
+
+    /** Clear the log */
+    void clear() {
+        this->beginResetModel();
+        this->window->memory_access_log.clear();
+        this->window->memory_access_log.shrink_to_fit();
+        this->window->memory_accesses_not_kept = 0;
+        this->shown_rows = 0;
+        this->endResetModel();
+    }
+
+private:
+    Debugger *window;
+    int shown_rows = 0;
+};
+
+Debugger::WatchpointsDialog::WatchpointsDialog(Debugger *window) : QDialog(window), window(window) {
+    this->setWindowTitle("Watchpoints");
+
+    auto *layout = new QVBoxLayout(this);
+
+    // List the watchpoints
+    this->watchpoint_table = new QTableWidget(this);
+    window->format_table(this->watchpoint_table);
+    this->watchpoint_table->setColumnCount(3);
+    this->watchpoint_table->setColumnWidth(0, 160);
+    this->watchpoint_table->setColumnWidth(1, 120);
+    this->watchpoint_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    this->watchpoint_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    this->watchpoint_table->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    this->watchpoint_table->verticalScrollBar()->show();
+    this->watchpoint_table->setMinimumHeight(100);
+    layout->addWidget(this->watchpoint_table);
+
+    // Controls for adding them
+    auto *add_row = new QWidget(this);
+    auto *add_row_l = new QHBoxLayout(add_row);
+    add_row_l->setContentsMargins(0,0,0,0);
+    add_row_l->addWidget(new QLabel("Start:", add_row));
+    this->start_input = new QLineEdit(add_row);
+    this->start_input->setFont(window->get_table_font());
+    this->start_input->setPlaceholderText("e.g. $C000");
+    add_row_l->addWidget(this->start_input);
+    add_row_l->addWidget(new QLabel("End:", add_row));
+    this->end_input = new QLineEdit(add_row);
+    this->end_input->setFont(window->get_table_font());
+    this->end_input->setPlaceholderText("same as start");
+    add_row_l->addWidget(this->end_input);
+    this->read_check = new QCheckBox("Read", add_row);
+    add_row_l->addWidget(this->read_check);
+    this->write_check = new QCheckBox("Write", add_row);
+    this->write_check->setChecked(true);
+    add_row_l->addWidget(this->write_check);
+    this->break_check = new QCheckBox("Break", add_row);
+    add_row_l->addWidget(this->break_check);
+    this->log_check = new QCheckBox("Log", add_row);
+    this->log_check->setChecked(true);
+    add_row_l->addWidget(this->log_check);
+    auto *add_button = new QPushButton("Add", add_row);
+    connect(add_button, &QPushButton::clicked, this, &WatchpointsDialog::add_watchpoint);
+    connect(this->start_input, &QLineEdit::returnPressed, this, &WatchpointsDialog::add_watchpoint);
+    connect(this->end_input, &QLineEdit::returnPressed, this, &WatchpointsDialog::add_watchpoint);
+    add_row_l->addWidget(add_button);
+    auto *remove_button = new QPushButton("Remove", add_row);
+    connect(remove_button, &QPushButton::clicked, this, &WatchpointsDialog::remove_watchpoint);
+    add_row_l->addWidget(remove_button);
+    layout->addWidget(add_row);
+
+    // Show the access log
+    this->log_summary = new QLabel(this);
+    layout->addWidget(this->log_summary);
+
+    this->model = new Model(this, window);
+    this->log_view = new QTableView(this);
+    this->log_view->setModel(this->model);
+    this->log_view->setFont(window->get_table_font());
+    this->log_view->setAlternatingRowColors(true);
+    this->log_view->setShowGrid(false);
+    this->log_view->setWordWrap(false);
+    this->log_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    this->log_view->setSelectionMode(QAbstractItemView::SingleSelection);
+    this->log_view->verticalHeader()->hide();
+    this->log_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    this->log_view->verticalHeader()->setDefaultSectionSize(window->get_table_font().pixelSize() + 4);
+    this->log_view->horizontalHeader()->setStretchLastSection(true);
+    this->log_view->setMinimumWidth(600);
+    this->log_view->setMinimumHeight(300);
+    connect(this->log_view, &QTableView::doubleClicked, this, &WatchpointsDialog::double_clicked_item);
+    layout->addWidget(this->log_view);
+
+    auto *button_row = new QWidget(this);
+    auto *button_row_l = new QHBoxLayout(button_row);
+    button_row_l->setContentsMargins(0,0,0,0);
+    button_row_l->addStretch(1);
+    auto *clear_button = new QPushButton("Clear", button_row);
+    connect(clear_button, &QPushButton::clicked, this, &WatchpointsDialog::clear_log);
+    button_row_l->addWidget(clear_button);
+    auto *export_button = new QPushButton("Export...", button_row);
+    connect(export_button, &QPushButton::clicked, this, &WatchpointsDialog::export_log);
+    button_row_l->addWidget(export_button);
+    layout->addWidget(button_row);
+
+    this->setLayout(layout);
+}
+
+void Debugger::WatchpointsDialog::refresh_log() {
+    this->model->update_rows();
+
+    char summary[256];
+    auto &instance = this->window->get_instance();
+    std::snprintf(summary, sizeof(summary), "%zu accesses logged (%llu dropped)", this->window->memory_access_log.size(), static_cast<unsigned long long>(instance.get_dropped_memory_access_count() + this->window->memory_accesses_not_kept));
+    this->log_summary->setText(summary);
+}
+
+void Debugger::WatchpointsDialog::refresh_watchpoints() {
+    auto watchpoints = this->window->get_instance().get_watchpoints();
+    this->watchpoint_table->setRowCount(watchpoints.size());
+
+    int row = 0;
+    for(auto &w : watchpoints) {
+        char range[32];
+        if(w.start == w.end) {
+            std::snprintf(range, sizeof(range), "$%04x", w.start);
+        }
+        else {
+            std::snprintf(range, sizeof(range), "$%04x-$%04x", w.start, w.end);
+        }
+
+        char access[32];
+        std::snprintf(access, sizeof(access), "%s%s%s", (w.flags & WATCHPOINT_READ) ? "Read" : "", (w.flags & WATCHPOINT_READ) && (w.flags & WATCHPOINT_WRITE) ? "/" : "", (w.flags & WATCHPOINT_WRITE) ? "Write" : "");
+
+        char action[32];
+        std::snprintf(action, sizeof(action), "%s%s%s", (w.flags & WATCHPOINT_BREAK) ? "Break" : "", (w.flags & WATCHPOINT_BREAK) && (w.flags & WATCHPOINT_LOG) ? ", " : "", (w.flags & WATCHPOINT_LOG) ? "Log" : "");
+
+        this->watchpoint_table->setItem(row, 0, new QTableWidgetItem(range));
+        this->watchpoint_table->setItem(row, 1, new QTableWidgetItem(access));
+        this->watchpoint_table->setItem(row, 2, new QTableWidgetItem(action));
+        row++;
+    }
+}
+
+void Debugger::WatchpointsDialog::add_watchpoint() {
+    std::uint8_t flags = (this->read_check->isChecked() ? WATCHPOINT_READ : 0) |
+                         (this->write_check->isChecked() ? WATCHPOINT_WRITE : 0) |
+                         (this->break_check->isChecked() ? WATCHPOINT_BREAK : 0) |
+                         (this->log_check->isChecked() ? WATCHPOINT_LOG : 0);
+
+    if(!(flags & (WATCHPOINT_READ | WATCHPOINT_WRITE)) || !(flags & (WATCHPOINT_BREAK | WATCHPOINT_LOG))) {
+        QMessageBox(QMessageBox::Icon::Critical, "Invalid Watchpoint", "A watchpoint needs to watch reads and/or writes and either break or log.", QMessageBox::StandardButton::Ok).exec();
+        return;
+    }
+
+    auto &instance = this->window->get_instance();
+    auto evaluate = [&instance](QLineEdit *input) -> std::optional<std::uint16_t> {
+        auto text = input->text().trimmed();
+        auto value = instance.evaluate_expression(text.toUtf8().data());
+        if(!value.has_value()) {
+            QMessageBox(QMessageBox::Icon::Critical, "Invalid Expression", QString("An invalid expression `") + text + "` was given. Check your input and try again.", QMessageBox::StandardButton::Ok).exec();
+        }
+        return value;
+    };
+
+    auto start = evaluate(this->start_input);
+    if(!start.has_value()) {
+        return;
+    }
+
+    auto end = start;
+    if(!this->end_input->text().trimmed().isEmpty() && !(end = evaluate(this->end_input)).has_value()) {
+        return;
+    }
+
+    instance.add_watchpoint(Watchpoint { *start, *end, flags });
+    this->start_input->clear();
+    this->end_input->clear();
+    this->refresh_watchpoints();
+}
+
+void Debugger::WatchpointsDialog::remove_watchpoint() {
+    auto row = this->watchpoint_table->currentRow();
+    if(row >= 0) {
+        this->window->get_instance().remove_watchpoint(row);
+        this->refresh_watchpoints();
+    }
+}
+
+void Debugger::WatchpointsDialog::clear_log() {
+    this->model->clear();
+    this->refresh_log();
+}
+
+void Debugger::WatchpointsDialog::double_clicked_item(const QModelIndex &index) {
+    if(index.isValid()) {
+        this->window->disassembler->go_to(this->window->memory_access_log[index.row()].pc);
+    }
+}
+
+void Debugger::WatchpointsDialog::export_log() {
+    // The log keeps growing while we export, so give the worker its own copy
+    auto log = std::make_shared<const std::vector<MemoryAccess>>(this->window->memory_access_log);
+
+    export_table(this, { "index", "cycle", "pc", "access", "address", "value" }, log->size(), [log](std::uint64_t row, std::vector<std::string> &fields) {
+        auto &access = (*log)[row];
+
+        char text[16];
+        auto hex = [&text](const char *format, unsigned int value) -> const char * {
+            std::snprintf(text, sizeof(text), format, value);
+            return text;
+        };
+
+        fields[0] = std::to_string(row);
+        fields[1] = std::to_string(access.cycle);
+        fields[2] = hex("$%04x", access.pc);
+        fields[3] = access_type_name(access.type);
+        fields[4] = hex("$%04x", access.address);
+        fields[5] = hex("$%02x", access.value);
+    });
+}
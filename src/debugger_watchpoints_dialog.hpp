@@ -0,0 +1,43 @@
+#ifndef DEBUGGER_WATCHPOINTS_DIALOG_HPP
+#define DEBUGGER_WATCHPOINTS_DIALOG_HPP
+
+#include <QDialog>
+
+#include "debugger.hpp"
+
+class QTableView;
+class QLabel;
+
+class Debugger::WatchpointsDialog : public QDialog {
+public:
+    WatchpointsDialog(Debugger *window);
+
+    /** Show accesses that were logged since the last refresh */
+    void refresh_log();
+
+    /** Show the watchpoints that are set */
+    void refresh_watchpoints();
+
+private:
+    class Model;
+
+    Model *model;
+    QTableView *log_view;
+    QLabel *log_summary;
+    QTableWidget *watchpoint_table;
+    QLineEdit *start_input;
+    QLineEdit *end_input;
+    QCheckBox *read_check;
+    QCheckBox *write_check;
+    QCheckBox *break_check;
+    QCheckBox *log_check;
+    Debugger *window;
+
+    void add_watchpoint();
+    void remove_watchpoint();
+    void clear_log();
+    void export_log();
+    void double_clicked_item(const QModelIndex &index);
+};
+
+#endif
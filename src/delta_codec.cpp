@@ -0,0 +1,130 @@
+#include "delta_codec.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+// Runs of unchanged bytes shorter than this are cheaper to leave inside a literal than to split the literal
+static constexpr const std::size_t MIN_ZERO_RUN = 4;
+
+static void write_varint(std::vector<std::uint8_t> &output, std::size_t value) {
+    while(value >= 0x80) {
+        output.emplace_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    output.emplace_back(static_cast<std::uint8_t>(value));
+}
+
+static bool read_varint(const std::uint8_t *data, std::size_t size, std::size_t &position, std::size_t &value) {
+    value = 0;
+    for(std::size_t shift = 0; shift < sizeof(value) * 8; shift += 7) {
+        if(position >= size) {
+            return false;
+        }
+        auto byte = data[position++];
+        value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline std::uint8_t base_byte(const std::uint8_t *base, std::size_t base_size, std::size_t offset) {
+    return offset < base_size ? base[offset] : 0;
+}
+
+// Find where the run of unchanged bytes starting at offset ends
+static std::size_t skip_unchanged(const std::uint8_t *base, std::size_t base_size, const std::uint8_t *target, std::size_t target_size, std::size_t offset) {
+    // Compare a word at a time while both buffers have data
+    auto both_end = std::min(base_size, target_size);
+    while(offset + sizeof(std::uint64_t) <= both_end) {
+        std::uint64_t a, b;
+        std::memcpy(&a, base + offset, sizeof(a));
+        std::memcpy(&b, target + offset, sizeof(b));
+        if(a != b) {
+            break;
+        }
+        offset += sizeof(a);
+    }
+
+    while(offset < target_size && target[offset] == base_byte(base, base_size, offset)) {
+        offset++;
+    }
+
+    return offset;
+}
+
+void encode_delta(const std::uint8_t *base, std::size_t base_size, const std::uint8_t *target, std::size_t target_size, std::vector<std::uint8_t> &output) {
+    output.clear();
+    write_varint(output, target_size);
+
+    std::size_t offset = 0;
+    while(offset < target_size) {
+        auto literal_start = skip_unchanged(base, base_size, target, target_size, offset);
+
+        // Extend the literal until we hit a long enough run of unchanged bytes (or the end)
+        auto literal_end = literal_start;
+        while(literal_end < target_size) {
+            if(target[literal_end] != base_byte(base, base_size, literal_end)) {
+                literal_end++;
+                continue;
+            }
+
+            auto run_end = skip_unchanged(base, base_size, target, target_size, literal_end);
+            if(run_end - literal_end >= MIN_ZERO_RUN || run_end == target_size) {
+                break;
+            }
+            literal_end = run_end;
+        }
+
+        write_varint(output, literal_start - offset);
+        write_varint(output, literal_end - literal_start);
+        for(auto i = literal_start; i < literal_end; i++) {
+            output.emplace_back(target[i] ^ base_byte(base, base_size, i));
+        }
+
+        offset = literal_end;
+    }
+}
+
+bool decode_delta(const std::uint8_t *base, std::size_t base_size, const std::uint8_t *delta, std::size_t delta_size, std::vector<std::uint8_t> &output) {
+    std::size_t position = 0;
+    std::size_t target_size;
+    if(!read_varint(delta, delta_size, position, target_size)) {
+        return false;
+    }
+    output.resize(target_size);
+
+    // Copy whatever's left of the base (or zeroes) for unchanged bytes
+    auto copy_unchanged = [&base, &base_size, &output](std::size_t offset, std::size_t length) {
+        auto from_base = offset < base_size ? std::min(length, base_size - offset) : 0;
+        if(from_base > 0) {
+            std::memcpy(output.data() + offset, base + offset, from_base);
+        }
+        if(from_base < length) {
+            std::memset(output.data() + offset + from_base, 0, length - from_base);
+        }
+    };
+
+    std::size_t offset = 0;
+    while(offset < target_size) {
+        std::size_t unchanged, literal;
+        if(!read_varint(delta, delta_size, position, unchanged) || !read_varint(delta, delta_size, position, literal)) {
+            return false;
+        }
+        if(unchanged > target_size - offset || literal > target_size - offset - unchanged || literal > delta_size - position) {
+            return false;
+        }
+
+        copy_unchanged(offset, unchanged);
+        offset += unchanged;
+
+        for(std::size_t i = 0; i < literal; i++) {
+            output[offset + i] = delta[position + i] ^ base_byte(base, base_size, offset + i);
+        }
+        offset += literal;
+        position += literal;
+    }
+
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef DELTA_CODEC_HPP
+#define DELTA_CODEC_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Encode the target as an XOR against the base, collapsing runs of unchanged bytes.
+ *
+ * Two save states taken close together are mostly identical, so the result is usually a small fraction of the size. If
+ * there is no base (base_size is 0), this simply collapses runs of zeroes in the target.
+ *
+ * @param base        base data (may be null if base_size is 0)
+ * @param base_size   size of the base data (bytes past this are treated as zero)
+ * @param target      data to encode
+ * @param target_size size of the data to encode
+ * @param output      where to put the encoded data (cleared first)
+ */
+void encode_delta(const std::uint8_t *base, std::size_t base_size, const std::uint8_t *target, std::size_t target_size, std::vector<std::uint8_t> &output);
+
+/**
+ * Decode data encoded with encode_delta() against the same base
+ *
+ * @param base       base data (may be null if base_size is 0)
+ * @param base_size  size of the base data
+ * @param delta      encoded data
+ * @param delta_size size of the encoded data
+ * @param output     where to put the decoded data (resized as needed)
+ * @return           true if successful, false if the encoded data is corrupt
+ */
+bool decode_delta(const std::uint8_t *base, std::size_t base_size, const std::uint8_t *delta, std::size_t delta_size, std::vector<std::uint8_t> &output);
+
+#endif
@@ -0,0 +1,104 @@
+#include "disassembly_cache.hpp"
+
+#include <algorithm>
+
+bool DisassemblyCache::is_cacheable(std::uint16_t address) noexcept {
+    return address < 0x8000                         // ROM
+        || (address >= 0xA000 && address < 0xFE00) // cartridge RAM, work RAM, and echo RAM
+        || (address >= 0xFF80 && address < 0xFFFF); // HRAM
+}
+
+bool DisassemblyCache::find(std::uint16_t address, std::uint16_t bank, SM83Instruction &instruction) {
+    if(!is_cacheable(address)) {
+        this->uncacheable++;
+        return false;
+    }
+
+    auto entry = this->entries.find(make_key(address, bank));
+    if(entry == this->entries.end()) {
+        this->misses++;
+        return false;
+    }
+
+    // Anything outside of ROM has to have not been written to since
+    auto &e = entry->second;
+    if(address >= 0x8000) {
+        auto last_address = static_cast<std::uint16_t>(address + e.instruction.length - 1);
+        if(e.first_page_generation != this->page_generation[address >> 8] || e.last_page_generation != this->page_generation[last_address >> 8]) {
+            this->stale++;
+            this->entries.erase(entry);
+            return false;
+        }
+    }
+
+    this->hits++;
+    instruction = e.instruction;
+    return true;
+}
+
+void DisassemblyCache::insert(const SM83Instruction &instruction) {
+    if(!is_cacheable(instruction.address)) {
+        return;
+    }
+
+    // Banks are switched in 4 KiB units at the smallest, so an instruction crossing into the next one might be made of bytes
+    // from a bank that isn't part of the key; these are rare enough to not bother with
+    auto end = static_cast<std::uint32_t>(instruction.address) + instruction.length - 1;
+    if(end > 0xFFFF || (end >> 12) != (instruction.address >> 12) || !is_cacheable(static_cast<std::uint16_t>(end))) {
+        return;
+    }
+
+    if(this->entries.size() >= this->max_entries) {
+        this->entries.clear();
+    }
+
+    auto &e = this->entries[make_key(instruction.address, instruction.bank)];
+    e.instruction = instruction;
+    e.instruction.symbol.clear();
+    e.instruction.target_symbol.clear();
+    e.first_page_generation = this->page_generation[instruction.address >> 8];
+    e.last_page_generation = this->page_generation[end >> 8];
+}
+
+void DisassemblyCache::invalidate_memory() noexcept {
+    for(auto &g : this->page_generation) {
+        g++;
+    }
+}
+
+std::uint64_t DisassemblyCache::get_generation(std::uint16_t address, std::size_t length) const noexcept {
+    if(length == 0) {
+        return 0;
+    }
+
+    // Page generations only go up, so the sum changes if any of them do
+    std::size_t first_page = address >> 8;
+    std::size_t page_count = std::min<std::size_t>(((address + length - 1) >> 8) - first_page + 1, this->page_generation.size());
+    std::uint64_t generation = 0;
+    for(std::size_t p = 0; p < page_count; p++) {
+        generation += this->page_generation[(first_page + p) % this->page_generation.size()];
+    }
+    return generation;
+}
+
+void DisassemblyCache::clear() {
+    this->entries.clear();
+    this->invalidate_memory();
+}
+
+DisassemblyCache::Statistics DisassemblyCache::get_statistics() const noexcept {
+    Statistics statistics = {};
+    statistics.hits = this->hits;
+    statistics.misses = this->misses;
+    statistics.stale = this->stale;
+    statistics.uncacheable = this->uncacheable;
+    statistics.entries = this->entries.size();
+    return statistics;
+}
+
+void DisassemblyCache::reset_statistics() noexcept {
+    this->hits = 0;
+    this->misses = 0;
+    this->stale = 0;
+    this->uncacheable = 0;
+}
@@ -0,0 +1,144 @@
+#ifndef DISASSEMBLY_CACHE_HPP
+#define DISASSEMBLY_CACHE_HPP
+
+#include <cstdint>
+#include <array>
+#include <unordered_map>
+
+#include "sm83_disassembler.hpp"
+
+/**
+ * Decoded instructions keyed by bank and address.
+ *
+ * ROM can't change while a cartridge is loaded, so anything decoded from ROM stays valid until clear() is called. Code in
+ * RAM is checked against a generation counter for each 256-byte page it came from; note_write() bumps the counter, so a
+ * write anywhere in the page makes everything decoded from that page stale. VRAM, OAM, and I/O registers can change without
+ * the CPU writing to them, so they are never cached.
+ *
+ * Symbols are not cached since they can change independently of memory.
+ *
+ * This is not thread-safe; the owner has to synchronize access.
+ */
+class DisassemblyCache {
+public:
+    struct Statistics {
+        /** Lookups that found a valid instruction */
+        std::uint64_t hits;
+
+        /** Lookups that found nothing */
+        std::uint64_t misses;
+
+        /** Lookups that found an instruction that had been written over since */
+        std::uint64_t stale;
+
+        /** Lookups of addresses that are never cached */
+        std::uint64_t uncacheable;
+
+        /** Number of instructions held */
+        std::size_t entries;
+    };
+
+    /**
+     * Instantiate a cache
+     *
+     * @param max_entries maximum number of instructions to hold (everything is dropped when this is exceeded)
+     */
+    DisassemblyCache(std::size_t max_entries = 65536) : max_entries(max_entries) {}
+
+    /**
+     * Check if instructions at the address can be cached
+     *
+     * @param address address
+     * @return        true if cacheable
+     */
+    static bool is_cacheable(std::uint16_t address) noexcept;
+
+    /**
+     * Find an instruction
+     *
+     * @param address     address of the instruction
+     * @param bank        bank mapped to the address
+     * @param instruction where to put the instruction if found
+     * @return            true if found and still valid
+     */
+    bool find(std::uint16_t address, std::uint16_t bank, SM83Instruction &instruction);
+
+    /**
+     * Add an instruction
+     *
+     * @param instruction instruction (its address and bank are used as the key)
+     */
+    void insert(const SM83Instruction &instruction);
+
+    /**
+     * Note that memory was written to, invalidating anything decoded from that page
+     *
+     * @param address address written to
+     */
+    void note_write(std::uint16_t address) noexcept {
+        this->page_generation[address >> 8]++;
+
+        // Echo RAM mirrors work RAM, so a write to either one changes both
+        if(address >= 0xC000 && address < 0xDE00) {
+            this->page_generation[(address + 0x2000) >> 8]++;
+        }
+        else if(address >= 0xE000 && address < 0xFE00) {
+            this->page_generation[(address - 0x2000) >> 8]++;
+        }
+    }
+
+    /**
+     * Get a number that changes whenever memory in a range is written to or invalidated
+     *
+     * @param address first address
+     * @param length  number of bytes
+     * @return        generation
+     */
+    std::uint64_t get_generation(std::uint16_t address, std::size_t length) const noexcept;
+
+    /**
+     * Invalidate everything decoded from RAM (e.g. after a save state is loaded)
+     */
+    void invalidate_memory() noexcept;
+
+    /**
+     * Remove everything (e.g. when a different ROM is loaded)
+     */
+    void clear();
+
+    /**
+     * Get statistics
+     *
+     * @return statistics
+     */
+    Statistics get_statistics() const noexcept;
+
+    /**
+     * Reset the hit/miss counters
+     */
+    void reset_statistics() noexcept;
+
+private:
+    struct Entry {
+        SM83Instruction instruction;
+
+        // Generation of the first and last page the instruction's bytes came from
+        std::uint32_t first_page_generation;
+        std::uint32_t last_page_generation;
+    };
+
+    std::size_t max_entries;
+    std::unordered_map<std::uint32_t, Entry> entries;
+    std::array<std::uint32_t, 256> page_generation = {};
+
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t stale = 0;
+    std::uint64_t uncacheable = 0;
+
+    static std::uint32_t make_key(std::uint16_t address, std::uint16_t bank) noexcept {
+        return (static_cast<std::uint32_t>(bank) << 16) | address;
+    }
+};
+
+#endif
@@ -26,6 +26,11 @@ static constexpr const std::uint32_t REWIND_SLIDER_MIN = 15;
 static constexpr const std::uint32_t REWIND_SLIDER_GRANULARITY = 5;
 static constexpr const std::uint32_t REWIND_SLIDER_TICK_INTERVAL = 15;
 
+static constexpr const std::uint32_t REWIND_BUDGET_SLIDER_MAX = 512;
+static constexpr const std::uint32_t REWIND_BUDGET_SLIDER_MIN = 16;
+static constexpr const std::uint32_t REWIND_BUDGET_SLIDER_GRANULARITY = 16;
+static constexpr const std::uint32_t REWIND_BUDGET_SLIDER_TICK_INTERVAL = 64;
+
 static constexpr const std::uint32_t BASE_SPEED_SLIDER_MAX = 800;
 static constexpr const std::uint32_t BASE_SPEED_SLIDER_MIN = 0;
 static constexpr const std::uint32_t BASE_SPEED_SLIDER_GRANULARITY = 25;
@@ -152,6 +157,12 @@ EditSpeedControlSettingsDialog::EditSpeedControlSettingsDialog(GameWindow *windo
                       "Set the maximum rewind buffer length in seconds. If the emulator attempts to rewind beyond this buffer length, the\n"
                       "emulator will automatically pause."
                     },
+                    { "Rewind memory (MiB):",
+                      &this->rewind_budget_amount,
+                      &this->rewind_budget_slider,
+                      "Set the maximum memory to use for the rewind buffer. If the rewind buffer would use more than this, the oldest part\n"
+                      "of it is discarded, so the rewind buffer may be shorter than the length set above."
+                    },
                     { "Rewind speed (%):",
                       &this->rewind_speed_amount,
                       &this->rewind_speed_slider,
@@ -183,6 +194,10 @@ EditSpeedControlSettingsDialog::EditSpeedControlSettingsDialog(GameWindow *windo
     this->rewind_slider->setTickInterval(REWIND_SLIDER_TICK_INTERVAL / REWIND_SLIDER_GRANULARITY);
     this->rewind_slider->setMinimum(REWIND_SLIDER_MIN / REWIND_SLIDER_GRANULARITY);
 
+    this->rewind_budget_slider->setMaximum(REWIND_BUDGET_SLIDER_MAX / REWIND_BUDGET_SLIDER_GRANULARITY);
+    this->rewind_budget_slider->setTickInterval(REWIND_BUDGET_SLIDER_TICK_INTERVAL / REWIND_BUDGET_SLIDER_GRANULARITY);
+    this->rewind_budget_slider->setMinimum(REWIND_BUDGET_SLIDER_MIN / REWIND_BUDGET_SLIDER_GRANULARITY);
+
     this->max_cpu_multiplier_slider->setMaximum(MAX_CPU_MULTIPLIER_SLIDER_MAX / MAX_CPU_MULTIPLIER_SLIDER_GRANULARITY);
     this->max_cpu_multiplier_slider->setTickInterval(MAX_CPU_MULTIPLIER_SLIDER_TICK_INTERVAL / MAX_CPU_MULTIPLIER_SLIDER_GRANULARITY);
     this->max_cpu_multiplier_slider->setMinimum(MAX_CPU_MULTIPLIER_SLIDER_MIN / MAX_CPU_MULTIPLIER_SLIDER_GRANULARITY);
@@ -190,6 +205,7 @@ EditSpeedControlSettingsDialog::EditSpeedControlSettingsDialog(GameWindow *windo
     // Sliders should update the textbox. Use individual functions for each value since we don't want to constrain everything to what is available on a slider.
     connect(this->slowmo_slider, &QSlider::valueChanged, this, &EditSpeedControlSettingsDialog::update_slowmo_textbox);
     connect(this->rewind_slider, &QSlider::valueChanged, this, &EditSpeedControlSettingsDialog::update_rewind_textbox);
+    connect(this->rewind_budget_slider, &QSlider::valueChanged, this, &EditSpeedControlSettingsDialog::update_rewind_budget_textbox);
     connect(this->turbo_slider, &QSlider::valueChanged, this, &EditSpeedControlSettingsDialog::update_turbo_textbox);
     connect(this->rewind_speed_slider, &QSlider::valueChanged, this, &EditSpeedControlSettingsDialog::update_rewind_speed_textbox);
     connect(this->base_speed_slider, &QSlider::valueChanged, this, &EditSpeedControlSettingsDialog::update_base_speed_textbox);
@@ -198,6 +214,7 @@ EditSpeedControlSettingsDialog::EditSpeedControlSettingsDialog(GameWindow *windo
     this->turbo_amount->setText(QString::number(window->max_turbo * 100));
     this->slowmo_amount->setText(QString::number(window->max_slowmo * 100));
     this->rewind_amount->setText(QString::number(window->rewind_length));
+    this->rewind_budget_amount->setText(QString::number(window->rewind_budget_kib / 1024));
     this->rewind_speed_amount->setText(QString::number(window->rewind_speed * 100));
     this->base_speed_amount->setText(QString::number(window->base_multiplier * 100));
     this->max_cpu_multiplier_amount->setText(QString::number(window->max_cpu_multiplier * 100));
@@ -206,6 +223,7 @@ EditSpeedControlSettingsDialog::EditSpeedControlSettingsDialog(GameWindow *windo
     this->update_sliders(QString());
     connect(this->slowmo_amount, &QLineEdit::textEdited, this, &EditSpeedControlSettingsDialog::update_sliders);
     connect(this->rewind_amount, &QLineEdit::textEdited, this, &EditSpeedControlSettingsDialog::update_sliders);
+    connect(this->rewind_budget_amount, &QLineEdit::textEdited, this, &EditSpeedControlSettingsDialog::update_sliders);
     connect(this->turbo_amount, &QLineEdit::textEdited, this, &EditSpeedControlSettingsDialog::update_sliders);
     connect(this->rewind_speed_amount, &QLineEdit::textEdited, this, &EditSpeedControlSettingsDialog::update_sliders);
     connect(this->base_speed_amount, &QLineEdit::textEdited, this, &EditSpeedControlSettingsDialog::update_sliders);
@@ -237,8 +255,9 @@ EditSpeedControlSettingsDialog::EditSpeedControlSettingsDialog(GameWindow *windo
 }
 
 void EditSpeedControlSettingsDialog::perform_accept() {
-    bool rewind_ok = true, rewind_speed_ok = true, base_speed_ok = true, slowmo_ok = true, turbo_ok = true, max_cpu_multiplier_ok = true;
+    bool rewind_ok = true, rewind_budget_ok = true, rewind_speed_ok = true, base_speed_ok = true, slowmo_ok = true, turbo_ok = true, max_cpu_multiplier_ok = true;
     double rewind_amount = this->rewind_amount->text().toDouble(&rewind_ok);
+    unsigned int rewind_budget_amount = this->rewind_budget_amount->text().toUInt(&rewind_budget_ok);
     double rewind_speed_amount = this->rewind_speed_amount->text().toDouble(&rewind_speed_ok) / 100.0;
     double slowmo_amount = this->slowmo_amount->text().toDouble(&slowmo_ok) / 100.0;
     double turbo_amount = this->turbo_amount->text().toDouble(&turbo_ok) / 100.0;
@@ -252,6 +271,7 @@ void EditSpeedControlSettingsDialog::perform_accept() {
     }
 
     COMPLAIN_IF_INVALID(!rewind_ok || rewind_amount < 0, "Rewind Length")
+    COMPLAIN_IF_INVALID(!rewind_budget_ok || rewind_budget_amount == 0 || rewind_budget_amount > UINT_MAX / 1024, "Rewind Memory")
     COMPLAIN_IF_INVALID(!slowmo_ok || turbo_amount < 0, "Slowmo Speed")
     COMPLAIN_IF_INVALID(!turbo_ok || slowmo_amount < 0, "Turbo Speed")
     COMPLAIN_IF_INVALID(!base_speed_ok || base_speed_amount < 0, "Base Speed")
@@ -259,10 +279,14 @@ void EditSpeedControlSettingsDialog::perform_accept() {
     COMPLAIN_IF_INVALID(!max_cpu_multiplier_ok || max_cpu_multiplier_amount <= 0, "Max CPU Multiplier")
 
     // Change things
-    if(window->rewind_length != rewind_amount) { // perform this check since the rewind gets reset when set_rewind_length is called
+    if(window->rewind_length != rewind_amount) { // perform this check since the rewind history may be trimmed when set_rewind_length is called
         window->rewind_length = rewind_amount;
         window->instance->set_rewind_length(rewind_amount);
     }
+    if(window->rewind_budget_kib != rewind_budget_amount * 1024) {
+        window->rewind_budget_kib = rewind_budget_amount * 1024;
+        window->instance->set_rewind_memory_budget(static_cast<std::size_t>(window->rewind_budget_kib) * 1024);
+    }
     window->max_slowmo = slowmo_amount;
     window->max_turbo = turbo_amount;
     window->rewind_speed = rewind_speed_amount;
@@ -283,6 +307,7 @@ void EditSpeedControlSettingsDialog::update_sliders(const QString &) {
     this->turbo_slider->blockSignals(true);
     this->slowmo_slider->blockSignals(true);
     this->rewind_slider->blockSignals(true);
+    this->rewind_budget_slider->blockSignals(true);
     this->rewind_speed_slider->blockSignals(true);
     this->base_speed_slider->blockSignals(true);
     this->max_cpu_multiplier_slider->blockSignals(true);
@@ -290,6 +315,7 @@ void EditSpeedControlSettingsDialog::update_sliders(const QString &) {
     this->turbo_slider->setValue(this->turbo_amount->text().toInt() / TURBO_SLIDER_GRANULARITY);
     this->slowmo_slider->setValue(this->slowmo_amount->text().toInt() / SLOWMO_SLIDER_GRANULARITY);
     this->rewind_slider->setValue(this->rewind_amount->text().toInt() / REWIND_SLIDER_GRANULARITY);
+    this->rewind_budget_slider->setValue(this->rewind_budget_amount->text().toInt() / REWIND_BUDGET_SLIDER_GRANULARITY);
     this->rewind_speed_slider->setValue(this->rewind_speed_amount->text().toInt() / REWIND_SPEED_SLIDER_GRANULARITY);
     this->base_speed_slider->setValue(this->base_speed_amount->text().toInt() / BASE_SPEED_SLIDER_GRANULARITY);
     this->max_cpu_multiplier_slider->setValue(this->max_cpu_multiplier_amount->text().toInt() / MAX_CPU_MULTIPLIER_SLIDER_GRANULARITY);
@@ -297,6 +323,7 @@ void EditSpeedControlSettingsDialog::update_sliders(const QString &) {
     this->turbo_slider->blockSignals(false);
     this->slowmo_slider->blockSignals(false);
     this->rewind_slider->blockSignals(false);
+    this->rewind_budget_slider->blockSignals(false);
     this->rewind_speed_slider->blockSignals(false);
     this->base_speed_slider->blockSignals(false);
     this->max_cpu_multiplier_slider->blockSignals(false);
@@ -305,6 +332,9 @@ void EditSpeedControlSettingsDialog::update_sliders(const QString &) {
 void EditSpeedControlSettingsDialog::update_rewind_textbox(int v) {
     this->rewind_amount->setText(QString::number(v * REWIND_SLIDER_GRANULARITY));
 }
+void EditSpeedControlSettingsDialog::update_rewind_budget_textbox(int v) {
+    this->rewind_budget_amount->setText(QString::number(v * REWIND_BUDGET_SLIDER_GRANULARITY));
+}
 void EditSpeedControlSettingsDialog::update_rewind_speed_textbox(int v) {
     this->rewind_speed_amount->setText(QString::number(v * REWIND_SPEED_SLIDER_GRANULARITY));
 }
@@ -18,12 +18,13 @@ private:
     GameWindow *window;
 
     QCheckBox *enable_rewind, *enable_turbo, *enable_slowmo;
-    QLineEdit *base_speed_amount, *rewind_amount, *rewind_speed_amount, *turbo_amount, *slowmo_amount, *max_cpu_multiplier_amount;
-    QSlider *base_speed_slider, *rewind_slider, *rewind_speed_slider, *turbo_slider, *slowmo_slider, *max_cpu_multiplier_slider;
+    QLineEdit *base_speed_amount, *rewind_amount, *rewind_budget_amount, *rewind_speed_amount, *turbo_amount, *slowmo_amount, *max_cpu_multiplier_amount;
+    QSlider *base_speed_slider, *rewind_slider, *rewind_budget_slider, *rewind_speed_slider, *turbo_slider, *slowmo_slider, *max_cpu_multiplier_slider;
 
     void update_sliders(const QString &);
 
     void update_rewind_textbox(int);
+    void update_rewind_budget_textbox(int);
     void update_rewind_speed_textbox(int);
     void update_turbo_textbox(int);
     void update_slowmo_textbox(int);
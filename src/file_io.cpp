@@ -0,0 +1,71 @@
+#include "file_io.hpp"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+bool flush_to_disk(std::FILE *file) noexcept {
+    if(std::fflush(file) != 0) {
+        return false;
+    }
+
+    #ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+    #else
+    return fsync(fileno(file)) == 0;
+    #endif
+}
+
+bool write_file_atomically(const std::filesystem::path &path, const std::uint8_t *data, std::size_t size) noexcept {
+    auto temp_path = path;
+    temp_path += ".tmp";
+
+    auto *f = std::fopen(temp_path.string().c_str(), "wb");
+    if(f == nullptr) {
+        std::fprintf(stderr, "Failed to open %s for writing\n", temp_path.string().c_str());
+        return false;
+    }
+
+    bool success = std::fwrite(data, 1, size, f) == size && flush_to_disk(f);
+    success = std::fclose(f) == 0 && success;
+
+    std::error_code ec;
+    if(success) {
+        std::filesystem::rename(temp_path, path, ec);
+        if(ec) {
+            std::fprintf(stderr, "Failed to rename %s to %s: %s\n", temp_path.string().c_str(), path.string().c_str(), ec.message().c_str());
+            success = false;
+        }
+    }
+    else {
+        std::fprintf(stderr, "Failed to write %s\n", temp_path.string().c_str());
+    }
+
+    if(!success) {
+        std::filesystem::remove(temp_path, ec);
+    }
+
+    return success;
+}
+
+bool read_file(const std::filesystem::path &path, std::vector<std::uint8_t> &data) noexcept {
+    auto *f = std::fopen(path.string().c_str(), "rb");
+    if(f == nullptr) {
+        return false;
+    }
+
+    data.clear();
+    std::uint8_t chunk[4096];
+    std::size_t read;
+    while((read = std::fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        data.insert(data.end(), chunk, chunk + read);
+    }
+
+    bool success = std::ferror(f) == 0;
+    std::fclose(f);
+    return success;
+}
@@ -0,0 +1,38 @@
+#ifndef FILE_IO_HPP
+#define FILE_IO_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+/**
+ * Write the data to a temporary file next to the path, flush it to disk, and then rename it over the path. If anything
+ * fails, the file at the path is left untouched.
+ *
+ * @param path path to write to
+ * @param data data to write
+ * @param size number of bytes to write
+ * @return     true if successful
+ */
+bool write_file_atomically(const std::filesystem::path &path, const std::uint8_t *data, std::size_t size) noexcept;
+
+/**
+ * Flush a file's buffers and wait for the data to actually reach the disk
+ *
+ * @param file file to flush
+ * @return     true if successful
+ */
+bool flush_to_disk(std::FILE *file) noexcept;
+
+/**
+ * Read a whole file
+ *
+ * @param path path to read
+ * @param data where to put the contents (resized to fit)
+ * @return     true if successful
+ */
+bool read_file(const std::filesystem::path &path, std::vector<std::uint8_t> &data) noexcept;
+
+#endif
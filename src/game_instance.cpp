@@ -1,7 +1,10 @@
 #include "game_instance.hpp"
 #include "built_in_boot_rom.h"
 #include "gb_proxy.h"
+#include "file_io.hpp"
+#include "hash.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <thread>
@@ -39,6 +42,15 @@ static char *malloc_string(const char *string) {
     return str;
 }
 
+static SM83ExpressionState get_expression_state(GB_gameboy_s *gb) noexcept {
+    const auto *registers = GB_get_registers(gb);
+    return { registers->af, registers->bc, registers->de, registers->hl, registers->sp, registers->pc };
+}
+
+static std::uint8_t read_memory_for_expression(void *gb, std::uint16_t address) {
+    return GB_safe_read_memory(reinterpret_cast<GB_gameboy_s *>(gb), address);
+}
+
 static inline uint8_t *get_8_bit_gb_register_address(struct GB_gameboy_s *gb, GameInstance::SM83Register r) {
     auto *gbr = GB_get_registers(gb);
 
@@ -151,7 +163,20 @@ void GameInstance::load_boot_rom(GB_gameboy_t *gb, GB_boot_rom_t type) noexcept
 
     // If a boot rom is set, load that... unless it fails
     if(!fast_override && instance->boot_rom_path.has_value()) {
-        if(GB_load_boot_rom(gb, instance->boot_rom_path->string().c_str()) == 0) {
+        // This happens on every reset, so only read (and hash) the file again if it changed
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(*instance->boot_rom_path, ec);
+        if(ec || !instance->boot_rom_file_modified.has_value() || *instance->boot_rom_file_modified != modified) {
+            instance->boot_rom_file_modified = std::nullopt;
+            if(!ec && read_file(*instance->boot_rom_path, instance->boot_rom_file_data) && !instance->boot_rom_file_data.empty()) {
+                instance->boot_rom_file_modified = modified;
+                instance->boot_rom_file_hash = fnv1a_64(instance->boot_rom_file_data.data(), instance->boot_rom_file_data.size());
+            }
+        }
+
+        if(instance->boot_rom_file_modified.has_value()) {
+            GB_load_boot_rom_from_buffer(gb, instance->boot_rom_file_data.data(), instance->boot_rom_file_data.size());
+            instance->boot_rom_hash = instance->boot_rom_file_hash;
             return;
         }
         else {
@@ -192,6 +217,7 @@ void GameInstance::load_boot_rom(GB_gameboy_t *gb, GB_boot_rom_t type) noexcept
     }
 
     GB_load_boot_rom_from_buffer(gb, boot_rom, boot_rom_size);
+    instance->boot_rom_hash = fnv1a_64(boot_rom, boot_rom_size);
 }
 
 static std::uint32_t rgb_encode(GB_gameboy_t *, uint8_t r, uint8_t g, uint8_t b) {
@@ -219,6 +245,11 @@ void GameInstance::on_vblank(GB_gameboy_s *gameboy, GB_vblank_type_t) noexcept {
     // Set this since we hit vblank
     instance->vblank_hit = true;
 
+    // Update watches once per frame (the emulation thread holds the main mutex here)
+    instance->cpu_running = false;
+    instance->evaluate_watches_without_mutex();
+    instance->cpu_running = true;
+
     instance->should_rewind = instance->rewinding;
     instance->vblank_mutex.unlock();
 }
@@ -235,6 +266,7 @@ GameInstance::GameInstance(GB_model_t model, GB_border_mode_t border) {
     GB_apu_set_sample_callback(&this->gameboy, GameInstance::on_sample);
     GB_set_rumble_mode(&this->gameboy, GB_rumble_mode_t::GB_RUMBLE_CARTRIDGE_ONLY);
     GB_set_rumble_callback(&this->gameboy, GameInstance::on_rumble);
+    GB_set_write_memory_callback(&this->gameboy, GameInstance::on_memory_write);
     
     this->update_pixel_buffer_size();
 }
@@ -245,91 +277,242 @@ GameInstance::~GameInstance() {
     GB_free(&this->gameboy);
 }
 
-char *GameInstance::on_input_requested(GB_gameboy_s *gameboy) {
-    auto *instance = resolve_instance(gameboy);
-    instance->reset_audio();
+void GameInstance::start_trace_without_mutex(std::size_t count, bool step_over, bool break_when_done, const std::optional<std::filesystem::path> &trace_path) {
+    count = std::max<std::size_t>(count, 1);
+
+    // If we can't write to the file, keep it in memory instead
+    if(trace_path.has_value()) {
+        this->trace_file_writer = std::make_unique<TraceFileWriter>(*trace_path, this->rom_hash);
+        if(!this->trace_file_writer->is_open()) {
+            this->trace_file_writer.reset();
+        }
+    }
 
-    // Check if we're breaking and tracing?
-    bool bnt = false;
-    if(instance->current_break_and_trace_remaining > 0) {
-        bnt = (--instance->current_break_and_trace_remaining) > 0;
+    // Allocate everything up front so the execution callback never has to
+    this->trace_buffer.reset(this->trace_file_writer != nullptr ? 0 : std::min(count, MAX_TRACE_RECORDS));
+    this->current_break_and_trace_remaining = count;
+    this->current_break_and_trace_step_over = step_over;
+    this->current_break_and_trace_break_when_done = break_when_done;
+    this->trace_call_depth = 0;
+    this->trace_has_previous = false;
+    this->tracing = true;
+    this->update_memory_callbacks_without_mutex();
+}
 
-        bool hit_breakpoint = false;
-        auto pc = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_PC);
-        for(auto i : instance->get_breakpoints_without_mutex()) {
-            if(i == pc) {
-                hit_breakpoint = true;
-                break;
+void GameInstance::finish_trace_without_mutex() {
+    this->tracing = false;
+    this->update_memory_callbacks_without_mutex();
+    this->current_break_and_trace_remaining = 0;
+
+    if(this->trace_file_writer == nullptr) {
+        this->trace_buffer.take(this->break_and_trace_result.emplace_back());
+        return;
+    }
+
+    // This can run from the execution callback, so hand the writer every symbol and let it finish the file on its own thread
+    TraceFile::Names names;
+    std::uint32_t bank_count = get_gb_symbol_bank_count(&this->gameboy);
+    for(std::uint32_t bank = 0; bank < bank_count; bank++) {
+        std::uint32_t symbol_count = get_gb_symbol_count(&this->gameboy, static_cast<std::uint16_t>(bank));
+        for(std::uint32_t s = 0; s < symbol_count; s++) {
+            std::uint16_t address;
+            const char *name = get_gb_symbol(&this->gameboy, static_cast<std::uint16_t>(bank), s, &address);
+            if(name != nullptr) {
+                names.emplace((bank << 16) | address, name);
             }
         }
+    }
 
-        // If we hit a breakpoint in the middle of breaking and tracing, end prematurely
-        if(hit_breakpoint) {
-            bnt = false;
-            instance->current_break_and_trace_remaining = 0;
-        }
+    this->trace_file_writer->finish(std::move(names));
+    this->finishing_trace_files.emplace_back(std::move(this->trace_file_writer));
+}
 
-        // If we've hit the end, do we continue or stop now?
-        else if(!bnt && !instance->current_break_and_trace_break_when_done) {
-            return malloc_string("continue");
+void GameInstance::on_execution(GB_gameboy_s *gb, std::uint16_t address, std::uint8_t opcode) noexcept {
+    auto *instance = resolve_instance(gb);
+    instance->current_instruction_address = address;
+
+    if(instance->coverage_enabled) {
+        // Peeking at the second byte isn't the CPU reading it, so don't let it trip read watchpoints
+        std::uint8_t cb_opcode = 0;
+        if(opcode == 0xCB) {
+            bool cpu_running = instance->cpu_running;
+            instance->cpu_running = false;
+            cb_opcode = GB_safe_read_memory(gb, static_cast<std::uint16_t>(address + 1));
+            instance->cpu_running = cpu_running;
         }
+        instance->coverage.record(get_gb_bank_for_address(gb, address), address, opcode, cb_opcode);
     }
 
-    // If that didn't satisfy it, maybe we have something set here?
-    if(!bnt) {
-        for(auto b = instance->break_and_trace_breakpoints.begin(); b != instance->break_and_trace_breakpoints.end(); b++) {
-            auto pc = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_PC);
+    if(instance->profiling) {
+        instance->sample_profile_without_mutex(address);
+    }
 
-            auto &[bp_address, break_count, step_over, break_when_done] = *b;
-            if(pc == bp_address) {
-                instance->current_break_and_trace_remaining = break_count;
-                instance->current_break_and_trace_step_over = step_over;
-                instance->current_break_and_trace_break_when_done = break_when_done;
-                instance->break_and_trace_result.emplace_back().reserve(instance->current_break_and_trace_remaining + 1);
-                bnt = true;
+    // Break right after the return that finishes the next/finish a false breakpoint condition interrupted
+    if(instance->resuming_step && get_sm83_flow_type(opcode) == SM83_FLOW_RETURN) {
+        const auto *registers = GB_get_registers(gb);
+        if(is_sm83_condition_met(get_sm83_condition(opcode), registers->f) && instance->is_step_finished_without_mutex(static_cast<std::uint16_t>(registers->sp + 2))) {
+            instance->resuming_step = false;
+            instance->update_memory_callbacks_without_mutex();
+            instance->break_requested = true;
+            GB_debugger_break(gb);
+        }
+    }
 
-                // Remove the breakpoint
-                char command[512];
-                std::snprintf(command, sizeof(command), "delete $%04x", pc);
-                instance->execute_command_without_mutex(malloc_string(command));
-                instance->break_and_trace_breakpoints.erase(b);
+    if(!instance->tracing) {
+        return;
+    }
 
-                break;
+    // When stepping over, only record what runs at the depth we started at
+    if(instance->current_break_and_trace_step_over) {
+        if(instance->trace_has_previous) {
+            // Returning out of where we started is fine; keep going from the caller
+            instance->trace_call_depth = std::max<std::int64_t>(instance->trace_call_depth + instance->trace_next_depth_change, 0);
+
+            // If we ended up on an interrupt vector instead of where the last instruction was going, an interrupt fired
+            if(address != instance->trace_next_pc && address >= 0x40 && address <= 0x60 && (address & 7) == 0) {
+                instance->trace_call_depth++;
             }
         }
+
+        instance->predict_trace_step_without_mutex(address, opcode);
+
+        if(instance->trace_call_depth > 0) {
+            return;
+        }
+    }
+
+    const auto *registers = GB_get_registers(gb);
+
+    TraceRecord record;
+    record.cycle = instance->elapsed_cycles + get_gb_cycles_since_run(gb);
+    record.pc = address;
+    record.sp = registers->sp;
+    record.bank = get_gb_bank_for_address(gb, address);
+    record.a = registers->a;
+    record.f = registers->f;
+    record.b = registers->b;
+    record.c = registers->c;
+    record.d = registers->d;
+    record.e = registers->e;
+    record.h = registers->h;
+    record.l = registers->l;
+    record.opcode = opcode;
+    record.flags = (instance->current_break_and_trace_step_over ? TRACE_RECORD_STEP_OVER : 0) | (is_gb_boot_rom_finished(gb) ? 0 : TRACE_RECORD_BOOT_ROM);
+    if(instance->trace_file_writer != nullptr) {
+        instance->trace_file_writer->push(record);
+    }
+    else {
+        instance->trace_buffer.push(record);
     }
 
-    // If we are, continue after we record the current state
-    if(bnt) {
-        auto &b = instance->break_and_trace_result[instance->break_and_trace_result.size() - 1].emplace_back();
-        b.a = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_A);
-        b.b = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_B);
-        b.c = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_C);
-        b.d = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_D);
-        b.e = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_E);
-        b.f = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_F);
-        b.h = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_H);
-        b.l = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_L);
-        b.sp = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_SP);
-        b.pc = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_PC);
-        b.carry = b.f & GB_CARRY_FLAG;
-        b.half_carry = b.f & GB_HALF_CARRY_FLAG;
-        b.subtract = b.f & GB_SUBTRACT_FLAG;
-        b.zero = b.f & GB_ZERO_FLAG;
-        b.step_over = instance->current_break_and_trace_step_over;
-
-        b.disassembly = instance->disassemble_without_mutex(b.pc, 1);
-
-        if(instance->current_break_and_trace_step_over) {
-            return malloc_string("next");
+    if(--instance->current_break_and_trace_remaining == 0) {
+        bool break_when_done = instance->current_break_and_trace_break_when_done;
+        instance->finish_trace_without_mutex();
+
+        // This stops before the next instruction
+        if(break_when_done) {
+            instance->break_requested = true;
+            GB_debugger_break(gb);
         }
-        else {
-            return malloc_string("step");
+    }
+}
+
+void GameInstance::predict_trace_step_without_mutex(std::uint16_t address, std::uint8_t opcode) noexcept {
+    this->trace_has_previous = true;
+    this->trace_next_depth_change = 0;
+
+    auto flow = get_sm83_flow_type(opcode);
+    const auto *registers = GB_get_registers(&this->gameboy);
+    if(flow == SM83_FLOW_NONE || !is_sm83_condition_met(get_sm83_condition(opcode), registers->f)) {
+        this->trace_next_pc = static_cast<std::uint16_t>(address + get_sm83_instruction_length(opcode));
+        return;
+    }
+
+    // These reads aren't the CPU's, so don't let them trip read watchpoints
+    bool cpu_running = this->cpu_running;
+    this->cpu_running = false;
+
+    switch(flow) {
+        case SM83_FLOW_JUMP:
+        case SM83_FLOW_CALL: {
+            std::uint8_t bytes[3] = { opcode, GB_safe_read_memory(&this->gameboy, static_cast<std::uint16_t>(address + 1)), GB_safe_read_memory(&this->gameboy, static_cast<std::uint16_t>(address + 2)) };
+            SM83Instruction instruction;
+            decode_sm83_instruction(address, bytes, instruction);
+            this->trace_next_pc = instruction.target.value_or(static_cast<std::uint16_t>(address + instruction.length));
+            this->trace_next_depth_change = flow == SM83_FLOW_CALL ? 1 : 0;
+            break;
+        }
+        case SM83_FLOW_JUMP_HL:
+            this->trace_next_pc = static_cast<std::uint16_t>((registers->h << 8) | registers->l);
+            break;
+        case SM83_FLOW_RETURN:
+            this->trace_next_pc = static_cast<std::uint16_t>(GB_safe_read_memory(&this->gameboy, registers->sp) | (GB_safe_read_memory(&this->gameboy, static_cast<std::uint16_t>(registers->sp + 1)) << 8));
+            this->trace_next_depth_change = -1;
+            break;
+        default:
+            break;
+    }
+
+    this->cpu_running = cpu_running;
+}
+
+char *GameInstance::on_input_requested(GB_gameboy_s *gameboy) {
+    auto *instance = resolve_instance(gameboy);
+
+    // If nobody asked to break and we aren't where the last step was going, SameBoy stopped here because of a breakpoint
+    auto pc = get_gb_register(&instance->gameboy, SM83Register::SM83_REG_PC);
+    bool stopped_by_breakpoint = !instance->break_requested && !instance->is_step_finished_without_mutex(GB_get_registers(gameboy)->sp);
+    instance->break_requested = false;
+
+    bool hit_breakpoint = false;
+    if(stopped_by_breakpoint && instance->breakpoints.has_enabled_breakpoint(pc)) {
+        instance->cpu_running = false;
+        hit_breakpoint = instance->breakpoints.record_hit(pc, get_gb_bank_for_address(&instance->gameboy, pc), get_expression_state(&instance->gameboy), read_memory_for_expression, &instance->gameboy);
+        instance->cpu_running = true;
+
+        // Only conditional breakpoints are here and none of their conditions were met, so carry on as if we never stopped
+        if(!hit_breakpoint) {
+            if(instance->step_mode == STEP_OVER || instance->step_mode == STEP_OUT) {
+                instance->resuming_step = true;
+                instance->update_memory_callbacks_without_mutex();
+            }
+            return malloc_string("continue");
+        }
+    }
+
+    // Whatever we were stepping towards, we've stopped now
+    instance->step_mode = STEP_NONE;
+    if(instance->resuming_step) {
+        instance->resuming_step = false;
+        instance->update_memory_callbacks_without_mutex();
+    }
+
+    instance->reset_audio();
+
+    // If we stopped in the middle of a trace (e.g. we hit a breakpoint), end it here
+    if(instance->tracing) {
+        instance->finish_trace_without_mutex();
+    }
+
+    // If we have a break-and-trace breakpoint here, trace from here and keep going
+    if(hit_breakpoint) {
+        auto b = instance->break_and_trace_breakpoints.find(pc);
+        if(b != instance->break_and_trace_breakpoints.end()) {
+            auto &[break_count, step_over, break_when_done, trace_path] = b->second;
+            instance->start_trace_without_mutex(break_count, step_over, break_when_done, trace_path);
+
+            // Remove the breakpoint
+            instance->breakpoints.remove_all_at(pc);
+            instance->sync_breakpoints_without_mutex();
+            instance->break_and_trace_breakpoints.erase(b);
+
+            return malloc_string("continue");
         }
     }
     
     // Indicate we've paused
     instance->bp_paused = true;
+    instance->cpu_running = false;
     char *continue_text = nullptr;
     
     // Unlock mutex since the thread is now halted
@@ -360,6 +543,19 @@ char *GameInstance::on_input_requested(GB_gameboy_s *gameboy) {
     
     // Unpause (mutex is locked from loop)
     instance->continue_text = std::nullopt;
+    instance->step_sp = GB_get_registers(gameboy)->sp;
+    if(std::strcmp(continue_text, "step") == 0) {
+        instance->step_mode = STEP_INSTRUCTION;
+    }
+    else if(std::strcmp(continue_text, "next") == 0) {
+        // Anything that isn't a call is just a step
+        auto opcode = GB_safe_read_memory(gameboy, pc);
+        instance->step_mode = get_sm83_flow_type(opcode) == SM83_FLOW_CALL ? STEP_OVER : STEP_INSTRUCTION;
+    }
+    else if(std::strcmp(continue_text, "finish") == 0) {
+        instance->step_mode = STEP_OUT;
+    }
+    instance->cpu_running = true;
     return continue_text;
 }
 
@@ -373,7 +569,9 @@ float GameInstance::get_frame_rate() noexcept {
 void GameInstance::reset() noexcept {
     this->mutex.lock();
     this->reset_to_original_model();
+    this->begin_boot_without_mutex();
     this->reset_audio();
+    this->clear_rewind_history();
     this->mutex.unlock();
 }
 
@@ -382,7 +580,10 @@ void GameInstance::set_model(GB_model_t model, GB_border_mode_t border) {
     this->original_model = std::nullopt; // we're changing models so it doesn't matter
     GB_switch_model_and_reset(&this->gameboy, model);
     GB_set_border_mode(&this->gameboy, border);
+    this->disassembly_cache.invalidate_memory();
+    this->begin_boot_without_mutex();
     this->reset_audio();
+    this->clear_rewind_history();
     this->update_pixel_buffer_size();
     this->mutex.unlock();
 }
@@ -413,11 +614,15 @@ void GameInstance::start_game_loop(GameInstance *instance) noexcept {
         // Run some cycles on the gameboy
         if(!instance->manual_paused && !instance->rewind_paused && !instance->pause_zero_speed) {
             if(instance->should_rewind) {
-                GB_rewind_pop(&instance->gameboy);
-                if(!GB_rewind_pop(&instance->gameboy)) { // if we can't rewind any further, pause until the user lets go of the rewind button
+                instance->discard_rewind_frames_after_seek();
+
+                // Go back to the frame before the last one we recorded; if we can't rewind any further, pause until the user lets go of the rewind button
+                if(!instance->rewind_buffer.pop(instance->rewind_frame, instance->rewind_state) || GB_load_state_from_buffer(&instance->gameboy, instance->rewind_state.data(), instance->rewind_state.size()) != 0) {
                     instance->rewind_paused = true;
                 }
+                instance->disassembly_cache.invalidate_memory();
                 instance->should_rewind = false;
+                instance->boot_snapshot_pending = false;
             }
 
             // Skip intro if needed
@@ -430,7 +635,19 @@ void GameInstance::start_game_loop(GameInstance *instance) noexcept {
             }
 
             GB_set_key_mask(&instance->gameboy, button_bitfield);
-            GB_run(&instance->gameboy);
+
+            // Input can change how the boot ROM ends (e.g. picking a palette on a Game Boy Color), so don't cache a boot like that
+            if(button_bitfield != 0) {
+                instance->boot_snapshot_pending = false;
+            }
+
+            instance->cpu_running = true;
+            instance->elapsed_cycles += GB_run(&instance->gameboy);
+            instance->cpu_running = false;
+
+            if(instance->boot_snapshot_pending) {
+                instance->capture_boot_snapshot_if_ready();
+            }
             
             // Wait until the end of GB_run to calculate frame rate
             if(instance->vblank_hit) {
@@ -454,6 +671,11 @@ void GameInstance::start_game_loop(GameInstance *instance) noexcept {
                     instance->frame_rate = fps_buffer_size / f_total;
                 }
                 
+                // Record the frame for rewinding unless we're rewinding through it
+                if(!instance->should_rewind) {
+                    instance->record_rewind_frame();
+                }
+
                 // Done
                 instance->vblank_hit = false;
 
@@ -493,50 +715,161 @@ void GameInstance::start_game_loop(GameInstance *instance) noexcept {
     instance->loop_running = false;
 }
 
-std::vector<std::pair<std::string, std::uint16_t>> GameInstance::get_backtrace() {
-    // Get the backtrace string
-    this->mutex.lock();
-
-    std::vector<std::pair<std::string, std::uint16_t>> backtrace;
-    auto *cmd = malloc_string("backtrace");
-    auto backtrace_str = execute_command_without_mutex(cmd);
+void GameInstance::update_backtrace_without_mutex() {
+    // SameBoy keeps return addresses oldest first with nothing in the first slot, which is where the current PC goes
     std::size_t bt_count = get_gb_backtrace_size(&this->gameboy);
-    backtrace.resize(bt_count);
-    for(std::size_t b = 1; b < bt_count; b++) {
-        backtrace[bt_count - b].second = get_gb_backtrace_address(&this->gameboy, b);
+    bool changed = bt_count != this->backtrace.size();
+    if(changed) {
+        this->backtrace.resize(bt_count);
+    }
+
+    for(std::size_t b = 0; b < bt_count; b++) {
+        auto &frame = this->backtrace[b];
+        std::uint16_t address, bank;
+        if(b == 0) {
+            address = get_gb_register(&this->gameboy, SM83Register::SM83_REG_PC);
+            bank = get_gb_bank_for_address(&this->gameboy, address);
+        }
+        else {
+            address = get_gb_backtrace_address(&this->gameboy, bt_count - b);
+            bank = get_gb_backtrace_bank(&this->gameboy, bt_count - b);
+        }
+
+        if(!changed && frame.address == address && frame.bank == bank) {
+            continue;
+        }
+
+        changed = true;
+        frame.address = address;
+        frame.bank = bank;
+        frame.symbol_offset = 0;
+        const char *symbol = get_gb_symbol_for_address(&this->gameboy, bank, address, &frame.symbol_offset);
+        frame.symbol = symbol != nullptr ? symbol : "";
     }
-    if(bt_count > 0) {
-        backtrace[0].second = get_gb_register(&this->gameboy, SM83Register::SM83_REG_PC);
+
+    if(changed) {
+        this->backtrace_generation++;
     }
+}
+
+std::vector<GameInstance::BacktraceFrame> GameInstance::get_backtrace() {
+    this->mutex.lock();
+    this->update_backtrace_without_mutex();
+    auto backtrace = this->backtrace;
+    this->mutex.unlock();
+    return backtrace;
+}
 
+std::uint64_t GameInstance::get_backtrace_generation() {
+    this->mutex.lock();
+    this->update_backtrace_without_mutex();
+    auto generation = this->backtrace_generation;
     this->mutex.unlock();
+    return generation;
+}
+
+void GameInstance::sync_breakpoints_without_mutex() {
+    if(this->synced_breakpoint_generation == this->breakpoints.get_enabled_generation()) {
+        return;
+    }
 
-    // Process the backtraces now that the mutex has unlocked
-    std::size_t backtrace_str_len = backtrace_str.size();
-    std::size_t str_start = 0;
-    std::size_t backtrace_line = 0;
-    for(std::size_t b = 0; b < backtrace_str_len && backtrace_line < bt_count; b++) {
-        if(backtrace_str[b] == '\n') {
-            backtrace[backtrace_line].first = std::string(backtrace_str, str_start, b - str_start);
-            str_start = b + 1;
-            backtrace_line++;
+    // SameBoy sorts by bank first, then address
+    std::vector<std::uint32_t> keys;
+    keys.reserve(this->breakpoints.size());
+    for(auto &b : this->breakpoints.get_breakpoints()) {
+        if(b.enabled) {
+            keys.emplace_back(static_cast<std::uint32_t>(b.bank) << 16 | b.address);
         }
     }
+    std::sort(keys.begin(), keys.end());
 
-    return backtrace;
+    if(set_gb_breakpoints(&this->gameboy, keys.data(), keys.size())) {
+        this->synced_breakpoint_generation = this->breakpoints.get_enabled_generation();
+    }
+}
+
+std::optional<SM83Expression> GameInstance::compile_expression_without_mutex(const std::string &expression, std::string &error) {
+    // Symbols are resolved now so they don't have to be looked up every time it's evaluated
+    return SM83Expression::compile(expression, error, [this](const std::string &name) -> std::optional<std::uint16_t> {
+        std::uint16_t value;
+        if(GB_debugger_evaluate(&this->gameboy, name.c_str(), &value, nullptr) == 0) {
+            return value;
+        }
+        return std::nullopt;
+    });
+}
+
+bool GameInstance::set_breakpoint_condition(std::uint16_t address, std::uint16_t bank, const std::string &condition, std::string &error) {
+    this->mutex.lock();
+
+    std::shared_ptr<const SM83Expression> compiled;
+    if(!condition.empty()) {
+        auto expression = this->compile_expression_without_mutex(condition, error);
+        if(!expression.has_value()) {
+            this->mutex.unlock();
+            return false;
+        }
+        compiled = std::make_shared<const SM83Expression>(std::move(*expression));
+    }
+
+    this->breakpoints.add(address, bank);
+    this->breakpoints.set_condition(address, bank, std::move(compiled));
+    this->sync_breakpoints_without_mutex();
+    this->mutex.unlock();
+    return true;
+}
+
+void GameInstance::evaluate_watches_without_mutex() noexcept {
+    if(this->watches.empty()) {
+        return;
+    }
+
+    auto state = get_expression_state(&this->gameboy);
+    for(auto &w : this->watches) {
+        w.value = w.expression.evaluate(state, read_memory_for_expression, &this->gameboy);
+    }
+}
+
+bool GameInstance::add_watch(const std::string &expression, std::string &error) {
+    this->mutex.lock();
+    auto compiled = this->compile_expression_without_mutex(expression, error);
+    if(compiled.has_value()) {
+        this->watches.push_back({ std::move(*compiled), 0 });
+        this->evaluate_watches_without_mutex();
+    }
+    this->mutex.unlock();
+    return compiled.has_value();
+}
+
+void GameInstance::remove_watch(std::size_t index) {
+    this->mutex.lock();
+    if(index < this->watches.size()) {
+        this->watches.erase(this->watches.begin() + index);
+    }
+    this->mutex.unlock();
 }
 
-std::vector<std::uint16_t> GameInstance::get_breakpoints_without_mutex() {
-    std::vector<std::uint16_t> breakpoints;
-    std::size_t bp_count = get_gb_breakpoint_size(&this->gameboy);
-    breakpoints.resize(bp_count);
-    for(std::size_t b = 0; b < bp_count; b++) {
-        breakpoints[b] = get_gb_breakpoint_address(&this->gameboy, b);
+std::vector<std::pair<std::string, std::uint16_t>> GameInstance::get_watches() {
+    std::vector<std::pair<std::string, std::uint16_t>> watches;
+
+    this->mutex.lock();
+
+    // Nothing runs while we're paused, so make sure edited registers and memory show up
+    if(this->bp_paused) {
+        this->evaluate_watches_without_mutex();
+    }
+
+    watches.reserve(this->watches.size());
+    for(auto &w : this->watches) {
+        watches.emplace_back(w.expression.get_text(), w.value);
     }
-    return breakpoints;
+    this->mutex.unlock();
+
+    return watches;
 }
 
-std::vector<std::uint16_t> GameInstance::get_breakpoints() MAKE_GETTER(this->get_breakpoints_without_mutex())
+std::vector<Breakpoint> GameInstance::get_breakpoints() MAKE_GETTER(this->breakpoints.get_breakpoints())
+std::uint64_t GameInstance::get_breakpoint_generation() noexcept MAKE_GETTER(this->breakpoints.get_generation())
 
 bool GameInstance::read_pixel_buffer(std::uint32_t *destination, std::size_t destination_length) noexcept {
     this->vblank_mutex.lock();
@@ -647,8 +980,19 @@ void GameInstance::transfer_sample_buffer(std::vector<std::int16_t> &destination
 
 void GameInstance::on_sample(GB_gameboy_s *gameboy, GB_sample_t *sample) {
     auto *instance = resolve_instance(gameboy);
+
+    // Record the raw output before volume, mono, or SDL's buffer limits can touch it
+    if(instance->audio_recorder != nullptr) {
+        instance->record_sample(sample);
+    }
+    if(instance->oscilloscope_enabled) {
+        instance->update_oscilloscope(sample);
+    }
+
     if(instance->audio_enabled) {
         auto &buffer = instance->sample_buffer;
+        auto &stats = instance->audio_statistics;
+        stats.samples_produced.fetch_add(1, std::memory_order_relaxed);
 
         auto &left = sample->left;
         auto &right = sample->right;
@@ -682,7 +1026,12 @@ void GameInstance::on_sample(GB_gameboy_s *gameboy, GB_sample_t *sample) {
 
             // If we have too many frames queued, flush the buffer (causes popping but prevents high delay)
             if(frames_queued > max_frames_queued) {
-                if(!turbo_mode) {
+                if(turbo_mode) {
+                    stats.samples_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    stats.samples_dropped.fetch_add(1 + instance->sample_buffer.size() / 2, std::memory_order_relaxed); // the flush throws away what we buffered, too
+                    stats.flush_events.fetch_add(1, std::memory_order_relaxed);
                     instance->reset_audio();
                 }
                 return;
@@ -701,6 +1050,26 @@ void GameInstance::on_sample(GB_gameboy_s *gameboy, GB_sample_t *sample) {
             std::size_t actual_buffered_frames = instance->sample_buffer.size() / 2;
 
             if(actual_buffered_frames >= required_buffered_frames) {
+                // Did the device run out of audio since we last queued?
+                if(frames_queued == 0 && instance->sdl_audio_playing) {
+                    stats.underruns.fetch_add(1, std::memory_order_relaxed);
+                }
+                instance->sdl_audio_playing = true;
+
+                auto depth_bucket = std::min(frames_queued / std::max<std::size_t>(buffer_size, 1), AUDIO_QUEUE_DEPTH_BUCKETS - 1);
+                stats.queue_depth_histogram[depth_bucket].fetch_add(1, std::memory_order_relaxed);
+                stats.samples_queued.fetch_add(actual_buffered_frames, std::memory_order_relaxed);
+
+                // The newest sample has to wait for everything already queued plus the device's own buffer
+                auto sample_rate = instance->current_sample_rate.load();
+                if(sample_rate > 0) {
+                    auto latency_us = static_cast<std::uint32_t>((frames_queued + actual_buffered_frames + buffer_size) * 1000000ULL / sample_rate);
+                    stats.latency_us.store(latency_us, std::memory_order_relaxed);
+                    if(latency_us > stats.max_latency_us.load(std::memory_order_relaxed)) {
+                        stats.max_latency_us.store(latency_us, std::memory_order_relaxed);
+                    }
+                }
+
                 SDL_QueueAudio(dev, instance->sample_buffer.data(), instance->sample_buffer.size() * sizeof(*instance->sample_buffer.data()));
                 instance->sample_buffer.clear();
                 instance->unpause_sdl_audio();
@@ -711,10 +1080,151 @@ void GameInstance::on_sample(GB_gameboy_s *gameboy, GB_sample_t *sample) {
         else {
             buffer.emplace_back(left);
             buffer.emplace_back(right);
+            stats.samples_queued.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Get the output of an APU channel, centering the 4-bit DAC input around 0 (silent channels are 0)
+static std::int16_t get_channel_output(const GB_gameboy_s *gameboy, std::size_t channel) noexcept {
+    int level = get_gb_channel_sample(gameboy, static_cast<GB_channel_t>(channel));
+    return level < 0 ? 0 : static_cast<std::int16_t>((level * 2 - 15) * 2048);
+}
+
+void GameInstance::record_sample(const GB_sample_t *sample) noexcept {
+    AudioRecorder::Frame frame;
+    frame.left = sample->left;
+    frame.right = sample->right;
+
+    if(this->audio_recorder->is_recording_stems()) {
+        for(std::size_t c = 0; c < AudioRecorder::STEM_COUNT; c++) {
+            frame.stems[c] = get_channel_output(&this->gameboy, c);
+        }
+    }
+    else {
+        std::fill(std::begin(frame.stems), std::end(frame.stems), 0);
+    }
+
+    this->audio_recorder->push(frame);
+
+    if(this->audio_recorder->has_failed()) {
+        this->interrupt_audio_recording_without_mutex();
+    }
+}
+
+void GameInstance::interrupt_audio_recording_without_mutex() noexcept {
+    // Only one recording can be running at a time, and start_audio_recording() clears this first, so nothing gets overwritten
+    this->interrupted_audio_recorder = std::move(this->audio_recorder);
+    this->release_audio_recording_sample_rate_without_mutex();
+}
+
+void GameInstance::release_audio_recording_sample_rate_without_mutex() noexcept {
+    if(this->audio_recorder_set_sample_rate && this->current_sample_rate == 0) {
+        GB_set_sample_rate(&this->gameboy, 0);
+    }
+    this->audio_recorder_set_sample_rate = false;
+}
+
+GameInstance::AudioRecordingResult GameInstance::finish_audio_recording(AudioRecorder &recorder) noexcept {
+    recorder.finish();
+
+    AudioRecordingResult result;
+    result.frames_written = recorder.get_frames_written();
+    result.frames_dropped = recorder.get_frames_dropped();
+    result.write_failed = recorder.has_failed();
+    return result;
+}
+
+void GameInstance::update_oscilloscope(const GB_sample_t *sample) noexcept {
+    std::int16_t values[OSCILLOSCOPE_TRACE_COUNT];
+    for(std::size_t c = 0; c < AudioRecorder::STEM_COUNT; c++) {
+        values[c] = get_channel_output(&this->gameboy, c);
+    }
+    values[OSCILLOSCOPE_TRACE_COUNT - 1] = static_cast<std::int16_t>((sample->left + sample->right) / 2);
+
+    auto &pending = this->oscilloscope_pending;
+    if(this->oscilloscope_pending_samples == 0) {
+        std::copy(std::begin(values), std::end(values), pending.min);
+        std::copy(std::begin(values), std::end(values), pending.max);
+    }
+    else {
+        for(std::size_t t = 0; t < OSCILLOSCOPE_TRACE_COUNT; t++) {
+            pending.min[t] = std::min(pending.min[t], values[t]);
+            pending.max[t] = std::max(pending.max[t], values[t]);
         }
     }
+
+    // Once we have enough samples, send it off (if the UI isn't keeping up, it just loses this record)
+    if(++this->oscilloscope_pending_samples >= this->oscilloscope_decimation) {
+        this->oscilloscope_ring.push(pending);
+        this->oscilloscope_pending_samples = 0;
+    }
+}
+
+void GameInstance::set_oscilloscope_enabled(bool enabled) noexcept {
+    this->mutex.lock();
+    this->oscilloscope_decimation = std::max<std::size_t>(1, this->current_sample_rate / OSCILLOSCOPE_RECORDS_PER_SECOND);
+    this->oscilloscope_pending_samples = 0;
+    this->oscilloscope_enabled = enabled;
+    this->mutex.unlock();
+}
+
+std::size_t GameInstance::read_oscilloscope(OscilloscopeRecord *destination, std::size_t count) noexcept {
+    return this->oscilloscope_ring.pop(destination, count);
+}
+
+bool GameInstance::start_audio_recording(const std::filesystem::path &path, bool stems, bool block_when_full, std::uint32_t sample_rate) noexcept {
+    this->stop_audio_recording();
+    this->pop_interrupted_audio_recording();
+
+    this->mutex.lock();
+
+    // SameBoy only generates samples if it has a sample rate, so give it one if audio isn't set up
+    std::uint32_t rate = this->current_sample_rate;
+    if(rate == 0) {
+        rate = sample_rate;
+        GB_set_sample_rate(&this->gameboy, rate);
+        this->audio_recorder_set_sample_rate = true;
+    }
+
+    auto recorder = std::make_unique<AudioRecorder>(path, rate, stems, block_when_full);
+    bool success = recorder->is_open();
+    if(success) {
+        this->audio_recorder = std::move(recorder);
+    }
+
+    this->mutex.unlock();
+    return success;
+}
+
+std::optional<GameInstance::AudioRecordingResult> GameInstance::stop_audio_recording() noexcept {
+    this->mutex.lock();
+    auto recorder = std::move(this->audio_recorder);
+    this->release_audio_recording_sample_rate_without_mutex();
+    this->mutex.unlock();
+
+    if(recorder == nullptr) {
+        return std::nullopt;
+    }
+
+    // Finish it outside of the mutex so the emulation thread isn't held up while the last samples are written
+    return finish_audio_recording(*recorder);
+}
+
+std::optional<GameInstance::AudioRecordingResult> GameInstance::pop_interrupted_audio_recording() noexcept {
+    this->mutex.lock();
+    auto recorder = std::move(this->interrupted_audio_recorder);
+    this->mutex.unlock();
+
+    if(recorder == nullptr) {
+        return std::nullopt;
+    }
+
+    return finish_audio_recording(*recorder);
 }
 
+bool GameInstance::is_recording_audio() noexcept MAKE_GETTER(this->audio_recorder != nullptr)
+
 void GameInstance::set_audio_enabled(bool enabled, std::uint32_t sample_rate) noexcept {
     this->mutex.lock();
     this->sample_buffer.clear();
@@ -735,6 +1245,39 @@ void GameInstance::set_audio_enabled(bool enabled, std::uint32_t sample_rate) no
     this->mutex.unlock();
 }
 
+GameInstance::AudioStatistics GameInstance::get_audio_statistics() const noexcept {
+    const auto &counters = this->audio_statistics;
+
+    AudioStatistics stats;
+    stats.samples_produced = counters.samples_produced.load(std::memory_order_relaxed);
+    stats.samples_queued = counters.samples_queued.load(std::memory_order_relaxed);
+    stats.samples_dropped = counters.samples_dropped.load(std::memory_order_relaxed);
+    stats.flush_events = counters.flush_events.load(std::memory_order_relaxed);
+    stats.reset_audio_calls = counters.reset_audio_calls.load(std::memory_order_relaxed);
+    stats.underruns = counters.underruns.load(std::memory_order_relaxed);
+    for(std::size_t i = 0; i < AUDIO_QUEUE_DEPTH_BUCKETS; i++) {
+        stats.queue_depth_histogram[i] = counters.queue_depth_histogram[i].load(std::memory_order_relaxed);
+    }
+    stats.latency_ms = counters.latency_us.load(std::memory_order_relaxed) / 1000.0;
+    stats.max_latency_ms = counters.max_latency_us.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+void GameInstance::reset_audio_statistics() noexcept {
+    auto &counters = this->audio_statistics;
+    counters.samples_produced = 0;
+    counters.samples_queued = 0;
+    counters.samples_dropped = 0;
+    counters.flush_events = 0;
+    counters.reset_audio_calls = 0;
+    counters.underruns = 0;
+    for(auto &i : counters.queue_depth_histogram) {
+        i = 0;
+    }
+    counters.latency_us = 0;
+    counters.max_latency_us = 0;
+}
+
 void GameInstance::set_speed_multiplier(double speed_multiplier) noexcept {
     this->mutex.lock();
     if(speed_multiplier < 0.001) {
@@ -775,7 +1318,8 @@ std::string GameInstance::clear_log_buffer() {
 
 void GameInstance::break_immediately() noexcept {
     this->mutex.lock();
-    if(this->current_break_and_trace_remaining == 0) {
+    if(!this->tracing) {
+        this->break_requested = true;
         GB_debugger_break(&this->gameboy);
     }
     this->mutex.unlock();
@@ -791,6 +1335,7 @@ void GameInstance::unbreak(const char *command) {
 }
 
 std::uint16_t GameInstance::get_register_value(SM83Register reg) noexcept MAKE_GETTER(get_gb_register(&this->gameboy, reg))
+SM83ExpressionState GameInstance::get_registers() noexcept MAKE_GETTER(get_expression_state(&this->gameboy))
 void GameInstance::set_register_value(SM83Register reg, std::uint16_t value) noexcept MAKE_SETTER(set_gb_register(&this->gameboy, reg, value))
 
 std::optional<std::uint16_t> GameInstance::evaluate_expression(const char *expression) noexcept {
@@ -832,6 +1377,9 @@ void GameInstance::begin_loading_rom() noexcept {
     this->clear_all_button_states_no_mutex();
 
     // Reset break and trace
+    if(this->tracing) {
+        this->finish_trace_without_mutex();
+    }
     this->current_break_and_trace_remaining = 0;
     this->break_and_trace_result.clear();
     this->break_and_trace_breakpoints.clear();
@@ -842,6 +1390,14 @@ void GameInstance::begin_loading_rom() noexcept {
     // Reset the gameboy
     this->reset_to_original_model();
 
+    // Old history belongs to the old ROM
+    this->clear_rewind_history();
+
+    // Same with anything we decoded from it or counted running
+    this->disassembly_cache.clear();
+    this->coverage.clear();
+    this->profiler.clear();
+
     // Reset frame times
     this->frame_time_index = 0;
     this->last_frame_time = clock::now();
@@ -853,6 +1409,7 @@ void GameInstance::load_rom(const std::byte *rom_data, const std::size_t rom_siz
     // Load the ROM
     GB_load_rom_from_buffer(&this->gameboy, reinterpret_cast<const std::uint8_t *>(rom_data), rom_size);
     this->load_save_and_symbols(sram_path, symbol_path);
+    this->begin_boot_without_mutex();
 
     this->mutex.unlock();
 }
@@ -866,6 +1423,7 @@ int GameInstance::load_isx(const std::filesystem::path &isx_path, const std::opt
     // If successful, load the battery and symbol files
     if(result == 0) {
         this->load_save_and_symbols(sram_path, symbol_path);
+        this->begin_boot_without_mutex();
     }
     
     this->mutex.unlock();
@@ -875,6 +1433,10 @@ int GameInstance::load_isx(const std::filesystem::path &isx_path, const std::opt
 void GameInstance::load_save_and_symbols(const std::optional<std::filesystem::path> &sram_path, const std::optional<std::filesystem::path> &symbol_path) {
     GB_debugger_clear_symbols(&this->gameboy);
     this->rom_loaded = true;
+
+    std::size_t rom_size = 0;
+    const auto *rom = GB_get_direct_access(&this->gameboy, GB_DIRECT_ACCESS_ROM, &rom_size, nullptr);
+    this->rom_hash = rom != nullptr ? fnv1a_64(rom, rom_size) : 0;
     
     if(sram_path.has_value()) {
         GB_load_battery(&this->gameboy, sram_path->string().c_str());
@@ -882,11 +1444,28 @@ void GameInstance::load_save_and_symbols(const std::optional<std::filesystem::pa
     if(symbol_path.has_value()) {
         GB_debugger_load_symbol_file(&this->gameboy, symbol_path->string().c_str());
     }
+
+    // Samples from now on belong to these symbols
+    if(this->profiling) {
+        this->profiler.set_symbols(this->get_profile_symbols_without_mutex());
+    }
 }
 
 
 int GameInstance::save_sram(const std::filesystem::path &path) noexcept MAKE_GETTER(GB_save_battery(&this->gameboy, path.string().c_str()))
 
+GameInstance::clock::duration GameInstance::create_sram_snapshot(std::vector<std::uint8_t> &sram) {
+    this->mutex.lock();
+    auto start = clock::now();
+    sram.resize(GB_save_battery_size(&this->gameboy));
+    if(!sram.empty()) {
+        GB_save_battery_to_buffer(&this->gameboy, sram.data(), sram.size());
+    }
+    auto stall = clock::now() - start;
+    this->mutex.unlock();
+    return stall;
+}
+
 std::string GameInstance::execute_command_without_mutex(char *command) {
     this->retain_logs(true);
     GB_debugger_execute_command(&this->gameboy, command);
@@ -925,26 +1504,224 @@ std::string GameInstance::disassemble_without_mutex(std::uint16_t address, std::
 
 std::string GameInstance::disassemble_address(std::uint16_t address, std::uint8_t count) MAKE_GETTER(disassemble_without_mutex(address, count))
 
-std::size_t GameInstance::get_pixel_buffer_size_without_mutex() noexcept {
-    return GB_get_screen_width(&this->gameboy) * GB_get_screen_height(&this->gameboy);
-}
-bool GameInstance::set_up_sdl_audio(std::uint32_t sample_rate, std::uint32_t buffer_size) noexcept {
-    this->mutex.lock();
-    SDL_AudioSpec request = {}, result = {}, preferred = {};
-    request.format = AUDIO_S16SYS;
-    request.channels = 2;
-    request.userdata = this;
+void GameInstance::decode_instruction_without_mutex(std::uint16_t address, SM83Instruction &instruction) {
+    auto bank = get_gb_bank_for_address(&this->gameboy, address);
 
-    SDL_GetAudioDeviceSpec(0, 0, &preferred);
-    request.freq = preferred.freq;
-    request.samples = preferred.samples;
+    // The boot ROM sits on top of the cartridge until it finishes, so don't mix the two up in the cache
+    bool use_cache = address >= 0x900 || is_gb_boot_rom_finished(&this->gameboy);
 
-    int flags = 0;
+    if(!use_cache || !this->disassembly_cache.find(address, bank, instruction)) {
+        std::uint8_t bytes[3];
+        bytes[0] = GB_safe_read_memory(&this->gameboy, address);
 
-    if(sample_rate != 0) {
-        request.freq = sample_rate;
-        flags |= SDL_AUDIO_ALLOW_FREQUENCY_CHANGE;
-    }
+        // Only read what the instruction needs so we don't touch anything past it
+        auto length = get_sm83_instruction_length(bytes[0]);
+        for(std::uint8_t i = 1; i < sizeof(bytes); i++) {
+            bytes[i] = i < length ? GB_safe_read_memory(&this->gameboy, static_cast<std::uint16_t>(address + i)) : 0;
+        }
+
+        decode_sm83_instruction(address, bytes, instruction);
+        instruction.bank = bank;
+
+        if(use_cache) {
+            this->disassembly_cache.insert(instruction);
+        }
+    }
+
+    this->look_up_symbols_without_mutex(instruction);
+}
+
+void GameInstance::look_up_symbols_without_mutex(SM83Instruction &instruction) {
+    const char *symbol = GB_debugger_name_for_address(&this->gameboy, instruction.address);
+    instruction.symbol = symbol != nullptr ? symbol : "";
+
+    const char *target_symbol = instruction.target.has_value() ? GB_debugger_name_for_address(&this->gameboy, *instruction.target) : nullptr;
+    instruction.target_symbol = target_symbol != nullptr ? target_symbol : "";
+}
+
+void GameInstance::decode_instruction_in_bank_without_mutex(std::uint16_t address, std::uint16_t bank, bool boot_rom, SM83Instruction &instruction) {
+    // The boot ROM and ROM banks can't change, so those can be decoded exactly as they were when they ran
+    std::size_t size = 0;
+    const std::uint8_t *source = nullptr;
+    std::size_t offset = 0;
+
+    // The boot ROM covers $0000-$00FF, plus $0200-$08FF on a Game Boy Color
+    if(boot_rom && (address < 0x100 || address >= 0x200)) {
+        source = reinterpret_cast<const std::uint8_t *>(GB_get_direct_access(&this->gameboy, GB_DIRECT_ACCESS_BOOTROM, &size, nullptr));
+        offset = address;
+        boot_rom = source != nullptr && offset < size;
+    }
+    else {
+        boot_rom = false;
+    }
+
+    if(!boot_rom && address < 0x8000) {
+        if(this->disassembly_cache.find(address, bank, instruction)) {
+            this->look_up_symbols_without_mutex(instruction);
+            return;
+        }
+        source = reinterpret_cast<const std::uint8_t *>(GB_get_direct_access(&this->gameboy, GB_DIRECT_ACCESS_ROM, &size, nullptr));
+        offset = static_cast<std::size_t>(bank) * 0x4000 + (address & 0x3FFF);
+    }
+
+    // Anything else could have changed since, so the best we can do is what's there now
+    if(source == nullptr || offset >= size) {
+        this->decode_instruction_without_mutex(address, instruction);
+        return;
+    }
+
+    std::uint8_t bytes[3] = {};
+    for(std::size_t i = 0; i < sizeof(bytes) && offset + i < size; i++) {
+        bytes[i] = source[offset + i];
+    }
+
+    decode_sm83_instruction(address, bytes, instruction);
+    instruction.bank = bank;
+    if(!boot_rom) {
+        this->disassembly_cache.insert(instruction);
+    }
+
+    this->look_up_symbols_without_mutex(instruction);
+}
+
+std::optional<std::filesystem::path> GameInstance::pop_finished_trace_file() {
+    while(true) {
+        std::unique_ptr<TraceFileWriter> writer;
+
+        this->mutex.lock();
+        auto finished = std::find_if(this->finishing_trace_files.begin(), this->finishing_trace_files.end(), [](auto &w) { return w->is_finished(); });
+        if(finished != this->finishing_trace_files.end()) {
+            writer = std::move(*finished);
+            this->finishing_trace_files.erase(finished);
+        }
+        this->mutex.unlock();
+
+        if(writer == nullptr) {
+            return std::nullopt;
+        }
+
+        // It's done, so this doesn't wait on anything
+        auto path = writer->get_path();
+        bool succeeded = writer->succeeded();
+        writer.reset();
+        if(succeeded) {
+            return path;
+        }
+    }
+}
+
+std::uint64_t GameInstance::get_rom_hash() noexcept MAKE_GETTER(this->rom_hash)
+
+std::vector<SM83Instruction> GameInstance::decode_trace(const std::vector<BreakAndTraceResult> &results) {
+    std::vector<SM83Instruction> instructions(results.size());
+
+    this->mutex.lock();
+    for(std::size_t i = 0; i < results.size(); i++) {
+        auto &r = results[i];
+        this->decode_instruction_in_bank_without_mutex(r.pc, r.bank, r.flags & TRACE_RECORD_BOOT_ROM, instructions[i]);
+    }
+    this->mutex.unlock();
+
+    return instructions;
+}
+
+std::vector<SM83Instruction> GameInstance::disassemble_instructions_without_mutex(std::uint16_t address, std::size_t count) {
+    std::vector<SM83Instruction> instructions(count);
+    for(auto &i : instructions) {
+        this->decode_instruction_without_mutex(address, i);
+        address += i.length;
+    }
+    return instructions;
+}
+
+std::vector<SM83Instruction> GameInstance::disassemble_instructions(std::uint16_t address, std::size_t count) MAKE_GETTER(this->disassemble_instructions_without_mutex(address, count))
+
+DisassemblyCache::Statistics GameInstance::get_disassembly_cache_statistics() MAKE_GETTER(this->disassembly_cache.get_statistics())
+
+std::uint64_t GameInstance::get_memory_generation(std::uint16_t address, std::size_t length) {
+    this->mutex.lock();
+
+    auto generation = this->disassembly_cache.get_generation(address, length);
+    auto hash = fnv1a_64(&generation, sizeof(generation));
+
+    // Banks are 4 KiB or larger, so checking every 4 KiB in the range catches every bank that's mapped in
+    bool boot_rom = !is_gb_boot_rom_finished(&this->gameboy);
+    hash = fnv1a_64(&boot_rom, sizeof(boot_rom), hash);
+    auto last = static_cast<std::uint32_t>(address) + std::max<std::size_t>(length, 1) - 1;
+    for(std::uint32_t a = address & 0xF000; a <= last; a += 0x1000) {
+        auto bank = get_gb_bank_for_address(&this->gameboy, static_cast<std::uint16_t>(a));
+        hash = fnv1a_64(&bank, sizeof(bank), hash);
+    }
+
+    this->mutex.unlock();
+    return hash;
+}
+
+GameInstance::DisassemblerBenchmark GameInstance::benchmark_disassembler(std::uint16_t address, std::size_t count) {
+    DisassemblerBenchmark result = {};
+    count = std::max<std::size_t>(count, 1);
+
+    auto per_second = [&count](clock::time_point start) {
+        auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+        return seconds > 0.0 ? count / seconds : 0.0;
+    };
+
+    this->mutex.lock();
+
+    // SameBoy only does up to 255 at a time, so it goes in chunks of that (same as the debugger does per refresh). Find where
+    // each chunk starts ahead of time so both decode the same instructions once each without that counting against either.
+    std::vector<std::pair<std::uint16_t, std::uint8_t>> chunks;
+    SM83Instruction instruction;
+    auto chunk_address = address;
+    for(std::size_t remaining = count; remaining > 0;) {
+        auto chunk = static_cast<std::uint8_t>(std::min<std::size_t>(remaining, 255));
+        chunks.emplace_back(chunk_address, chunk);
+        for(std::size_t i = 0; i < chunk; i++) {
+            this->decode_instruction_without_mutex(chunk_address, instruction);
+            chunk_address += instruction.length;
+        }
+        remaining -= chunk;
+    }
+
+    auto start = clock::now();
+    auto native_address = address;
+    for(std::size_t i = 0; i < count; i++) {
+        this->decode_instruction_without_mutex(native_address, instruction);
+        native_address += instruction.length;
+    }
+    result.native_per_second = per_second(start);
+
+    start = clock::now();
+    for(auto &chunk : chunks) {
+        this->disassemble_without_mutex(chunk.first, chunk.second);
+    }
+    result.log_per_second = per_second(start);
+
+    this->mutex.unlock();
+
+    return result;
+}
+
+std::size_t GameInstance::get_pixel_buffer_size_without_mutex() noexcept {
+    return GB_get_screen_width(&this->gameboy) * GB_get_screen_height(&this->gameboy);
+}
+bool GameInstance::set_up_sdl_audio(std::uint32_t sample_rate, std::uint32_t buffer_size) noexcept {
+    this->mutex.lock();
+    SDL_AudioSpec request = {}, result = {}, preferred = {};
+    request.format = AUDIO_S16SYS;
+    request.channels = 2;
+    request.userdata = this;
+
+    SDL_GetAudioDeviceSpec(0, 0, &preferred);
+    request.freq = preferred.freq;
+    request.samples = preferred.samples;
+
+    int flags = 0;
+
+    if(sample_rate != 0) {
+        request.freq = sample_rate;
+        flags |= SDL_AUDIO_ALLOW_FREQUENCY_CHANGE;
+    }
 
     if(buffer_size != 0) {
         request.samples = buffer_size;
@@ -990,6 +1767,9 @@ void GameInstance::unpause_sdl_audio() noexcept {
 }
 
 void GameInstance::reset_audio() noexcept {
+    this->audio_statistics.reset_audio_calls.fetch_add(1, std::memory_order_relaxed);
+    this->sdl_audio_playing = false;
+
     if(this->sdl_audio_device.has_value()) {
         SDL_PauseAudioDevice(*this->sdl_audio_device, 1);
         SDL_ClearQueuedAudio(*this->sdl_audio_device);
@@ -1007,6 +1787,12 @@ void GameInstance::close_sdl_audio_device() noexcept {
 
 void GameInstance::set_current_sample_rate(std::uint32_t new_sample_rate) noexcept {
     this->current_sample_rate = new_sample_rate;
+
+    // A WAV file can't change sample rates partway through, so end the recording (it gets finished outside of the mutex)
+    if(this->audio_recorder != nullptr && new_sample_rate != 0 && new_sample_rate != this->audio_recorder->get_sample_rate()) {
+        std::fprintf(stderr, "Sample rate changed - audio recording stopped\n");
+        this->interrupt_audio_recording_without_mutex();
+    }
 }
 
 void GameInstance::set_turbo_mode(bool turbo, float ratio) noexcept {
@@ -1017,31 +1803,53 @@ void GameInstance::set_turbo_mode(bool turbo, float ratio) noexcept {
     this->mutex.unlock();
 }
 
-void GameInstance::set_boot_rom_path(const std::optional<std::filesystem::path> &boot_rom_path) MAKE_SETTER(this->boot_rom_path = boot_rom_path)
+void GameInstance::set_boot_rom_path(const std::optional<std::filesystem::path> &boot_rom_path) MAKE_SETTER(this->boot_rom_path = boot_rom_path; this->boot_rom_file_modified = std::nullopt)
 void GameInstance::set_use_fast_boot_rom(bool fast_boot_rom) noexcept MAKE_SETTER(this->fast_boot_rom = fast_boot_rom)
+void GameInstance::set_boot_snapshot_enabled(bool enabled) noexcept MAKE_SETTER(this->boot_snapshot_enabled = enabled; this->boot_snapshot_pending = this->boot_snapshot_pending && enabled)
+void GameInstance::set_boot_snapshot_directory(const std::optional<std::filesystem::path> &directory, BackgroundIO *io) MAKE_SETTER(this->boot_snapshot_cache.set_directory(directory, io))
 
-void GameInstance::break_and_trace_at(std::uint16_t address, std::size_t n, bool step_over, bool break_when_done) {
+void GameInstance::break_and_trace_at(std::uint16_t address, std::size_t n, bool step_over, bool break_when_done, const std::optional<std::filesystem::path> &trace_path) {
     // Remove the breakpoint
     this->remove_breakpoint(address);
 
     // Re-add it now
     this->mutex.lock();
-    this->break_and_trace_breakpoints.emplace_back(address, n, step_over, break_when_done);
-
-    char command[512];
-    std::snprintf(command, sizeof(command), "breakpoint $%04x", address);
-    this->execute_command_without_mutex(malloc_string(command));
+    this->break_and_trace_breakpoints[address] = { n, step_over, break_when_done, trace_path };
+    this->breakpoints.add(address);
+    this->sync_breakpoints_without_mutex();
+    this->mutex.unlock();
+}
 
+void GameInstance::break_at(std::uint16_t address, std::uint16_t bank) noexcept {
+    this->mutex.lock();
+    this->breakpoints.add(address, bank);
+    this->sync_breakpoints_without_mutex();
     this->mutex.unlock();
 }
 
-void GameInstance::break_at(std::uint16_t address) noexcept {
+void GameInstance::add_breakpoints(const std::vector<Breakpoint> &breakpoints) {
     this->mutex.lock();
+    this->breakpoints.add(breakpoints);
+    this->sync_breakpoints_without_mutex();
+    this->mutex.unlock();
+}
 
-    char command[512];
-    std::snprintf(command, sizeof(command), "breakpoint $%04x", address);
-    this->execute_command_without_mutex(malloc_string(command));
+void GameInstance::remove_breakpoints(const std::vector<Breakpoint> &breakpoints) {
+    this->mutex.lock();
+    this->breakpoints.remove(breakpoints);
+    for(auto &b : breakpoints) {
+        if(!this->breakpoints.has_breakpoint(b.address)) {
+            this->break_and_trace_breakpoints.erase(b.address);
+        }
+    }
+    this->sync_breakpoints_without_mutex();
+    this->mutex.unlock();
+}
 
+void GameInstance::set_breakpoint_enabled(std::uint16_t address, std::uint16_t bank, bool enabled) {
+    this->mutex.lock();
+    this->breakpoints.set_enabled(address, bank, enabled);
+    this->sync_breakpoints_without_mutex();
     this->mutex.unlock();
 }
 
@@ -1059,25 +1867,9 @@ std::optional<std::vector<GameInstance::BreakAndTraceResult>> GameInstance::pop_
 
 void GameInstance::remove_breakpoint(std::uint16_t breakpoint) noexcept {
     this->mutex.lock();
-    char cmd[256];
-    std::snprintf(cmd, sizeof(cmd), "delete $%04x", breakpoint);
-    this->execute_command_without_mutex(malloc_string(cmd));
-
-    // Remove all matching breakpoints
-    while(true) {
-        bool did_it = true;
-        for(auto b = this->break_and_trace_breakpoints.begin(); b != this->break_and_trace_breakpoints.end(); b++) {
-            if(std::get<0>(*b) == breakpoint) {
-                this->break_and_trace_breakpoints.erase(b);
-                did_it = false;
-                break;
-            }
-        }
-        if(did_it) {
-            break;
-        }
-    }
-
+    this->breakpoints.remove_all_at(breakpoint);
+    this->break_and_trace_breakpoints.erase(breakpoint);
+    this->sync_breakpoints_without_mutex();
     this->mutex.unlock();
 }
 
@@ -1085,8 +1877,9 @@ void GameInstance::set_highpass_filter_mode(GB_highpass_mode_t mode) noexcept MA
 
 void GameInstance::remove_all_breakpoints() noexcept {
     this->mutex.lock();
-    this->execute_command_without_mutex(malloc_string("delete"));
+    this->breakpoints.clear();
     this->break_and_trace_breakpoints.clear();
+    this->sync_breakpoints_without_mutex();
     this->mutex.unlock();
 }
 
@@ -1103,6 +1896,16 @@ std::vector<std::uint8_t> GameInstance::create_save_state() {
     return data;
 }
 
+GameInstance::clock::duration GameInstance::create_save_state(std::vector<std::uint8_t> &state) {
+    this->mutex.lock();
+    auto start = clock::now();
+    state.resize(GB_get_save_state_size(&this->gameboy));
+    GB_save_state_to_buffer(&this->gameboy, state.data());
+    auto stall = clock::now() - start;
+    this->mutex.unlock();
+    return stall;
+}
+
 bool GameInstance::load_save_state(const std::filesystem::path &path) noexcept {
     // Load the state maybe
     this->mutex.lock();
@@ -1115,12 +1918,41 @@ bool GameInstance::load_save_state(const std::filesystem::path &path) noexcept {
         original_model = model_before;
     }
 
+    // We can't rewind through a loaded state
+    if(success) {
+        this->clear_rewind_history();
+        this->boot_snapshot_pending = false;
+        this->disassembly_cache.invalidate_memory();
+    }
+
     // Done
     this->mutex.unlock();
     return success;
 }
 
-bool GameInstance::load_save_state(const std::vector<std::uint8_t> &state) noexcept MAKE_GETTER(GB_load_state_from_buffer(&this->gameboy, state.data(), state.size()) == 0)
+bool GameInstance::load_save_state(const std::vector<std::uint8_t> &state) noexcept {
+    return this->load_save_state(state.data(), state.size());
+}
+
+bool GameInstance::load_save_state(const std::uint8_t *state, std::size_t size) noexcept {
+    this->mutex.lock();
+    auto model_before = GB_get_model(&this->gameboy);
+    auto success = GB_load_state_from_buffer(&this->gameboy, state, size) == 0;
+    auto model_after = GB_get_model(&this->gameboy);
+
+    // Same as loading from a file
+    if(model_before != model_after && !original_model.has_value()) {
+        original_model = model_before;
+    }
+
+    if(success) {
+        this->clear_rewind_history();
+        this->boot_snapshot_pending = false;
+        this->disassembly_cache.invalidate_memory();
+    }
+    this->mutex.unlock();
+    return success;
+}
 
 void GameInstance::set_rapid_button_state(GB_key_t button, bool pressed) {
     this->rapid_button_bitfield = set_button_bitmask(this->rapid_button_bitfield, button, pressed);
@@ -1130,11 +1962,284 @@ void GameInstance::on_rumble(GB_gameboy_s *gb, double rumble) noexcept {
     reinterpret_cast<GameInstance *>(GB_get_user_data(gb))->rumble = rumble;
 }
 
+bool GameInstance::on_memory_write(GB_gameboy_s *gb, std::uint16_t address, std::uint8_t data) noexcept {
+    auto *instance = reinterpret_cast<GameInstance *>(GB_get_user_data(gb));
+    instance->disassembly_cache.note_write(address);
+    instance->check_watchpoints_without_mutex(address, data, WATCHPOINT_WRITE);
+    return true;
+}
+
+std::uint8_t GameInstance::on_memory_read(GB_gameboy_s *gb, std::uint16_t address, std::uint8_t data) noexcept {
+    reinterpret_cast<GameInstance *>(GB_get_user_data(gb))->check_watchpoints_without_mutex(address, data, WATCHPOINT_READ);
+    return data;
+}
+
+void GameInstance::check_watchpoints_without_mutex(std::uint16_t address, std::uint8_t value, std::uint8_t type) noexcept {
+    auto actions = this->watchpoints.get_actions(address, type);
+    if(actions == 0 || !this->cpu_running) {
+        return;
+    }
+
+    // The opcode is fetched before the execution callback, so that read is attributed to the previous instruction
+    MemoryAccess access;
+    access.cycle = this->elapsed_cycles + get_gb_cycles_since_run(&this->gameboy);
+    access.pc = this->current_instruction_address;
+    access.address = address;
+    access.value = value;
+    access.type = type;
+
+    if(actions & WATCHPOINT_LOG) {
+        this->watchpoints.log(access);
+    }
+
+    // This stops before the next instruction
+    if(actions & WATCHPOINT_BREAK) {
+        this->watchpoint_break = access;
+        this->break_requested = true;
+        GB_debugger_break(&this->gameboy);
+    }
+}
+
+bool GameInstance::is_step_finished_without_mutex(std::uint16_t sp) const noexcept {
+    switch(this->step_mode) {
+        case STEP_INSTRUCTION:
+            return true;
+        // Stepping over a call finishes once we're back in the caller's stack frame
+        case STEP_OVER:
+            return sp >= this->step_sp;
+        // Finishing a function finishes once we've returned out of its stack frame
+        case STEP_OUT:
+            return sp > this->step_sp;
+        default:
+            return false;
+    }
+}
+
+void GameInstance::update_memory_callbacks_without_mutex() noexcept {
+    auto flags = this->watchpoints.get_all_flags();
+    GB_set_execution_callback(&this->gameboy, (this->tracing || this->coverage_enabled || this->profiling || this->resuming_step || flags != 0) ? GameInstance::on_execution : nullptr);
+    GB_set_read_memory_callback(&this->gameboy, (flags & WATCHPOINT_READ) ? GameInstance::on_memory_read : nullptr);
+}
+
+void GameInstance::add_watchpoint(const Watchpoint &watchpoint) {
+    this->mutex.lock();
+    this->watchpoints.add(watchpoint);
+    this->update_memory_callbacks_without_mutex();
+    this->mutex.unlock();
+}
+
+void GameInstance::remove_watchpoint(std::size_t index) {
+    this->mutex.lock();
+    this->watchpoints.remove(index);
+    this->update_memory_callbacks_without_mutex();
+    this->mutex.unlock();
+}
+
+std::vector<Watchpoint> GameInstance::get_watchpoints() MAKE_GETTER(this->watchpoints.get_watchpoints())
+
+std::size_t GameInstance::drain_memory_access_log(std::vector<MemoryAccess> &output) {
+    return this->watchpoints.drain_log(output);
+}
+
+std::uint64_t GameInstance::get_dropped_memory_access_count() const noexcept {
+    return this->watchpoints.get_dropped();
+}
+
+std::optional<MemoryAccess> GameInstance::pop_watchpoint_break() {
+    this->mutex.lock();
+    auto access = std::move(this->watchpoint_break);
+    this->watchpoint_break = std::nullopt;
+    this->mutex.unlock();
+    return access;
+}
+
+void GameInstance::set_coverage_enabled(bool enabled) {
+    this->mutex.lock();
+    this->coverage_enabled = enabled;
+    this->update_memory_callbacks_without_mutex();
+    this->mutex.unlock();
+}
+
+bool GameInstance::is_coverage_enabled() MAKE_GETTER(this->coverage_enabled)
+
+void GameInstance::clear_coverage() MAKE_SETTER(this->coverage.clear())
+
+std::vector<std::uint32_t> GameInstance::get_coverage_counts(const std::vector<std::uint16_t> &addresses, std::uint32_t &max_count) {
+    std::vector<std::uint32_t> counts(addresses.size());
+
+    this->mutex.lock();
+    for(std::size_t i = 0; i < addresses.size(); i++) {
+        counts[i] = this->coverage.get_count(get_gb_bank_for_address(&this->gameboy, addresses[i]), addresses[i]);
+    }
+    max_count = this->coverage.get_max_count();
+    this->mutex.unlock();
+
+    return counts;
+}
+
+std::vector<CoverageEntry> GameInstance::get_coverage() MAKE_GETTER(this->coverage.get_entries())
+
+OpcodeCounts GameInstance::get_opcode_counts() MAKE_GETTER(this->coverage.get_opcode_counts())
+
+void GameInstance::start_profiler(std::uint32_t interval) {
+    this->mutex.lock();
+    this->profiler.set_symbols(this->get_profile_symbols_without_mutex());
+    this->profiler.start();
+    this->profile_interval = std::max<std::uint32_t>(interval, 1);
+    this->next_profile_sample = 0;
+    this->profiling = true;
+    this->update_memory_callbacks_without_mutex();
+    this->mutex.unlock();
+}
+
+void GameInstance::stop_profiler() {
+    this->mutex.lock();
+    this->profiling = false;
+    this->update_memory_callbacks_without_mutex();
+    this->mutex.unlock();
+
+    // Nothing else is sampled now, so let it finish aggregating without holding anything up
+    this->profiler.stop();
+}
+
+bool GameInstance::is_profiling() MAKE_GETTER(this->profiling)
+
+void GameInstance::clear_profile() {
+    this->profiler.clear();
+}
+
+std::uint64_t GameInstance::get_profile_sample_count(std::uint64_t &dropped) {
+    dropped = this->profiler.get_dropped();
+    return this->profiler.get_sample_count();
+}
+
+ProfileReport GameInstance::get_profile_report() {
+    return this->profiler.get_report();
+}
+
+bool GameInstance::export_profile(const std::filesystem::path &path) {
+    return this->profiler.export_collapsed_stacks(path);
+}
+
+void GameInstance::sample_profile_without_mutex(std::uint16_t address) noexcept {
+    auto cycle = this->elapsed_cycles + get_gb_cycles_since_run(&this->gameboy);
+    if(cycle < this->next_profile_sample) {
+        return;
+    }
+    this->next_profile_sample = cycle + this->profile_interval;
+
+    // Call sites are kept oldest first after an unused first slot; keep the innermost ones if there are too many
+    ProfileSample sample;
+    std::size_t bt_count = get_gb_backtrace_size(&this->gameboy);
+    std::size_t first = bt_count > ProfileSample::MAX_DEPTH ? bt_count - (ProfileSample::MAX_DEPTH - 1) : 1;
+    for(std::size_t b = first; b < bt_count; b++) {
+        sample.frames[sample.depth++] = ProfileFrame { get_gb_backtrace_address(&this->gameboy, b), get_gb_backtrace_bank(&this->gameboy, b) };
+    }
+    sample.frames[sample.depth++] = ProfileFrame { address, get_gb_bank_for_address(&this->gameboy, address) };
+
+    this->profiler.push(sample);
+}
+
+std::shared_ptr<const ProfileSymbols> GameInstance::get_profile_symbols_without_mutex() {
+    auto symbols = std::make_shared<ProfileSymbols>();
+
+    // Local labels (e.g. "Function.loop") are part of the function they're in
+    std::uint32_t bank_count = get_gb_symbol_bank_count(&this->gameboy);
+    for(std::uint32_t bank = 0; bank < bank_count; bank++) {
+        std::uint32_t symbol_count = get_gb_symbol_count(&this->gameboy, static_cast<std::uint16_t>(bank));
+        for(std::uint32_t s = 0; s < symbol_count; s++) {
+            std::uint16_t address;
+            const char *name = get_gb_symbol(&this->gameboy, static_cast<std::uint16_t>(bank), s, &address);
+            if(name != nullptr && std::strchr(name, '.') == nullptr) {
+                symbols->add(static_cast<std::uint16_t>(bank), address, name);
+            }
+        }
+    }
+
+    symbols->sort();
+    return symbols;
+}
+
 void GameInstance::set_rumble_mode(GB_rumble_mode_t mode) noexcept MAKE_SETTER(GB_set_rumble_mode(&this->gameboy, mode))
 
 void GameInstance::set_rewind(bool rewinding) noexcept MAKE_SETTER(this->rewinding = rewinding)
 
-void GameInstance::set_rewind_length(double seconds) noexcept MAKE_SETTER(GB_set_rewind_length(&this->gameboy, seconds))
+void GameInstance::set_rewind_length(double seconds) noexcept MAKE_SETTER(this->rewind_buffer.set_max_frames(static_cast<std::size_t>(std::max(seconds, 0.0) * GB_get_usual_frame_rate(&this->gameboy))))
+
+void GameInstance::set_rewind_memory_budget(std::size_t bytes) {
+    this->rewind_buffer.set_byte_budget(bytes);
+}
+
+void GameInstance::record_rewind_frame() noexcept {
+    this->discard_rewind_frames_after_seek();
+
+    // The buffer would just throw it away, so don't bother serializing anything if rewinding is off
+    if(this->rewind_buffer.get_max_frames() == 0) {
+        return;
+    }
+
+    // Only take the snapshot here; compression happens on the rewind buffer's worker
+    auto state = this->rewind_buffer.acquire_buffer(GB_get_save_state_size(&this->gameboy));
+    GB_save_state_to_buffer(&this->gameboy, state.data());
+    this->rewind_buffer.push(++this->rewind_frame, std::move(state));
+}
+
+void GameInstance::discard_rewind_frames_after_seek() noexcept {
+    // Seeking back leaves frames after the one we went to so we can still scrub forward, but once we continue from here, they're gone
+    if(this->rewind_seek_pending) {
+        this->rewind_buffer.truncate_after(this->rewind_frame);
+        this->rewind_seek_pending = false;
+    }
+}
+
+void GameInstance::clear_rewind_history() noexcept {
+    this->rewind_buffer.clear();
+    this->rewind_seek_pending = false;
+}
+
+GameInstance::RewindTimeline GameInstance::get_rewind_timeline() {
+    this->mutex.lock();
+    auto current_frame = this->rewind_frame;
+    auto frame_rate = GB_get_usual_frame_rate(&this->gameboy);
+    this->mutex.unlock();
+
+    auto statistics = this->rewind_buffer.get_statistics();
+
+    RewindTimeline timeline = {};
+    timeline.first_frame = statistics.first_frame;
+    timeline.last_frame = statistics.last_frame;
+    timeline.current_frame = current_frame;
+    timeline.frame_count = statistics.frame_count;
+    timeline.keyframe_count = statistics.keyframe_count;
+    timeline.memory_usage = statistics.memory_usage;
+    timeline.memory_budget = statistics.byte_budget;
+    timeline.frames_dropped = statistics.frames_dropped;
+    timeline.seconds = statistics.frame_count / frame_rate;
+    timeline.bytes_per_second = timeline.seconds > 0.0 ? statistics.memory_usage / timeline.seconds : 0.0;
+    return timeline;
+}
+
+bool GameInstance::seek_rewind_without_mutex(std::uint64_t frame) {
+    if(!this->rewind_buffer.get_state(frame, this->rewind_state) || GB_load_state_from_buffer(&this->gameboy, this->rewind_state.data(), this->rewind_state.size()) != 0) {
+        return false;
+    }
+
+    this->rewind_frame = frame;
+    this->rewind_seek_pending = true;
+    this->boot_snapshot_pending = false;
+    this->disassembly_cache.invalidate_memory();
+    return true;
+}
+
+bool GameInstance::seek_rewind(std::uint64_t frame) MAKE_GETTER(this->seek_rewind_without_mutex(frame))
+
+bool GameInstance::seek_rewind_back(double seconds) {
+    this->mutex.lock();
+    auto frames = static_cast<std::uint64_t>(std::max(seconds, 0.0) * GB_get_usual_frame_rate(&this->gameboy));
+    auto success = this->seek_rewind_without_mutex(frames < this->rewind_frame ? this->rewind_frame - frames : 0);
+    this->mutex.unlock();
+    return success;
+}
 
 void color_block(GB_gameboy_s *gb, std::uint32_t *block, const std::uint8_t *tile_data, GB_palette_type_t palette_type, unsigned int palette_index, unsigned int stride = GameInstance::GB_TILESET_TILE_LENGTH) {
     // Get palettes
@@ -1236,6 +2341,60 @@ void GameInstance::draw_tilemap(std::uint32_t *destination, GB_map_type_t map_ty
 
 std::uint8_t GameInstance::read_memory(std::uint16_t address) noexcept MAKE_GETTER(GB_safe_read_memory(&this->gameboy, address))
 
+void GameInstance::read_memory_range(std::uint16_t address, std::uint8_t *output, std::size_t length) noexcept {
+    this->mutex.lock();
+    for(std::size_t i = 0; i < length; i++) {
+        output[i] = GB_safe_read_memory(&this->gameboy, static_cast<std::uint16_t>(address + i));
+    }
+    this->mutex.unlock();
+}
+
+void GameInstance::write_memory(std::uint16_t address, std::uint8_t value) noexcept MAKE_SETTER(GB_write_memory(&this->gameboy, address, value))
+
+static std::size_t copy_memory_region(GB_gameboy_s *gb, GB_direct_access_t region, std::size_t offset, std::size_t length, std::vector<std::uint8_t> &output) {
+    std::size_t size = 0;
+    const auto *data = reinterpret_cast<const std::uint8_t *>(GB_get_direct_access(gb, region, &size, nullptr));
+    if(data == nullptr || offset >= size) {
+        output.clear();
+        return data == nullptr ? 0 : size;
+    }
+
+    length = std::min(length, size - offset);
+    output.resize(length);
+    std::memcpy(output.data(), data + offset, length);
+    return size;
+}
+
+std::size_t GameInstance::read_memory_region(GB_direct_access_t region, std::size_t offset, std::size_t length, std::vector<std::uint8_t> &output) {
+    this->mutex.lock();
+    auto size = copy_memory_region(&this->gameboy, region, offset, length, output);
+    this->mutex.unlock();
+    return size;
+}
+
+bool GameInstance::write_memory_region(GB_direct_access_t region, std::size_t offset, std::uint8_t value) {
+    this->mutex.lock();
+
+    std::size_t size = 0;
+    auto *data = reinterpret_cast<std::uint8_t *>(GB_get_direct_access(&this->gameboy, region, &size, nullptr));
+    bool written = data != nullptr && offset < size;
+    if(written) {
+        data[offset] = value;
+
+        // ROM isn't expected to change, so nothing decoded from it is ever checked again; start over
+        if(region == GB_DIRECT_ACCESS_ROM || region == GB_DIRECT_ACCESS_BOOTROM) {
+            this->disassembly_cache.clear();
+        }
+        else {
+            // We don't know which address this is mapped to, if any
+            this->disassembly_cache.invalidate_memory();
+        }
+    }
+
+    this->mutex.unlock();
+    return written;
+}
+
 const uint32_t *GameInstance::get_palette(GB_palette_type_t palette_type, unsigned char palette_index) noexcept MAKE_GETTER(get_gb_palette(&this->gameboy, palette_type, palette_index))
 
 GameInstance::TilesetInfo GameInstance::get_tileset_info() noexcept MAKE_GETTER(this->get_tileset_info_without_mutex())
@@ -1506,6 +2665,8 @@ void GameInstance::get_raw_palette(GB_palette_type_t type, std::size_t palette,
 }
 
 void GameInstance::reset_to_original_model() noexcept {
+    this->disassembly_cache.invalidate_memory();
+
     // If we have an original model set, use that
     if(this->original_model.has_value()) {
         GB_switch_model_and_reset(&this->gameboy, *this->original_model);
@@ -1521,7 +2682,7 @@ void GameInstance::reset_to_original_model() noexcept {
 bool GameInstance::break_and_trace_results_ready() MAKE_GETTER(this->break_and_trace_results_ready_no_mutex())
 
 bool GameInstance::break_and_trace_results_ready_no_mutex() const noexcept {
-    return (this->break_and_trace_result.size() > 1) || (this->break_and_trace_result.size() == 1 && this->current_break_and_trace_remaining == 0);
+    return !this->break_and_trace_result.empty();
 }
 
 bool GameInstance::is_game_boy_color() noexcept MAKE_GETTER(GB_is_cgb(&this->gameboy))
@@ -1559,6 +2720,67 @@ std::optional<std::vector<std::uint32_t>> GameInstance::pop_printed_image(std::s
     }
 }
 
+std::vector<std::uint8_t> GameInstance::get_rom_header() {
+    this->mutex.lock();
+    std::vector<std::uint8_t> header;
+    std::size_t rom_size = 0;
+    const auto *rom = reinterpret_cast<const std::uint8_t *>(GB_get_direct_access(&this->gameboy, GB_DIRECT_ACCESS_ROM, &rom_size, nullptr));
+    if(this->rom_loaded && rom != nullptr && rom_size >= 0x150) {
+        header.assign(rom + 0x100, rom + 0x150);
+    }
+    this->mutex.unlock();
+    return header;
+}
+
+void GameInstance::begin_boot_without_mutex() noexcept {
+    this->boot_snapshot_pending = false;
+    if(!this->boot_snapshot_enabled || !this->rom_loaded) {
+        return;
+    }
+
+    // The boot ROM only looks at the header, so that's all we need to tell cartridges apart
+    std::size_t rom_size = 0;
+    const auto *rom = reinterpret_cast<const std::uint8_t *>(GB_get_direct_access(&this->gameboy, GB_DIRECT_ACCESS_ROM, &rom_size, nullptr));
+    if(rom == nullptr || rom_size < 0x150) {
+        return;
+    }
+    this->boot_snapshot_key = { static_cast<std::uint32_t>(GB_get_model(&this->gameboy)), this->boot_rom_hash, fnv1a_64(rom + 0x100, 0x50), this->fast_boot_rom };
+
+    // If we don't have one yet, take it when the boot ROM finishes
+    if(!this->boot_snapshot_cache.get(this->boot_snapshot_key, this->boot_snapshot_state)) {
+        this->boot_snapshot_pending = true;
+        return;
+    }
+
+    // The snapshot has whatever was in cartridge RAM back then, so put back what's there now
+    std::vector<std::uint8_t> battery(GB_save_battery_size(&this->gameboy));
+    if(!battery.empty()) {
+        GB_save_battery_to_buffer(&this->gameboy, battery.data(), battery.size());
+    }
+
+    if(GB_load_state_from_buffer(&this->gameboy, this->boot_snapshot_state.data(), this->boot_snapshot_state.size()) != 0) {
+        std::fprintf(stderr, "Failed to restore the post-boot snapshot - running the boot ROM instead\n");
+        this->boot_snapshot_pending = true;
+        return;
+    }
+
+    if(!battery.empty()) {
+        GB_load_battery_from_buffer(&this->gameboy, battery.data(), battery.size());
+    }
+    this->disassembly_cache.invalidate_memory();
+}
+
+void GameInstance::capture_boot_snapshot_if_ready() noexcept {
+    if(!is_gb_boot_rom_finished(&this->gameboy)) {
+        return;
+    }
+
+    this->boot_snapshot_pending = false;
+    this->boot_snapshot_state.resize(GB_get_save_state_size(&this->gameboy));
+    GB_save_state_to_buffer(&this->gameboy, this->boot_snapshot_state.data());
+    this->boot_snapshot_cache.put(this->boot_snapshot_key, this->boot_snapshot_state);
+}
+
 void GameInstance::skip_sgb_intro_if_needed() noexcept {
     // Skip intro animation?
     if(GB_is_sgb(&this->gameboy) && this->fast_boot_rom) {
@@ -12,8 +12,26 @@ extern "C" {
 #include <optional>
 #include <filesystem>
 #include <chrono>
+#include <memory>
+#include <unordered_map>
 #include <SDL2/SDL.h>
 
+#include "audio_recorder.hpp"
+#include "spsc_ring_buffer.hpp"
+#include "rewind_buffer.hpp"
+#include "boot_snapshot_cache.hpp"
+#include "sm83_disassembler.hpp"
+#include "disassembly_cache.hpp"
+#include "trace_buffer.hpp"
+#include "trace_file.hpp"
+#include "breakpoint_manager.hpp"
+#include "sm83_expression.hpp"
+#include "watchpoint_manager.hpp"
+#include "coverage_collector.hpp"
+#include "sampling_profiler.hpp"
+
+class BackgroundIO;
+
 class GameInstance {
 public: // all public functions assume the mutex is not locked
     GameInstance(GB_model_t model, GB_border_mode_t border);
@@ -98,6 +116,126 @@ public: // all public functions assume the mutex is not locked
      */
     bool is_audio_enabled() noexcept;
 
+    /**
+     * Start recording audio to a WAV file. This works even if audio playback is disabled.
+     *
+     * @param path            path to write the mixed output to
+     * @param stems           also write each APU channel to its own file
+     * @param block_when_full wait for the writer instead of dropping samples if it falls behind (for capturing as fast as emulation runs)
+     * @param sample_rate     sample rate to use if one is not already set
+     * @return                true if recording started
+     */
+    bool start_audio_recording(const std::filesystem::path &path, bool stems = false, bool block_when_full = false, std::uint32_t sample_rate = 48000) noexcept;
+
+    struct AudioRecordingResult {
+        std::uint64_t frames_written;
+        std::uint64_t frames_dropped;
+        bool write_failed;
+    };
+
+    /**
+     * Stop recording audio, finishing any pending writes
+     *
+     * @return result of the recording, or nullopt if nothing was being recorded
+     */
+    std::optional<AudioRecordingResult> stop_audio_recording() noexcept;
+
+    /**
+     * Finish a recording that was stopped by the emulator rather than by stop_audio_recording(), such as if the sample rate
+     * changed or a write failed. Poll this while recording so the UI can find out.
+     *
+     * @return result of the recording, or nullopt if no recording was stopped
+     */
+    std::optional<AudioRecordingResult> pop_interrupted_audio_recording() noexcept;
+
+    /**
+     * Get whether or not audio is being recorded
+     *
+     * @return audio is being recorded
+     */
+    bool is_recording_audio() noexcept;
+
+    /** Number of buckets in the audio queue depth histogram. Each bucket is one SDL buffer wide, and the last bucket holds everything beyond that. */
+    static constexpr const std::size_t AUDIO_QUEUE_DEPTH_BUCKETS = 10;
+
+    struct AudioStatistics {
+        /** Frames generated by the core while audio was enabled */
+        std::uint64_t samples_produced;
+
+        /** Frames sent to the audio device (or to the sample buffer if not using SDL) */
+        std::uint64_t samples_queued;
+
+        /** Frames thrown away because the device queue was too full */
+        std::uint64_t samples_dropped;
+
+        /** Number of times the device queue was flushed because it was too full */
+        std::uint64_t flush_events;
+
+        /** Number of times the audio was reset (flushes, pauses, breakpoints, resets, etc.) */
+        std::uint64_t reset_audio_calls;
+
+        /** Number of times the device queue ran dry while playing */
+        std::uint64_t underruns;
+
+        /** Device queue depth (in SDL buffers) each time audio was queued */
+        std::uint64_t queue_depth_histogram[AUDIO_QUEUE_DEPTH_BUCKETS];
+
+        /** Estimated time between a sample being generated and it being played, as of the last time audio was queued */
+        double latency_ms;
+
+        /** Highest latency estimate seen */
+        double max_latency_ms;
+    };
+
+    /**
+     * Get the audio pipeline statistics. This does not lock the mutex.
+     *
+     * @return statistics
+     */
+    AudioStatistics get_audio_statistics() const noexcept;
+
+    /**
+     * Reset the audio pipeline statistics to zero
+     */
+    void reset_audio_statistics() noexcept;
+
+    /** Number of traces given to the oscilloscope (each APU channel, then the mix) */
+    static constexpr const std::size_t OSCILLOSCOPE_TRACE_COUNT = AudioRecorder::STEM_COUNT + 1;
+
+    /** Approximate number of oscilloscope records generated per second of emulation */
+    static constexpr const std::size_t OSCILLOSCOPE_RECORDS_PER_SECOND = 4000;
+
+    struct OscilloscopeRecord {
+        /** Lowest sample of each trace in this record */
+        std::int16_t min[OSCILLOSCOPE_TRACE_COUNT];
+
+        /** Highest sample of each trace in this record */
+        std::int16_t max[OSCILLOSCOPE_TRACE_COUNT];
+    };
+
+    /**
+     * Set whether or not to feed the oscilloscope. Nothing is generated while this is off.
+     *
+     * @param enabled oscilloscope is enabled
+     */
+    void set_oscilloscope_enabled(bool enabled) noexcept;
+
+    /**
+     * Get whether or not the oscilloscope is being fed
+     *
+     * @return oscilloscope is enabled
+     */
+    bool is_oscilloscope_enabled() const noexcept { return this->oscilloscope_enabled; }
+
+    /**
+     * Take decimated oscilloscope records. This does not lock the mutex, but only one thread may call it.
+     *
+     * @param destination where to put the records
+     * @param count       maximum number of records to take
+     * @return            number of records taken
+     */
+    std::size_t read_oscilloscope(OscilloscopeRecord *destination, std::size_t count) noexcept;
+
     /**
      * Load the ROM at the given path
      *
@@ -134,6 +272,20 @@ public: // all public functions assume the mutex is not locked
      * @return rom is loaded
      */
     bool is_rom_loaded() const noexcept { return this->rom_loaded; }
+
+    /**
+     * Get a hash of the loaded ROM, for telling whether something recorded from a ROM (such as a trace) came from this one
+     *
+     * @return hash
+     */
+    std::uint64_t get_rom_hash() noexcept;
+
+    /**
+     * Get the cartridge header (0x100-0x14F) of the loaded ROM
+     *
+     * @return header, or nothing if no ROM is loaded
+     */
+    std::vector<std::uint8_t> get_rom_header();
     
     /**
      * Set the playback speed
@@ -149,6 +301,14 @@ public: // all public functions assume the mutex is not locked
      * @return     0 on success, non-zero on failure
      */
     int save_sram(const std::filesystem::path &path) noexcept;
+
+    /**
+     * Copy the SRAM (and RTC data, if any) into a buffer so it can be written without holding up emulation
+     *
+     * @param sram where to put the data (empty if the cartridge has no battery)
+     * @return     time emulation was blocked
+     */
+    clock::duration create_sram_snapshot(std::vector<std::uint8_t> &sram);
     
     /**
      * Reset the gameboy. Note that this does not unload the ROMs, save data, etc.
@@ -199,18 +359,46 @@ public: // all public functions assume the mutex is not locked
     void set_border_mode(GB_border_mode_t border) noexcept;
     
     /**
-     * Get all currently set breakpoints
+     * Get all currently set breakpoints, sorted by address and bank
      * 
-     * @return breakpoint addresses
+     * @return breakpoints
+     */
+    std::vector<Breakpoint> get_breakpoints();
+
+    /**
+     * Get a number that changes whenever breakpoints change (including hit counts), so they only need copied when it does
+     *
+     * @return generation
      */
-    std::vector<std::uint16_t> get_breakpoints();
+    std::uint64_t get_breakpoint_generation() noexcept;
     
+    struct BacktraceFrame {
+        /** Address (the current PC for the first frame, and return addresses after that) */
+        std::uint16_t address;
+
+        /** Bank the address is in */
+        std::uint16_t bank;
+
+        /** Closest symbol at or before the address, or empty if none */
+        std::string symbol;
+
+        /** How far past the symbol the address is */
+        std::uint16_t symbol_offset;
+    };
+
     /**
      * Get the current backtrace
      * 
-     * @return backtrace addresses and string names
+     * @return backtrace, innermost first
      */
-    std::vector<std::pair<std::string, std::uint16_t>> get_backtrace();
+    std::vector<BacktraceFrame> get_backtrace();
+
+    /**
+     * Get a number that changes whenever the backtrace changes
+     *
+     * @return generation
+     */
+    std::uint64_t get_backtrace_generation();
     
     /**
      * Get the current value of the given register
@@ -219,6 +407,13 @@ public: // all public functions assume the mutex is not locked
      * @return     register value
      */
     std::uint16_t get_register_value(SM83Register reg) noexcept;
+
+    /**
+     * Get all 16-bit registers at once
+     *
+     * @return registers
+     */
+    SM83ExpressionState get_registers() noexcept;
     
     /**
      * Set the current value of the given register
@@ -367,6 +562,50 @@ public: // all public functions assume the mutex is not locked
      */
     std::string disassemble_address(std::uint16_t address, std::uint8_t count);
 
+    /**
+     * Decode instructions starting at the given address. Unlike disassemble_address(), this does not go through SameBoy's
+     * log output.
+     *
+     * @param  address address to start at
+     * @param  count   number of instructions to decode
+     * @return         decoded instructions
+     */
+    std::vector<SM83Instruction> disassemble_instructions(std::uint16_t address, std::size_t count);
+
+    struct DisassemblerBenchmark {
+        /** Instructions per second decoded with disassemble_instructions() */
+        double native_per_second;
+
+        /** Instructions per second decoded with disassemble_address() */
+        double log_per_second;
+    };
+
+    /**
+     * Time both disassembly paths on the same code. The instance is held for the duration of the benchmark.
+     *
+     * @param  address address to start at
+     * @param  count   number of instructions to decode with each path
+     * @return         results
+     */
+    DisassemblerBenchmark benchmark_disassembler(std::uint16_t address, std::size_t count);
+
+    /**
+     * Get statistics for the cache used by disassemble_instructions()
+     *
+     * @return statistics
+     */
+    DisassemblyCache::Statistics get_disassembly_cache_statistics();
+
+    /**
+     * Get a number that changes whenever disassembling a range could give something different (the CPU wrote to it, a
+     * different bank or the boot ROM was mapped in, or a save state was loaded)
+     *
+     * @param address first address
+     * @param length  number of bytes
+     * @return        generation
+     */
+    std::uint64_t get_memory_generation(std::uint16_t address, std::size_t length);
+
     /**
      * Get the audio buffer size
      *
@@ -402,12 +641,28 @@ public: // all public functions assume the mutex is not locked
     void break_immediately() noexcept;
 
     /**
-     * Remove the given breakpoint
+     * Remove all breakpoints at the given address, regardless of bank
      *
      * @param breakpoint breakpoint to remove
      */
     void remove_breakpoint(std::uint16_t breakpoint) noexcept;
 
+    /**
+     * Remove many breakpoints at once
+     *
+     * @param breakpoints breakpoints to remove (only the address and bank are used)
+     */
+    void remove_breakpoints(const std::vector<Breakpoint> &breakpoints);
+
+    /**
+     * Enable or disable a breakpoint without removing it
+     *
+     * @param address address
+     * @param bank    bank (or BREAKPOINT_ANY_BANK)
+     * @param enabled enable it
+     */
+    void set_breakpoint_enabled(std::uint16_t address, std::uint16_t bank, bool enabled);
+
     /**
      * Remove all breakpoints
      */
@@ -442,6 +697,22 @@ public: // all public functions assume the mutex is not locked
      */
     void set_use_fast_boot_rom(bool fast_boot_rom) noexcept;
 
+    /**
+     * Set whether or not to skip the boot ROM on reset (and when loading a ROM) by restoring a snapshot taken when it last
+     * handed off to a cartridge with the same header on the same model and boot ROM. Cartridge RAM is left alone.
+     *
+     * @param enabled skip the boot ROM when possible
+     */
+    void set_boot_snapshot_enabled(bool enabled) noexcept;
+
+    /**
+     * Set a directory to keep post-boot snapshots in so they're reused between runs
+     *
+     * @param directory directory (or nullopt to only keep them in memory)
+     * @param io        where to queue writes to the directory so emulation doesn't wait on them
+     */
+    void set_boot_snapshot_directory(const std::optional<std::filesystem::path> &directory, BackgroundIO *io);
+
     /**
      * Add a break-and-trace breakpoint at address
      *
@@ -449,23 +720,193 @@ public: // all public functions assume the mutex is not locked
      * @param n               number of times to step
      * @param step_over       step over
      * @param break_when_done stop execution on completion
+     * @param trace_path      stream the trace to this file instead of keeping it in memory (see pop_finished_trace_file())
      */
-    void break_and_trace_at(std::uint16_t address, std::size_t n, bool step_over, bool break_when_done);
+    void break_and_trace_at(std::uint16_t address, std::size_t n, bool step_over, bool break_when_done, const std::optional<std::filesystem::path> &trace_path = std::nullopt);
 
     /**
      * Add a breakpoint at address
      *
      * @param address address to breakpoint
+     * @param bank    only break when this bank is mapped (or BREAKPOINT_ANY_BANK)
      */
-    void break_at(std::uint16_t address) noexcept;
+    void break_at(std::uint16_t address, std::uint16_t bank = BREAKPOINT_ANY_BANK) noexcept;
 
-    struct BreakAndTraceResult {
-        std::uint8_t a,b,c,d,e,f,h,l;
-        bool step_over;
-        std::uint16_t sp, pc;
-        bool carry, half_carry, subtract, zero; // C, H, N, Z
-        std::string disassembly;
-    };
+    /**
+     * Add many breakpoints at once
+     *
+     * @param breakpoints breakpoints to add
+     */
+    void add_breakpoints(const std::vector<Breakpoint> &breakpoints);
+
+    /**
+     * Set a condition for a breakpoint, adding the breakpoint if needed. The condition is compiled once (see SM83Expression)
+     * and checked each time the breakpoint is hit; execution only stops if it's nonzero.
+     *
+     * @param address   address
+     * @param bank      bank (or BREAKPOINT_ANY_BANK)
+     * @param condition condition, or an empty string to always stop
+     * @param error     set to what went wrong if the condition couldn't be compiled
+     * @return          true if set
+     */
+    bool set_breakpoint_condition(std::uint16_t address, std::uint16_t bank, const std::string &condition, std::string &error);
+
+    /**
+     * Add an expression to evaluate every frame
+     *
+     * @param expression expression (see SM83Expression)
+     * @param error      set to what went wrong if the expression couldn't be compiled
+     * @return           true if added
+     */
+    bool add_watch(const std::string &expression, std::string &error);
+
+    /**
+     * Remove a watch expression
+     *
+     * @param index index of the watch
+     */
+    void remove_watch(std::size_t index);
+
+    /**
+     * Get all watch expressions and their values as of the last frame
+     *
+     * @return expressions and values
+     */
+    std::vector<std::pair<std::string, std::uint16_t>> get_watches();
+
+    /**
+     * Add a memory watchpoint
+     *
+     * @param watchpoint watchpoint to add
+     */
+    void add_watchpoint(const Watchpoint &watchpoint);
+
+    /**
+     * Remove a memory watchpoint
+     *
+     * @param index index of the watchpoint
+     */
+    void remove_watchpoint(std::size_t index);
+
+    /**
+     * Get all memory watchpoints
+     *
+     * @return watchpoints
+     */
+    std::vector<Watchpoint> get_watchpoints();
+
+    /**
+     * Move accesses logged by watchpoints to the end of output. This does not lock, but only one thread may call it.
+     *
+     * @param output where to put the accesses
+     * @return       number of accesses added
+     */
+    std::size_t drain_memory_access_log(std::vector<MemoryAccess> &output);
+
+    /**
+     * Get the number of accesses that were not logged because the log was not drained in time
+     *
+     * @return number of dropped accesses
+     */
+    std::uint64_t get_dropped_memory_access_count() const noexcept;
+
+    /**
+     * Get the access that last made a watchpoint break
+     *
+     * @return access, or nullopt if no watchpoint broke since the last call
+     */
+    std::optional<MemoryAccess> pop_watchpoint_break();
+
+    /**
+     * Set whether or not to count how many times every instruction runs
+     *
+     * @param enabled enable coverage
+     */
+    void set_coverage_enabled(bool enabled);
+
+    /**
+     * Get whether or not coverage is being collected
+     *
+     * @return true if enabled
+     */
+    bool is_coverage_enabled();
+
+    /**
+     * Forget all collected coverage
+     */
+    void clear_coverage();
+
+    /**
+     * Get how many times instructions ran, using whatever banks are currently mapped to them
+     *
+     * @param addresses addresses to look up
+     * @param max_count set to the highest count of any address
+     * @return          counts for each address
+     */
+    std::vector<std::uint32_t> get_coverage_counts(const std::vector<std::uint16_t> &addresses, std::uint32_t &max_count);
+
+    /**
+     * Get every address that ran at least once, sorted by bank and then address
+     *
+     * @return coverage
+     */
+    std::vector<CoverageEntry> get_coverage();
+
+    /**
+     * Get how many times each opcode ran while coverage was collected
+     *
+     * @return opcode counts
+     */
+    OpcodeCounts get_opcode_counts();
+
+    /**
+     * Start sampling where the CPU is, resolving samples against the loaded symbols on a background thread
+     *
+     * @param interval cycles (in 8 MiHz ticks) between samples
+     */
+    void start_profiler(std::uint32_t interval);
+
+    /**
+     * Stop sampling, keeping what was sampled so far
+     */
+    void stop_profiler();
+
+    /**
+     * Get whether or not the profiler is sampling
+     *
+     * @return true if sampling
+     */
+    bool is_profiling();
+
+    /**
+     * Forget everything the profiler sampled
+     */
+    void clear_profile();
+
+    /**
+     * Get the number of samples taken and how many were dropped because they couldn't be aggregated in time
+     *
+     * @param dropped set to the number of dropped samples
+     * @return        number of samples
+     */
+    std::uint64_t get_profile_sample_count(std::uint64_t &dropped);
+
+    /**
+     * Get a flat and hierarchical report of where the CPU spent its time
+     *
+     * @return report
+     */
+    ProfileReport get_profile_report();
+
+    /**
+     * Export every sampled call stack in the collapsed format used by flame graph tools
+     *
+     * @param path path to write to
+     * @return     true if successful
+     */
+    bool export_profile(const std::filesystem::path &path);
+
+    using BreakAndTraceResult = TraceRecord;
 
     /**
      * Get whether or not we can use our tracing results
@@ -481,6 +922,22 @@ public: // all public functions assume the mutex is not locked
      */
     std::optional<std::vector<BreakAndTraceResult>> pop_break_and_trace_results();
 
+    /**
+     * Decode the instructions that were traced. ROM instructions are decoded from the bank they ran from; anything else is
+     * decoded from what's in memory now.
+     *
+     * @param  results results to decode
+     * @return         one instruction per result
+     */
+    std::vector<SM83Instruction> decode_trace(const std::vector<BreakAndTraceResult> &results);
+
+    /**
+     * Get the path of a trace file that finished being written
+     *
+     * @return path, or nullopt if none finished since the last call
+     */
+    std::optional<std::filesystem::path> pop_finished_trace_file();
+
     /**
      * Set the color correction mode
      *
@@ -503,6 +960,14 @@ public: // all public functions assume the mutex is not locked
      */
     std::vector<std::uint8_t> create_save_state();
 
+    /**
+     * Create a save state in the given buffer, resizing it as needed. The mutex is only held long enough to copy the state into memory.
+     *
+     * @param state buffer to write to
+     * @return      how long the emulation thread was blocked by the copy
+     */
+    clock::duration create_save_state(std::vector<std::uint8_t> &state);
+
     /**
      * Load a save state at the given path
      *
@@ -519,6 +984,15 @@ public: // all public functions assume the mutex is not locked
      */
     bool load_save_state(const std::vector<std::uint8_t> &state) noexcept;
 
+    /**
+     * Load a save state from memory (e.g. a mapped file)
+     *
+     * @param state save state
+     * @param size  size of the save state
+     * @return      true if successful
+     */
+    bool load_save_state(const std::uint8_t *state, std::size_t size) noexcept;
+
     /**
      * Set the audio highpass filter mode
      *
@@ -554,6 +1028,68 @@ public: // all public functions assume the mutex is not locked
      */
     void set_rewind_length(double seconds) noexcept;
 
+    /**
+     * Set the maximum memory to use for rewind history. The oldest history is dropped first.
+     *
+     * @param bytes bytes to use
+     */
+    void set_rewind_memory_budget(std::size_t bytes);
+
+    struct RewindTimeline {
+        /** First frame that can be rewound to */
+        std::uint64_t first_frame;
+
+        /** Last frame that can be rewound to */
+        std::uint64_t last_frame;
+
+        /** Frame currently being emulated */
+        std::uint64_t current_frame;
+
+        /** Number of frames held */
+        std::size_t frame_count;
+
+        /** Number of frames held as keyframes */
+        std::size_t keyframe_count;
+
+        /** Bytes used by rewind history */
+        std::size_t memory_usage;
+
+        /** Maximum bytes used by rewind history */
+        std::size_t memory_budget;
+
+        /** Frames not recorded because compression could not keep up */
+        std::uint64_t frames_dropped;
+
+        /** Seconds of history held */
+        double seconds;
+
+        /** Bytes used per second of history */
+        double bytes_per_second;
+    };
+
+    /**
+     * Get the rewind history available to seek through
+     *
+     * @return timeline
+     */
+    RewindTimeline get_rewind_timeline();
+
+    /**
+     * Jump to a frame in the rewind history. Frames after it are discarded once emulation continues.
+     *
+     * @param frame frame to jump to (the closest frame before it is used if it is not held)
+     * @return      true if successful
+     */
+    bool seek_rewind(std::uint64_t frame);
+
+    /**
+     * Jump back in the rewind history
+     *
+     * @param seconds seconds to jump back
+     * @return        true if successful
+     */
+    bool seek_rewind_back(double seconds);
+
     static const constexpr std::size_t GB_TILESET_WIDTH = 256,
                                        GB_TILESET_PAGE_WIDTH = GB_TILESET_WIDTH / 2,
                                        GB_TILESET_HEIGHT = 192,
@@ -591,6 +1127,44 @@ public: // all public functions assume the mutex is not locked
      */
     std::uint8_t read_memory(std::uint16_t address) noexcept;
 
+    /**
+     * Read memory as the CPU sees it all at once rather than a byte at a time (this wraps around after $FFFF)
+     *
+     * @param address first address
+     * @param output  where to put the bytes
+     * @param length  number of bytes to read
+     */
+    void read_memory_range(std::uint16_t address, std::uint8_t *output, std::size_t length) noexcept;
+
+    /**
+     * Write a byte to memory as the CPU would (so writing to ROM sends it to the cartridge's mapper)
+     *
+     * @param address address to write to
+     * @param value   value to write
+     */
+    void write_memory(std::uint16_t address, std::uint8_t value) noexcept;
+
+    /**
+     * Copy part of a memory region, including banks that aren't mapped in
+     *
+     * @param region region to read (e.g. GB_DIRECT_ACCESS_RAM for all of work RAM)
+     * @param offset offset into the region (e.g. bank * bank size)
+     * @param length most bytes to read
+     * @param output where to put the bytes (resized to however many could be read)
+     * @return       size of the whole region, or 0 if it isn't available
+     */
+    std::size_t read_memory_region(GB_direct_access_t region, std::size_t offset, std::size_t length, std::vector<std::uint8_t> &output);
+
+    /**
+     * Write a byte directly into a memory region, bypassing the CPU
+     *
+     * @param region region to write to
+     * @param offset offset into the region
+     * @param value  value to write
+     * @return       true if written, false if the offset is outside of the region
+     */
+    bool write_memory_region(GB_direct_access_t region, std::size_t offset, std::uint8_t value);
+
     /**
      * Get the palete colors. There are 4 colors.
      *
@@ -770,14 +1344,39 @@ private: // all private functions assume the mutex is locked by the caller
     // Pixel buffer - holds the current pixels
     std::vector<std::uint32_t> pixel_buffer[3];
 
-    // Break and trace addresses
-    std::vector<std::tuple<std::uint16_t, std::size_t, bool, bool>> break_and_trace_breakpoints;
+    // Break and trace addresses (count, step over, break when done, trace path)
+    std::unordered_map<std::uint16_t, std::tuple<std::size_t, bool, bool, std::optional<std::filesystem::path>>> break_and_trace_breakpoints;
     std::vector<std::vector<BreakAndTraceResult>> break_and_trace_result;
     std::size_t current_break_and_trace_remaining = 0;
     bool current_break_and_trace_step_over = false;
     bool current_break_and_trace_break_when_done = false;
     bool break_and_trace_results_ready_no_mutex() const noexcept;
 
+    // Tracing is done from the execution callback, which is only set while a trace is running (or watchpoints, coverage, or the profiler need it)
+    static constexpr const std::size_t MAX_TRACE_RECORDS = 4 * 1024 * 1024;
+    TraceBuffer trace_buffer;
+    bool tracing = false;
+
+    // Stepping over calls tracks where each instruction will go next so a jump elsewhere can be told apart from an interrupt
+    std::int64_t trace_call_depth = 0;
+    bool trace_has_previous = false;
+    std::uint16_t trace_next_pc = 0;
+    std::int8_t trace_next_depth_change = 0;
+    void predict_trace_step_without_mutex(std::uint16_t address, std::uint8_t opcode) noexcept;
+
+    static void on_execution(GB_gameboy_s *gb, std::uint16_t address, std::uint8_t opcode) noexcept;
+    void start_trace_without_mutex(std::size_t count, bool step_over, bool break_when_done, const std::optional<std::filesystem::path> &trace_path);
+
+    // If set, records go here instead of the trace buffer
+    std::unique_ptr<TraceFileWriter> trace_file_writer;
+
+    // Trace files whose writers are still finishing them; these are only joined once they're done, outside of callbacks
+    std::vector<std::unique_ptr<TraceFileWriter>> finishing_trace_files;
+    void finish_trace_without_mutex();
+
+    // Cycles run so far, not counting the current GB_run() call
+    std::uint64_t elapsed_cycles = 0;
+
     // SDL audio device
     std::optional<SDL_AudioDeviceID> sdl_audio_device;
     std::size_t sdl_audio_buffer_size;
@@ -799,6 +1398,7 @@ private: // all private functions assume the mutex is locked by the caller
     
     // Is a ROM loaded?
     std::atomic_bool rom_loaded = false;
+    std::uint64_t rom_hash = 0;
     
     // Paused
     std::atomic_bool manual_paused = false;
@@ -847,6 +1447,41 @@ private: // all private functions assume the mutex is locked by the caller
     bool force_mono = false;
     int volume = 50;
     double volume_scale = 1.0;
+
+    // Audio statistics (atomic so they can be read without the mutex; only written by the emulation thread aside from resets)
+    struct AudioStatisticsCounters {
+        std::atomic<std::uint64_t> samples_produced = 0;
+        std::atomic<std::uint64_t> samples_queued = 0;
+        std::atomic<std::uint64_t> samples_dropped = 0;
+        std::atomic<std::uint64_t> flush_events = 0;
+        std::atomic<std::uint64_t> reset_audio_calls = 0;
+        std::atomic<std::uint64_t> underruns = 0;
+        std::atomic<std::uint64_t> queue_depth_histogram[AUDIO_QUEUE_DEPTH_BUCKETS] = {};
+        std::atomic<std::uint32_t> latency_us = 0;
+        std::atomic<std::uint32_t> max_latency_us = 0;
+    } audio_statistics;
+
+    // Set when audio is queued and cleared on reset; if the queue is empty while this is set, we underran
+    bool sdl_audio_playing = false;
+
+    // Oscilloscope (each record is the min/max of several samples so the UI doesn't have to look at every sample)
+    std::atomic_bool oscilloscope_enabled = false;
+    SPSCRingBuffer<OscilloscopeRecord> oscilloscope_ring = SPSCRingBuffer<OscilloscopeRecord>(16384);
+    OscilloscopeRecord oscilloscope_pending;
+    std::size_t oscilloscope_pending_samples = 0;
+    std::size_t oscilloscope_decimation = 1;
+    void update_oscilloscope(const GB_sample_t *sample) noexcept;
+
+    // Audio recording
+    std::unique_ptr<AudioRecorder> audio_recorder;
+    bool audio_recorder_set_sample_rate = false;
+    void record_sample(const GB_sample_t *sample) noexcept;
+
+    // Recording that was stopped while the mutex was held; it's finished outside of it by pop_interrupted_audio_recording()
+    std::unique_ptr<AudioRecorder> interrupted_audio_recorder;
+    void interrupt_audio_recording_without_mutex() noexcept;
+    void release_audio_recording_sample_rate_without_mutex() noexcept;
+    static AudioRecordingResult finish_audio_recording(AudioRecorder &recorder) noexcept;
     
     // Set whether or not to retain logs into a buffer instead of printing to the console
     void retain_logs(bool retain) noexcept { this->log_buffer_retained = retain; }
@@ -899,12 +1534,92 @@ private: // all private functions assume the mutex is locked by the caller
     static void load_boot_rom(GB_gameboy_t *gb, GB_boot_rom_t type) noexcept;
     std::optional<std::filesystem::path> boot_rom_path;
     bool fast_boot_rom;
+    std::uint64_t boot_rom_hash = 0; // hash of the boot ROM last loaded
+
+    // Contents of the boot ROM file as of when it was last modified (nullopt if it hasn't been read since the path was set)
+    std::vector<std::uint8_t> boot_rom_file_data;
+    std::uint64_t boot_rom_file_hash = 0;
+    std::optional<std::filesystem::file_time_type> boot_rom_file_modified;
+
+    // Post-boot snapshots
+    BootSnapshotCache boot_snapshot_cache;
+    bool boot_snapshot_enabled = true;
+    bool boot_snapshot_pending = false; // if set, take a snapshot once the boot ROM hands off
+    BootSnapshotCache::Key boot_snapshot_key = {};
+    std::vector<std::uint8_t> boot_snapshot_state;
+    void begin_boot_without_mutex() noexcept;
+    void capture_boot_snapshot_if_ready() noexcept;
 
     // Disassemble without that mutex
     std::string disassemble_without_mutex(std::uint16_t address, std::uint8_t count);
-
-    // Get the backtrace without a mutex
-    std::vector<std::uint16_t> get_breakpoints_without_mutex();
+    std::vector<SM83Instruction> disassemble_instructions_without_mutex(std::uint16_t address, std::size_t count);
+    void decode_instruction_without_mutex(std::uint16_t address, SM83Instruction &instruction);
+    void decode_instruction_in_bank_without_mutex(std::uint16_t address, std::uint16_t bank, bool boot_rom, SM83Instruction &instruction);
+    void look_up_symbols_without_mutex(SM83Instruction &instruction);
+
+    // Decoded instructions; RAM entries are invalidated as the CPU writes to memory
+    DisassemblyCache disassembly_cache;
+    static bool on_memory_write(GB_gameboy_s *gb, std::uint16_t address, std::uint8_t data) noexcept;
+
+    // Backtrace as of the last time it was checked; symbols are only looked up when it changes
+    std::vector<BacktraceFrame> backtrace;
+    std::uint64_t backtrace_generation = 0;
+    void update_backtrace_without_mutex();
+
+    // Breakpoints; these are copied to SameBoy's breakpoint list (which it checks every instruction) when they change
+    BreakpointManager breakpoints;
+    std::uint64_t synced_breakpoint_generation = 0;
+    void sync_breakpoints_without_mutex();
+
+    // Used to tell if SameBoy stopped because of a breakpoint or because the last step/next/finish got where it was going
+    enum StepMode {
+        STEP_NONE,
+        STEP_INSTRUCTION,
+        STEP_OVER,
+        STEP_OUT
+    };
+    StepMode step_mode = STEP_NONE;
+    std::uint16_t step_sp = 0;
+    bool break_requested = false;
+    bool is_step_finished_without_mutex(std::uint16_t sp) const noexcept;
+
+    // SameBoy forgets about next/finish once anything stops it, so if a breakpoint's condition wasn't met partway through
+    // one, we finish it ourselves from the execution callback
+    bool resuming_step = false;
+
+    // Compiled watch expressions and their values as of the last frame
+    struct Watch {
+        SM83Expression expression;
+        std::uint16_t value;
+    };
+    std::vector<Watch> watches;
+    void evaluate_watches_without_mutex() noexcept;
+
+    // Compile an expression, looking up symbols
+    std::optional<SM83Expression> compile_expression_without_mutex(const std::string &expression, std::string &error);
+
+    // Memory watchpoints; the execution callback is also set while any are active so we know which instruction made an access
+    WatchpointManager watchpoints;
+    std::uint16_t current_instruction_address = 0;
+    std::optional<MemoryAccess> watchpoint_break;
+    static std::uint8_t on_memory_read(GB_gameboy_s *gb, std::uint16_t address, std::uint8_t data) noexcept;
+    void check_watchpoints_without_mutex(std::uint16_t address, std::uint8_t value, std::uint8_t type) noexcept;
+    void update_memory_callbacks_without_mutex() noexcept;
+
+    // Coverage is also counted from the execution callback
+    CoverageCollector coverage;
+    bool coverage_enabled = false;
+
+    // And so is profiling, which samples once every profile_interval cycles
+    SamplingProfiler profiler;
+    bool profiling = false;
+    std::uint32_t profile_interval = 0;
+    std::uint64_t next_profile_sample = 0;
+    void sample_profile_without_mutex(std::uint16_t address) noexcept;
+    std::shared_ptr<const ProfileSymbols> get_profile_symbols_without_mutex();
+
+    // Set only while the CPU is running, so our own reads (watches, conditions, the debugger) don't trip watchpoints
+    bool cpu_running = false;
 
     // Rumble
     std::atomic<double> rumble = 0.0;
@@ -912,6 +1627,16 @@ private: // all private functions assume the mutex is locked by the caller
     bool should_rewind = false;
     std::atomic_bool rewind_paused = false;
 
+    // Rewind history
+    RewindBuffer rewind_buffer;
+    std::uint64_t rewind_frame = 0;
+    bool rewind_seek_pending = false; // if set, discard anything after rewind_frame before recording the next frame
+    std::vector<std::uint8_t> rewind_state;
+    void record_rewind_frame() noexcept;
+    void discard_rewind_frames_after_seek() noexcept;
+    void clear_rewind_history() noexcept;
+    bool seek_rewind_without_mutex(std::uint64_t frame);
+
     // Rapid buttons
     std::atomic<GB_key_mask_t> rapid_button_bitfield = static_cast<decltype(button_bitfield.load())>(0);
     bool rapid_button_state = false;
@@ -18,20 +18,31 @@
 #include <QMessageBox>
 #include <QCheckBox>
 #include <bit>
+#include <algorithm>
 #include <QMimeData>
 #include "printer.hpp"
 #include "edit_advanced_game_boy_model_dialog.hpp"
 #include "edit_speed_control_settings_dialog.hpp"
 
 #include <QLabel>
+#include <QWidgetAction>
+#include <QDateTime>
+#include <QStandardPaths>
 
 #include "vram_viewer.hpp"
+#include "memory_viewer.hpp"
+#include "audio_oscilloscope.hpp"
+#include "rewind_scrubber.hpp"
+#include "file_io.hpp"
+#include "mapped_file.hpp"
+#include "hash.hpp"
 #include "input_device.hpp"
 
 #define SETTINGS_VOLUME "volume"
 #define SETTINGS_SCALE "scale"
 #define SETTINGS_SCALING_FILTER "scale_filter"
 #define SETTINGS_SHOW_FPS "show_fps"
+#define SETTINGS_SHOW_AUDIO_STATISTICS "show_audio_statistics"
 #define SETTINGS_MONO "mono"
 #define SETTINGS_MUTE "mute"
 #define SETTINGS_RECENT_ROMS "recent_roms"
@@ -41,11 +52,16 @@
 #define SETTINGS_BUFFER_MODE "buffer_mode"
 #define SETTINGS_RTC_MODE "rtc_mode"
 #define SETTINGS_COLOR_CORRECTION_MODE "color_correction_mode"
-#define SETTINGS_TEMPORARY_SAVE_BUFFER_LENGTH "temporary_save_buffer_length"
+#define SETTINGS_TEMPORARY_SAVE_BUFFER_SIZE "temporary_save_buffer_size_kib"
+#define SETTINGS_SRAM_FLUSH_INTERVAL "sram_flush_interval_sec"
+#define SETTINGS_USE_SAVE_STATE_STORE "use_save_state_pack"
+#define SETTINGS_SUSPEND_ON_EXIT "suspend_on_exit"
+#define SETTINGS_SKIP_BOOT_ROM_ON_RESET "skip_boot_rom_on_reset"
 #define SETTINGS_HIGHPASS_FILTER_MODE "highpass_filter_mode"
 #define SETTINGS_RUMBLE_MODE "rumble_mode"
 #define SETTINGS_STATUS_TEXT_HIDDEN "status_text_hidden"
 #define SETTINGS_REWIND_LENGTH "rewind_length"
+#define SETTINGS_REWIND_BUDGET "rewind_budget_kib"
 #define SETTINGS_REWIND_SPEED "rewind_speed"
 #define SETTINGS_BASE_SPEED "base_speed"
 #define SETTINGS_MAX_TURBO "max_turbo"
@@ -268,6 +284,7 @@ GameWindow::GameWindow() {
     auto settings = get_superdux_settings();
     this->scaling = settings.value(SETTINGS_SCALE, this->scaling).toInt();
     this->show_fps = settings.value(SETTINGS_SHOW_FPS, this->show_fps).toBool();
+    this->show_audio_statistics = settings.value(SETTINGS_SHOW_AUDIO_STATISTICS, this->show_audio_statistics).toBool();
     auto gb_type_maybe = static_cast<decltype(this->gb_type)>(settings.value(SETTINGS_GB_MODEL, static_cast<int>(this->gb_type)).toInt());
     if(gb_type_maybe < 0 || gb_type_maybe >= GameBoyType::GameBoy_END) {
         std::fprintf(stderr, "Invalid Game Boy type in config - defaulting to GBC\n");
@@ -308,7 +325,10 @@ GameWindow::GameWindow() {
     LOAD_INT_SETTING_VALUE(this->color_correction_mode, SETTINGS_COLOR_CORRECTION_MODE);
     LOAD_INT_SETTING_VALUE(this->scaling_filter, SETTINGS_SCALING_FILTER);
 
-    LOAD_UINT_SETTING_VALUE(this->temporary_save_state_buffer_length, SETTINGS_TEMPORARY_SAVE_BUFFER_LENGTH);
+    LOAD_UINT_SETTING_VALUE(this->temporary_save_state_buffer_size_kib, SETTINGS_TEMPORARY_SAVE_BUFFER_SIZE);
+    this->temporary_save_states.set_byte_budget(static_cast<std::size_t>(this->temporary_save_state_buffer_size_kib) * 1024);
+    LOAD_UINT_SETTING_VALUE(this->rewind_budget_kib, SETTINGS_REWIND_BUDGET);
+    LOAD_UINT_SETTING_VALUE(this->sram_flush_interval, SETTINGS_SRAM_FLUSH_INTERVAL);
     LOAD_UINT_SETTING_VALUE(this->sample_rate, SETTINGS_SAMPLE_RATE);
     LOAD_UINT_SETTING_VALUE(this->sample_count, SETTINGS_SAMPLE_BUFFER_SIZE);
 
@@ -319,6 +339,9 @@ GameWindow::GameWindow() {
     LOAD_BOOL_SETTING_VALUE(this->turbo_enabled, SETTINGS_TURBO_ENABLED);
     LOAD_BOOL_SETTING_VALUE(this->slowmo_enabled, SETTINGS_SLOWMO_ENABLED);
     LOAD_BOOL_SETTING_VALUE(this->rewind_enabled, SETTINGS_REWIND_ENABLED);
+    LOAD_BOOL_SETTING_VALUE(this->use_save_state_store, SETTINGS_USE_SAVE_STATE_STORE);
+    LOAD_BOOL_SETTING_VALUE(this->suspend_on_exit, SETTINGS_SUSPEND_ON_EXIT);
+    LOAD_BOOL_SETTING_VALUE(this->skip_boot_rom_on_reset, SETTINGS_SKIP_BOOT_ROM_ON_RESET);
     LOAD_BOOL_SETTING_VALUE(this->gb_allow_external_boot_rom, SETTINGS_GB_ALLOW_EXTERNAL_BOOT_ROM);
     LOAD_BOOL_SETTING_VALUE(this->gbc_allow_external_boot_rom, SETTINGS_GBC_ALLOW_EXTERNAL_BOOT_ROM);
     LOAD_BOOL_SETTING_VALUE(this->gba_allow_external_boot_rom, SETTINGS_GBA_ALLOW_EXTERNAL_BOOT_ROM);
@@ -353,8 +376,11 @@ GameWindow::GameWindow() {
     this->instance = std::make_unique<GameInstance>(this->model_for_type(this->gb_type), this->use_border_for_type(this->gb_type) ? GB_border_mode_t::GB_BORDER_ALWAYS : GB_border_mode_t::GB_BORDER_NEVER);
     this->instance->set_use_fast_boot_rom(this->use_fast_boot_rom_for_type(this->gb_type));
     this->instance->set_boot_rom_path(this->boot_rom_for_type(this->gb_type));
+    this->instance->set_boot_snapshot_enabled(this->skip_boot_rom_on_reset);
+    this->instance->set_boot_snapshot_directory(std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "boot_snapshots", &this->background_io);
     this->instance->set_pixel_buffering_mode(static_cast<GameInstance::PixelBufferMode>(settings.value(SETTINGS_BUFFER_MODE, instance->get_pixel_buffering_mode()).toInt()));
     this->instance->set_rewind_length(this->rewind_length);
+    this->instance->set_rewind_memory_budget(static_cast<std::size_t>(this->rewind_budget_kib) * 1024);
 
     // Set window title and enable drag-n-dropping files
     this->setAcceptDrops(true);
@@ -380,7 +406,9 @@ GameWindow::GameWindow() {
     // Save states
     this->save_state_menu = file_menu->addMenu("Save States");
     this->save_state_menu->setEnabled(false);
-    std::vector<QMenu *> save_state_menus(10);
+    connect(this->save_state_menu, &QMenu::aboutToShow, this, &GameWindow::update_save_state_menu);
+    auto &save_state_menus = this->save_state_slot_menus;
+    save_state_menus.resize(SaveStateIndex::SLOT_COUNT);
 
     auto *revert_save_state = this->save_state_menu->addAction("Revert Load State");
     connect(revert_save_state, &QAction::triggered, this, &GameWindow::action_revert_save_state);
@@ -391,11 +419,21 @@ GameWindow::GameWindow() {
 
     this->save_state_menu->addSeparator();
 
-    for(int i = 0; i < 10; i++) {
+    for(int i = 0; i < static_cast<int>(SaveStateIndex::SLOT_COUNT); i++) {
         char m[256];
         std::snprintf(m, sizeof(m), "Save State #%i", i);
         save_state_menus[i] = this->save_state_menu->addMenu(m);
 
+        // Preview of what's in the slot
+        auto *preview = new QLabel(save_state_menus[i]);
+        preview->setAlignment(Qt::AlignCenter);
+        preview->setMinimumSize(SaveStateIndex::THUMBNAIL_WIDTH * 2, SaveStateIndex::THUMBNAIL_HEIGHT * 2);
+        auto *preview_action = new QWidgetAction(save_state_menus[i]);
+        preview_action->setDefaultWidget(preview);
+        save_state_menus[i]->addAction(preview_action);
+        save_state_menus[i]->addSeparator();
+        this->save_state_slot_previews.emplace_back(preview);
+
         int base_key;
         switch(i) {
             case 0:
@@ -440,10 +478,21 @@ GameWindow::GameWindow() {
         load->setShortcut(static_cast<int>(Qt::CTRL) + static_cast<int>(Qt::SHIFT) + base_key);
         connect(load, &QAction::triggered, this, &GameWindow::action_load_save_state);
         load->setData(i);
+        this->load_save_state_actions.emplace_back(load);
     }
     this->save_state_menu->addSeparator();
     auto *import = this->save_state_menu->addAction("Import...");
     connect(import, &QAction::triggered, this, &GameWindow::action_import_save_state);
+    auto *validate = this->save_state_menu->addAction("Validate Save States in Folder...");
+    connect(validate, &QAction::triggered, this, &GameWindow::action_validate_save_states);
+
+    this->save_state_menu->addSeparator();
+    this->use_save_state_store_action = this->save_state_menu->addAction("Store Save States in Pack");
+    this->use_save_state_store_action->setCheckable(true);
+    this->use_save_state_store_action->setChecked(this->use_save_state_store);
+    connect(this->use_save_state_store_action, &QAction::triggered, this, &GameWindow::action_toggle_save_state_store);
+    auto *compact_save_state_store = this->save_state_menu->addAction("Compact Save State Pack");
+    connect(compact_save_state_store, &QAction::triggered, this, &GameWindow::action_compact_save_state_store);
 
     this->save_sram_now = file_menu->addAction("Save SRAM to Disk");
     this->save_sram_now->setEnabled(false);
@@ -451,6 +500,29 @@ GameWindow::GameWindow() {
     this->save_sram_now->setIcon(GET_ICON("document-save"));
     connect(this->save_sram_now, &QAction::triggered, this, &GameWindow::action_save_sram);
 
+    // Periodically save SRAM if it changed
+    auto *sram_flush_interval = file_menu->addMenu("Autosave SRAM");
+    std::pair<const char *, unsigned int> sram_flush_intervals[] = {
+        {"Off", 0},
+        {"Every 10 Seconds", 10},
+        {"Every 30 Seconds", 30},
+        {"Every Minute", 60},
+        {"Every 5 Minutes", 300}
+    };
+    for(auto &i : sram_flush_intervals) {
+        auto *action = sram_flush_interval->addAction(i.first);
+        action->setData(i.second);
+        connect(action, &QAction::triggered, this, &GameWindow::action_set_sram_flush_interval);
+        action->setCheckable(true);
+        action->setChecked(i.second == this->sram_flush_interval);
+        this->sram_flush_interval_options.emplace_back(action);
+    }
+
+    auto *suspend_on_exit = file_menu->addAction("Resume Where You Left Off");
+    suspend_on_exit->setCheckable(true);
+    suspend_on_exit->setChecked(this->suspend_on_exit);
+    connect(suspend_on_exit, &QAction::triggered, this, &GameWindow::action_toggle_suspend_on_exit);
+
     file_menu->addSeparator();
 
     this->exit_without_saving = file_menu->addAction("Quit Without Saving");
@@ -695,6 +767,17 @@ GameWindow::GameWindow() {
     connect(this->reset_rom_action, &QAction::triggered, this, &GameWindow::action_reset);
     this->reset_rom_action->setIcon(GET_ICON("view-refresh"));
     this->reset_rom_action->setEnabled(false);
+
+    auto *skip_boot_rom_on_reset = emulation_menu->addAction("Skip Boot ROM After First Boot");
+    skip_boot_rom_on_reset->setCheckable(true);
+    skip_boot_rom_on_reset->setChecked(this->skip_boot_rom_on_reset);
+    connect(skip_boot_rom_on_reset, &QAction::triggered, this, &GameWindow::action_toggle_skip_boot_rom_on_reset);
+
+    // Rewind timeline
+    this->rewind_scrubber_window = new RewindScrubber(this);
+    this->show_rewind_scrubber = emulation_menu->addAction("Show Rewind Timeline");
+    connect(this->show_rewind_scrubber, &QAction::triggered, this->rewind_scrubber_window, &RewindScrubber::show);
+    connect(this->show_rewind_scrubber, &QAction::triggered, this->rewind_scrubber_window, &RewindScrubber::activateWindow);
     emulation_menu->addSeparator();
 
     // Create the printer
@@ -707,6 +790,16 @@ GameWindow::GameWindow() {
 
     emulation_menu->addSeparator();
 
+    // Audio recording
+    this->record_audio_action = emulation_menu->addAction("Record Audio...");
+    this->record_audio_action->setCheckable(true);
+    this->record_audio_action->setChecked(false);
+    connect(this->record_audio_action, &QAction::triggered, this, &GameWindow::action_toggle_audio_recording);
+
+    this->record_audio_stems_action = emulation_menu->addAction("Record Channel Stems");
+    this->record_audio_stems_action->setCheckable(true);
+    this->record_audio_stems_action->setChecked(false);
+
     // Debug menu
     auto *debug_menu = bar->addMenu("Debug");
     connect(debug_menu, &QMenu::aboutToShow, this, &GameWindow::action_showing_menu);
@@ -715,6 +808,19 @@ GameWindow::GameWindow() {
     this->show_fps_button = debug_menu->addAction("Show FPS");
     connect(this->show_fps_button, &QAction::triggered, this, &GameWindow::action_toggle_showing_fps);
     this->show_fps_button->setCheckable(true);
+    this->show_audio_statistics_button = debug_menu->addAction("Show Audio Statistics");
+    connect(this->show_audio_statistics_button, &QAction::triggered, this, &GameWindow::action_toggle_showing_audio_statistics);
+    this->show_audio_statistics_button->setCheckable(true);
+    auto *save_state_cache_statistics = debug_menu->addAction("Show Save State Cache Statistics...");
+    connect(save_state_cache_statistics, &QAction::triggered, this, &GameWindow::action_show_save_state_cache_statistics);
+    auto *save_state_store_statistics = debug_menu->addAction("Show Save State Pack Statistics...");
+    connect(save_state_store_statistics, &QAction::triggered, this, &GameWindow::action_show_save_state_store_statistics);
+    auto *sram_flush_statistics = debug_menu->addAction("Show SRAM Save Statistics...");
+    connect(sram_flush_statistics, &QAction::triggered, this, &GameWindow::action_show_sram_flush_statistics);
+    auto *disassembly_cache_statistics = debug_menu->addAction("Show Disassembly Cache Statistics...");
+    connect(disassembly_cache_statistics, &QAction::triggered, this, &GameWindow::action_show_disassembly_cache_statistics);
+    auto *benchmark_disassembler = debug_menu->addAction("Benchmark Disassembler...");
+    connect(benchmark_disassembler, &QAction::triggered, this, &GameWindow::action_benchmark_disassembler);
     debug_menu->addSeparator();
 
     // Here's the layout
@@ -746,14 +852,25 @@ GameWindow::GameWindow() {
     connect(this->show_vram_viewer, &QAction::triggered, this->vram_viewer_window, &VRAMViewer::activateWindow);
     this->show_vram_viewer->setEnabled(false);
 
+    this->memory_viewer_window = new MemoryViewer(this);
+    this->show_memory_viewer = debug_menu->addAction("Show Memory Viewer");
+    connect(this->show_memory_viewer, &QAction::triggered, this->memory_viewer_window, &MemoryViewer::show);
+    connect(this->show_memory_viewer, &QAction::triggered, this->memory_viewer_window, &MemoryViewer::activateWindow);
+    this->show_memory_viewer->setEnabled(false);
+
+    // And the audio oscilloscope
+    this->audio_oscilloscope_window = new AudioOscilloscope(this);
+    this->show_audio_oscilloscope = debug_menu->addAction("Show Audio Oscilloscope");
+    connect(this->show_audio_oscilloscope, &QAction::triggered, this->audio_oscilloscope_window, &AudioOscilloscope::show);
+    connect(this->show_audio_oscilloscope, &QAction::triggered, this->audio_oscilloscope_window, &AudioOscilloscope::activateWindow);
+
     // Now, set this
     this->set_pixel_view_scaling(this->scaling);
 
-    // If showing FPS, trigger it
-    if(this->show_fps) {
-        this->show_fps = false;
-        this->action_toggle_showing_fps();
-    }
+    // If showing FPS or audio statistics, set up the overlay
+    this->show_fps_button->setChecked(this->show_fps);
+    this->show_audio_statistics_button->setChecked(this->show_audio_statistics);
+    this->update_fps_text_visibility();
 
     // Audio
     bool result = this->instance->set_up_sdl_audio(this->sample_rate, this->sample_count);
@@ -827,6 +944,17 @@ void GameWindow::load_rom(const char *rom_path) noexcept {
 
     this->instance->remove_all_breakpoints();
     this->save_if_loaded();
+    this->sram_flusher.detach();
+
+    // Switching to another ROM is as good as exiting this one (reopening the same ROM starts it over)
+    if(std::filesystem::path(path).replace_extension(".sav") != this->save_path) {
+        this->suspend_if_loaded();
+    }
+
+    // We may be reloading the same ROM, so make sure its save is on disk before it gets read again
+    this->background_io.wait_until_idle();
+    this->save_state_store.reset();
+
     this->reset_rom_action->setEnabled(true);
     this->exit_without_saving->setEnabled(true);
 
@@ -845,6 +973,9 @@ void GameWindow::load_rom(const char *rom_path) noexcept {
 
     if(path.extension() == ".isx") {
         r = this->instance->load_isx(path, save_path, sym_path);
+
+        std::vector<std::uint8_t> isx_data;
+        this->rom_hash = read_file(path, isx_data) ? fnv1a_64(isx_data.data(), isx_data.size()) : 0;
     }
     else {
         FILE *f = std::fopen(rom_path, "rb");
@@ -1003,6 +1134,7 @@ void GameWindow::load_rom(const char *rom_path) noexcept {
         }
 
         this->instance->load_rom(reinterpret_cast<const std::byte *>(rom_data.data()), rom_data.size(), save_path, sym_path);
+        this->rom_hash = fnv1a_64(rom_data.data(), rom_data.size());
     }
 
     // Success!
@@ -1015,10 +1147,25 @@ void GameWindow::load_rom(const char *rom_path) noexcept {
         // Enable these options
         this->show_debugger->setEnabled(true);
         this->show_vram_viewer->setEnabled(true);
+        this->show_memory_viewer->setEnabled(true);
         this->save_state_menu->setEnabled(true);
         this->save_sram_now->setEnabled(true);
         this->show_printer->setEnabled(true);
 
+        // Slots belong to the ROM, so read them again next time they're needed
+        this->save_state_index_loaded = false;
+        this->open_save_state_store_if_needed();
+        this->warm_save_state_slot_cache();
+
+        // Whatever was just loaded is already on disk
+        this->sram_flusher.reset(*this->instance, this->save_path);
+        this->next_sram_flush = clock::now() + std::chrono::seconds(this->sram_flush_interval);
+        this->play_time_start = clock::now();
+        this->play_time_offset_ms = 0;
+
+        // Skip the boot ROM and intro if we left off somewhere last time
+        this->resume_if_suspended();
+
         // Fire this once
         this->game_loop();
     }
@@ -1158,29 +1305,77 @@ void GameWindow::redraw_pixel_buffer() {
         }
     }
 
-    // Show frame rate
+    // Show frame rate and/or audio statistics
     if(this->fps_text) {
         auto fps = this->instance->get_frame_rate();
         auto multiplier = this->base_multiplier * this->rewind_multiplier * this->slowmo_multiplier * this->turbo_multiplier;
+        auto now = clock::now();
 
-        if(this->last_fps != fps || this->last_speed != multiplier) {
-            char fps_str[64];
-            char mul_str[64] = {};
-            char fps_text_str[64];
-            if(fps == 0.0) {
-                std::snprintf(fps_str, sizeof(fps_str), "--");
-            }
-            else {
-                std::snprintf(fps_str, sizeof(fps_str), "%.01f", fps);
-            }
+        bool update_fps = this->show_fps && (this->last_fps != fps || this->last_speed != multiplier);
+        bool update_audio = this->show_audio_statistics && now >= this->next_audio_statistics_update;
 
-            if(multiplier != 1.0) {
-                std::snprintf(mul_str, sizeof(mul_str), "(%.01f%% speed)", multiplier * 100.0);
+        if(update_fps || update_audio) {
+            std::string text;
+
+            if(this->show_fps) {
+                char fps_str[64];
+                char mul_str[64] = {};
+                char fps_text_str[192];
+                if(fps == 0.0) {
+                    std::snprintf(fps_str, sizeof(fps_str), "--");
+                }
+                else {
+                    std::snprintf(fps_str, sizeof(fps_str), "%.01f", fps);
+                }
+
+                if(multiplier != 1.0) {
+                    std::snprintf(mul_str, sizeof(mul_str), "(%.01f%% speed)", multiplier * 100.0);
+                }
+
+                std::snprintf(fps_text_str, sizeof(fps_text_str), "FPS: %-6s %s", fps_str, mul_str);
+                text += fps_text_str;
             }
 
-            std::snprintf(fps_text_str, sizeof(fps_text_str), "FPS: %-6s %s", fps_str, mul_str);
+            if(this->show_audio_statistics) {
+                auto stats = this->instance->get_audio_statistics();
 
-            this->fps_text->setPlainText(fps_text_str);
+                // Show the queue depth histogram as percentages
+                std::uint64_t histogram_total = 0;
+                for(auto i : stats.queue_depth_histogram) {
+                    histogram_total += i;
+                }
+                std::string histogram;
+                for(auto i : stats.queue_depth_histogram) {
+                    char bucket[16];
+                    std::snprintf(bucket, sizeof(bucket), " %3u", histogram_total == 0 ? 0U : static_cast<unsigned>(i * 100 / histogram_total));
+                    histogram += bucket;
+                }
+
+                char audio_str[512];
+                std::snprintf(audio_str, sizeof(audio_str),
+                              "Latency: %.01f ms (max %.01f ms)\n"
+                              "Samples: %llu made, %llu queued, %llu dropped\n"
+                              "Flushes: %llu  Underruns: %llu  Resets: %llu\n"
+                              "Queue %%:%s",
+                              stats.latency_ms, stats.max_latency_ms,
+                              static_cast<unsigned long long>(stats.samples_produced),
+                              static_cast<unsigned long long>(stats.samples_queued),
+                              static_cast<unsigned long long>(stats.samples_dropped),
+                              static_cast<unsigned long long>(stats.flush_events),
+                              static_cast<unsigned long long>(stats.underruns),
+                              static_cast<unsigned long long>(stats.reset_audio_calls),
+                              histogram.c_str());
+
+                if(!text.empty()) {
+                    text += "\n";
+                }
+                text += audio_str;
+
+                // No need to redraw this more than a few times per second
+                this->next_audio_statistics_update = now + std::chrono::milliseconds(250);
+            }
+
+            this->fps_text->setPlainText(text.c_str());
             this->last_fps = fps;
             this->last_speed = multiplier;
         }
@@ -1238,8 +1433,22 @@ void GameWindow::set_pixel_view_scaling(int scaling) {
 
 void GameWindow::game_loop() {
     this->redraw_pixel_buffer();
+    this->show_background_io_completions();
+    this->check_for_interrupted_audio_recording();
+
+    // Save SRAM in the background if it's time to (this only writes if it actually changed)
+    if(this->sram_flush_interval > 0 && this->instance->is_rom_loaded()) {
+        auto now = clock::now();
+        if(now >= this->next_sram_flush) {
+            this->sram_flusher.flush(*this->instance, this->background_io);
+            this->next_sram_flush = now + std::chrono::seconds(this->sram_flush_interval);
+        }
+    }
     this->debugger_window->refresh_view();
     this->vram_viewer_window->refresh_view();
+    this->memory_viewer_window->refresh_view();
+    this->audio_oscilloscope_window->refresh_view();
+    this->rewind_scrubber_window->refresh_view();
     this->printer_window->refresh_view();
 
     SDL_Event event;
@@ -1365,9 +1574,26 @@ void GameWindow::make_shadow(QGraphicsTextItem *object) {
 void GameWindow::action_toggle_showing_fps() noexcept {
     this->show_fps = !this->show_fps;
     this->show_fps_button->setChecked(this->show_fps);
+    this->update_fps_text_visibility();
+}
+
+void GameWindow::action_toggle_showing_audio_statistics() noexcept {
+    this->show_audio_statistics = !this->show_audio_statistics;
+    this->show_audio_statistics_button->setChecked(this->show_audio_statistics);
+
+    // Start counting from zero so the numbers reflect what's happening now
+    if(this->show_audio_statistics) {
+        this->instance->reset_audio_statistics();
+    }
+
+    this->update_fps_text_visibility();
+}
+
+void GameWindow::update_fps_text_visibility() {
+    bool needs_text = this->show_fps || this->show_audio_statistics;
 
     // If showing frame rate, create text objects and initialize the FPS counter
-    if(this->show_fps) {
+    if(needs_text && this->fps_text == nullptr) {
         auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
         font.setPixelSize(9);
 
@@ -1375,12 +1601,15 @@ void GameWindow::action_toggle_showing_fps() noexcept {
         fps_text->setDefaultTextColor(QColor::fromRgb(255,255,0));
         fps_text->setPos(0, 0);
         this->make_shadow(this->fps_text);
-        this->last_fps = -1.0;
     }
-    else {
+    else if(!needs_text) {
         delete this->fps_text;
         this->fps_text = nullptr;
     }
+
+    // Force a redraw of the text
+    this->last_fps = -1.0;
+    this->next_audio_statistics_update = {};
 }
 
 void GameWindow::action_toggle_pause() noexcept {
@@ -1420,6 +1649,77 @@ void GameWindow::action_toggle_audio() noexcept {
     }
 }
 
+void GameWindow::check_for_interrupted_audio_recording() {
+    if(!this->record_audio_action->isChecked()) {
+        return;
+    }
+
+    auto result = this->instance->pop_interrupted_audio_recording();
+    if(result.has_value()) {
+        this->finish_audio_recording(*result, true);
+    }
+}
+
+void GameWindow::finish_audio_recording(const GameInstance::AudioRecordingResult &result, bool interrupted) {
+    this->record_audio_action->setChecked(false);
+    this->record_audio_stems_action->setEnabled(true);
+
+    if(result.write_failed) {
+        this->show_status_text("Error: Failed to write audio recording");
+    }
+    else if(interrupted) {
+        this->show_status_text("Audio recording stopped (sample rate changed)");
+    }
+    else if(result.frames_dropped > 0) {
+        char m[256];
+        std::snprintf(m, sizeof(m), "Audio recording saved (%llu samples dropped)", static_cast<unsigned long long>(result.frames_dropped));
+        this->show_status_text(m);
+    }
+    else {
+        this->show_status_text("Audio recording saved");
+    }
+}
+
+void GameWindow::action_toggle_audio_recording() {
+    // If we're already recording, stop
+    if(this->instance->is_recording_audio()) {
+        auto result = this->instance->stop_audio_recording();
+        if(result.has_value()) {
+            this->finish_audio_recording(*result, false);
+        }
+        return;
+    }
+
+    // If the emulator already stopped it and we haven't noticed yet, that's what the user wanted anyway
+    auto interrupted = this->instance->pop_interrupted_audio_recording();
+    if(interrupted.has_value()) {
+        this->finish_audio_recording(*interrupted, true);
+        return;
+    }
+
+    QFileDialog qfd;
+    qfd.setWindowTitle("Record Audio");
+    qfd.setAcceptMode(QFileDialog::AcceptMode::AcceptSave);
+    qfd.setDefaultSuffix("wav");
+    qfd.setNameFilters(QStringList { "WAV File (*.wav)" });
+
+    if(qfd.exec() != QDialog::DialogCode::Accepted) {
+        this->record_audio_action->setChecked(false);
+        return;
+    }
+
+    auto path = std::filesystem::path(qfd.selectedFiles().at(0).toStdString());
+    if(this->instance->start_audio_recording(path, this->record_audio_stems_action->isChecked())) {
+        this->record_audio_action->setChecked(true);
+        this->record_audio_stems_action->setEnabled(false); // can't change this mid-recording
+        this->show_status_text("Recording audio");
+    }
+    else {
+        this->record_audio_action->setChecked(false);
+        this->show_status_text("Error: Failed to start audio recording");
+    }
+}
+
 void GameWindow::show_status_text(const char *text) {
     if(this->status_text_hidden) {
         return;
@@ -1473,10 +1773,11 @@ void GameWindow::action_hiding_menu() noexcept {
     this->menu_open = false;
 }
 
-bool GameWindow::save_if_loaded() noexcept {
+bool GameWindow::save_if_loaded(bool force) noexcept {
     if(this->instance->is_rom_loaded()) {
-        if(this->instance->save_sram(this->save_path) == 0) {
-            print_debug_message("Saved cartridge RAM to %s\n", save_path.string().c_str());
+        // Only the snapshot holds up emulation; the write happens in the background
+        if(this->sram_flusher.flush(*this->instance, this->background_io, force)) {
+            print_debug_message("Queued saving cartridge RAM to %s\n", save_path.string().c_str());
             return true;
         }
         else {
@@ -1492,15 +1793,151 @@ bool GameWindow::save_if_loaded() noexcept {
 
 void GameWindow::action_save_sram() noexcept {
     // Initiate saving the SRAM
+    // The result is shown once the background write finishes
     auto filename = this->save_path.filename().string();
-    if(!this->save_if_loaded()) {
+    if(!this->save_if_loaded(true)) {
         char message[256];
         std::snprintf(message, sizeof(message), "Failed to save %s", filename.c_str());
         this->show_status_text(message);
     }
-    else {
-        this->show_status_text("SRAM saved");
+}
+
+void GameWindow::action_set_sram_flush_interval() noexcept {
+    MAKE_MODE_SETTER_WITH_VARIABLE(this->sram_flush_interval, this->sram_flush_interval_options);
+    this->next_sram_flush = clock::now() + std::chrono::seconds(this->sram_flush_interval);
+}
+
+void GameWindow::suspend_if_loaded() {
+    if(!this->suspend_on_exit || !this->instance->is_rom_loaded()) {
+        return;
     }
+
+    // Snapshot now, but let the write finish while everything else is being torn down
+    auto buffer = this->save_state_buffer_pool.acquire();
+    auto stall = this->instance->create_save_state(buffer);
+    print_debug_message("Suspend snapshot blocked emulation for %.03f ms\n", std::chrono::duration_cast<std::chrono::microseconds>(stall).count() / 1000.0);
+
+    auto model = static_cast<std::uint32_t>(this->model_for_type(this->gb_type));
+    this->background_io.enqueue([this, path = get_suspend_state_path(this->save_path), rom_hash = this->rom_hash, model, play_time_ms = this->get_play_time_ms(), buffer = std::move(buffer)]() mutable {
+        auto data = encode_suspend_state(rom_hash, model, play_time_ms, buffer.data(), buffer.size());
+        this->save_state_buffer_pool.release(std::move(buffer));
+
+        BackgroundIO::Completion completion;
+        completion.success = write_file_atomically(path, data.data(), data.size());
+        if(!completion.success) {
+            completion.message = "Failed to write suspend state";
+        }
+        return completion;
+    });
+}
+
+bool GameWindow::resume_if_suspended() {
+    auto path = get_suspend_state_path(this->save_path);
+    std::error_code ec;
+    if(!std::filesystem::is_regular_file(path, ec)) {
+        return false;
+    }
+
+    auto start = clock::now();
+    bool resumed = false;
+    if(this->suspend_on_exit) {
+        std::vector<std::uint8_t> data;
+        auto state = this->save_state_buffer_pool.acquire();
+        std::uint64_t play_time_ms = 0;
+
+        auto result = read_file(path, data) ? decode_suspend_state(data, this->rom_hash, static_cast<std::uint32_t>(this->model_for_type(this->gb_type)), play_time_ms, state) : SUSPEND_STATE_INVALID;
+        if(result == SUSPEND_STATE_OK) {
+            resumed = this->instance->load_save_state(state);
+        }
+        else {
+            print_debug_message("Not resuming from %s: %s\n", path.string().c_str(), describe_suspend_state_result(result));
+        }
+        this->save_state_buffer_pool.release(std::move(state));
+
+        if(resumed) {
+            this->play_time_start = clock::now();
+            this->play_time_offset_ms = play_time_ms;
+        }
+    }
+
+    // It's used up either way; leaving it around could later roll back progress made after it
+    std::filesystem::remove(path, ec);
+
+    if(resumed) {
+        print_debug_message("Resumed from %s in %.03f ms\n", path.string().c_str(), std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count() / 1000.0);
+        this->show_status_text("Resumed where you left off");
+    }
+
+    return resumed;
+}
+
+void GameWindow::action_toggle_skip_boot_rom_on_reset() noexcept {
+    this->skip_boot_rom_on_reset = !this->skip_boot_rom_on_reset;
+    qobject_cast<QAction *>(sender())->setChecked(this->skip_boot_rom_on_reset);
+    this->instance->set_boot_snapshot_enabled(this->skip_boot_rom_on_reset);
+}
+
+void GameWindow::action_toggle_suspend_on_exit() noexcept {
+    this->suspend_on_exit = !this->suspend_on_exit;
+    qobject_cast<QAction *>(sender())->setChecked(this->suspend_on_exit);
+}
+
+void GameWindow::action_show_sram_flush_statistics() {
+    auto statistics = this->sram_flusher.get_statistics();
+
+    char message[512];
+    std::snprintf(message, sizeof(message),
+                  "Checks: %llu\n"
+                  "Skipped (unchanged): %llu\n"
+                  "Writes: %llu\n"
+                  "Failed writes: %llu\n"
+                  "Bytes written: %llu\n"
+                  "Emulation blocked: %.03f ms last, %.03f ms max",
+                  static_cast<unsigned long long>(statistics.checks),
+                  static_cast<unsigned long long>(statistics.unchanged),
+                  static_cast<unsigned long long>(statistics.writes),
+                  static_cast<unsigned long long>(statistics.failed_writes),
+                  static_cast<unsigned long long>(statistics.bytes_written),
+                  statistics.last_stall_ms,
+                  statistics.max_stall_ms);
+    QMessageBox(QMessageBox::Icon::Information, "SRAM Saves", message, QMessageBox::Ok).exec();
+}
+
+void GameWindow::action_benchmark_disassembler() {
+    // Decode from wherever the CPU is so both paths see the same (real) code
+    auto pc = this->instance->get_register_value(GameInstance::SM83Register::SM83_REG_PC);
+    auto results = this->instance->benchmark_disassembler(pc, 25500);
+
+    char message[512];
+    std::snprintf(message, sizeof(message),
+                  "Native decoder: %.0f instructions/sec\n"
+                  "SameBoy log capture: %.0f instructions/sec\n"
+                  "Speedup: %.1fx",
+                  results.native_per_second,
+                  results.log_per_second,
+                  results.log_per_second > 0.0 ? results.native_per_second / results.log_per_second : 0.0);
+    QMessageBox(QMessageBox::Icon::Information, "Disassembler Benchmark", message, QMessageBox::Ok).exec();
+}
+
+void GameWindow::action_show_disassembly_cache_statistics() {
+    auto statistics = this->instance->get_disassembly_cache_statistics();
+    auto lookups = statistics.hits + statistics.misses + statistics.stale;
+
+    char message[512];
+    std::snprintf(message, sizeof(message),
+                  "Instructions cached: %zu\n"
+                  "Hits: %llu\n"
+                  "Misses: %llu\n"
+                  "Stale (written over): %llu\n"
+                  "Not cacheable: %llu\n"
+                  "Hit rate: %.01f%%",
+                  statistics.entries,
+                  static_cast<unsigned long long>(statistics.hits),
+                  static_cast<unsigned long long>(statistics.misses),
+                  static_cast<unsigned long long>(statistics.stale),
+                  static_cast<unsigned long long>(statistics.uncacheable),
+                  lookups > 0 ? 100.0 * statistics.hits / lookups : 0.0);
+    QMessageBox(QMessageBox::Icon::Information, "Disassembly Cache", message, QMessageBox::Ok).exec();
 }
 
 void GameWindow::action_set_model() noexcept {
@@ -1519,7 +1956,12 @@ void GameWindow::action_set_model() noexcept {
 }
 
 void GameWindow::action_quit_without_saving() noexcept {
-    QMessageBox qmb(QMessageBox::Icon::Question, "Are You Sure?", "This will close the emulator without saving your SRAM.\n\nAny save data that has not been saved to disk will be lost.", QMessageBox::Cancel | QMessageBox::Ok);
+    QString message = "This will close the emulator without saving your SRAM.\n\nAny save data that has not been saved to disk will be lost.";
+    if(this->sram_flush_interval > 0) {
+        message += "\n\nSRAM autosave is on, so changes made before the last autosave are already on disk.";
+    }
+
+    QMessageBox qmb(QMessageBox::Icon::Question, "Are You Sure?", message, QMessageBox::Cancel | QMessageBox::Ok);
     qmb.setDefaultButton(QMessageBox::Cancel);
 
     if(qmb.exec() == QMessageBox::Ok) {
@@ -1546,12 +1988,17 @@ GameWindow::~GameWindow() {
 void GameWindow::closeEvent(QCloseEvent *) {
     if(!this->exit_without_save) {
         this->save_if_loaded();
+        this->suspend_if_loaded();
     }
 
+    // Don't exit until pending writes are done
+    this->background_io.wait_until_idle();
+
     auto settings = get_superdux_settings();
     settings.setValue(SETTINGS_VOLUME, this->instance->get_volume());
     settings.setValue(SETTINGS_SCALE, this->scaling);
     settings.setValue(SETTINGS_SHOW_FPS, this->show_fps);
+    settings.setValue(SETTINGS_SHOW_AUDIO_STATISTICS, this->show_audio_statistics);
     settings.setValue(SETTINGS_MONO, this->instance->is_mono_forced());
     settings.setValue(SETTINGS_MUTE, !this->instance->is_audio_enabled());
     settings.setValue(SETTINGS_RECENT_ROMS, this->recent_roms);
@@ -1561,17 +2008,22 @@ void GameWindow::closeEvent(QCloseEvent *) {
     settings.setValue(SETTINGS_BUFFER_MODE, instance->get_pixel_buffering_mode());
     settings.setValue(SETTINGS_RTC_MODE, this->rtc_mode);
     settings.setValue(SETTINGS_COLOR_CORRECTION_MODE, this->color_correction_mode);
-    settings.setValue(SETTINGS_TEMPORARY_SAVE_BUFFER_LENGTH, this->temporary_save_state_buffer_length);
+    settings.setValue(SETTINGS_TEMPORARY_SAVE_BUFFER_SIZE, this->temporary_save_state_buffer_size_kib);
+    settings.setValue(SETTINGS_SRAM_FLUSH_INTERVAL, this->sram_flush_interval);
     settings.setValue(SETTINGS_HIGHPASS_FILTER_MODE, this->highpass_filter_mode);
     settings.setValue(SETTINGS_RUMBLE_MODE, this->rumble_mode);
     settings.setValue(SETTINGS_STATUS_TEXT_HIDDEN, this->status_text_hidden);
     settings.setValue(SETTINGS_REWIND_LENGTH, this->rewind_length);
+    settings.setValue(SETTINGS_REWIND_BUDGET, this->rewind_budget_kib);
     settings.setValue(SETTINGS_REWIND_SPEED, this->rewind_speed);
     settings.setValue(SETTINGS_MAX_SLOWMO, this->max_slowmo);
     settings.setValue(SETTINGS_MAX_TURBO, this->max_turbo);
     settings.setValue(SETTINGS_BASE_SPEED, this->base_multiplier);
     settings.setValue(SETTINGS_MAX_CPU_MULTIPLIER, this->max_cpu_multiplier);
     settings.setValue(SETTINGS_REWIND_ENABLED, this->rewind_enabled);
+    settings.setValue(SETTINGS_USE_SAVE_STATE_STORE, this->use_save_state_store);
+    settings.setValue(SETTINGS_SUSPEND_ON_EXIT, this->suspend_on_exit);
+    settings.setValue(SETTINGS_SKIP_BOOT_ROM_ON_RESET, this->skip_boot_rom_on_reset);
     settings.setValue(SETTINGS_SLOWMO_ENABLED, this->slowmo_enabled);
     settings.setValue(SETTINGS_TURBO_ENABLED, this->turbo_enabled);
     settings.setValue(SETTINGS_SCALING_FILTER, this->scaling_filter);
@@ -1789,47 +2241,316 @@ void GameWindow::action_create_save_state() {
     auto save_state = qobject_cast<QAction *>(sender())->data().toInt();
     auto path = this->get_save_state_path(save_state);
 
-    // Attempt to save
-    if(this->instance->create_save_state(path)) {
+    // Take a snapshot now (this is the only part that holds up emulation), then write it out in the background
+    auto buffer = this->save_state_buffer_pool.acquire();
+    auto stall = this->instance->create_save_state(buffer);
+    print_debug_message("Save state #%i snapshot blocked emulation for %.03f ms\n", save_state, std::chrono::duration_cast<std::chrono::microseconds>(stall).count() / 1000.0);
+
+    // Describe the slot with what's on screen; this only goes in the index once the state is actually written
+    SaveStateIndex::Slot slot;
+    slot.present = true;
+    slot.timestamp = QDateTime::currentSecsSinceEpoch();
+    slot.play_time_ms = this->get_play_time_ms();
+    slot.state_size = buffer.size();
+    std::uint32_t width, height;
+    this->instance->get_dimensions(width, height);
+    if(this->pixel_buffer.size() >= static_cast<std::size_t>(width) * height) {
+        slot.thumbnail = SaveStateIndex::make_thumbnail(this->pixel_buffer.data(), width, height);
+    }
+
+    // Keep the in-memory copy in sync so loading this slot doesn't have to wait for the write
+    this->save_state_slot_cache.store(save_state, buffer);
+
+    this->background_io.enqueue([this, save_state, path, store = this->save_state_store.get(), buffer = std::move(buffer), save_path = this->save_path, slot = std::move(slot)]() mutable {
+        BackgroundIO::Completion completion;
+        if(store != nullptr) {
+            // The pack has it now, so don't leave an older copy of the slot lying around
+            completion.success = store->put(get_save_state_store_name(save_state), buffer.data(), buffer.size());
+            if(completion.success) {
+                std::error_code ec;
+                std::filesystem::remove(path, ec);
+            }
+        }
+        else {
+            completion.success = write_file_atomically(path, buffer.data(), buffer.size());
+        }
+        this->save_state_buffer_pool.release(std::move(buffer));
+
+        // Only update the index once the state itself is safely written (and only if it's still the same ROM's index)
+        if(completion.success) {
+            completion.then = [this, save_state, save_path = std::move(save_path), slot = std::move(slot)]() mutable {
+                if(save_path != this->save_path) {
+                    return;
+                }
+                this->load_save_state_index_if_needed();
+                this->save_state_index.set_slot(save_state, std::move(slot));
+                this->background_io.enqueue([index_path = SaveStateIndex::get_index_path(save_path), index = this->save_state_index.serialize()]() {
+                    BackgroundIO::Completion completion;
+                    completion.success = write_file_atomically(index_path, index.data(), index.size());
+                    return completion;
+                });
+            };
+        }
+
         char msg[256];
-        std::snprintf(msg, sizeof(msg), "Created save state #%i", save_state);
-        this->show_status_text(msg);
+        if(completion.success) {
+            std::snprintf(msg, sizeof(msg), "Created save state #%i", save_state);
+        }
+        else {
+            std::snprintf(msg, sizeof(msg), "Failed to create save state #%i", save_state);
+        }
+        completion.message = msg;
+        return completion;
+    });
+}
+
+void GameWindow::warm_save_state_slot_cache() {
+    auto generation = this->save_state_slot_cache.clear();
+
+    std::vector<std::filesystem::path> paths;
+    for(std::size_t i = 0; i < SaveStateIndex::SLOT_COUNT; i++) {
+        paths.emplace_back(this->get_save_state_path(static_cast<int>(i)));
+    }
+
+    this->background_io.enqueue([this, generation, paths, store = this->save_state_store.get()]() {
+        for(std::size_t i = 0; i < paths.size(); i++) {
+            std::error_code ec;
+            std::vector<std::uint8_t> state;
+            bool in_store = is_save_state_newer_in_store(store, static_cast<int>(i), paths[i]);
+            if((in_store && store->get(get_save_state_store_name(static_cast<int>(i)), state)) || (std::filesystem::is_regular_file(paths[i], ec) && read_file(paths[i], state))) {
+                this->save_state_slot_cache.store_if_absent(i, std::move(state), generation);
+            }
+        }
+        BackgroundIO::Completion completion;
+        completion.success = true;
+        return completion;
+    });
+}
+
+void GameWindow::action_show_save_state_cache_statistics() {
+    auto statistics = this->save_state_slot_cache.get_statistics();
+    auto loads = statistics.hits + statistics.misses;
+
+    char message[512];
+    std::snprintf(message, sizeof(message),
+                  "Slots in memory: %zu\n"
+                  "Memory used: %.01f KiB\n"
+                  "Loads from memory: %llu\n"
+                  "Loads from disk: %llu\n"
+                  "Hit rate: %.01f%%",
+                  statistics.slots_cached,
+                  statistics.memory_usage / 1024.0,
+                  static_cast<unsigned long long>(statistics.hits),
+                  static_cast<unsigned long long>(statistics.misses),
+                  loads > 0 ? statistics.hits * 100.0 / loads : 0.0);
+    QMessageBox(QMessageBox::Icon::Information, "Save State Cache", message, QMessageBox::Ok).exec();
+}
+
+std::string GameWindow::get_save_state_store_name(int index) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "s%i", index);
+    return name;
+}
+
+bool GameWindow::is_save_state_newer_in_store(SaveStateStore *store, int index, const std::filesystem::path &path) {
+    auto stored = store != nullptr ? store->get_modified(get_save_state_store_name(index)) : std::nullopt;
+    if(!stored.has_value()) {
+        return false;
+    }
+
+    // A loose file can be left over (or written while the pack was turned off), so only use the pack if it's not older
+    std::error_code ec;
+    auto loose = std::filesystem::last_write_time(path, ec);
+    return ec || *stored >= std::chrono::file_clock::to_sys(loose);
+}
+
+void GameWindow::open_save_state_store_if_needed() {
+    if(!this->use_save_state_store || this->save_state_store != nullptr || !this->instance->is_rom_loaded()) {
+        return;
+    }
+
+    auto store = std::make_unique<SaveStateStore>(std::filesystem::path(this->save_path).replace_extension(".spack"));
+    if(store->open()) {
+        this->save_state_store = std::move(store);
     }
     else {
-        char err[256];
-        std::snprintf(err, sizeof(err), "Failed to create save state #%i", save_state);
-        this->show_status_text(err);
+        this->show_status_text("Failed to open the save state pack");
     }
 }
 
-bool GameWindow::load_save_state(const std::filesystem::path &path) {
-    // Nope!
-    if(!this->save_states_allowed()) {
-        return false;
+void GameWindow::action_toggle_save_state_store() {
+    this->use_save_state_store = this->use_save_state_store_action->isChecked();
+
+    // Queued saves may still be writing into the pack
+    this->background_io.wait_until_idle();
+    if(this->use_save_state_store) {
+        this->open_save_state_store_if_needed();
+    }
+    else {
+        this->save_state_store.reset();
     }
 
-    // Back up the save state in case this was done by mistake
-    auto backup = this->instance->create_save_state();
-    if(this->instance->load_save_state(path)) {
-        // If we hit the maximum save states, remove the first state before adding a new state (and don't increment the counter)
-        if(this->next_temporary_save_state + 1 > this->temporary_save_state_buffer_length) {
-            this->temporary_save_states.erase(this->temporary_save_states.begin());
+    // Slots may be somewhere else now
+    this->save_state_index_loaded = false;
+    if(this->instance->is_rom_loaded()) {
+        this->warm_save_state_slot_cache();
+    }
+}
+
+void GameWindow::action_compact_save_state_store() {
+    if(this->save_state_store == nullptr) {
+        this->show_status_text("Save states are not being stored in a pack");
+        return;
+    }
+
+    auto before = this->save_state_store->get_statistics().pack_bytes;
+    this->background_io.enqueue([store = this->save_state_store.get(), before]() {
+        BackgroundIO::Completion completion;
+        completion.success = store->compact();
+
+        char msg[256];
+        if(completion.success) {
+            auto after = store->get_statistics().pack_bytes;
+            std::snprintf(msg, sizeof(msg), "Compacted save state pack (freed %llu KiB)", static_cast<unsigned long long>((before > after ? before - after : 0) / 1024));
         }
+        else {
+            std::snprintf(msg, sizeof(msg), "Failed to compact save state pack");
+        }
+        completion.message = msg;
+        return completion;
+    });
+}
+
+void GameWindow::action_show_save_state_store_statistics() {
+    if(this->save_state_store == nullptr) {
+        QMessageBox(QMessageBox::Icon::Information, "Save State Pack", "Save states are not being stored in a pack.", QMessageBox::Ok).exec();
+        return;
+    }
+
+    auto statistics = this->save_state_store->get_statistics();
+
+    char message[512];
+    std::snprintf(message, sizeof(message),
+                  "Save states: %zu\n"
+                  "Save state data: %.01f KiB\n"
+                  "Unique chunks: %zu (%.01f KiB)\n"
+                  "Pack size: %.01f KiB\n"
+                  "Reclaimable by compacting: %.01f KiB\n"
+                  "Deduplication ratio: %.02fx",
+                  statistics.states,
+                  statistics.logical_bytes / 1024.0,
+                  statistics.chunks,
+                  statistics.chunk_bytes / 1024.0,
+                  statistics.pack_bytes / 1024.0,
+                  statistics.reclaimable_bytes / 1024.0,
+                  statistics.chunk_bytes > 0 ? static_cast<double>(statistics.logical_bytes) / statistics.chunk_bytes : 0.0);
+    QMessageBox(QMessageBox::Icon::Information, "Save State Pack", message, QMessageBox::Ok).exec();
+}
+
+void GameWindow::load_save_state_index_if_needed() {
+    if(this->save_state_index_loaded) {
+        return;
+    }
+
+    this->save_state_index.load(SaveStateIndex::get_index_path(this->save_path));
+    this->save_state_index.reconcile([this](std::size_t slot) { return this->get_save_state_path(static_cast<int>(slot)); }, [this](std::size_t slot) {
+        return this->save_state_store != nullptr ? this->save_state_store->get_size(get_save_state_store_name(static_cast<int>(slot))) : std::nullopt;
+    });
+    this->save_state_index_loaded = true;
+}
+
+void GameWindow::update_save_state_menu() {
+    if(!this->instance->is_rom_loaded()) {
+        return;
+    }
+
+    this->load_save_state_index_if_needed();
 
-        // Otherwise, increment the counter
+    for(std::size_t i = 0; i < SaveStateIndex::SLOT_COUNT; i++) {
+        auto &slot = this->save_state_index.get_slot(i);
+        auto *preview = this->save_state_slot_previews[i];
+        QString title = QString("Save State #%1").arg(i);
+
+        this->load_save_state_actions[i]->setEnabled(slot.present);
+
+        if(!slot.present) {
+            this->save_state_slot_menus[i]->setTitle(title);
+            this->save_state_slot_menus[i]->setIcon(QIcon());
+            preview->setPixmap(QPixmap());
+            preview->setText("Empty");
+            continue;
+        }
+
+        title += " - " + QDateTime::fromSecsSinceEpoch(slot.timestamp).toString("yyyy-MM-dd hh:mm");
+        if(slot.play_time_ms > 0) {
+            auto seconds = slot.play_time_ms / 1000;
+            title += QString(" (%1:%2:%3)").arg(seconds / 3600).arg((seconds / 60) % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+        }
+        this->save_state_slot_menus[i]->setTitle(title);
+
+        if(slot.thumbnail.empty()) {
+            this->save_state_slot_menus[i]->setIcon(QIcon());
+            preview->setPixmap(QPixmap());
+            preview->setText(QString("No preview\n%1 KiB").arg(slot.state_size / 1024));
+        }
         else {
-            this->next_temporary_save_state++;
+            auto image = QImage(reinterpret_cast<const uchar *>(slot.thumbnail.data()), SaveStateIndex::THUMBNAIL_WIDTH, SaveStateIndex::THUMBNAIL_HEIGHT, QImage::Format::Format_ARGB32);
+            auto pixmap = QPixmap::fromImage(image);
+            this->save_state_slot_menus[i]->setIcon(QIcon(pixmap));
+            preview->setPixmap(pixmap.scaled(SaveStateIndex::THUMBNAIL_WIDTH * 2, SaveStateIndex::THUMBNAIL_HEIGHT * 2));
         }
+    }
+}
 
-        // Push the save state into the buffer
-        this->temporary_save_states.resize(this->next_temporary_save_state);
-        this->temporary_save_states[this->next_temporary_save_state - 1] = backup;
+std::uint64_t GameWindow::get_play_time_ms() const {
+    return this->play_time_offset_ms + std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - this->play_time_start).count();
+}
 
-        return true;
+void GameWindow::show_background_io_completions() {
+    for(auto &c : this->background_io.pop_completions()) {
+        if(c.then) {
+            c.then();
+        }
+        if(!c.message.empty()) {
+            this->show_status_text(c.message.c_str());
+        }
     }
-    else {
+}
+
+bool GameWindow::load_save_state(const std::filesystem::path &path) {
+    // If we're still writing this state, wait for it to finish
+    this->background_io.wait_until_idle();
+
+    return this->load_save_state_and_back_up([this, &path]() { return this->instance->load_save_state(path); });
+}
+
+bool GameWindow::load_save_state(const std::vector<std::uint8_t> &state) {
+    return this->load_save_state_and_back_up([this, &state]() { return this->instance->load_save_state(state); });
+}
+
+bool GameWindow::load_save_state_and_back_up(const std::function<bool ()> &load) {
+    // Nope!
+    if(!this->save_states_allowed()) {
         return false;
     }
+
+    // Back up the save state in case this was done by mistake
+    auto backup = this->save_state_buffer_pool.acquire();
+    this->instance->create_save_state(backup);
+
+    bool success = load();
+    if(success) {
+        // Anything we reverted past is gone now
+        this->temporary_save_states.truncate(this->next_temporary_save_state);
+        this->temporary_save_states.push_back(backup);
+
+        // Drop the oldest states if we're over budget
+        this->temporary_save_states.trim_to_budget();
+        this->next_temporary_save_state = this->temporary_save_states.size();
+    }
+
+    this->save_state_buffer_pool.release(std::move(backup));
+    return success;
 }
 
 void GameWindow::action_load_save_state() {
@@ -1840,15 +2561,42 @@ void GameWindow::action_load_save_state() {
 
     auto save_state = qobject_cast<QAction *>(sender())->data().toInt();
     auto path = this->get_save_state_path(save_state);
-    if(!std::filesystem::is_regular_file(path)) {
-        char err[256];
-        std::snprintf(err, sizeof(err), "Save state #%i does not exist", save_state);
-        this->show_status_text(err);
-        return;
+
+    // Use the copy in memory if we have it; otherwise read it (and keep it for next time)
+    auto state = this->save_state_buffer_pool.acquire();
+    if(!this->save_state_slot_cache.load(save_state, state)) {
+        // If we're still writing this state, wait for it to finish
+        this->background_io.wait_until_idle();
+
+        bool in_store = is_save_state_newer_in_store(this->save_state_store.get(), save_state, path);
+        if(!in_store && !std::filesystem::is_regular_file(path)) {
+            char err[256];
+            std::snprintf(err, sizeof(err), "Save state #%i does not exist", save_state);
+            this->show_status_text(err);
+            this->save_state_buffer_pool.release(std::move(state));
+            return;
+        }
+
+        if(in_store ? this->save_state_store->get(get_save_state_store_name(save_state), state) : read_file(path, state)) {
+            this->save_state_slot_cache.store(save_state, state);
+        }
+        else {
+            state.clear();
+        }
     }
 
+    auto statistics = this->save_state_slot_cache.get_statistics();
+    print_debug_message("Save state cache: %zu slot(s), %zu KiB, %llu hit(s), %llu miss(es)\n", statistics.slots_cached, statistics.memory_usage / 1024, static_cast<unsigned long long>(statistics.hits), static_cast<unsigned long long>(statistics.misses));
+
     // Attempt to load
-    if(this->load_save_state(path)) {
+    bool success = !state.empty() && this->load_save_state(state);
+    this->save_state_buffer_pool.release(std::move(state));
+    if(success) {
+        // Carry over the play time from when the state was saved
+        this->load_save_state_index_if_needed();
+        this->play_time_start = clock::now();
+        this->play_time_offset_ms = this->save_state_index.get_slot(save_state).play_time_ms;
+
         char msg[256];
         std::snprintf(msg, sizeof(msg), "Loaded save state #%i", save_state);
         this->show_status_text(msg);
@@ -1873,9 +2621,35 @@ void GameWindow::action_import_save_state() {
         return;
     }
 
-    // Maybe attempt to load
+    // If we're still writing this state, wait for it to finish
+    this->background_io.wait_until_idle();
+
+    // Map it so we can check it (and load it) without reading it into memory first
     auto path = std::filesystem::path(qfd.selectedFiles().at(0).toStdString());
-    if(this->load_save_state(path)) {
+    MappedFile file(path);
+    if(!file.is_open()) {
+        this->show_status_text("Failed to open imported save state");
+        return;
+    }
+
+    auto expected = this->get_save_state_expectations();
+    SaveStateInfo info;
+    read_save_state_info(file.data(), file.size(), expected.native_header, info);
+    auto check = check_save_state(info, expected);
+    if(check == SaveStateCheck::SAVE_STATE_UNRECOGNIZED) {
+        this->show_status_text("Imported file is not a save state");
+        return;
+    }
+    else if(check != SaveStateCheck::SAVE_STATE_MATCHES) {
+        auto message = QString("This save state was %1.\n\nWould you like to try to load it anyway?").arg(describe_save_state_check(check));
+        QMessageBox warning(QMessageBox::Icon::Warning, "Import a Save State", message, static_cast<QMessageBox::StandardButtons>(QMessageBox::StandardButton::Cancel) | QMessageBox::StandardButton::Ok);
+        if(warning.exec() != QMessageBox::StandardButton::Ok) {
+            return;
+        }
+    }
+
+    // Maybe attempt to load
+    if(this->load_save_state_and_back_up([this, &file]() { return this->instance->load_save_state(file.data(), file.size()); })) {
         this->show_status_text("Loaded imported save state");
     }
     else {
@@ -1883,6 +2657,96 @@ void GameWindow::action_import_save_state() {
     }
 }
 
+void GameWindow::action_validate_save_states() {
+    if(!this->instance->is_rom_loaded()) {
+        return;
+    }
+
+    auto directory = QFileDialog::getExistingDirectory(this, "Validate Save States in Folder");
+    if(directory.isEmpty()) {
+        return;
+    }
+
+    std::vector<std::filesystem::path> paths;
+    std::error_code ec;
+    for(auto &entry : std::filesystem::directory_iterator(directory.toStdString(), ec)) {
+        std::error_code entry_ec;
+        if(entry.is_regular_file(entry_ec)) {
+            paths.emplace_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    auto start = clock::now();
+    auto results = validate_save_states(paths, this->get_save_state_expectations());
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count() / 1000.0;
+
+    std::size_t counts[SaveStateCheck::SAVE_STATE_WRONG_MODEL + 1] = {};
+    QString details;
+    for(auto &r : results) {
+        counts[r.check]++;
+        if(r.check != SaveStateCheck::SAVE_STATE_UNRECOGNIZED) {
+            details += QString("%1: %2").arg(QString::fromStdString(r.path.filename().string()), describe_save_state_check(r.check));
+            if(!r.info.emulator.empty()) {
+                details += QString(" (%1)").arg(QString::fromStdString(r.info.emulator));
+            }
+            details += "\n";
+        }
+    }
+
+    char message[512];
+    std::snprintf(message, sizeof(message),
+                  "Checked %zu file(s) in %.01f ms\n\n"
+                  "Match the loaded ROM: %zu\n"
+                  "Different model: %zu\n"
+                  "Different ROM: %zu\n"
+                  "ROM not recorded: %zu\n"
+                  "Not save states: %zu\n"
+                  "Unreadable: %zu",
+                  results.size(),
+                  elapsed_ms,
+                  counts[SaveStateCheck::SAVE_STATE_MATCHES],
+                  counts[SaveStateCheck::SAVE_STATE_WRONG_MODEL],
+                  counts[SaveStateCheck::SAVE_STATE_WRONG_ROM],
+                  counts[SaveStateCheck::SAVE_STATE_UNKNOWN_ROM],
+                  counts[SaveStateCheck::SAVE_STATE_UNRECOGNIZED],
+                  counts[SaveStateCheck::SAVE_STATE_UNREADABLE]);
+
+    QMessageBox box(QMessageBox::Icon::Information, "Validate Save States", message, QMessageBox::Ok);
+    box.setDetailedText(details);
+    box.exec();
+}
+
+SaveStateExpectations GameWindow::get_save_state_expectations() {
+    SaveStateExpectations expected;
+
+    // Native save states start with a magic number and version, so take them from one of ours
+    auto state = this->save_state_buffer_pool.acquire();
+    this->instance->create_save_state(state);
+    expected.native_header.assign(state.begin(), state.begin() + std::min(state.size(), SAVE_STATE_NATIVE_HEADER_SIZE));
+    this->save_state_buffer_pool.release(std::move(state));
+
+    expected.rom_header = this->instance->get_rom_header();
+
+    switch(this->gb_type) {
+        case GameBoyType::GameBoyGB:
+            expected.model_family = 'G';
+            break;
+        case GameBoyType::GameBoySGB:
+        case GameBoyType::GameBoySGB2:
+            expected.model_family = 'S';
+            break;
+        case GameBoyType::GameBoyGBA:
+            expected.model_family = 'A';
+            break;
+        default:
+            expected.model_family = 'C';
+            break;
+    }
+
+    return expected;
+}
+
 void GameWindow::action_show_advanced_model_options() noexcept {
     EditAdvancedGameBoyModelDialog dialog(this);
     dialog.exec();
@@ -1895,22 +2759,27 @@ void GameWindow::action_revert_save_state() {
     }
 
     // Try to load the last save state
-    auto &state = this->temporary_save_states[this->next_temporary_save_state - 1];
-    auto backup = this->instance->create_save_state();
-    if(this->instance->load_save_state(state)) {
+    auto state = this->save_state_buffer_pool.acquire();
+    auto backup = this->save_state_buffer_pool.acquire();
+    this->instance->create_save_state(backup);
+
+    if(this->temporary_save_states.get(this->next_temporary_save_state - 1, state) && this->instance->load_save_state(state)) {
         char m[256];
         std::snprintf(m, sizeof(m), "Loaded temp save state %u / %zu", this->next_temporary_save_state, this->temporary_save_states.size());
         this->show_status_text(m);
         this->next_temporary_save_state--;
 
         // Back up save state if we want to un-revert
-        this->temporary_save_states[this->next_temporary_save_state] = backup;
+        this->temporary_save_states.set(this->next_temporary_save_state, backup);
     }
     else {
         char m[256];
         std::snprintf(m, sizeof(m), "Failed to load temp state %u / %zu", this->next_temporary_save_state, this->temporary_save_states.size());
         this->show_status_text(m);
     }
+
+    this->save_state_buffer_pool.release(std::move(state));
+    this->save_state_buffer_pool.release(std::move(backup));
 }
 
 void GameWindow::action_unrevert_save_state() {
@@ -1920,11 +2789,13 @@ void GameWindow::action_unrevert_save_state() {
     }
 
     // Load the next save state
-    auto &state = this->temporary_save_states[this->next_temporary_save_state];
-    auto backup = this->instance->create_save_state();
-    if(this->instance->load_save_state(state)) {
+    auto state = this->save_state_buffer_pool.acquire();
+    auto backup = this->save_state_buffer_pool.acquire();
+    this->instance->create_save_state(backup);
+
+    if(this->temporary_save_states.get(this->next_temporary_save_state, state) && this->instance->load_save_state(state)) {
         // Back up save state if we want to un-un-revert
-        this->temporary_save_states[this->next_temporary_save_state] = backup;
+        this->temporary_save_states.set(this->next_temporary_save_state, backup);
         this->next_temporary_save_state++;
 
         char m[256];
@@ -1937,6 +2808,9 @@ void GameWindow::action_unrevert_save_state() {
         std::snprintf(m, sizeof(m), "Failed to undo temp save state %u / %zu", this->next_temporary_save_state, this->temporary_save_states.size());
         this->show_status_text(m);
     }
+
+    this->save_state_buffer_pool.release(std::move(state));
+    this->save_state_buffer_pool.release(std::move(backup));
 }
 
 void GameWindow::action_toggle_hide_status_text() noexcept {
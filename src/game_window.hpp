@@ -20,16 +20,30 @@ extern "C" {
 #include <QTimer>
 
 #include <thread>
+#include <functional>
 
 #include "input_device.hpp"
 
 #include "game_instance.hpp"
+#include "background_io.hpp"
+#include "buffer_pool.hpp"
+#include "save_state_ring.hpp"
+#include "save_state_index.hpp"
+#include "save_state_slot_cache.hpp"
+#include "save_state_store.hpp"
+#include "sram_flusher.hpp"
+#include "suspend_state.hpp"
+#include "save_state_validator.hpp"
 
 class Printer;
 class Debugger;
 class EditAdvancedGameBoyModelDialog;
 class EditSpeedControlSettingsDialog;
 class VRAMViewer;
+class MemoryViewer;
+class AudioOscilloscope;
+class RewindScrubber;
+class QLabel;
 
 class GameWindow : public QMainWindow {
     Q_OBJECT
@@ -89,10 +103,15 @@ private:
 
     // Emulation
     QAction *pause_action;
+
+    // Audio recording
+    QAction *record_audio_action;
+    QAction *record_audio_stems_action;
     void game_loop();
     std::vector<QAction *> rtc_mode_options;
     GB_rtc_mode_t rtc_mode = GB_rtc_mode_t::GB_RTC_MODE_ACCURATE;
     double rewind_length = 30.0;
+    unsigned int rewind_budget_kib = 65536;
     double rewind_speed = 1.0;
     double max_turbo = 4.0;
     double max_slowmo = 0.25;
@@ -135,6 +154,12 @@ private:
     double last_fps = -1.0;
     double last_speed = 1.0;
 
+    // For showing audio statistics (shares the FPS overlay)
+    bool show_audio_statistics = false;
+    QAction *show_audio_statistics_button;
+    clock::time_point next_audio_statistics_update;
+    void update_fps_text_visibility();
+
     void show_status_text(const char *text);
     QGraphicsTextItem *status_text = nullptr;
     clock::time_point status_text_deletion;
@@ -181,13 +206,57 @@ private:
     // Save states
     std::vector<QAction *> create_save_state_actions;
     std::vector<QAction *> load_save_state_actions;
-    std::vector<std::vector<std::uint8_t>> temporary_save_states;
+    SaveStateRing temporary_save_states;
     unsigned int next_temporary_save_state = 0;
-    unsigned int temporary_save_state_buffer_length = 10;
+    unsigned int temporary_save_state_buffer_size_kib = 4096;
     bool load_save_state(const std::filesystem::path &path);
+    bool load_save_state(const std::vector<std::uint8_t> &state);
+    bool load_save_state_and_back_up(const std::function<bool ()> &load);
+    SaveStateExpectations get_save_state_expectations();
+
+    // Save state buffers are reused between saves; this must be declared before background_io since queued writes return buffers here
+    BufferPool save_state_buffer_pool;
+
+    // Numbered slots held in memory; also declared before background_io since it's filled in the background
+    SaveStateSlotCache save_state_slot_cache = SaveStateSlotCache(SaveStateIndex::SLOT_COUNT);
+    void warm_save_state_slot_cache();
+
+    // Optional pack holding the ROM's numbered slots with identical chunks stored once; declared before background_io since
+    // queued writes go into it
+    std::unique_ptr<SaveStateStore> save_state_store;
+    bool use_save_state_store = false;
+    QAction *use_save_state_store_action;
+    void open_save_state_store_if_needed();
+    static std::string get_save_state_store_name(int index);
+
+    // Whether the pack's copy of a slot should be read instead of the loose file at path (whichever was written last wins)
+    static bool is_save_state_newer_in_store(SaveStateStore *store, int index, const std::filesystem::path &path);
+
+    // Periodic battery saves; declared before background_io since queued writes update its counters
+    SRAMFlusher sram_flusher;
+    unsigned int sram_flush_interval = 0; // seconds (0 = only save when switching ROMs or exiting, so Quit Without Saving means what it says)
+    std::vector<QAction *> sram_flush_interval_options;
+    clock::time_point next_sram_flush;
+
+    // File writes that shouldn't block the UI or emulation
+    BackgroundIO background_io;
+    void show_background_io_completions();
     std::filesystem::path get_save_state_path(int index) const;
     QMenu *save_state_menu;
 
+    // Slot previews; the index is read the first time the save state menu is opened after loading a ROM
+    SaveStateIndex save_state_index;
+    bool save_state_index_loaded = false;
+    std::vector<QMenu *> save_state_slot_menus;
+    std::vector<QLabel *> save_state_slot_previews;
+    void load_save_state_index_if_needed();
+    void update_save_state_menu();
+
+    // Play time recorded into save states (carried over when one is loaded)
+    clock::time_point play_time_start;
+    std::uint64_t play_time_offset_ms = 0;
+    std::uint64_t get_play_time_ms() const;
+
     void reload_devices();
     InputDeviceGamepad *last_used_input_device = nullptr;
 
@@ -195,7 +264,16 @@ private:
     std::filesystem::path save_path;
     bool exit_without_save = false;
     QAction *exit_without_saving;
-    bool save_if_loaded() noexcept;
+    bool save_if_loaded(bool force = false) noexcept;
+
+    // Suspend on exit and resume on the next launch (rom_hash identifies the loaded ROM)
+    std::uint64_t rom_hash = 0;
+    bool suspend_on_exit = true;
+
+    // Restore a snapshot taken when the boot ROM finished instead of running it again (see BootSnapshotCache)
+    bool skip_boot_rom_on_reset = true;
+    void suspend_if_loaded();
+    bool resume_if_suspended();
 
     // Debugging
     QAction *show_debugger;
@@ -205,6 +283,18 @@ private:
     QAction *show_vram_viewer;
     VRAMViewer *vram_viewer_window;
 
+    // Memory viewing
+    QAction *show_memory_viewer;
+    MemoryViewer *memory_viewer_window;
+
+    // Audio oscilloscope
+    QAction *show_audio_oscilloscope;
+    AudioOscilloscope *audio_oscilloscope_window;
+
+    // Rewind timeline
+    QAction *show_rewind_scrubber;
+    RewindScrubber *rewind_scrubber_window;
+
     // Recent ROMs
     QStringList recent_roms;
     QMenu *recent_roms_menu;
@@ -252,6 +342,7 @@ private slots:
     void action_set_scaling() noexcept;
     void action_set_scale_filter() noexcept;
     void action_toggle_showing_fps() noexcept;
+    void action_toggle_showing_audio_statistics() noexcept;
     void action_toggle_pause() noexcept;
     void action_open_rom() noexcept;
     void action_open_recent_rom();
@@ -271,7 +362,18 @@ private slots:
 
     void action_create_save_state();
     void action_load_save_state();
+    void action_show_save_state_cache_statistics();
+    void action_toggle_save_state_store();
+    void action_compact_save_state_store();
+    void action_show_save_state_store_statistics();
+    void action_set_sram_flush_interval() noexcept;
+    void action_show_sram_flush_statistics();
+    void action_benchmark_disassembler();
+    void action_show_disassembly_cache_statistics();
+    void action_toggle_suspend_on_exit() noexcept;
+    void action_toggle_skip_boot_rom_on_reset() noexcept;
     void action_import_save_state();
+    void action_validate_save_states();
 
     void action_revert_save_state();
     void action_unrevert_save_state();
@@ -280,6 +382,9 @@ private slots:
     void action_set_volume();
     void action_add_volume();
     void action_set_channel_count() noexcept;
+    void action_toggle_audio_recording();
+    void finish_audio_recording(const GameInstance::AudioRecordingResult &result, bool interrupted);
+    void check_for_interrupted_audio_recording();
 
     void action_showing_menu() noexcept;
     void action_hiding_menu() noexcept;
@@ -1,6 +1,8 @@
 #define GB_INTERNAL // I solumnly swear I am up to no good
 #include "gb_proxy.h"
 
+#include <stdlib.h>
+
 // from SameBoy's debugger.c (struct is not exposed - will need updated if sameboy gets updated)
 struct GB_breakpoint_s {
     union {
@@ -20,6 +22,38 @@ uint32_t get_gb_backtrace_size(const struct GB_gameboy_s *gb) {
 uint16_t get_gb_backtrace_address(const struct GB_gameboy_s *gb, uint32_t bt) {
     return gb->backtrace_returns[bt].addr;
 }
+uint16_t get_gb_backtrace_bank(const struct GB_gameboy_s *gb, uint32_t bt) {
+    return gb->backtrace_returns[bt].bank;
+}
+
+const char *get_gb_symbol_for_address(struct GB_gameboy_s *gb, uint16_t bank, uint16_t address, uint16_t *offset) {
+    if(bank >= gb->n_symbol_maps || gb->bank_symbols[bank] == NULL) {
+        return NULL;
+    }
+
+    const GB_bank_symbol_t *symbol = GB_map_find_symbol(gb->bank_symbols[bank], address);
+    if(symbol == NULL) {
+        return NULL;
+    }
+
+    *offset = address - symbol->addr;
+    return symbol->name;
+}
+
+uint32_t get_gb_symbol_bank_count(const struct GB_gameboy_s *gb) {
+    return gb->n_symbol_maps;
+}
+uint32_t get_gb_symbol_count(const struct GB_gameboy_s *gb, uint16_t bank) {
+    if(bank >= gb->n_symbol_maps || gb->bank_symbols[bank] == NULL) {
+        return 0;
+    }
+    return gb->bank_symbols[bank]->n_symbols;
+}
+const char *get_gb_symbol(const struct GB_gameboy_s *gb, uint16_t bank, uint32_t index, uint16_t *address) {
+    const GB_bank_symbol_t *symbol = &gb->bank_symbols[bank]->symbols[index];
+    *address = symbol->addr;
+    return symbol->name;
+}
 
 uint32_t get_gb_breakpoint_size(const struct GB_gameboy_s *gb) {
     return gb->n_breakpoints;
@@ -28,6 +62,38 @@ uint16_t get_gb_breakpoint_address(const struct GB_gameboy_s *gb, uint32_t bt) {
     return gb->breakpoints[bt].addr;
 }
 
+bool set_gb_breakpoints(struct GB_gameboy_s *gb, const uint32_t *keys, uint32_t count) {
+    // We don't make conditional breakpoints, but free any that were made through the debugger console
+    for(uint32_t b = 0; b < gb->n_breakpoints; b++) {
+        free(gb->breakpoints[b].condition);
+        gb->breakpoints[b].condition = NULL;
+    }
+
+    if(count == 0) {
+        free(gb->breakpoints);
+        gb->breakpoints = NULL;
+        gb->n_breakpoints = 0;
+        return true;
+    }
+
+    struct GB_breakpoint_s *breakpoints = realloc(gb->breakpoints, count * sizeof(*breakpoints));
+    if(breakpoints == NULL) {
+        return false;
+    }
+
+    // SameBoy binary searches these by key, so they have to stay sorted
+    for(uint32_t b = 0; b < count; b++) {
+        breakpoints[b].addr = (uint16_t)(keys[b] & 0xFFFF);
+        breakpoints[b].bank = (uint16_t)(keys[b] >> 16);
+        breakpoints[b].condition = NULL;
+        breakpoints[b].is_jump_to = false;
+    }
+
+    gb->breakpoints = breakpoints;
+    gb->n_breakpoints = count;
+    return true;
+}
+
 static const uint32_t PALETTE_NONE[4] = { 0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555, 0xFF000000 };
 static const uint32_t PALETTE_ZERO[4] = {0,0,0,0};
 
@@ -59,6 +125,40 @@ const uint32_t *get_gb_palette(struct GB_gameboy_s *gb, GB_palette_type_t palett
     return palette + 4 * (palette_index % 8);
 }
 
+int get_gb_channel_sample(const struct GB_gameboy_s *gb, GB_channel_t channel) {
+    if(!gb->apu.global_enable || !gb->apu.is_active[channel]) {
+        return -1;
+    }
+    return gb->apu.samples[channel];
+}
+
 void skip_sgb_intro_animation(struct GB_gameboy_s *gb) {
     gb->sgb->intro_animation = 1000;
 }
+
+bool is_gb_boot_rom_finished(const struct GB_gameboy_s *gb) {
+    return gb->boot_rom_finished;
+}
+
+uint16_t get_gb_bank_for_address(const struct GB_gameboy_s *gb, uint16_t address) {
+    if(address < 0x4000) {
+        return gb->mbc_rom0_bank;
+    }
+    else if(address < 0x8000) {
+        return gb->mbc_rom_bank;
+    }
+    else if(address < 0xA000) {
+        return gb->cgb_vram_bank;
+    }
+    else if(address < 0xC000) {
+        return gb->mbc_ram_bank;
+    }
+    else if(address >= 0xD000 && address < 0xE000) {
+        return gb->cgb_ram_bank;
+    }
+    return 0;
+}
+
+uint32_t get_gb_cycles_since_run(const struct GB_gameboy_s *gb) {
+    return gb->cycles_since_run;
+}
@@ -15,18 +15,48 @@ uint32_t get_gb_backtrace_size(const struct GB_gameboy_s *gb);
 // Then get their addresses
 uint16_t get_gb_backtrace_address(const struct GB_gameboy_s *gb, uint32_t bt);
 
+// And their banks
+uint16_t get_gb_backtrace_bank(const struct GB_gameboy_s *gb, uint32_t bt);
+
+// Get the closest symbol at or before an address in a bank, setting offset to how far past it the address is (NULL if none)
+const char *get_gb_symbol_for_address(struct GB_gameboy_s *gb, uint16_t bank, uint16_t address, uint16_t *offset);
+
+// Get the # of banks that can have symbols
+uint32_t get_gb_symbol_bank_count(const struct GB_gameboy_s *gb);
+
+// Get the # of symbols in a bank
+uint32_t get_gb_symbol_count(const struct GB_gameboy_s *gb, uint16_t bank);
+
+// Then get their names and addresses (sorted by address)
+const char *get_gb_symbol(const struct GB_gameboy_s *gb, uint16_t bank, uint32_t index, uint16_t *address);
+
 // Get the # of breakpoints
 uint32_t get_gb_breakpoint_size(const struct GB_gameboy_s *gb);
 
 // Then get their addresses
 uint16_t get_gb_breakpoint_address(const struct GB_gameboy_s *gb, uint32_t bt);
 
+// Replace all breakpoints; keys are (bank << 16 | address), sorted, with bank 0xFFFF for any bank (returns false if out of memory)
+bool set_gb_breakpoints(struct GB_gameboy_s *gb, const uint32_t *keys, uint32_t count);
+
 // Get a pointer to the palette
 const uint32_t *get_gb_palette(struct GB_gameboy_s *gb, GB_palette_type_t palette_type, unsigned char palette_index);
 
+// Get the current DAC input of an APU channel (0-15), or -1 if the channel is not active
+int get_gb_channel_sample(const struct GB_gameboy_s *gb, GB_channel_t channel);
+
 // Skip the SGB intro animation
 void skip_sgb_intro_animation(struct GB_gameboy_s *gb);
 
+// Check if the boot ROM has handed off to the cartridge
+bool is_gb_boot_rom_finished(const struct GB_gameboy_s *gb);
+
+// Get the bank currently mapped to an address (0 if the region isn't banked)
+uint16_t get_gb_bank_for_address(const struct GB_gameboy_s *gb, uint16_t address);
+
+// Get the number of cycles (8 MiHz ticks) run so far in the current GB_run() call
+uint32_t get_gb_cycles_since_run(const struct GB_gameboy_s *gb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,26 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+static constexpr const std::uint64_t FNV1A_64_OFFSET_BASIS = 0xCBF29CE484222325;
+static constexpr const std::uint64_t FNV1A_64_PRIME = 0x100000001B3;
+
+/**
+ * Hash data with 64-bit FNV-1a. This is fast and good enough to tell whether data changed, but it is not cryptographic.
+ *
+ * @param data data to hash
+ * @param size size of the data
+ * @param hash hash to continue from (to hash several pieces as one)
+ * @return     hash
+ */
+inline std::uint64_t fnv1a_64(const void *data, std::size_t size, std::uint64_t hash = FNV1A_64_OFFSET_BASIS) noexcept {
+    auto *bytes = reinterpret_cast<const std::uint8_t *>(data);
+    for(std::size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "mapped_file.hpp"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+#ifdef _WIN32
+    auto file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return;
+    }
+    this->size_bytes = static_cast<std::size_t>(size.QuadPart);
+    this->opened = true;
+
+    // Empty files can't be mapped, but there's nothing to read anyway
+    if(this->size_bytes > 0) {
+        auto mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping_handle != nullptr) {
+            this->mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping_handle); // the view keeps the mapping alive
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return;
+    }
+
+    struct stat s;
+    if(fstat(fd, &s) != 0) {
+        close(fd);
+        return;
+    }
+    this->size_bytes = static_cast<std::size_t>(s.st_size);
+    this->opened = true;
+
+    // Empty files can't be mapped, but there's nothing to read anyway
+    if(this->size_bytes > 0) {
+        auto *mapping = mmap(nullptr, this->size_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping != MAP_FAILED) {
+            this->mapping = mapping;
+        }
+    }
+    close(fd); // the mapping stays valid after the descriptor is closed
+#endif
+
+    if(this->size_bytes > 0 && this->mapping == nullptr) {
+        std::fprintf(stderr, "Failed to map %s\n", path.string().c_str());
+    }
+}
+
+MappedFile::~MappedFile() {
+    if(this->mapping == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(this->mapping);
+#else
+    munmap(this->mapping, this->size_bytes);
+#endif
+}
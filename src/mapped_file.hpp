@@ -0,0 +1,55 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+/**
+ * Read-only memory mapping of a whole file, so it can be looked at without reading it into a buffer first
+ */
+class MappedFile {
+public:
+    /**
+     * Map a file. Check is_open() to see if it worked.
+     *
+     * @param path path to the file
+     */
+    MappedFile(const std::filesystem::path &path);
+
+    /**
+     * Unmap the file
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * Get whether or not the file was mapped
+     *
+     * @return true if mapped
+     */
+    bool is_open() const noexcept { return this->mapping != nullptr || (this->opened && this->size_bytes == 0); }
+
+    /**
+     * Get the contents of the file
+     *
+     * @return pointer to the contents (null if empty or not open)
+     */
+    const std::uint8_t *data() const noexcept { return reinterpret_cast<const std::uint8_t *>(this->mapping); }
+
+    /**
+     * Get the size of the file
+     *
+     * @return size in bytes
+     */
+    std::size_t size() const noexcept { return this->size_bytes; }
+
+private:
+    void *mapping = nullptr;
+    std::size_t size_bytes = 0;
+    bool opened = false;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "memory_diff.hpp"
+
+#include <bit>
+#include <cstring>
+
+std::size_t diff_memory(const std::uint8_t *a, const std::uint8_t *b, std::size_t size, std::uint8_t *changed) noexcept {
+    static constexpr const std::uint64_t LOW_BITS = 0x7F7F7F7F7F7F7F7F;
+    static constexpr const std::uint64_t ONES = 0x0101010101010101;
+
+    std::size_t count = 0;
+    std::size_t offset = 0;
+
+    for(; offset + sizeof(std::uint64_t) <= size; offset += sizeof(std::uint64_t)) {
+        std::uint64_t x, y;
+        std::memcpy(&x, a + offset, sizeof(x));
+        std::memcpy(&y, b + offset, sizeof(y));
+        auto difference = x ^ y;
+
+        // Set the high bit of every byte that isn't zero, then move it down to the low bit
+        auto mask = (((difference & LOW_BITS) + LOW_BITS) | difference) >> 7 & ONES;
+        std::memcpy(changed + offset, &mask, sizeof(mask));
+        count += std::popcount(mask);
+    }
+
+    for(; offset < size; offset++) {
+        changed[offset] = a[offset] != b[offset];
+        count += changed[offset];
+    }
+
+    return count;
+}
@@ -0,0 +1,21 @@
+#ifndef MEMORY_DIFF_HPP
+#define MEMORY_DIFF_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Find which bytes differ between two buffers.
+ *
+ * This compares eight bytes at a time and turns each word of differences into a byte mask without branching, so unchanged
+ * memory (the usual case) costs about one comparison per word.
+ *
+ * @param a       first buffer
+ * @param b       second buffer
+ * @param size    number of bytes to compare
+ * @param changed set to 1 for each byte that differs and 0 for each byte that doesn't (size bytes)
+ * @return        number of bytes that differ
+ */
+std::size_t diff_memory(const std::uint8_t *a, const std::uint8_t *b, std::size_t size, std::uint8_t *changed) noexcept;
+
+#endif
@@ -0,0 +1,395 @@
+#include "memory_viewer.hpp"
+#include "game_window.hpp"
+#include "memory_diff.hpp"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QTableView>
+#include <QHeaderView>
+#include <QScrollBar>
+#include <QFontDatabase>
+#include <QApplication>
+#include <QMessageBox>
+#include <QAbstractTableModel>
+
+#include <algorithm>
+#include <cstdio>
+
+static constexpr const int BYTES_PER_ROW = 16;
+
+const MemoryViewer::Region MemoryViewer::REGIONS[] = {
+    { "CPU Address Space", std::nullopt, 0x0000, 0x0000, 0 },
+    { "ROM", GB_DIRECT_ACCESS_ROM, 0x0000, 0x4000, 0x4000 },
+    { "Video RAM", GB_DIRECT_ACCESS_VRAM, 0x8000, 0x8000, 0x2000 },
+    { "Cartridge RAM", GB_DIRECT_ACCESS_CART_RAM, 0xA000, 0xA000, 0x2000 },
+    { "Work RAM", GB_DIRECT_ACCESS_RAM, 0xC000, 0xD000, 0x1000 },
+    { "Object Attribute Memory", GB_DIRECT_ACCESS_OAM, 0xFE00, 0xFE00, 0 },
+    { "I/O Registers", GB_DIRECT_ACCESS_IO, 0xFF00, 0xFF00, 0 },
+    { "High RAM", GB_DIRECT_ACCESS_HRAM, 0xFF80, 0xFF80, 0 }
+};
+
+class MemoryViewer::Model : public QAbstractTableModel {
+public:
+    enum Column {
+        COLUMN_ASCII = BYTES_PER_ROW,
+
+        COLUMN_COUNT
+    };
+
+    Model(MemoryViewer *viewer) : QAbstractTableModel(viewer), viewer(viewer) {
+        auto palette = QApplication::palette();
+        this->text_highlight_color = palette.color(QPalette::ColorRole::HighlightedText);
+        this->bg_highlight_color = palette.color(QPalette::ColorRole::Highlight);
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : static_cast<int>((this->viewer->region_size + BYTES_PER_ROW - 1) / BYTES_PER_ROW);
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : COLUMN_COUNT;
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override {
+        if(role != Qt::DisplayRole) {
+            return QVariant();
+        }
+
+        char text[16];
+        if(orientation == Qt::Horizontal) {
+            if(section == COLUMN_ASCII) {
+                return "ASCII";
+            }
+            std::snprintf(text, sizeof(text), "%02X", section);
+            return text;
+        }
+
+        // Show where each row is mapped to, with its bank if it's banked
+        auto &region = *this->viewer->region;
+        std::size_t offset = static_cast<std::size_t>(section) * BYTES_PER_ROW;
+        if(region.bank_size == 0) {
+            std::snprintf(text, sizeof(text), "%04x", static_cast<unsigned int>(region.first_address + offset));
+        }
+        else {
+            auto bank = offset / region.bank_size;
+            auto address = (bank == 0 ? region.first_address : region.banked_address) + offset % region.bank_size;
+            std::snprintf(text, sizeof(text), "%02zx:%04zx", bank, address);
+        }
+        return text;
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        if(!index.isValid()) {
+            return QVariant();
+        }
+
+        std::size_t row_offset = static_cast<std::size_t>(index.row()) * BYTES_PER_ROW;
+
+        if(index.column() == COLUMN_ASCII) {
+            if(role != Qt::DisplayRole) {
+                return QVariant();
+            }
+
+            char text[BYTES_PER_ROW + 1] = {};
+            for(int i = 0; i < BYTES_PER_ROW; i++) {
+                auto *byte = this->get_byte(row_offset + i);
+                if(byte == nullptr) {
+                    break;
+                }
+                text[i] = (*byte >= 0x20 && *byte < 0x7F) ? static_cast<char>(*byte) : '.';
+            }
+            return text;
+        }
+
+        // Bytes that aren't in view haven't been read yet
+        std::size_t offset = row_offset + index.column();
+        auto *byte = this->get_byte(offset);
+        if(byte == nullptr) {
+            return QVariant();
+        }
+
+        bool changed = this->viewer->changed[offset - this->viewer->visible_offset] != 0;
+        switch(role) {
+            case Qt::DisplayRole:
+            case Qt::EditRole: {
+                char text[4];
+                std::snprintf(text, sizeof(text), "%02X", *byte);
+                return text;
+            }
+            case Qt::ForegroundRole:
+                return changed ? QVariant(this->text_highlight_color) : QVariant();
+            case Qt::BackgroundRole:
+                return changed ? QVariant(this->bg_highlight_color) : QVariant();
+            case Qt::TextAlignmentRole:
+                return Qt::AlignCenter;
+            default:
+                return QVariant();
+        }
+    }
+
+    Qt::ItemFlags flags(const QModelIndex &index) const override {
+        auto flags = QAbstractTableModel::flags(index);
+        if(index.isValid() && index.column() != COLUMN_ASCII) {
+            flags |= Qt::ItemIsEditable;
+        }
+        return flags;
+    }
+
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override {
+        if(!index.isValid() || index.column() == COLUMN_ASCII || role != Qt::EditRole) {
+            return false;
+        }
+
+        bool ok = false;
+        auto byte = value.toString().trimmed().remove('$').toUInt(&ok, 16);
+        if(!ok || byte > 0xFF) {
+            return false;
+        }
+
+        this->viewer->write_byte(static_cast<std::size_t>(index.row()) * BYTES_PER_ROW + index.column(), static_cast<std::uint8_t>(byte));
+        return true;
+    }
+
+    /** Start over (e.g. the region changed) */
+    void reset() {
+        this->beginResetModel();
+        this->endResetModel();
+    }
+
+    /** Draw rows again */
+    void rows_changed(int first, int last) {
+        emit this->dataChanged(this->index(first, 0), this->index(last, COLUMN_COUNT - 1));
+    }
+
+private:
+    MemoryViewer *viewer;
+    QColor text_highlight_color;
+    QColor bg_highlight_color;
+
+    const std::uint8_t *get_byte(std::size_t offset) const noexcept {
+        auto &visible = this->viewer->visible;
+        if(offset < this->viewer->visible_offset || offset - this->viewer->visible_offset >= visible.size()) {
+            return nullptr;
+        }
+        return &visible[offset - this->viewer->visible_offset];
+    }
+};
+
+MemoryViewer::MemoryViewer(GameWindow *window) : QMainWindow(window), window(window), region(&REGIONS[0]) {
+    auto table_font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    table_font.setPixelSize(14);
+
+    this->setWindowTitle("Memory Viewer");
+
+    auto *central_w = new QWidget(this);
+    this->setCentralWidget(central_w);
+    auto *layout = new QVBoxLayout(central_w);
+    central_w->setLayout(layout);
+
+    // Pick what to look at and where
+    auto *top_row = new QWidget(central_w);
+    auto *top_row_l = new QHBoxLayout(top_row);
+    top_row_l->setContentsMargins(0,0,0,0);
+    top_row_l->addWidget(new QLabel("Region:", top_row));
+    this->region_box = new QComboBox(top_row);
+    for(auto &r : REGIONS) {
+        this->region_box->addItem(r.name);
+    }
+    connect(this->region_box, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MemoryViewer::region_changed);
+    top_row_l->addWidget(this->region_box);
+    top_row_l->addWidget(new QLabel("Go to:", top_row));
+    this->go_to_input = new QLineEdit(top_row);
+    this->go_to_input->setFont(table_font);
+    this->go_to_input->setPlaceholderText("Address or bank:address");
+    connect(this->go_to_input, &QLineEdit::returnPressed, this, &MemoryViewer::go_to_address);
+    top_row_l->addWidget(this->go_to_input);
+    layout->addWidget(top_row);
+
+    // Only the rows in view are ever read
+    this->model = new Model(this);
+    this->table_view = new QTableView(central_w);
+    this->table_view->setModel(this->model);
+    this->table_view->setFont(table_font);
+    this->table_view->setShowGrid(false);
+    this->table_view->setWordWrap(false);
+    this->table_view->setSelectionMode(QAbstractItemView::SingleSelection);
+    this->table_view->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed | QAbstractItemView::AnyKeyPressed);
+    this->table_view->verticalHeader()->setFont(table_font);
+    this->table_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    this->table_view->verticalHeader()->setDefaultSectionSize(table_font.pixelSize() + 4);
+    this->table_view->horizontalHeader()->setFont(table_font);
+    this->table_view->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    this->table_view->horizontalHeader()->setDefaultSectionSize(table_font.pixelSize() * 2);
+    this->table_view->horizontalHeader()->setStretchLastSection(true);
+    this->table_view->setMinimumWidth(table_font.pixelSize() * 2 * (BYTES_PER_ROW + 6));
+    this->table_view->setMinimumHeight(400);
+    connect(this->table_view->verticalScrollBar(), &QScrollBar::valueChanged, this, &MemoryViewer::read_visible_memory);
+    layout->addWidget(this->table_view);
+}
+
+MemoryViewer::~MemoryViewer() {}
+
+void MemoryViewer::refresh_view() {
+    if(this->isHidden()) {
+        return;
+    }
+
+    // Update at 20 Hz; changes are highlighted relative to the last update, not the last frame
+    auto now = std::chrono::steady_clock::now();
+    if(now - this->last_update < std::chrono::milliseconds(1000 / 20)) {
+        return;
+    }
+    this->last_update = now;
+
+    this->read_visible_memory();
+}
+
+void MemoryViewer::read_visible_memory() {
+    auto &instance = this->window->get_instance();
+
+    int first_row = std::max(this->table_view->rowAt(0), 0);
+    int last_row = this->table_view->rowAt(this->table_view->viewport()->height() - 1);
+    if(last_row < 0) {
+        last_row = std::max(this->model->rowCount() - 1, first_row);
+    }
+
+    std::size_t offset = static_cast<std::size_t>(first_row) * BYTES_PER_ROW;
+    std::size_t length = static_cast<std::size_t>(last_row - first_row + 1) * BYTES_PER_ROW;
+
+    // Keep what we had so we can tell what changed
+    auto previous_offset = this->visible_offset;
+    std::swap(this->previous, this->visible);
+
+    std::size_t size;
+    if(this->region->region.has_value()) {
+        size = instance.read_memory_region(*this->region->region, offset, length, this->visible);
+    }
+    else {
+        size = 0x10000;
+        this->visible.resize(std::min(length, size - std::min(offset, size)));
+        instance.read_memory_range(static_cast<std::uint16_t>(offset), this->visible.data(), this->visible.size());
+    }
+    this->visible_offset = offset;
+
+    // The region changed size (e.g. a different ROM was loaded), so start over
+    if(size != this->region_size) {
+        this->region_size = size;
+        this->previous.clear();
+        this->changed.assign(this->visible.size(), 0);
+        this->previously_changed.clear();
+        this->model->reset();
+        return;
+    }
+
+    std::swap(this->changed, this->previously_changed);
+    this->changed.resize(this->visible.size());
+
+    // If we scrolled, everything in view is new
+    bool same_view = previous_offset == offset && this->previous.size() == this->visible.size();
+    if(!same_view) {
+        std::fill(this->changed.begin(), this->changed.end(), 0);
+        if(!this->visible.empty()) {
+            this->model->rows_changed(first_row, first_row + static_cast<int>((this->visible.size() - 1) / BYTES_PER_ROW));
+        }
+        return;
+    }
+
+    diff_memory(this->previous.data(), this->visible.data(), this->visible.size(), this->changed.data());
+
+    // Only draw rows that changed or are no longer highlighted
+    bool had_highlights = this->previously_changed.size() == this->changed.size();
+    int dirty_start = -1;
+    int row_count = static_cast<int>((this->visible.size() + BYTES_PER_ROW - 1) / BYTES_PER_ROW);
+    for(int r = 0; r <= row_count; r++) {
+        bool dirty = false;
+        if(r < row_count) {
+            std::size_t row_start = static_cast<std::size_t>(r) * BYTES_PER_ROW;
+            std::size_t row_end = std::min(row_start + BYTES_PER_ROW, this->changed.size());
+            for(std::size_t i = row_start; i < row_end && !dirty; i++) {
+                dirty = this->changed[i] || (had_highlights && this->previously_changed[i]);
+            }
+        }
+
+        if(dirty && dirty_start < 0) {
+            dirty_start = r;
+        }
+        else if(!dirty && dirty_start >= 0) {
+            this->model->rows_changed(first_row + dirty_start, first_row + r - 1);
+            dirty_start = -1;
+        }
+    }
+}
+
+void MemoryViewer::region_changed(int index) {
+    this->region = &REGIONS[index];
+    this->region_size = 0;
+    this->visible.clear();
+    this->previous.clear();
+    this->changed.clear();
+    this->previously_changed.clear();
+    this->model->reset();
+    this->read_visible_memory();
+}
+
+void MemoryViewer::go_to_address() {
+    auto text = this->go_to_input->text().trimmed();
+    auto &region = *this->region;
+    auto &instance = this->window->get_instance();
+
+    // Either bank:address or an expression for an address in the first bank that's switched in there
+    std::optional<std::size_t> offset;
+    auto colon = text.indexOf(':');
+    std::optional<std::uint16_t> address;
+    std::size_t bank = region.first_address == region.banked_address ? 0 : 1;
+    if(colon >= 0 && region.bank_size > 0) {
+        bool ok = false;
+        bank = text.left(colon).remove('$').toUInt(&ok, 16);
+        if(ok) {
+            address = instance.evaluate_expression(text.mid(colon + 1).toUtf8().data());
+        }
+    }
+    else {
+        address = instance.evaluate_expression(text.toUtf8().data());
+    }
+
+    if(address.has_value()) {
+        if(!region.region.has_value()) {
+            offset = *address;
+        }
+        else if(region.bank_size == 0) {
+            if(*address >= region.first_address) {
+                offset = *address - region.first_address;
+            }
+        }
+        else if(*address >= region.banked_address && *address < region.banked_address + region.bank_size && (bank > 0 || region.first_address == region.banked_address)) {
+            offset = bank * region.bank_size + (*address - region.banked_address);
+        }
+        else if(*address >= region.first_address && *address < region.first_address + region.bank_size) {
+            offset = *address - region.first_address;
+        }
+    }
+
+    if(!offset.has_value() || *offset >= this->region_size) {
+        QMessageBox(QMessageBox::Icon::Critical, "Invalid Address", QString("`") + text + "` is not in " + region.name + ".", QMessageBox::StandardButton::Ok).exec();
+        return;
+    }
+
+    auto index = this->model->index(static_cast<int>(*offset / BYTES_PER_ROW), static_cast<int>(*offset % BYTES_PER_ROW));
+    this->table_view->scrollTo(index, QAbstractItemView::PositionAtTop);
+    this->table_view->setCurrentIndex(index);
+    this->read_visible_memory();
+}
+
+void MemoryViewer::write_byte(std::size_t offset, std::uint8_t value) {
+    auto &instance = this->window->get_instance();
+    if(this->region->region.has_value()) {
+        instance.write_memory_region(*this->region->region, offset, value);
+    }
+    else {
+        instance.write_memory(static_cast<std::uint16_t>(offset), value);
+    }
+    this->read_visible_memory();
+}
@@ -0,0 +1,67 @@
+#ifndef MEMORY_VIEWER_HPP
+#define MEMORY_VIEWER_HPP
+
+#include <QMainWindow>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+class GameWindow;
+class QTableView;
+class QComboBox;
+class QLineEdit;
+
+#include "game_instance.hpp"
+
+class MemoryViewer : public QMainWindow {
+    Q_OBJECT
+
+public:
+    MemoryViewer(GameWindow *window);
+    ~MemoryViewer() override;
+
+    void refresh_view();
+
+private:
+    class Model;
+
+    struct Region {
+        const char *name;
+
+        // Where the region comes from (nullopt for the CPU's address space)
+        std::optional<GB_direct_access_t> region;
+
+        // Address of the first bank, address of every other bank, and the size of a bank (0 if not banked)
+        std::uint16_t first_address;
+        std::uint16_t banked_address;
+        std::size_t bank_size;
+    };
+    static const Region REGIONS[];
+
+    GameWindow *window;
+    Model *model;
+    QTableView *table_view;
+    QComboBox *region_box;
+    QLineEdit *go_to_input;
+
+    // Currently shown region and how big it is
+    const Region *region;
+    std::size_t region_size = 0;
+
+    // Bytes that are in view, what they were on the last refresh, and which ones changed since
+    std::size_t visible_offset = 0;
+    std::vector<std::uint8_t> visible;
+    std::vector<std::uint8_t> previous;
+    std::vector<std::uint8_t> changed;
+    std::vector<std::uint8_t> previously_changed;
+    std::chrono::steady_clock::time_point last_update;
+
+    void read_visible_memory();
+    void region_changed(int index);
+    void go_to_address();
+    void write_byte(std::size_t offset, std::uint8_t value);
+};
+
+#endif
@@ -0,0 +1,291 @@
+#include "rewind_buffer.hpp"
+#include "delta_codec.hpp"
+
+#include <algorithm>
+
+RewindBuffer::RewindBuffer(std::size_t byte_budget, std::size_t max_frames, std::size_t keyframe_interval) : byte_budget(byte_budget), max_frames(max_frames), keyframe_interval(std::max<std::size_t>(keyframe_interval, 1)) {
+    this->worker = std::thread(&RewindBuffer::worker_loop, this);
+}
+
+RewindBuffer::~RewindBuffer() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->finishing = true;
+    lock.unlock();
+
+    this->frame_available.notify_all();
+    this->worker.join();
+}
+
+void RewindBuffer::push(std::uint64_t frame, std::vector<std::uint8_t> &&state) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    if(this->max_frames == 0) {
+        lock.unlock();
+        this->pool.release(std::move(state));
+        return;
+    }
+
+    // Don't let the emulation thread pile up snapshots faster than we can encode them
+    if(this->pending.size() >= MAX_PENDING) {
+        this->frames_dropped++;
+        lock.unlock();
+        this->pool.release(std::move(state));
+        return;
+    }
+
+    this->pending.emplace_back(PendingFrame { frame, std::move(state) });
+    lock.unlock();
+
+    this->frame_available.notify_one();
+}
+
+bool RewindBuffer::pop(std::uint64_t &frame, std::vector<std::uint8_t> &state) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->wait_until_idle(lock);
+
+    if(this->entries.size() < 2) {
+        return false;
+    }
+
+    // XOR deltas work both ways, so if we have the last state, we can undo the last delta without going back to a keyframe
+    auto &last = this->entries.back();
+    auto &previous = this->entries[this->entries.size() - 2];
+    bool reversed = !last.keyframe && this->last_state_valid && previous.state_size == last.state_size &&
+                    decode_delta(this->last_state.data(), this->last_state.size(), last.encoded.data(), last.encoded.size(), this->scratch);
+
+    this->remove_last_entry();
+
+    if(reversed) {
+        this->last_state.swap(this->scratch);
+    }
+    else {
+        this->last_state_valid = false; // stale, so don't let decode_entry() use it
+        this->last_state_valid = this->decode_entry(this->entries.size() - 1, this->last_state);
+        if(!this->last_state_valid) {
+            return false;
+        }
+    }
+    this->last_state_valid = true;
+
+    frame = this->entries.back().frame;
+    state.assign(this->last_state.begin(), this->last_state.end());
+    return true;
+}
+
+bool RewindBuffer::get_state(std::uint64_t &frame, std::vector<std::uint8_t> &state) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->wait_until_idle(lock);
+
+    if(this->entries.empty()) {
+        return false;
+    }
+    frame = std::max(frame, this->entries.front().frame);
+
+    // Find the last frame at or before the one requested
+    auto after = std::upper_bound(this->entries.begin(), this->entries.end(), frame, [](std::uint64_t frame, const Entry &entry) { return frame < entry.frame; });
+    auto index = static_cast<std::size_t>(after - this->entries.begin()) - 1;
+
+    frame = this->entries[index].frame;
+    return this->decode_entry(index, state);
+}
+
+void RewindBuffer::truncate_after(std::uint64_t frame) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->wait_until_idle(lock);
+
+    if(this->entries.empty() || this->entries.back().frame <= frame) {
+        return;
+    }
+
+    while(!this->entries.empty() && this->entries.back().frame > frame) {
+        this->remove_last_entry();
+    }
+
+    // Decode the new last frame so the next frame can be a delta against it
+    this->last_state_valid = false;
+    if(!this->entries.empty()) {
+        this->last_state_valid = this->decode_entry(this->entries.size() - 1, this->last_state);
+    }
+}
+
+void RewindBuffer::clear() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    for(auto &p : this->pending) {
+        this->pool.release(std::move(p.state));
+    }
+    this->pending.clear();
+    this->wait_until_idle(lock);
+
+    this->entries.clear();
+    this->memory_usage = 0;
+    this->keyframe_count = 0;
+    this->frames_since_keyframe = 0;
+    this->last_state_valid = false;
+}
+
+void RewindBuffer::set_byte_budget(std::size_t byte_budget) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->byte_budget = byte_budget;
+    this->trim();
+}
+
+void RewindBuffer::set_max_frames(std::size_t max_frames) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->max_frames = max_frames;
+    this->trim();
+}
+
+std::size_t RewindBuffer::get_max_frames() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->max_frames;
+}
+
+RewindBuffer::Statistics RewindBuffer::get_statistics() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    Statistics statistics = {};
+    if(!this->entries.empty()) {
+        statistics.first_frame = this->entries.front().frame;
+        statistics.last_frame = this->entries.back().frame;
+    }
+    statistics.frame_count = this->entries.size();
+    statistics.keyframe_count = this->keyframe_count;
+    statistics.memory_usage = this->memory_usage;
+    statistics.byte_budget = this->byte_budget;
+    statistics.frames_dropped = this->frames_dropped;
+    return statistics;
+}
+
+void RewindBuffer::worker_loop() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while(true) {
+        this->frame_available.wait(lock, [this]() { return this->finishing || !this->pending.empty(); });
+
+        if(this->finishing) {
+            break;
+        }
+
+        auto next = std::move(this->pending.front());
+        this->pending.pop_front();
+        this->encoding = true;
+
+        bool keyframe = this->entries.empty() || !this->last_state_valid || this->frames_since_keyframe + 1 >= this->keyframe_interval;
+
+        // Nothing else touches last_state or the scratch buffer while we're encoding, so we can do this without the lock
+        lock.unlock();
+
+        if(keyframe) {
+            encode_delta(nullptr, 0, next.state.data(), next.state.size(), this->scratch);
+        }
+        else {
+            encode_delta(this->last_state.data(), this->last_state.size(), next.state.data(), next.state.size(), this->scratch);
+        }
+
+        Entry entry = { next.frame, keyframe, next.state.size(), std::vector<std::uint8_t>(this->scratch.begin(), this->scratch.end()) };
+        this->last_state.swap(next.state);
+
+        lock.lock();
+
+        this->memory_usage += entry.encoded.size();
+        this->entries.emplace_back(std::move(entry));
+        if(keyframe) {
+            this->keyframe_count++;
+            this->frames_since_keyframe = 0;
+        }
+        else {
+            this->frames_since_keyframe++;
+        }
+        this->last_state_valid = true;
+        this->trim();
+
+        // This now holds the previous last state, so it can go back to the pool for the next snapshot
+        this->pool.release(std::move(next.state));
+        this->encoding = false;
+
+        if(this->pending.empty()) {
+            this->idle.notify_all();
+        }
+    }
+}
+
+void RewindBuffer::wait_until_idle(std::unique_lock<std::mutex> &lock) {
+    this->idle.wait(lock, [this]() { return this->pending.empty() && !this->encoding; });
+}
+
+bool RewindBuffer::decode_entry(std::size_t index, std::vector<std::uint8_t> &state) {
+    if(index >= this->entries.size()) {
+        return false;
+    }
+
+    if(index + 1 == this->entries.size() && this->last_state_valid) {
+        state.assign(this->last_state.begin(), this->last_state.end());
+        return true;
+    }
+
+    // The first entry is always a keyframe, so this always finds one
+    auto keyframe = index;
+    while(keyframe > 0 && !this->entries[keyframe].keyframe) {
+        keyframe--;
+    }
+
+    auto previous = this->pool.acquire();
+    auto &first = this->entries[keyframe].encoded;
+    bool success = decode_delta(nullptr, 0, first.data(), first.size(), keyframe == index ? state : previous);
+
+    for(auto i = keyframe + 1; i <= index && success; i++) {
+        auto &encoded = this->entries[i].encoded;
+        if(i == index) {
+            success = decode_delta(previous.data(), previous.size(), encoded.data(), encoded.size(), state);
+        }
+        else {
+            success = decode_delta(previous.data(), previous.size(), encoded.data(), encoded.size(), this->scratch);
+            previous.swap(this->scratch);
+        }
+    }
+
+    this->pool.release(std::move(previous));
+    return success;
+}
+
+void RewindBuffer::trim() {
+    if(this->max_frames == 0) {
+        while(!this->entries.empty()) {
+            this->remove_last_entry();
+        }
+        this->last_state_valid = false;
+        return;
+    }
+
+    while(this->memory_usage > this->byte_budget || this->entries.size() > this->max_frames) {
+        // Find the start of the next group; if there isn't one, the last group is all we have, so keep it
+        std::size_t next_keyframe = 1;
+        while(next_keyframe < this->entries.size() && !this->entries[next_keyframe].keyframe) {
+            next_keyframe++;
+        }
+        if(next_keyframe >= this->entries.size()) {
+            break;
+        }
+
+        for(std::size_t i = 0; i < next_keyframe; i++) {
+            auto &front = this->entries.front();
+            this->memory_usage -= front.encoded.size();
+            this->keyframe_count -= front.keyframe ? 1 : 0;
+            this->entries.pop_front();
+        }
+    }
+}
+
+void RewindBuffer::remove_last_entry() {
+    auto &back = this->entries.back();
+    this->memory_usage -= back.encoded.size();
+    this->keyframe_count -= back.keyframe ? 1 : 0;
+    this->entries.pop_back();
+
+    // Count how far the new last entry is from its keyframe
+    this->frames_since_keyframe = 0;
+    for(auto i = this->entries.size(); i > 0 && !this->entries[i - 1].keyframe; i--) {
+        this->frames_since_keyframe++;
+    }
+}
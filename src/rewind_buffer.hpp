@@ -0,0 +1,190 @@
+#ifndef REWIND_BUFFER_HPP
+#define REWIND_BUFFER_HPP
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "buffer_pool.hpp"
+
+/**
+ * Frame-by-frame history of save states used for rewinding and scrubbing.
+ *
+ * Every keyframe_interval frames a keyframe is stored on its own, and every frame in between is stored as a delta against
+ * the frame before it (see delta_codec.hpp). Encoding happens on a worker thread so the emulation thread only has to
+ * snapshot the state. Any frame can be rebuilt by decoding forward from the keyframe before it, and history is dropped one
+ * keyframe group at a time from the front when going over the byte budget or the frame limit.
+ */
+class RewindBuffer {
+public:
+    struct Statistics {
+        /** First frame number stored */
+        std::uint64_t first_frame;
+
+        /** Last frame number stored */
+        std::uint64_t last_frame;
+
+        /** Number of frames stored */
+        std::size_t frame_count;
+
+        /** Number of stored frames that are keyframes */
+        std::size_t keyframe_count;
+
+        /** Bytes used by encoded frames */
+        std::size_t memory_usage;
+
+        /** Byte budget */
+        std::size_t byte_budget;
+
+        /** Frames dropped because the worker could not keep up */
+        std::uint64_t frames_dropped;
+    };
+
+    /**
+     * Instantiate a rewind buffer
+     *
+     * @param byte_budget       maximum bytes to use for encoded frames (at least one keyframe group is always kept)
+     * @param max_frames        maximum number of frames to hold (0 = don't hold anything)
+     * @param keyframe_interval number of frames per keyframe
+     */
+    RewindBuffer(std::size_t byte_budget = 64 * 1024 * 1024, std::size_t max_frames = 0, std::size_t keyframe_interval = 60);
+
+    /**
+     * Stop the worker. Anything still queued is discarded.
+     */
+    ~RewindBuffer();
+
+    /**
+     * Take a buffer to snapshot a frame into. Pass it back with push().
+     *
+     * @param size size of the buffer
+     * @return     buffer
+     */
+    std::vector<std::uint8_t> acquire_buffer(std::size_t size) { return this->pool.acquire(size); }
+
+    /**
+     * Queue a frame to be encoded. If the worker is too far behind, the frame is dropped.
+     *
+     * @param frame frame number (must be greater than the last frame pushed since the last clear or truncate)
+     * @param state save state (taken from acquire_buffer())
+     */
+    void push(std::uint64_t frame, std::vector<std::uint8_t> &&state);
+
+    /**
+     * Remove the last frame and get the frame before it
+     *
+     * @param frame where to put the frame number of the new last frame
+     * @param state where to put the state of the new last frame
+     * @return      true if successful, false if there is nothing to go back to
+     */
+    bool pop(std::uint64_t &frame, std::vector<std::uint8_t> &state);
+
+    /**
+     * Get the state of the given frame, or the closest one before it (or the first frame if it is older than everything held)
+     *
+     * @param frame frame number; set to the frame number actually found
+     * @param state where to put the state
+     * @return      true if successful, false if nothing is held
+     */
+    bool get_state(std::uint64_t &frame, std::vector<std::uint8_t> &state);
+
+    /**
+     * Remove every frame after the given frame
+     *
+     * @param frame frame number
+     */
+    void truncate_after(std::uint64_t frame);
+
+    /**
+     * Remove all frames
+     */
+    void clear();
+
+    /**
+     * Set the byte budget, trimming history if needed
+     *
+     * @param byte_budget byte budget
+     */
+    void set_byte_budget(std::size_t byte_budget);
+
+    /**
+     * Set the frame limit, trimming history if needed
+     *
+     * @param max_frames frame limit (0 = don't hold anything)
+     */
+    void set_max_frames(std::size_t max_frames);
+
+    /**
+     * Get the frame limit
+     *
+     * @return frame limit
+     */
+    std::size_t get_max_frames();
+
+    /**
+     * Get statistics
+     *
+     * @return statistics
+     */
+    Statistics get_statistics();
+
+private:
+    struct Entry {
+        std::uint64_t frame;
+        bool keyframe;
+        std::size_t state_size;
+        std::vector<std::uint8_t> encoded;
+    };
+
+    struct PendingFrame {
+        std::uint64_t frame;
+        std::vector<std::uint8_t> state;
+    };
+
+    // Maximum number of frames that can be waiting on the worker
+    static constexpr const std::size_t MAX_PENDING = 8;
+
+    std::mutex mutex;
+    std::condition_variable frame_available;
+    std::condition_variable idle;
+
+    std::deque<Entry> entries;
+    std::deque<PendingFrame> pending;
+    bool encoding = false;
+    bool finishing = false;
+    std::size_t memory_usage = 0;
+    std::size_t keyframe_count = 0;
+    std::uint64_t frames_dropped = 0;
+
+    std::size_t byte_budget;
+    std::size_t max_frames;
+    std::size_t keyframe_interval;
+
+    // Decoded copy of the last entry; only touched by the worker while encoding, otherwise guarded by the mutex
+    std::vector<std::uint8_t> last_state;
+    bool last_state_valid = false;
+    std::size_t frames_since_keyframe = 0;
+
+    BufferPool pool = BufferPool(MAX_PENDING + 4);
+    std::vector<std::uint8_t> scratch;
+
+    std::thread worker;
+    void worker_loop();
+
+    // Wait until nothing is queued or being encoded (mutex must be held by the lock)
+    void wait_until_idle(std::unique_lock<std::mutex> &lock);
+
+    // Decode the entry at the given index (mutex must be held and the worker idle)
+    bool decode_entry(std::size_t index, std::vector<std::uint8_t> &state);
+
+    // Drop keyframe groups from the front until within limits (mutex must be held)
+    void trim();
+
+    // Remove the last entry (mutex must be held)
+    void remove_last_entry();
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "rewind_scrubber.hpp"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSlider>
+#include <QLabel>
+#include <QPushButton>
+#include <QFontDatabase>
+
+#include "game_window.hpp"
+
+// How far the "back" button jumps
+static constexpr const double SEEK_BACK_SECONDS = 5.0;
+
+RewindScrubber::RewindScrubber(GameWindow *window) : QMainWindow(window), window(window) {
+    this->setWindowTitle("Rewind Timeline");
+
+    auto *central_w = new QWidget(this);
+    this->setCentralWidget(central_w);
+    auto *layout = new QVBoxLayout(central_w);
+    central_w->setLayout(layout);
+
+    auto *timeline_w = new QWidget(central_w);
+    auto *timeline_layout = new QHBoxLayout(timeline_w);
+    timeline_layout->setContentsMargins(0,0,0,0);
+    timeline_w->setLayout(timeline_layout);
+
+    auto *back_button = new QPushButton(QString("-%1 sec").arg(SEEK_BACK_SECONDS), timeline_w);
+    back_button->setToolTip("Jump back in the rewind history");
+    timeline_layout->addWidget(back_button);
+    connect(back_button, &QPushButton::clicked, this, &RewindScrubber::seek_back);
+
+    this->timeline = new QSlider(Qt::Orientation::Horizontal, timeline_w);
+    this->timeline->setMinimumWidth(400);
+    this->timeline->setToolTip("Drag to scrub through the rewind history. Anything after the selected point is discarded once the game continues.");
+    this->timeline->setToolTipDuration(INT_MAX);
+    timeline_layout->addWidget(this->timeline);
+    connect(this->timeline, &QSlider::valueChanged, this, &RewindScrubber::seek_to_slider);
+
+    this->position_text = new QLabel(timeline_w);
+    timeline_layout->addWidget(this->position_text);
+    layout->addWidget(timeline_w);
+
+    this->statistics_text = new QLabel(central_w);
+    this->statistics_text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    layout->addWidget(this->statistics_text);
+}
+
+RewindScrubber::~RewindScrubber() {}
+
+void RewindScrubber::seek_to_slider(int value) {
+    this->window->get_instance().seek_rewind(this->first_frame + static_cast<std::uint64_t>(value));
+}
+
+void RewindScrubber::seek_back() {
+    this->window->get_instance().seek_rewind_back(SEEK_BACK_SECONDS);
+    this->next_refresh = {};
+}
+
+void RewindScrubber::refresh_view() {
+    if(this->isHidden()) {
+        return;
+    }
+
+    // Don't bother updating faster than the user can read
+    auto now = clock::now();
+    if(now < this->next_refresh) {
+        return;
+    }
+    this->next_refresh = now + std::chrono::milliseconds(100);
+
+    auto timeline = this->window->get_instance().get_rewind_timeline();
+
+    // Leave the slider alone while it's being dragged so it doesn't fight the user
+    if(!this->timeline->isSliderDown()) {
+        this->first_frame = timeline.first_frame;
+        auto length = timeline.frame_count > 0 ? timeline.last_frame - timeline.first_frame : 0;
+        auto position = std::min(timeline.current_frame, timeline.last_frame);
+        position = position > timeline.first_frame ? position - timeline.first_frame : 0;
+
+        this->timeline->blockSignals(true);
+        this->timeline->setRange(0, static_cast<int>(length));
+        this->timeline->setValue(static_cast<int>(position));
+        this->timeline->blockSignals(false);
+        this->timeline->setEnabled(timeline.frame_count > 1);
+    }
+
+    auto frame_rate = timeline.frame_count > 0 ? timeline.frame_count / std::max(timeline.seconds, 0.001) : 0.0;
+    double behind = frame_rate > 0.0 && timeline.current_frame < timeline.last_frame ? (timeline.last_frame - timeline.current_frame) / frame_rate : 0.0;
+    this->position_text->setText(QString("-%1 sec").arg(behind, 0, 'f', 2));
+
+    this->statistics_text->setText(QString("History:   %1 sec (%2 frames, %3 keyframes)\n"
+                                           "Memory:    %4 / %5 MiB\n"
+                                           "Per sec:   %6 KiB\n"
+                                           "Dropped:   %7 frames")
+                                   .arg(timeline.seconds, 0, 'f', 1)
+                                   .arg(timeline.frame_count)
+                                   .arg(timeline.keyframe_count)
+                                   .arg(timeline.memory_usage / 1048576.0, 0, 'f', 2)
+                                   .arg(timeline.memory_budget / 1048576.0, 0, 'f', 0)
+                                   .arg(timeline.bytes_per_second / 1024.0, 0, 'f', 1)
+                                   .arg(timeline.frames_dropped));
+}
@@ -0,0 +1,35 @@
+#ifndef REWIND_SCRUBBER_HPP
+#define REWIND_SCRUBBER_HPP
+
+#include <QMainWindow>
+#include <chrono>
+#include <cstdint>
+
+class GameWindow;
+class QSlider;
+class QLabel;
+
+class RewindScrubber : public QMainWindow {
+public:
+    RewindScrubber(GameWindow *window);
+    ~RewindScrubber() override;
+
+    void refresh_view();
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    GameWindow *window;
+    QSlider *timeline;
+    QLabel *position_text;
+    QLabel *statistics_text;
+
+    // Slider positions are relative to this since frame numbers don't fit in an int
+    std::uint64_t first_frame = 0;
+    clock::time_point next_refresh;
+
+    void seek_to_slider(int value);
+    void seek_back();
+};
+
+#endif
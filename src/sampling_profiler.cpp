@@ -0,0 +1,261 @@
+#include "sampling_profiler.hpp"
+#include "file_io.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+void ProfileSymbols::add(std::uint16_t bank, std::uint16_t address, std::string name) {
+    this->symbols.emplace_back(Symbol { static_cast<std::uint32_t>(bank) << 16 | address, std::move(name) });
+}
+
+void ProfileSymbols::sort() {
+    std::stable_sort(this->symbols.begin(), this->symbols.end(), [](const Symbol &a, const Symbol &b) { return a.key < b.key; });
+}
+
+std::uint32_t ProfileSymbols::resolve(const ProfileFrame &frame) const noexcept {
+    std::uint32_t key = static_cast<std::uint32_t>(frame.bank) << 16 | frame.address;
+
+    // Find the last symbol at or before the address; it has to be in the same bank to count
+    auto after = std::upper_bound(this->symbols.begin(), this->symbols.end(), key, [](std::uint32_t k, const Symbol &s) { return k < s.key; });
+    if(after == this->symbols.begin() || ((after - 1)->key >> 16) != frame.bank) {
+        return key;
+    }
+    return (after - 1)->key;
+}
+
+std::string ProfileSymbols::name_for(std::uint32_t function) const {
+    auto found = std::lower_bound(this->symbols.begin(), this->symbols.end(), function, [](const Symbol &s, std::uint32_t k) { return s.key < k; });
+    if(found != this->symbols.end() && found->key == function) {
+        return found->name;
+    }
+
+    char name[16];
+    std::snprintf(name, sizeof(name), "$%02x:%04x", function >> 16, function & 0xFFFF);
+    return name;
+}
+
+SamplingProfiler::SamplingProfiler(std::size_t capacity) : samples(capacity), symbols(std::make_shared<ProfileSymbols>()) {}
+
+SamplingProfiler::~SamplingProfiler() {
+    this->stop();
+}
+
+void SamplingProfiler::start() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if(this->running) {
+        return;
+    }
+    this->running = true;
+    lock.unlock();
+
+    this->worker = std::thread(&SamplingProfiler::worker_loop, this);
+}
+
+void SamplingProfiler::stop() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if(!this->running) {
+        return;
+    }
+    this->running = false;
+    lock.unlock();
+
+    this->wake.notify_all();
+    this->worker.join();
+}
+
+void SamplingProfiler::set_symbols(std::shared_ptr<const ProfileSymbols> symbols) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->symbols = std::move(symbols);
+}
+
+void SamplingProfiler::clear() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->stacks.clear();
+    this->sample_count = 0;
+    this->dropped = 0;
+}
+
+std::uint64_t SamplingProfiler::get_sample_count() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->sample_count;
+}
+
+void SamplingProfiler::worker_loop() {
+    std::vector<ProfileSample> batch(256);
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while(true) {
+        // Popping is lock-free, so only hold the lock while counting
+        lock.unlock();
+        auto count = this->samples.pop(batch.data(), batch.size());
+        lock.lock();
+
+        if(count > 0) {
+            this->aggregate(batch.data(), count);
+            continue;
+        }
+
+        // Drain everything before exiting so nothing sampled gets lost
+        if(!this->running) {
+            break;
+        }
+
+        // Samples are pushed without waking us up (the emulation thread shouldn't have to), so check back regularly
+        this->wake.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+void SamplingProfiler::aggregate(const ProfileSample *samples, std::size_t count) {
+    auto &symbols = *this->symbols;
+
+    for(std::size_t s = 0; s < count; s++) {
+        auto &sample = samples[s];
+
+        this->key.clear();
+        for(std::size_t f = 0; f < sample.depth; f++) {
+            auto function = symbols.resolve(sample.frames[f]);
+            char bytes[sizeof(function)];
+            std::memcpy(bytes, &function, sizeof(function));
+            this->key.append(bytes, sizeof(bytes));
+        }
+
+        this->stacks[this->key]++;
+        this->sample_count++;
+    }
+}
+
+std::vector<std::pair<std::vector<std::string>, std::uint64_t>> SamplingProfiler::get_named_stacks_without_mutex() const {
+    std::vector<std::pair<std::vector<std::string>, std::uint64_t>> named;
+    named.reserve(this->stacks.size());
+
+    // Most stacks share most of their functions, so only look each one up once
+    std::unordered_map<std::uint32_t, std::string> names;
+
+    for(auto &[key, count] : this->stacks) {
+        auto &[frames, samples] = named.emplace_back();
+        samples = count;
+        frames.reserve(key.size() / sizeof(std::uint32_t));
+
+        for(std::size_t offset = 0; offset + sizeof(std::uint32_t) <= key.size(); offset += sizeof(std::uint32_t)) {
+            std::uint32_t function;
+            std::memcpy(&function, key.data() + offset, sizeof(function));
+
+            auto name = names.find(function);
+            if(name == names.end()) {
+                name = names.emplace(function, this->symbols->name_for(function)).first;
+            }
+            frames.emplace_back(name->second);
+        }
+    }
+
+    return named;
+}
+
+ProfileReport SamplingProfiler::get_report() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    auto named = this->get_named_stacks_without_mutex();
+
+    ProfileReport report;
+    report.sample_count = this->sample_count;
+    lock.unlock();
+
+    std::unordered_map<std::string, std::size_t> function_indices;
+    std::vector<std::size_t> counted;
+    report.nodes.emplace_back();
+
+    for(auto &[frames, samples] : named) {
+        if(frames.empty()) {
+            continue;
+        }
+
+        // Recursive functions only count once per stack toward their total
+        counted.clear();
+        std::size_t function = 0;
+        for(auto &name : frames) {
+            auto [index, inserted] = function_indices.try_emplace(name, report.functions.size());
+            function = index->second;
+            if(inserted) {
+                report.functions.emplace_back(ProfileReport::Function { name, 0, 0 });
+            }
+            if(std::find(counted.begin(), counted.end(), function) == counted.end()) {
+                report.functions[function].total_samples += samples;
+                counted.emplace_back(function);
+            }
+        }
+        report.functions[function].self_samples += samples;
+
+        // Walk down the call tree, adding anything that isn't there yet
+        std::size_t node = 0;
+        report.nodes[node].total_samples += samples;
+        for(auto &name : frames) {
+            std::size_t child = report.nodes.size();
+            for(auto c : report.nodes[node].children) {
+                if(report.nodes[c].name == name) {
+                    child = c;
+                    break;
+                }
+            }
+            if(child == report.nodes.size()) {
+                report.nodes[node].children.emplace_back(child);
+                report.nodes.emplace_back(ProfileReport::Node { name, 0, 0, {} });
+            }
+            node = child;
+            report.nodes[node].total_samples += samples;
+        }
+        report.nodes[node].self_samples += samples;
+    }
+
+    // Hottest first
+    std::sort(report.functions.begin(), report.functions.end(), [](const ProfileReport::Function &a, const ProfileReport::Function &b) {
+        if(a.self_samples != b.self_samples) {
+            return a.self_samples > b.self_samples;
+        }
+        if(a.total_samples != b.total_samples) {
+            return a.total_samples > b.total_samples;
+        }
+        return a.name < b.name;
+    });
+    for(auto &node : report.nodes) {
+        std::sort(node.children.begin(), node.children.end(), [&report](std::size_t a, std::size_t b) {
+            return report.nodes[a].total_samples > report.nodes[b].total_samples;
+        });
+    }
+
+    return report;
+}
+
+bool SamplingProfiler::export_collapsed_stacks(const std::filesystem::path &path) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    auto named = this->get_named_stacks_without_mutex();
+    lock.unlock();
+
+    // Sort the lines so exports from different runs can be diffed
+    std::vector<std::string> lines;
+    lines.reserve(named.size());
+    for(auto &[frames, samples] : named) {
+        std::string line;
+        for(auto &name : frames) {
+            if(!line.empty()) {
+                line += ';';
+            }
+
+            // Spaces and semicolons separate things in this format, so they can't be in names
+            for(char c : name) {
+                line += (c == ' ' || c == ';') ? '_' : c;
+            }
+        }
+        line += ' ';
+        line += std::to_string(samples);
+        line += '\n';
+        lines.emplace_back(std::move(line));
+    }
+    std::sort(lines.begin(), lines.end());
+
+    std::string output;
+    for(auto &line : lines) {
+        output += line;
+    }
+    return write_file_atomically(path, reinterpret_cast<const std::uint8_t *>(output.data()), output.size());
+}
@@ -0,0 +1,226 @@
+#ifndef SAMPLING_PROFILER_HPP
+#define SAMPLING_PROFILER_HPP
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "spsc_ring_buffer.hpp"
+
+/**
+ * An address and the bank mapped to it
+ */
+struct ProfileFrame {
+    /** Address */
+    std::uint16_t address;
+
+    /** Bank mapped to the address */
+    std::uint16_t bank;
+};
+
+/**
+ * Where the CPU was when it was sampled
+ */
+struct ProfileSample {
+    /** Deepest call stack kept; anything deeper loses its outermost callers */
+    static constexpr const std::size_t MAX_DEPTH = 32;
+
+    /** Number of frames used */
+    std::uint8_t depth = 0;
+
+    /** Call sites, outermost first, followed by the PC */
+    std::array<ProfileFrame, MAX_DEPTH> frames;
+};
+
+/**
+ * Symbols used to tell which function an address is in
+ */
+class ProfileSymbols {
+public:
+    /**
+     * Add a symbol. Call sort() when done adding them.
+     *
+     * @param bank    bank of the symbol
+     * @param address address of the symbol
+     * @param name    name of the symbol
+     */
+    void add(std::uint16_t bank, std::uint16_t address, std::string name);
+
+    /**
+     * Sort the symbols so they can be looked up
+     */
+    void sort();
+
+    /**
+     * Get the function an address is in
+     *
+     * @param frame address and bank
+     * @return      bank << 16 | address of the closest symbol at or before it in the same bank, or of the address itself if there is none
+     */
+    std::uint32_t resolve(const ProfileFrame &frame) const noexcept;
+
+    /**
+     * Get the name of a function from resolve()
+     *
+     * @param function function
+     * @return         name of its symbol, or $bank:address if there is none
+     */
+    std::string name_for(std::uint32_t function) const;
+
+private:
+    struct Symbol {
+        std::uint32_t key;
+        std::string name;
+    };
+    std::vector<Symbol> symbols;
+};
+
+/**
+ * Aggregated results from a profiler
+ */
+struct ProfileReport {
+    struct Function {
+        /** Name of the function */
+        std::string name;
+
+        /** Samples taken while in this function */
+        std::uint64_t self_samples;
+
+        /** Samples taken while in this function or anything it called */
+        std::uint64_t total_samples;
+    };
+
+    struct Node {
+        /** Name of the function (empty for the root) */
+        std::string name;
+
+        /** Samples taken while in this function when called from here */
+        std::uint64_t self_samples;
+
+        /** Samples taken while in this function or anything it called when called from here */
+        std::uint64_t total_samples;
+
+        /** Indices of the functions called from here */
+        std::vector<std::size_t> children;
+    };
+
+    /** Number of samples */
+    std::uint64_t sample_count = 0;
+
+    /** Every function that was sampled, hottest first */
+    std::vector<Function> functions;
+
+    /** Call tree; the first node is the root, and children are sorted hottest first */
+    std::vector<Node> nodes;
+};
+
+/**
+ * Aggregates samples of where the CPU is into counts per call stack.
+ *
+ * The emulation thread pushes samples into a lock-free ring buffer, and a background thread resolves them to functions and
+ * counts them, so sampling never waits on anything. If the ring buffer fills up, samples are dropped and counted.
+ */
+class SamplingProfiler {
+public:
+    /**
+     * Instantiate a profiler
+     *
+     * @param capacity number of samples that can be queued before they're aggregated
+     */
+    SamplingProfiler(std::size_t capacity = 1 << 14);
+    ~SamplingProfiler();
+
+    /**
+     * Start aggregating samples on a background thread
+     */
+    void start();
+
+    /**
+     * Aggregate anything left and stop the background thread
+     */
+    void stop();
+
+    /**
+     * Queue a sample. Call this from one thread only.
+     *
+     * @param sample sample to queue
+     */
+    void push(const ProfileSample &sample) noexcept {
+        if(!this->samples.push(sample)) {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Set the symbols to resolve samples with from now on
+     *
+     * @param symbols symbols
+     */
+    void set_symbols(std::shared_ptr<const ProfileSymbols> symbols);
+
+    /**
+     * Forget everything that was aggregated
+     */
+    void clear();
+
+    /**
+     * Get the number of samples dropped because they weren't aggregated in time
+     *
+     * @return number of dropped samples
+     */
+    std::uint64_t get_dropped() const noexcept { return this->dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * Get the number of samples aggregated
+     *
+     * @return number of samples
+     */
+    std::uint64_t get_sample_count();
+
+    /**
+     * Make a flat and hierarchical report of what was aggregated
+     *
+     * @return report
+     */
+    ProfileReport get_report();
+
+    /**
+     * Write every call stack and its sample count in the collapsed format used by flame graph tools (one "a;b;c count" per line)
+     *
+     * @param path path to write to
+     * @return     true if successful
+     */
+    bool export_collapsed_stacks(const std::filesystem::path &path);
+
+private:
+    SPSCRingBuffer<ProfileSample> samples;
+    std::atomic<std::uint64_t> dropped = 0;
+
+    // Sample counts keyed by the functions of each frame, outermost first
+    std::mutex mutex;
+    std::unordered_map<std::string, std::uint64_t> stacks;
+    std::uint64_t sample_count = 0;
+    std::shared_ptr<const ProfileSymbols> symbols;
+
+    std::condition_variable wake;
+    std::thread worker;
+    bool running = false;
+    void worker_loop();
+
+    // Resolve samples and count them (the worker reuses key for each one so it doesn't have to allocate)
+    std::string key;
+    void aggregate(const ProfileSample *samples, std::size_t count);
+
+    // Get each stack as names, outermost first
+    std::vector<std::pair<std::vector<std::string>, std::uint64_t>> get_named_stacks_without_mutex() const;
+};
+
+#endif
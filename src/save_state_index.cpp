@@ -0,0 +1,187 @@
+#include "save_state_index.hpp"
+#include "file_io.hpp"
+
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+static constexpr const char INDEX_MAGIC[4] = { 'S', 'D', 'X', 'I' };
+static constexpr const std::uint32_t INDEX_VERSION = 1;
+
+static constexpr const std::uint8_t SLOT_FLAG_PRESENT = 1 << 0;
+static constexpr const std::uint8_t SLOT_FLAG_THUMBNAIL = 1 << 1;
+
+// Game area of a frame with a Super Game Boy border
+static constexpr const std::uint32_t BORDER_WIDTH = 256, BORDER_HEIGHT = 224, SCREEN_WIDTH = 160, SCREEN_HEIGHT = 144;
+
+template<typename T> static void write_le(std::vector<std::uint8_t> &output, T value) {
+    auto v = static_cast<std::uint64_t>(value);
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        output.emplace_back(static_cast<std::uint8_t>(v >> (i * 8)));
+    }
+}
+
+template<typename T> static bool read_le(const std::vector<std::uint8_t> &input, std::size_t &position, T &value) {
+    if(input.size() - position < sizeof(T)) {
+        return false;
+    }
+    std::uint64_t v = 0;
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        v |= static_cast<std::uint64_t>(input[position++]) << (i * 8);
+    }
+    value = static_cast<T>(v);
+    return true;
+}
+
+std::filesystem::path SaveStateIndex::get_index_path(const std::filesystem::path &save_path) {
+    return std::filesystem::path(save_path).replace_extension(".sindex");
+}
+
+std::vector<std::uint32_t> SaveStateIndex::make_thumbnail(const std::uint32_t *pixels, std::uint32_t width, std::uint32_t height) {
+    std::vector<std::uint32_t> thumbnail(THUMBNAIL_WIDTH * THUMBNAIL_HEIGHT, 0xFF000000);
+    if(pixels == nullptr || width == 0 || height == 0) {
+        return thumbnail;
+    }
+
+    // Skip the border if there is one
+    std::uint32_t left = 0, top = 0, stride = width;
+    if(width == BORDER_WIDTH && height == BORDER_HEIGHT) {
+        left = (BORDER_WIDTH - SCREEN_WIDTH) / 2;
+        top = (BORDER_HEIGHT - SCREEN_HEIGHT) / 2;
+        width = SCREEN_WIDTH;
+        height = SCREEN_HEIGHT;
+    }
+
+    // Average every source pixel that falls in each thumbnail pixel
+    for(std::uint32_t ty = 0; ty < THUMBNAIL_HEIGHT; ty++) {
+        std::uint32_t y0 = ty * height / THUMBNAIL_HEIGHT;
+        std::uint32_t y1 = std::max(y0 + 1, (ty + 1) * height / THUMBNAIL_HEIGHT);
+
+        for(std::uint32_t tx = 0; tx < THUMBNAIL_WIDTH; tx++) {
+            std::uint32_t x0 = tx * width / THUMBNAIL_WIDTH;
+            std::uint32_t x1 = std::max(x0 + 1, (tx + 1) * width / THUMBNAIL_WIDTH);
+
+            std::uint32_t r = 0, g = 0, b = 0, count = 0;
+            for(std::uint32_t y = y0; y < y1; y++) {
+                auto *row = pixels + (top + y) * stride + left;
+                for(std::uint32_t x = x0; x < x1; x++) {
+                    auto p = row[x];
+                    r += (p >> 16) & 0xFF;
+                    g += (p >> 8) & 0xFF;
+                    b += p & 0xFF;
+                    count++;
+                }
+            }
+
+            thumbnail[ty * THUMBNAIL_WIDTH + tx] = 0xFF000000 | ((r / count) << 16) | ((g / count) << 8) | (b / count);
+        }
+    }
+
+    return thumbnail;
+}
+
+bool SaveStateIndex::load(const std::filesystem::path &path) {
+    this->clear();
+
+    std::vector<std::uint8_t> data;
+    if(!read_file(path, data)) {
+        return false;
+    }
+
+    std::size_t position = sizeof(INDEX_MAGIC);
+    std::uint32_t version, slot_count, thumbnail_width, thumbnail_height;
+    if(data.size() < sizeof(INDEX_MAGIC) || std::memcmp(data.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+       !read_le(data, position, version) || version != INDEX_VERSION ||
+       !read_le(data, position, slot_count) || slot_count != SLOT_COUNT ||
+       !read_le(data, position, thumbnail_width) || thumbnail_width != THUMBNAIL_WIDTH ||
+       !read_le(data, position, thumbnail_height) || thumbnail_height != THUMBNAIL_HEIGHT) {
+        return false;
+    }
+
+    for(auto &slot : this->slots) {
+        std::uint8_t flags;
+        if(!read_le(data, position, flags) || !read_le(data, position, slot.timestamp) || !read_le(data, position, slot.play_time_ms) || !read_le(data, position, slot.state_size)) {
+            this->clear();
+            return false;
+        }
+
+        slot.present = (flags & SLOT_FLAG_PRESENT) != 0;
+        if(flags & SLOT_FLAG_THUMBNAIL) {
+            slot.thumbnail.resize(THUMBNAIL_WIDTH * THUMBNAIL_HEIGHT);
+            for(auto &p : slot.thumbnail) {
+                if(!read_le(data, position, p)) {
+                    this->clear();
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void SaveStateIndex::reconcile(const std::function<std::filesystem::path (std::size_t)> &slot_path, const std::function<std::optional<std::uint64_t> (std::size_t)> &stored_size) {
+    for(std::size_t i = 0; i < SLOT_COUNT; i++) {
+        auto &slot = this->slots[i];
+        auto path = slot_path(i);
+
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if(ec) {
+            auto stored = stored_size ? stored_size(i) : std::nullopt;
+            if(!stored.has_value()) {
+                slot = Slot {};
+            }
+            else if(!slot.present || slot.state_size != *stored) {
+                slot = Slot {};
+                slot.present = true;
+                slot.state_size = *stored;
+            }
+            continue;
+        }
+
+        if(slot.present && slot.state_size == size) {
+            continue;
+        }
+
+        // Something else wrote this, so all we know is what the file system tells us
+        slot = Slot {};
+        slot.present = true;
+        slot.state_size = size;
+
+        auto modified = std::filesystem::last_write_time(path, ec);
+        if(!ec) {
+            auto system_time = std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(modified - std::filesystem::file_time_type::clock::now());
+            slot.timestamp = std::chrono::duration_cast<std::chrono::seconds>(system_time.time_since_epoch()).count();
+        }
+    }
+}
+
+std::vector<std::uint8_t> SaveStateIndex::serialize() const {
+    std::vector<std::uint8_t> output(INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+    write_le(output, INDEX_VERSION);
+    write_le(output, static_cast<std::uint32_t>(SLOT_COUNT));
+    write_le(output, THUMBNAIL_WIDTH);
+    write_le(output, THUMBNAIL_HEIGHT);
+
+    for(auto &slot : this->slots) {
+        bool has_thumbnail = slot.thumbnail.size() == THUMBNAIL_WIDTH * THUMBNAIL_HEIGHT;
+        write_le(output, static_cast<std::uint8_t>((slot.present ? SLOT_FLAG_PRESENT : 0) | (has_thumbnail ? SLOT_FLAG_THUMBNAIL : 0)));
+        write_le(output, slot.timestamp);
+        write_le(output, slot.play_time_ms);
+        write_le(output, slot.state_size);
+        if(has_thumbnail) {
+            for(auto p : slot.thumbnail) {
+                write_le(output, p);
+            }
+        }
+    }
+
+    return output;
+}
+
+void SaveStateIndex::clear() {
+    for(auto &slot : this->slots) {
+        slot = Slot {};
+    }
+}
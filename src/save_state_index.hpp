@@ -0,0 +1,107 @@
+#ifndef SAVE_STATE_INDEX_HPP
+#define SAVE_STATE_INDEX_HPP
+
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+/**
+ * Sidecar file describing each numbered save state slot of a ROM (timestamp, play time, size, and a small thumbnail) so
+ * menus can show what's in each slot without reading the save states themselves.
+ */
+class SaveStateIndex {
+public:
+    /** Number of numbered slots */
+    static constexpr const std::size_t SLOT_COUNT = 10;
+
+    /** Thumbnail dimensions */
+    static constexpr const std::uint32_t THUMBNAIL_WIDTH = 80, THUMBNAIL_HEIGHT = 72;
+
+    struct Slot {
+        /** A save state exists in this slot */
+        bool present = false;
+
+        /** Time the slot was saved in seconds since the Unix epoch */
+        std::int64_t timestamp = 0;
+
+        /** Play time when the slot was saved in milliseconds (0 if unknown) */
+        std::uint64_t play_time_ms = 0;
+
+        /** Size of the save state in bytes */
+        std::uint64_t state_size = 0;
+
+        /** THUMBNAIL_WIDTH x THUMBNAIL_HEIGHT ARGB32 pixels, or empty if no thumbnail is available */
+        std::vector<std::uint32_t> thumbnail;
+    };
+
+    /**
+     * Get the path of the index for a ROM
+     *
+     * @param save_path path to the ROM's battery save (save states are named after it, too)
+     * @return          path to the index
+     */
+    static std::filesystem::path get_index_path(const std::filesystem::path &save_path);
+
+    /**
+     * Downscale a frame into a thumbnail. If the frame has a Super Game Boy border, only the game area is used.
+     *
+     * @param pixels ARGB32 pixels
+     * @param width  width of the frame
+     * @param height height of the frame
+     * @return       thumbnail pixels
+     */
+    static std::vector<std::uint32_t> make_thumbnail(const std::uint32_t *pixels, std::uint32_t width, std::uint32_t height);
+
+    /**
+     * Read an index file. If it is missing or unreadable, every slot is cleared.
+     *
+     * @param path path to the index
+     * @return     true if read successfully
+     */
+    bool load(const std::filesystem::path &path);
+
+    /**
+     * Check the index against the save state files. Slots whose file is gone are cleared, and slots whose file does not
+     * match the recorded size (e.g. written by something else) keep only what the file system can tell us.
+     *
+     * @param slot_path   function returning the path of the save state for the slot
+     * @param stored_size optional function returning the size of the slot's save state if it is held somewhere other than
+     *                    its file (e.g. a save state pack), checked when the file is missing
+     */
+    void reconcile(const std::function<std::filesystem::path (std::size_t)> &slot_path, const std::function<std::optional<std::uint64_t> (std::size_t)> &stored_size = nullptr);
+
+    /**
+     * Get a slot
+     *
+     * @param slot slot index (must be less than SLOT_COUNT)
+     * @return     slot
+     */
+    const Slot &get_slot(std::size_t slot) const noexcept { return this->slots[slot]; }
+
+    /**
+     * Replace a slot
+     *
+     * @param slot slot index (must be less than SLOT_COUNT)
+     * @param data slot data
+     */
+    void set_slot(std::size_t slot, Slot data) { this->slots[slot] = std::move(data); }
+
+    /**
+     * Encode the index in the format read by load()
+     *
+     * @return encoded index
+     */
+    std::vector<std::uint8_t> serialize() const;
+
+    /**
+     * Clear every slot
+     */
+    void clear();
+
+private:
+    Slot slots[SLOT_COUNT];
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "save_state_ring.hpp"
+#include "delta_codec.hpp"
+
+void SaveStateRing::store(Entry &entry, const std::vector<std::uint8_t> *base, const std::vector<std::uint8_t> &state) {
+    this->memory_usage -= entry.encoded.size();
+
+    if(base != nullptr) {
+        encode_delta(base->data(), base->size(), state.data(), state.size(), this->scratch);
+    }
+    else {
+        encode_delta(nullptr, 0, state.data(), state.size(), this->scratch);
+    }
+
+    // Keep the capacity of the scratch buffer and give the entry a right-sized copy
+    entry.encoded.assign(this->scratch.begin(), this->scratch.end());
+    entry.encoded.shrink_to_fit();
+    this->memory_usage += entry.encoded.size();
+}
+
+bool SaveStateRing::get(std::size_t index, std::vector<std::uint8_t> &state) {
+    if(index >= this->entries.size()) {
+        return false;
+    }
+
+    if(index + 1 == this->entries.size() && this->last_state_valid) {
+        state.assign(this->last_state.begin(), this->last_state.end());
+        return true;
+    }
+
+    // Walk the chain from the first state
+    auto previous = this->pool.acquire();
+    auto &first = this->entries[0].encoded;
+    bool success = decode_delta(nullptr, 0, first.data(), first.size(), index == 0 ? state : previous);
+
+    for(std::size_t i = 1; i <= index && success; i++) {
+        auto &encoded = this->entries[i].encoded;
+        if(i == index) {
+            success = decode_delta(previous.data(), previous.size(), encoded.data(), encoded.size(), state);
+        }
+        else {
+            success = decode_delta(previous.data(), previous.size(), encoded.data(), encoded.size(), this->scratch);
+            previous.swap(this->scratch);
+        }
+    }
+
+    this->pool.release(std::move(previous));
+    return success;
+}
+
+void SaveStateRing::set(std::size_t index, const std::vector<std::uint8_t> &state) {
+    if(index >= this->entries.size()) {
+        return;
+    }
+
+    auto previous = this->pool.acquire();
+    auto next = this->pool.acquire();
+
+    bool has_previous = index > 0 && this->get(index - 1, previous);
+    bool has_next = index + 1 < this->entries.size() && this->get(index + 1, next);
+
+    this->store(this->entries[index], has_previous ? &previous : nullptr, state);
+
+    // The next state was relative to what we just replaced, so re-encode it
+    if(has_next) {
+        this->store(this->entries[index + 1], &state, next);
+    }
+
+    if(index + 1 == this->entries.size()) {
+        this->last_state.assign(state.begin(), state.end());
+        this->last_state_valid = true;
+    }
+
+    this->pool.release(std::move(previous));
+    this->pool.release(std::move(next));
+}
+
+void SaveStateRing::push_back(const std::vector<std::uint8_t> &state) {
+    // Make sure we know what the last state is so we can encode against it
+    if(!this->entries.empty() && !this->last_state_valid) {
+        this->last_state_valid = this->get(this->entries.size() - 1, this->last_state);
+    }
+
+    auto &entry = this->entries.emplace_back();
+    this->store(entry, this->entries.size() > 1 && this->last_state_valid ? &this->last_state : nullptr, state);
+
+    this->last_state.assign(state.begin(), state.end());
+    this->last_state_valid = true;
+}
+
+void SaveStateRing::truncate(std::size_t count) {
+    if(count >= this->entries.size()) {
+        return;
+    }
+
+    while(this->entries.size() > count) {
+        this->memory_usage -= this->entries.back().encoded.size();
+        this->entries.pop_back();
+    }
+
+    this->last_state_valid = false;
+}
+
+std::size_t SaveStateRing::trim_to_budget() {
+    std::size_t removed = 0;
+
+    while(this->memory_usage > this->byte_budget && this->entries.size() > 1) {
+        // The second state becomes the first, so it has to stand on its own now
+        auto second = this->pool.acquire();
+        if(this->get(1, second)) {
+            this->store(this->entries[1], nullptr, second);
+        }
+        this->pool.release(std::move(second));
+
+        this->memory_usage -= this->entries.front().encoded.size();
+        this->entries.pop_front();
+        removed++;
+    }
+
+    return removed;
+}
+
+void SaveStateRing::clear() {
+    this->entries.clear();
+    this->memory_usage = 0;
+    this->last_state_valid = false;
+}
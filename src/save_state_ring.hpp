@@ -0,0 +1,117 @@
+#ifndef SAVE_STATE_RING_HPP
+#define SAVE_STATE_RING_HPP
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+
+#include "buffer_pool.hpp"
+
+/**
+ * Ordered list of save states bounded by memory use rather than count.
+ *
+ * The first state is stored on its own and every other state is stored as a delta against the state before it (see
+ * delta_codec.hpp), so neighboring states that are mostly the same take up very little space.
+ */
+class SaveStateRing {
+public:
+    /**
+     * Instantiate a ring
+     *
+     * @param byte_budget maximum bytes to use for stored states (at least one state is always kept)
+     */
+    SaveStateRing(std::size_t byte_budget = 4 * 1024 * 1024) : byte_budget(byte_budget) {}
+
+    /**
+     * Get the number of stored states
+     *
+     * @return number of states
+     */
+    std::size_t size() const noexcept { return this->entries.size(); }
+
+    /**
+     * Get the number of bytes used by stored states
+     *
+     * @return bytes used
+     */
+    std::size_t get_memory_usage() const noexcept { return this->memory_usage; }
+
+    /**
+     * Get the byte budget
+     *
+     * @return byte budget
+     */
+    std::size_t get_byte_budget() const noexcept { return this->byte_budget; }
+
+    /**
+     * Set the byte budget. This does not trim anything until trim_to_budget() is called.
+     *
+     * @param byte_budget byte budget
+     */
+    void set_byte_budget(std::size_t byte_budget) noexcept { this->byte_budget = byte_budget; }
+
+    /**
+     * Get the state at the index
+     *
+     * @param index index of the state
+     * @param state where to put the state
+     * @return      true if successful
+     */
+    bool get(std::size_t index, std::vector<std::uint8_t> &state);
+
+    /**
+     * Replace the state at the index
+     *
+     * @param index index of the state
+     * @param state state to store
+     */
+    void set(std::size_t index, const std::vector<std::uint8_t> &state);
+
+    /**
+     * Add a state to the end
+     *
+     * @param state state to store
+     */
+    void push_back(const std::vector<std::uint8_t> &state);
+
+    /**
+     * Remove all states at and past the given index
+     *
+     * @param count number of states to keep
+     */
+    void truncate(std::size_t count);
+
+    /**
+     * Remove states from the front until we're within budget
+     *
+     * @return number of states removed
+     */
+    std::size_t trim_to_budget();
+
+    /**
+     * Remove all states
+     */
+    void clear();
+
+private:
+    struct Entry {
+        std::vector<std::uint8_t> encoded;
+    };
+
+    std::deque<Entry> entries;
+    std::size_t memory_usage = 0;
+    std::size_t byte_budget;
+
+    // Decoded copy of the last entry, so adding to the end doesn't have to decode the whole chain
+    std::vector<std::uint8_t> last_state;
+    bool last_state_valid = false;
+
+    // Reused between operations so we don't reallocate state-sized buffers every time
+    BufferPool pool = BufferPool(8);
+    std::vector<std::uint8_t> scratch;
+
+    // Store encoded data into an entry, updating the memory usage
+    void store(Entry &entry, const std::vector<std::uint8_t> *base, const std::vector<std::uint8_t> &state);
+};
+
+#endif
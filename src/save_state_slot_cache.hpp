@@ -0,0 +1,141 @@
+#ifndef SAVE_STATE_SLOT_CACHE_HPP
+#define SAVE_STATE_SLOT_CACHE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include <mutex>
+
+/**
+ * Thread-safe copy of the numbered save state slots kept in memory so loading a slot doesn't have to touch the disk.
+ *
+ * The cache is cleared whenever a different ROM is loaded. Each clear starts a new generation so anything still being read
+ * for the previous ROM can't end up in the cache.
+ */
+class SaveStateSlotCache {
+public:
+    struct Statistics {
+        /** Number of slots held */
+        std::size_t slots_cached;
+
+        /** Bytes held */
+        std::size_t memory_usage;
+
+        /** Loads served from memory */
+        std::uint64_t hits;
+
+        /** Loads that had to read the disk */
+        std::uint64_t misses;
+    };
+
+    /**
+     * Instantiate a cache
+     *
+     * @param slot_count number of slots
+     */
+    SaveStateSlotCache(std::size_t slot_count) : slots(slot_count) {}
+
+    /**
+     * Drop every slot and start a new generation
+     *
+     * @return new generation
+     */
+    std::uint64_t clear() {
+        this->mutex.lock();
+        for(auto &s : this->slots) {
+            s = std::nullopt;
+        }
+        this->memory_usage = 0;
+        auto generation = ++this->generation;
+        this->mutex.unlock();
+        return generation;
+    }
+
+    /**
+     * Store a slot that was just saved, replacing anything held
+     *
+     * @param slot  slot index
+     * @param state save state
+     */
+    void store(std::size_t slot, std::vector<std::uint8_t> state) {
+        this->mutex.lock();
+        this->replace(slot, std::move(state));
+        this->mutex.unlock();
+    }
+
+    /**
+     * Store a slot read from disk, unless the slot was saved since or the generation is stale
+     *
+     * @param slot       slot index
+     * @param state      save state
+     * @param generation generation returned by clear() before the read started
+     */
+    void store_if_absent(std::size_t slot, std::vector<std::uint8_t> state, std::uint64_t generation) {
+        this->mutex.lock();
+        if(generation == this->generation && slot < this->slots.size() && !this->slots[slot].has_value()) {
+            this->replace(slot, std::move(state));
+        }
+        this->mutex.unlock();
+    }
+
+    /**
+     * Copy a slot out of the cache, counting a hit or miss
+     *
+     * @param slot  slot index
+     * @param state where to put the save state
+     * @return      true if the slot was held
+     */
+    bool load(std::size_t slot, std::vector<std::uint8_t> &state) {
+        this->mutex.lock();
+        bool hit = slot < this->slots.size() && this->slots[slot].has_value();
+        if(hit) {
+            state.assign(this->slots[slot]->begin(), this->slots[slot]->end());
+            this->hits++;
+        }
+        else {
+            this->misses++;
+        }
+        this->mutex.unlock();
+        return hit;
+    }
+
+    /**
+     * Get statistics
+     *
+     * @return statistics
+     */
+    Statistics get_statistics() {
+        this->mutex.lock();
+        Statistics statistics = {};
+        for(auto &s : this->slots) {
+            statistics.slots_cached += s.has_value() ? 1 : 0;
+        }
+        statistics.memory_usage = this->memory_usage;
+        statistics.hits = this->hits;
+        statistics.misses = this->misses;
+        this->mutex.unlock();
+        return statistics;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::optional<std::vector<std::uint8_t>>> slots;
+    std::size_t memory_usage = 0;
+    std::uint64_t generation = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+
+    // Replace a slot (mutex must be held)
+    void replace(std::size_t slot, std::vector<std::uint8_t> &&state) {
+        if(slot >= this->slots.size()) {
+            return;
+        }
+        if(this->slots[slot].has_value()) {
+            this->memory_usage -= this->slots[slot]->size();
+        }
+        this->memory_usage += state.size();
+        this->slots[slot] = std::move(state);
+    }
+};
+
+#endif
@@ -0,0 +1,421 @@
+#include "save_state_store.hpp"
+#include "file_io.hpp"
+#include "hash.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
+
+#ifdef _WIN32
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#else
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
+
+static constexpr const char PACK_MAGIC[4] = { 'S', 'D', 'X', 'P' };
+static constexpr const std::uint32_t PACK_VERSION = 2; // version 1 had no modification time in state records
+static constexpr const std::uint64_t PACK_HEADER_SIZE = sizeof(PACK_MAGIC) + sizeof(PACK_VERSION);
+
+enum RecordType : std::uint8_t {
+    RECORD_CHUNK = 1,
+    RECORD_STATE = 2,
+    RECORD_REMOVE = 3
+};
+
+// Type, key, size
+static constexpr const std::uint64_t CHUNK_RECORD_HEADER_SIZE = 1 + 8 + 4;
+
+template<typename T> static void write_le(std::vector<std::uint8_t> &output, T value) {
+    auto v = static_cast<std::uint64_t>(value);
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        output.emplace_back(static_cast<std::uint8_t>(v >> (i * 8)));
+    }
+}
+
+template<typename T> static bool read_le(std::FILE *file, T &value) {
+    std::uint8_t bytes[sizeof(T)];
+    if(std::fread(bytes, sizeof(bytes), 1, file) != 1) {
+        return false;
+    }
+    std::uint64_t v = 0;
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        v |= static_cast<std::uint64_t>(bytes[i]) << (i * 8);
+    }
+    value = static_cast<T>(v);
+    return true;
+}
+
+static void write_chunk_record(std::vector<std::uint8_t> &output, std::uint64_t key, const std::uint8_t *data, std::size_t size) {
+    write_le(output, static_cast<std::uint8_t>(RECORD_CHUNK));
+    write_le(output, key);
+    write_le(output, static_cast<std::uint32_t>(size));
+    output.insert(output.end(), data, data + size);
+}
+
+static void write_state_record(std::vector<std::uint8_t> &output, const std::string &name, std::uint64_t size, std::int64_t modified, const std::vector<std::uint64_t> &chunks) {
+    write_le(output, static_cast<std::uint8_t>(RECORD_STATE));
+    write_le(output, static_cast<std::uint16_t>(name.size()));
+    output.insert(output.end(), name.begin(), name.end());
+    write_le(output, size);
+    write_le(output, modified);
+    write_le(output, static_cast<std::uint32_t>(chunks.size()));
+    for(auto c : chunks) {
+        write_le(output, c);
+    }
+}
+
+SaveStateStore::~SaveStateStore() {
+    this->close_without_mutex();
+}
+
+bool SaveStateStore::open() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->open_without_mutex();
+}
+
+bool SaveStateStore::open_without_mutex(bool upgrade) {
+    this->close_without_mutex();
+
+    // Start a new pack if there isn't one
+    std::error_code ec;
+    if(!std::filesystem::exists(this->path, ec)) {
+        std::vector<std::uint8_t> header(PACK_MAGIC, PACK_MAGIC + sizeof(PACK_MAGIC));
+        write_le(header, PACK_VERSION);
+        if(!write_file_atomically(this->path, header.data(), header.size())) {
+            return false;
+        }
+    }
+
+    this->file = std::fopen(this->path.string().c_str(), "r+b");
+    if(this->file == nullptr) {
+        std::fprintf(stderr, "Failed to open %s\n", this->path.string().c_str());
+        return false;
+    }
+
+    std::uint32_t version;
+    if(!this->scan_without_mutex(version)) {
+        this->close_without_mutex();
+        return false;
+    }
+
+    // Rewrite older packs so everything appended from now on matches the header
+    if(version != PACK_VERSION) {
+        if(upgrade) {
+            return this->compact_without_mutex();
+        }
+        this->close_without_mutex();
+        return false;
+    }
+
+    return true;
+}
+
+void SaveStateStore::close_without_mutex() noexcept {
+    if(this->file != nullptr) {
+        std::fclose(this->file);
+        this->file = nullptr;
+    }
+    this->chunks.clear();
+    this->states.clear();
+    this->pack_size = 0;
+}
+
+bool SaveStateStore::scan_without_mutex(std::uint32_t &version) {
+    // Chunk records are skipped with a seek, which happily goes past the end, so check them against the size
+    fseek64(this->file, 0, SEEK_END);
+    auto file_size = static_cast<std::uint64_t>(ftell64(this->file));
+    fseek64(this->file, 0, SEEK_SET);
+
+    char magic[sizeof(PACK_MAGIC)];
+    if(std::fread(magic, sizeof(magic), 1, this->file) != 1 || std::memcmp(magic, PACK_MAGIC, sizeof(magic)) != 0 || !read_le(this->file, version) || version < 1 || version > PACK_VERSION) {
+        std::fprintf(stderr, "%s is not a save state pack\n", this->path.string().c_str());
+        return false;
+    }
+
+    // Read records until we run out; anything after the last complete record was torn and gets dropped
+    std::uint64_t good_end = PACK_HEADER_SIZE;
+    while(true) {
+        std::uint8_t type;
+        if(!read_le(this->file, type)) {
+            break;
+        }
+
+        if(type == RECORD_CHUNK) {
+            std::uint64_t key;
+            std::uint32_t size;
+            if(!read_le(this->file, key) || !read_le(this->file, size)) {
+                break;
+            }
+            auto offset = good_end + CHUNK_RECORD_HEADER_SIZE;
+            if(offset + size > file_size || fseek64(this->file, size, SEEK_CUR) != 0) {
+                break;
+            }
+            this->chunks.emplace(key, ChunkLocation { offset, size });
+        }
+        else if(type == RECORD_STATE || type == RECORD_REMOVE) {
+            std::uint16_t name_length;
+            if(!read_le(this->file, name_length)) {
+                break;
+            }
+            std::string name(name_length, '\0');
+            if(name_length > 0 && std::fread(name.data(), name_length, 1, this->file) != 1) {
+                break;
+            }
+
+            if(type == RECORD_REMOVE) {
+                this->states.erase(name);
+            }
+            else {
+                State state;
+                std::uint32_t chunk_count;
+                state.modified = 0;
+                if(!read_le(this->file, state.size) || (version >= 2 && !read_le(this->file, state.modified)) || !read_le(this->file, chunk_count)) {
+                    break;
+                }
+                state.chunks.resize(chunk_count);
+                bool complete = true;
+                for(auto &c : state.chunks) {
+                    if(!read_le(this->file, c) || this->chunks.find(c) == this->chunks.end()) {
+                        complete = false;
+                        break;
+                    }
+                }
+                if(!complete) {
+                    break;
+                }
+                state.record_size = static_cast<std::uint64_t>(ftell64(this->file)) - good_end;
+                this->states[name] = std::move(state);
+            }
+        }
+        else {
+            break;
+        }
+
+        good_end = static_cast<std::uint64_t>(ftell64(this->file));
+    }
+
+    if(file_size > good_end) {
+        std::fprintf(stderr, "Discarding %llu byte(s) of incomplete data at the end of %s\n", static_cast<unsigned long long>(file_size - good_end), this->path.string().c_str());
+        std::fclose(this->file);
+        this->file = nullptr;
+
+        std::error_code ec;
+        std::filesystem::resize_file(this->path, good_end, ec);
+        this->file = std::fopen(this->path.string().c_str(), "r+b");
+        if(ec || this->file == nullptr) {
+            return false;
+        }
+    }
+
+    this->pack_size = good_end;
+    return true;
+}
+
+bool SaveStateStore::read_chunk_without_mutex(const ChunkLocation &location, std::uint8_t *output) {
+    return fseek64(this->file, location.offset, SEEK_SET) == 0 && std::fread(output, location.size, 1, this->file) == 1;
+}
+
+bool SaveStateStore::append_without_mutex(const std::vector<std::uint8_t> &record) {
+    // Wait for it to reach the disk, since the caller deletes the loose copy of the state once this returns
+    if(fseek64(this->file, this->pack_size, SEEK_SET) != 0 || std::fwrite(record.data(), record.size(), 1, this->file) != 1 || !flush_to_disk(this->file)) {
+        std::fprintf(stderr, "Failed to write to %s\n", this->path.string().c_str());
+        return false;
+    }
+    this->pack_size += record.size();
+    return true;
+}
+
+bool SaveStateStore::put(const std::string &name, const std::uint8_t *data, std::size_t size) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if(this->file == nullptr || name.size() > UINT16_MAX) {
+        return false;
+    }
+
+    // New chunks go in one record batch followed by the state so a torn write never leaves a state pointing at nothing
+    std::vector<std::uint8_t> record;
+    std::vector<std::uint64_t> state_chunks;
+    std::unordered_map<std::uint64_t, std::pair<std::uint64_t, std::size_t>> new_chunks; // key -> (offset in record, size)
+    std::vector<std::uint8_t> existing(CHUNK_SIZE);
+
+    for(std::size_t offset = 0; offset < size; offset += CHUNK_SIZE) {
+        auto *chunk = data + offset;
+        auto chunk_size = std::min(CHUNK_SIZE, size - offset);
+
+        // Find the chunk by its hash. On the off chance two different chunks have the same hash, move on to the next key.
+        auto key = fnv1a_64(chunk, chunk_size);
+        while(true) {
+            auto pending = new_chunks.find(key);
+            if(pending != new_chunks.end()) {
+                if(pending->second.second == chunk_size && std::memcmp(record.data() + pending->second.first, chunk, chunk_size) == 0) {
+                    break;
+                }
+                key++;
+                continue;
+            }
+
+            auto stored = this->chunks.find(key);
+            if(stored != this->chunks.end()) {
+                if(stored->second.size == chunk_size && this->read_chunk_without_mutex(stored->second, existing.data()) && std::memcmp(existing.data(), chunk, chunk_size) == 0) {
+                    break;
+                }
+                key++;
+                continue;
+            }
+
+            write_chunk_record(record, key, chunk, chunk_size);
+            new_chunks.emplace(key, std::make_pair(record.size() - chunk_size, chunk_size));
+            break;
+        }
+
+        state_chunks.emplace_back(key);
+    }
+
+    auto modified = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    auto state_record_start = record.size();
+    write_state_record(record, name, size, modified, state_chunks);
+
+    auto base = this->pack_size;
+    if(!this->append_without_mutex(record)) {
+        return false;
+    }
+
+    for(auto &c : new_chunks) {
+        this->chunks.emplace(c.first, ChunkLocation { base + c.second.first, static_cast<std::uint32_t>(c.second.second) });
+    }
+    this->states[name] = State { size, modified, record.size() - state_record_start, std::move(state_chunks) };
+    return true;
+}
+
+bool SaveStateStore::get(const std::string &name, std::vector<std::uint8_t> &data) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    auto state = this->states.find(name);
+    if(this->file == nullptr || state == this->states.end()) {
+        return false;
+    }
+
+    data.resize(state->second.size);
+    std::uint64_t offset = 0;
+    for(auto key : state->second.chunks) {
+        auto location = this->chunks.find(key);
+        if(location == this->chunks.end()) {
+            std::fprintf(stderr, "%s is corrupt: state %s uses a missing chunk\n", this->path.string().c_str(), name.c_str());
+            return false;
+        }
+        if(offset + location->second.size > data.size() || !this->read_chunk_without_mutex(location->second, data.data() + offset)) {
+            return false;
+        }
+        offset += location->second.size;
+    }
+
+    return offset == data.size();
+}
+
+std::optional<std::uint64_t> SaveStateStore::get_size(const std::string &name) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    auto state = this->states.find(name);
+    if(state == this->states.end()) {
+        return std::nullopt;
+    }
+    return state->second.size;
+}
+
+std::optional<std::chrono::system_clock::time_point> SaveStateStore::get_modified(const std::string &name) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    auto state = this->states.find(name);
+    if(state == this->states.end()) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(state->second.modified)));
+}
+
+bool SaveStateStore::remove(const std::string &name) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if(this->file == nullptr || name.size() > UINT16_MAX) {
+        return false;
+    }
+    if(this->states.find(name) == this->states.end()) {
+        return true;
+    }
+
+    std::vector<std::uint8_t> record;
+    write_le(record, static_cast<std::uint8_t>(RECORD_REMOVE));
+    write_le(record, static_cast<std::uint16_t>(name.size()));
+    record.insert(record.end(), name.begin(), name.end());
+    if(!this->append_without_mutex(record)) {
+        return false;
+    }
+
+    this->states.erase(name);
+    return true;
+}
+
+bool SaveStateStore::compact() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->compact_without_mutex();
+}
+
+bool SaveStateStore::compact_without_mutex() {
+    if(this->file == nullptr) {
+        return false;
+    }
+
+    std::vector<std::uint8_t> pack(PACK_MAGIC, PACK_MAGIC + sizeof(PACK_MAGIC));
+    write_le(pack, PACK_VERSION);
+
+    // Copy each chunk still in use once, then every state
+    std::unordered_set<std::uint64_t> written;
+    std::vector<std::uint8_t> chunk(CHUNK_SIZE);
+    for(auto &state : this->states) {
+        for(auto key : state.second.chunks) {
+            if(!written.insert(key).second) {
+                continue;
+            }
+            auto location = this->chunks.find(key);
+            if(location == this->chunks.end()) {
+                std::fprintf(stderr, "%s is corrupt: state %s uses a missing chunk\n", this->path.string().c_str(), state.first.c_str());
+                return false;
+            }
+            if(!this->read_chunk_without_mutex(location->second, chunk.data())) {
+                return false;
+            }
+            write_chunk_record(pack, key, chunk.data(), location->second.size);
+        }
+    }
+    for(auto &state : this->states) {
+        write_state_record(pack, state.first, state.second.size, state.second.modified, state.second.chunks);
+    }
+
+    // Close it first since some systems don't let you replace a file that's open
+    std::fclose(this->file);
+    this->file = nullptr;
+    bool written_ok = write_file_atomically(this->path, pack.data(), pack.size());
+    return this->open_without_mutex(false) && written_ok;
+}
+
+SaveStateStore::Statistics SaveStateStore::get_statistics() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    Statistics statistics = {};
+    statistics.states = this->states.size();
+    statistics.pack_bytes = this->pack_size;
+
+    std::unordered_set<std::uint64_t> used;
+    std::uint64_t live_bytes = this->pack_size > 0 ? PACK_HEADER_SIZE : 0;
+    for(auto &state : this->states) {
+        statistics.logical_bytes += state.second.size;
+        live_bytes += state.second.record_size;
+        for(auto key : state.second.chunks) {
+            // A missing chunk means the state can't be loaded anyway (get() reports it), so it just doesn't count here
+            auto location = this->chunks.find(key);
+            if(location != this->chunks.end() && used.insert(key).second) {
+                statistics.chunk_bytes += location->second.size;
+                live_bytes += CHUNK_RECORD_HEADER_SIZE + location->second.size;
+            }
+        }
+    }
+    statistics.chunks = used.size();
+    statistics.reclaimable_bytes = this->pack_size > live_bytes ? this->pack_size - live_bytes : 0;
+    return statistics;
+}
@@ -0,0 +1,157 @@
+#ifndef SAVE_STATE_STORE_HPP
+#define SAVE_STATE_STORE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <filesystem>
+
+/**
+ * Content-addressed pack of save states.
+ *
+ * Each state is split into fixed-size chunks, and each distinct chunk is stored only once per pack, so states that share
+ * most of their memory (as states of the same game almost always do) take up little more than the parts that differ.
+ *
+ * The pack is an append-only log: adding a state appends any new chunks followed by a record listing the state's chunks,
+ * and replacing or removing a state leaves its old records behind until compact() rewrites the pack. Each append is flushed
+ * to disk before it is considered written. If the last record was torn anyway (e.g. by a crash), it is discarded the next
+ * time the pack is opened.
+ *
+ * All functions are thread-safe.
+ */
+class SaveStateStore {
+public:
+    /** Size of each chunk in bytes */
+    static constexpr const std::size_t CHUNK_SIZE = 4096;
+
+    struct Statistics {
+        /** Number of states stored */
+        std::size_t states;
+
+        /** Number of distinct chunks used by stored states */
+        std::size_t chunks;
+
+        /** Total size of every stored state if they were stored separately */
+        std::uint64_t logical_bytes;
+
+        /** Total size of the distinct chunks used by stored states */
+        std::uint64_t chunk_bytes;
+
+        /** Size of the pack file */
+        std::uint64_t pack_bytes;
+
+        /** Bytes compact() would free */
+        std::uint64_t reclaimable_bytes;
+    };
+
+    /**
+     * Instantiate a store. Nothing is read until open() is called.
+     *
+     * @param path path to the pack file
+     */
+    SaveStateStore(const std::filesystem::path &path) : path(path) {}
+    ~SaveStateStore();
+
+    SaveStateStore(const SaveStateStore &) = delete;
+    SaveStateStore &operator=(const SaveStateStore &) = delete;
+
+    /**
+     * Open the pack, creating it if it does not exist
+     *
+     * @return true if successful
+     */
+    bool open();
+
+    /**
+     * Add a state, replacing any state with the same name
+     *
+     * @param name name of the state
+     * @param data state data
+     * @param size size of the state data
+     * @return     true if successful
+     */
+    bool put(const std::string &name, const std::uint8_t *data, std::size_t size);
+
+    /**
+     * Rebuild a state
+     *
+     * @param name name of the state
+     * @param data where to put the state data
+     * @return     true if successful
+     */
+    bool get(const std::string &name, std::vector<std::uint8_t> &data);
+
+    /**
+     * Get the size of a state without rebuilding it
+     *
+     * @param name name of the state
+     * @return     size, or nothing if the state does not exist
+     */
+    std::optional<std::uint64_t> get_size(const std::string &name);
+
+    /**
+     * Get when a state was added
+     *
+     * @param name name of the state
+     * @return     time it was added (the epoch if the pack is too old to know), or nothing if the state does not exist
+     */
+    std::optional<std::chrono::system_clock::time_point> get_modified(const std::string &name);
+
+    /**
+     * Remove a state
+     *
+     * @param name name of the state
+     * @return     true if successful (including if the state did not exist)
+     */
+    bool remove(const std::string &name);
+
+    /**
+     * Rewrite the pack with only the chunks still in use
+     *
+     * @return true if successful
+     */
+    bool compact();
+
+    /**
+     * Get statistics
+     *
+     * @return statistics
+     */
+    Statistics get_statistics();
+
+private:
+    struct ChunkLocation {
+        std::uint64_t offset;
+        std::uint32_t size;
+    };
+
+    struct State {
+        std::uint64_t size;
+        std::int64_t modified; // milliseconds since the Unix epoch
+        std::uint64_t record_size;
+        std::vector<std::uint64_t> chunks;
+    };
+
+    std::filesystem::path path;
+    std::FILE *file = nullptr;
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, ChunkLocation> chunks;
+    std::map<std::string, State> states;
+    std::uint64_t pack_size = 0;
+
+    // Everything below requires the mutex to be held
+    bool open_without_mutex(bool upgrade = true);
+    void close_without_mutex() noexcept;
+    bool scan_without_mutex(std::uint32_t &version);
+    bool read_chunk_without_mutex(const ChunkLocation &location, std::uint8_t *output);
+    bool append_without_mutex(const std::vector<std::uint8_t> &record);
+    bool compact_without_mutex();
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "save_state_validator.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+// Offsets into the ROM header passed in SaveStateExpectations (which starts at 0x100)
+static constexpr const std::size_t ROM_TITLE_OFFSET = 0x134 - 0x100;
+static constexpr const std::size_t ROM_GLOBAL_CHECKSUM_OFFSET = 0x14E - 0x100;
+static constexpr const std::size_t ROM_HEADER_SIZE = 0x150 - 0x100;
+
+static std::uint32_t read_u32_le(const std::uint8_t *data) {
+    return static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8) | (static_cast<std::uint32_t>(data[2]) << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+// Walk the BESS blocks; see https://github.com/LIJI32/SameBoy/blob/master/BESS.md
+static bool read_bess_blocks(const std::uint8_t *data, std::size_t size, SaveStateInfo &info) {
+    // The footer is the offset to the first block followed by "BESS"
+    if(size < 8 || std::memcmp(data + size - 4, "BESS", 4) != 0) {
+        return false;
+    }
+
+    auto end = size - 8;
+    std::size_t position = read_u32_le(data + size - 8);
+    while(position <= end && end - position >= 8) {
+        auto *id = data + position;
+        auto length = read_u32_le(data + position + 4);
+        position += 8;
+        if(length > end - position) {
+            return false;
+        }
+
+        auto *block = data + position;
+        if(std::memcmp(id, "END ", 4) == 0) {
+            return true;
+        }
+        else if(std::memcmp(id, "NAME", 4) == 0) {
+            info.emulator.assign(reinterpret_cast<const char *>(block), length);
+        }
+        else if(std::memcmp(id, "INFO", 4) == 0 && length >= sizeof(info.rom_title) + sizeof(info.rom_global_checksum)) {
+            std::memcpy(info.rom_title, block, sizeof(info.rom_title));
+            std::memcpy(info.rom_global_checksum, block + sizeof(info.rom_title), sizeof(info.rom_global_checksum));
+            info.has_rom_info = true;
+        }
+        else if(std::memcmp(id, "CORE", 4) == 0 && length >= 8) {
+            // Major and minor version, then the model
+            info.model.assign(reinterpret_cast<const char *>(block + 4), 4);
+        }
+
+        position += length;
+    }
+
+    // Ran off the end without an END block
+    return false;
+}
+
+bool read_save_state_info(const std::uint8_t *data, std::size_t size, const std::vector<std::uint8_t> &native_header, SaveStateInfo &info) {
+    info = SaveStateInfo {};
+    if(data == nullptr) {
+        return false;
+    }
+
+    info.native = native_header.size() == SAVE_STATE_NATIVE_HEADER_SIZE && size >= SAVE_STATE_NATIVE_HEADER_SIZE && std::memcmp(data, native_header.data(), SAVE_STATE_NATIVE_HEADER_SIZE) == 0;
+
+    // Don't trust anything from a BESS footer that doesn't parse
+    SaveStateInfo bess_info = info;
+    if(read_bess_blocks(data, size, bess_info)) {
+        info = std::move(bess_info);
+        info.bess = true;
+    }
+
+    return info.native || info.bess;
+}
+
+SaveStateCheck check_save_state(const SaveStateInfo &info, const SaveStateExpectations &expected) {
+    if(!info.native && !info.bess) {
+        return SAVE_STATE_UNRECOGNIZED;
+    }
+    if(!info.has_rom_info || expected.rom_header.size() < ROM_HEADER_SIZE) {
+        return SAVE_STATE_UNKNOWN_ROM;
+    }
+
+    auto *rom_header = expected.rom_header.data();
+    if(std::memcmp(info.rom_title, rom_header + ROM_TITLE_OFFSET, sizeof(info.rom_title)) != 0 ||
+       std::memcmp(info.rom_global_checksum, rom_header + ROM_GLOBAL_CHECKSUM_OFFSET, sizeof(info.rom_global_checksum)) != 0) {
+        return SAVE_STATE_WRONG_ROM;
+    }
+
+    if(!info.model.empty() && info.model[0] != expected.model_family) {
+        return SAVE_STATE_WRONG_MODEL;
+    }
+
+    return SAVE_STATE_MATCHES;
+}
+
+const char *describe_save_state_check(SaveStateCheck check) noexcept {
+    switch(check) {
+        case SAVE_STATE_MATCHES:
+            return "matches";
+        case SAVE_STATE_UNREADABLE:
+            return "could not be read";
+        case SAVE_STATE_UNRECOGNIZED:
+            return "not a save state";
+        case SAVE_STATE_WRONG_ROM:
+            return "made for a different ROM";
+        case SAVE_STATE_UNKNOWN_ROM:
+            return "does not say which ROM it is for";
+        case SAVE_STATE_WRONG_MODEL:
+            return "made on a different model";
+    }
+    return "unknown";
+}
+
+std::vector<SaveStateValidation> validate_save_states(const std::vector<std::filesystem::path> &paths, const SaveStateExpectations &expected, std::size_t thread_count) {
+    std::vector<SaveStateValidation> results(paths.size());
+
+    if(thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    thread_count = std::min(thread_count, paths.size());
+
+    // Each thread takes the next unchecked file until there are none left
+    std::atomic<std::size_t> next = 0;
+    auto worker = [&paths, &expected, &results, &next]() {
+        for(auto i = next++; i < paths.size(); i = next++) {
+            auto &result = results[i];
+            result.path = paths[i];
+
+            MappedFile file(paths[i]);
+            if(!file.is_open()) {
+                result.check = SAVE_STATE_UNREADABLE;
+                continue;
+            }
+
+            read_save_state_info(file.data(), file.size(), expected.native_header, result.info);
+            result.check = check_save_state(result.info, expected);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(std::size_t t = 1; t < thread_count; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto &t : threads) {
+        t.join();
+    }
+
+    return results;
+}
@@ -0,0 +1,122 @@
+#ifndef SAVE_STATE_VALIDATOR_HPP
+#define SAVE_STATE_VALIDATOR_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+/** Number of bytes at the start of a native save state that identify the format (magic and version) */
+static constexpr const std::size_t SAVE_STATE_NATIVE_HEADER_SIZE = 8;
+
+/**
+ * What a save state says about itself, read from its headers without loading it
+ */
+struct SaveStateInfo {
+    /** Starts with the same header as this build's own save states */
+    bool native = false;
+
+    /** Has a BESS footer (written by SameBoy as well as other emulators) */
+    bool bess = false;
+
+    /** Emulator that wrote it, if it says (BESS NAME block) */
+    std::string emulator;
+
+    /** BESS model ID (e.g. "CC  "), if present */
+    std::string model;
+
+    /** Whether the ROM title and global checksum are known (BESS INFO block) */
+    bool has_rom_info = false;
+
+    /** ROM title (0x134-0x143 of the ROM) */
+    std::uint8_t rom_title[16] = {};
+
+    /** ROM global checksum (0x14E-0x14F of the ROM) */
+    std::uint8_t rom_global_checksum[2] = {};
+};
+
+/**
+ * What the loaded ROM and model look like, to check save states against
+ */
+struct SaveStateExpectations {
+    /** First SAVE_STATE_NATIVE_HEADER_SIZE bytes of a save state made by this build */
+    std::vector<std::uint8_t> native_header;
+
+    /** 0x100-0x14F of the loaded ROM */
+    std::vector<std::uint8_t> rom_header;
+
+    /** First letter of the BESS model ID of the model being used ('G', 'S', 'C', or 'A') */
+    char model_family;
+};
+
+enum SaveStateCheck {
+    /** Made for the loaded ROM and model */
+    SAVE_STATE_MATCHES,
+
+    /** Could not be opened */
+    SAVE_STATE_UNREADABLE,
+
+    /** Neither a native save state nor BESS */
+    SAVE_STATE_UNRECOGNIZED,
+
+    /** Made for a different ROM */
+    SAVE_STATE_WRONG_ROM,
+
+    /** Does not say which ROM it was made for */
+    SAVE_STATE_UNKNOWN_ROM,
+
+    /** Made for the loaded ROM, but on a different model (loading it switches models) */
+    SAVE_STATE_WRONG_MODEL
+};
+
+/**
+ * Read the headers of a save state
+ *
+ * @param data          save state
+ * @param size          size of the save state
+ * @param native_header first SAVE_STATE_NATIVE_HEADER_SIZE bytes of a save state made by this build
+ * @param info          where to put what was found
+ * @return              true if it is a native or BESS save state
+ */
+bool read_save_state_info(const std::uint8_t *data, std::size_t size, const std::vector<std::uint8_t> &native_header, SaveStateInfo &info);
+
+/**
+ * Check save state headers against the loaded ROM and model
+ *
+ * @param info     headers read with read_save_state_info()
+ * @param expected loaded ROM and model
+ * @return         result
+ */
+SaveStateCheck check_save_state(const SaveStateInfo &info, const SaveStateExpectations &expected);
+
+/**
+ * Describe a check result
+ *
+ * @param check result
+ * @return      description
+ */
+const char *describe_save_state_check(SaveStateCheck check) noexcept;
+
+struct SaveStateValidation {
+    /** Path to the save state */
+    std::filesystem::path path;
+
+    /** Result */
+    SaveStateCheck check;
+
+    /** Headers that were read */
+    SaveStateInfo info;
+};
+
+/**
+ * Map and check a batch of save states, spreading the files across threads
+ *
+ * @param paths        paths to check
+ * @param expected     loaded ROM and model
+ * @param thread_count number of threads (0 = one per hardware thread)
+ * @return             results in the same order as the paths
+ */
+std::vector<SaveStateValidation> validate_save_states(const std::vector<std::filesystem::path> &paths, const SaveStateExpectations &expected, std::size_t thread_count = 0);
+
+#endif
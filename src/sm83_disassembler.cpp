@@ -0,0 +1,429 @@
+#include "sm83_disassembler.hpp"
+
+namespace {
+    struct OpcodeInfo {
+        const char *mnemonic;
+
+        // Operand template; {b} = byte, {w} = word, {r} = relative target, {h} = $FFxx, {s} = signed byte, {t} = RST target,
+        // {o} = the opcode itself
+        const char *operands;
+
+        std::uint8_t length;
+        SM83FlowType flow;
+        SM83Condition condition;
+    };
+
+    const OpcodeInfo OPCODES[256] = {
+        { "NOP", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 00
+        { "LD", "BC, {w}", 3, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 01
+        { "LD", "[BC], A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 02
+        { "INC", "BC", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 03
+        { "INC", "B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 04
+        { "DEC", "B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 05
+        { "LD", "B, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 06
+        { "RLCA", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 07
+        { "LD", "[{w}], SP", 3, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 08
+        { "ADD", "HL, BC", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 09
+        { "LD", "A, [BC]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 0A
+        { "DEC", "BC", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 0B
+        { "INC", "C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 0C
+        { "DEC", "C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 0D
+        { "LD", "C, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 0E
+        { "RRCA", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 0F
+        { "STOP", "", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 10
+        { "LD", "DE, {w}", 3, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 11
+        { "LD", "[DE], A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 12
+        { "INC", "DE", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 13
+        { "INC", "D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 14
+        { "DEC", "D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 15
+        { "LD", "D, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 16
+        { "RLA", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 17
+        { "JR", "{r}", 2, SM83_FLOW_JUMP, SM83_CONDITION_NONE }, // 18
+        { "ADD", "HL, DE", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 19
+        { "LD", "A, [DE]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 1A
+        { "DEC", "DE", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 1B
+        { "INC", "E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 1C
+        { "DEC", "E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 1D
+        { "LD", "E, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 1E
+        { "RRA", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 1F
+        { "JR", "NZ, {r}", 2, SM83_FLOW_JUMP, SM83_CONDITION_NZ }, // 20
+        { "LD", "HL, {w}", 3, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 21
+        { "LD", "[HL+], A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 22
+        { "INC", "HL", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 23
+        { "INC", "H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 24
+        { "DEC", "H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 25
+        { "LD", "H, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 26
+        { "DAA", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 27
+        { "JR", "Z, {r}", 2, SM83_FLOW_JUMP, SM83_CONDITION_Z }, // 28
+        { "ADD", "HL, HL", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 29
+        { "LD", "A, [HL+]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 2A
+        { "DEC", "HL", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 2B
+        { "INC", "L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 2C
+        { "DEC", "L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 2D
+        { "LD", "L, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 2E
+        { "CPL", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 2F
+        { "JR", "NC, {r}", 2, SM83_FLOW_JUMP, SM83_CONDITION_NC }, // 30
+        { "LD", "SP, {w}", 3, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 31
+        { "LD", "[HL-], A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 32
+        { "INC", "SP", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 33
+        { "INC", "[HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 34
+        { "DEC", "[HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 35
+        { "LD", "[HL], {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 36
+        { "SCF", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 37
+        { "JR", "C, {r}", 2, SM83_FLOW_JUMP, SM83_CONDITION_C }, // 38
+        { "ADD", "HL, SP", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 39
+        { "LD", "A, [HL-]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 3A
+        { "DEC", "SP", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 3B
+        { "INC", "A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 3C
+        { "DEC", "A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 3D
+        { "LD", "A, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 3E
+        { "CCF", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 3F
+        { "LD", "B, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 40
+        { "LD", "B, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 41
+        { "LD", "B, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 42
+        { "LD", "B, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 43
+        { "LD", "B, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 44
+        { "LD", "B, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 45
+        { "LD", "B, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 46
+        { "LD", "B, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 47
+        { "LD", "C, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 48
+        { "LD", "C, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 49
+        { "LD", "C, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 4A
+        { "LD", "C, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 4B
+        { "LD", "C, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 4C
+        { "LD", "C, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 4D
+        { "LD", "C, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 4E
+        { "LD", "C, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 4F
+        { "LD", "D, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 50
+        { "LD", "D, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 51
+        { "LD", "D, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 52
+        { "LD", "D, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 53
+        { "LD", "D, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 54
+        { "LD", "D, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 55
+        { "LD", "D, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 56
+        { "LD", "D, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 57
+        { "LD", "E, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 58
+        { "LD", "E, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 59
+        { "LD", "E, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 5A
+        { "LD", "E, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 5B
+        { "LD", "E, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 5C
+        { "LD", "E, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 5D
+        { "LD", "E, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 5E
+        { "LD", "E, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 5F
+        { "LD", "H, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 60
+        { "LD", "H, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 61
+        { "LD", "H, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 62
+        { "LD", "H, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 63
+        { "LD", "H, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 64
+        { "LD", "H, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 65
+        { "LD", "H, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 66
+        { "LD", "H, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 67
+        { "LD", "L, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 68
+        { "LD", "L, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 69
+        { "LD", "L, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 6A
+        { "LD", "L, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 6B
+        { "LD", "L, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 6C
+        { "LD", "L, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 6D
+        { "LD", "L, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 6E
+        { "LD", "L, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 6F
+        { "LD", "[HL], B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 70
+        { "LD", "[HL], C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 71
+        { "LD", "[HL], D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 72
+        { "LD", "[HL], E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 73
+        { "LD", "[HL], H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 74
+        { "LD", "[HL], L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 75
+        { "HALT", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 76
+        { "LD", "[HL], A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 77
+        { "LD", "A, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 78
+        { "LD", "A, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 79
+        { "LD", "A, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 7A
+        { "LD", "A, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 7B
+        { "LD", "A, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 7C
+        { "LD", "A, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 7D
+        { "LD", "A, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 7E
+        { "LD", "A, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 7F
+        { "ADD", "A, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 80
+        { "ADD", "A, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 81
+        { "ADD", "A, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 82
+        { "ADD", "A, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 83
+        { "ADD", "A, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 84
+        { "ADD", "A, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 85
+        { "ADD", "A, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 86
+        { "ADD", "A, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 87
+        { "ADC", "A, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 88
+        { "ADC", "A, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 89
+        { "ADC", "A, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 8A
+        { "ADC", "A, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 8B
+        { "ADC", "A, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 8C
+        { "ADC", "A, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 8D
+        { "ADC", "A, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 8E
+        { "ADC", "A, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 8F
+        { "SUB", "B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 90
+        { "SUB", "C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 91
+        { "SUB", "D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 92
+        { "SUB", "E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 93
+        { "SUB", "H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 94
+        { "SUB", "L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 95
+        { "SUB", "[HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 96
+        { "SUB", "A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 97
+        { "SBC", "A, B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 98
+        { "SBC", "A, C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 99
+        { "SBC", "A, D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 9A
+        { "SBC", "A, E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 9B
+        { "SBC", "A, H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 9C
+        { "SBC", "A, L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 9D
+        { "SBC", "A, [HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 9E
+        { "SBC", "A, A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // 9F
+        { "AND", "B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A0
+        { "AND", "C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A1
+        { "AND", "D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A2
+        { "AND", "E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A3
+        { "AND", "H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A4
+        { "AND", "L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A5
+        { "AND", "[HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A6
+        { "AND", "A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A7
+        { "XOR", "B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A8
+        { "XOR", "C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // A9
+        { "XOR", "D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // AA
+        { "XOR", "E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // AB
+        { "XOR", "H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // AC
+        { "XOR", "L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // AD
+        { "XOR", "[HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // AE
+        { "XOR", "A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // AF
+        { "OR", "B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B0
+        { "OR", "C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B1
+        { "OR", "D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B2
+        { "OR", "E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B3
+        { "OR", "H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B4
+        { "OR", "L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B5
+        { "OR", "[HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B6
+        { "OR", "A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B7
+        { "CP", "B", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B8
+        { "CP", "C", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // B9
+        { "CP", "D", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // BA
+        { "CP", "E", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // BB
+        { "CP", "H", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // BC
+        { "CP", "L", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // BD
+        { "CP", "[HL]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // BE
+        { "CP", "A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // BF
+        { "RET", "NZ", 1, SM83_FLOW_RETURN, SM83_CONDITION_NZ }, // C0
+        { "POP", "BC", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // C1
+        { "JP", "NZ, {w}", 3, SM83_FLOW_JUMP, SM83_CONDITION_NZ }, // C2
+        { "JP", "{w}", 3, SM83_FLOW_JUMP, SM83_CONDITION_NONE }, // C3
+        { "CALL", "NZ, {w}", 3, SM83_FLOW_CALL, SM83_CONDITION_NZ }, // C4
+        { "PUSH", "BC", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // C5
+        { "ADD", "A, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // C6
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // C7
+        { "RET", "Z", 1, SM83_FLOW_RETURN, SM83_CONDITION_Z }, // C8
+        { "RET", "", 1, SM83_FLOW_RETURN, SM83_CONDITION_NONE }, // C9
+        { "JP", "Z, {w}", 3, SM83_FLOW_JUMP, SM83_CONDITION_Z }, // CA
+        { "PREFIX", "", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // CB
+        { "CALL", "Z, {w}", 3, SM83_FLOW_CALL, SM83_CONDITION_Z }, // CC
+        { "CALL", "{w}", 3, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // CD
+        { "ADC", "A, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // CE
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // CF
+        { "RET", "NC", 1, SM83_FLOW_RETURN, SM83_CONDITION_NC }, // D0
+        { "POP", "DE", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // D1
+        { "JP", "NC, {w}", 3, SM83_FLOW_JUMP, SM83_CONDITION_NC }, // D2
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // D3
+        { "CALL", "NC, {w}", 3, SM83_FLOW_CALL, SM83_CONDITION_NC }, // D4
+        { "PUSH", "DE", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // D5
+        { "SUB", "{b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // D6
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // D7
+        { "RET", "C", 1, SM83_FLOW_RETURN, SM83_CONDITION_C }, // D8
+        { "RETI", "", 1, SM83_FLOW_RETURN, SM83_CONDITION_NONE }, // D9
+        { "JP", "C, {w}", 3, SM83_FLOW_JUMP, SM83_CONDITION_C }, // DA
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // DB
+        { "CALL", "C, {w}", 3, SM83_FLOW_CALL, SM83_CONDITION_C }, // DC
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // DD
+        { "SBC", "A, {b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // DE
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // DF
+        { "LDH", "[{h}], A", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E0
+        { "POP", "HL", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E1
+        { "LDH", "[C], A", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E2
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E3
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E4
+        { "PUSH", "HL", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E5
+        { "AND", "{b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E6
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // E7
+        { "ADD", "SP, {s}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // E8
+        { "JP", "HL", 1, SM83_FLOW_JUMP_HL, SM83_CONDITION_NONE }, // E9
+        { "LD", "[{w}], A", 3, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // EA
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // EB
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // EC
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // ED
+        { "XOR", "{b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // EE
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // EF
+        { "LDH", "A, [{h}]", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F0
+        { "POP", "AF", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F1
+        { "LDH", "A, [C]", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F2
+        { "DI", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F3
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F4
+        { "PUSH", "AF", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F5
+        { "OR", "{b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F6
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // F7
+        { "LD", "HL, SP{s}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F8
+        { "LD", "SP, HL", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // F9
+        { "LD", "A, [{w}]", 3, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // FA
+        { "EI", "", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // FB
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // FC
+        { "DB", "{o}", 1, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // FD
+        { "CP", "{b}", 2, SM83_FLOW_NONE, SM83_CONDITION_NONE }, // FE
+        { "RST", "{t}", 1, SM83_FLOW_CALL, SM83_CONDITION_NONE }, // FF
+    };
+
+    const char *CB_OPERATIONS[] = { "RLC", "RRC", "RL", "RR", "SLA", "SRA", "SWAP", "SRL" };
+    const char *CB_BIT_OPERATIONS[] = { nullptr, "BIT", "RES", "SET" };
+    const char *CB_REGISTERS[] = { "B", "C", "D", "E", "H", "L", "[HL]", "A" };
+
+    const char HEX[] = "0123456789ABCDEF";
+
+    // Writes into a fixed-size buffer, dropping anything that doesn't fit
+    struct OperandWriter {
+        char *output;
+        std::size_t size;
+        std::size_t position = 0;
+
+        void put(char c) noexcept {
+            if(this->position + 1 < this->size) {
+                this->output[this->position++] = c;
+            }
+        }
+
+        void put(const char *str) noexcept {
+            while(*str) {
+                this->put(*str++);
+            }
+        }
+
+        void put_hex(unsigned int value, unsigned int digits) noexcept {
+            this->put('$');
+            while(digits-- > 0) {
+                this->put(HEX[(value >> (digits * 4)) & 0xF]);
+            }
+        }
+
+        void finish() noexcept {
+            this->output[this->position] = 0;
+        }
+    };
+}
+
+std::uint8_t get_sm83_instruction_length(std::uint8_t opcode) noexcept {
+    return OPCODES[opcode].length;
+}
+
+SM83FlowType get_sm83_flow_type(std::uint8_t opcode) noexcept {
+    return OPCODES[opcode].flow;
+}
+
+SM83Condition get_sm83_condition(std::uint8_t opcode) noexcept {
+    return OPCODES[opcode].condition;
+}
+
+void decode_sm83_instruction(std::uint16_t address, const std::uint8_t *bytes, SM83Instruction &instruction) noexcept {
+    auto opcode = bytes[0];
+    const auto &info = OPCODES[opcode];
+
+    instruction.address = address;
+    instruction.length = info.length;
+    instruction.mnemonic = info.mnemonic;
+    instruction.flow = info.flow;
+    instruction.condition = info.condition;
+    instruction.target = std::nullopt;
+    for(std::uint8_t i = 0; i < sizeof(instruction.bytes); i++) {
+        instruction.bytes[i] = i < info.length ? bytes[i] : 0;
+    }
+
+    OperandWriter writer = { instruction.operands, sizeof(instruction.operands) };
+
+    // CB-prefixed instructions are regular enough to decode without a second table
+    if(opcode == 0xCB) {
+        auto cb = bytes[1];
+        auto bit_operation = cb >> 6;
+        if(bit_operation == 0) {
+            instruction.mnemonic = CB_OPERATIONS[(cb >> 3) & 7];
+        }
+        else {
+            instruction.mnemonic = CB_BIT_OPERATIONS[bit_operation];
+            writer.put(static_cast<char>('0' + ((cb >> 3) & 7)));
+            writer.put(", ");
+        }
+        writer.put(CB_REGISTERS[cb & 7]);
+        writer.finish();
+        return;
+    }
+
+    auto byte = bytes[1];
+    auto word = static_cast<std::uint16_t>(bytes[1] | (bytes[2] << 8));
+
+    for(const char *o = info.operands; *o; o++) {
+        if(*o != '{') {
+            writer.put(*o);
+            continue;
+        }
+
+        switch(o[1]) {
+            case 'b':
+                writer.put_hex(byte, 2);
+                break;
+            case 'w':
+                writer.put_hex(word, 4);
+                if(info.flow == SM83_FLOW_JUMP || info.flow == SM83_FLOW_CALL) {
+                    instruction.target = word;
+                }
+                break;
+            case 'r':
+                instruction.target = static_cast<std::uint16_t>(address + 2 + static_cast<std::int8_t>(byte));
+                writer.put_hex(*instruction.target, 4);
+                break;
+            case 'h':
+                writer.put_hex(0xFF00 | byte, 4);
+                break;
+            case 's': {
+                auto offset = static_cast<int>(static_cast<std::int8_t>(byte));
+                writer.put(offset < 0 ? '-' : '+');
+                writer.put_hex(static_cast<unsigned int>(offset < 0 ? -offset : offset), 2);
+                break;
+            }
+            case 't':
+                instruction.target = opcode & 0x38;
+                writer.put_hex(*instruction.target, 2);
+                break;
+            case 'o':
+                writer.put_hex(opcode, 2);
+                break;
+        }
+
+        o += 2; // skip the letter and the closing brace
+    }
+
+    writer.finish();
+}
+
+std::string format_sm83_instruction(const SM83Instruction &instruction) {
+    std::string text = instruction.mnemonic;
+    if(instruction.operands[0] != 0) {
+        text += ' ';
+        text += instruction.operands;
+    }
+    return text;
+}
+
+bool is_sm83_condition_met(SM83Condition condition, std::uint8_t f) noexcept {
+    bool zero = f & 0x80;
+    bool carry = f & 0x10;
+
+    switch(condition) {
+        case SM83_CONDITION_NZ:
+            return !zero;
+        case SM83_CONDITION_Z:
+            return zero;
+        case SM83_CONDITION_NC:
+            return !carry;
+        case SM83_CONDITION_C:
+            return carry;
+        default:
+            return true;
+    }
+}
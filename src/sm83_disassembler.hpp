@@ -0,0 +1,127 @@
+#ifndef SM83_DISASSEMBLER_HPP
+#define SM83_DISASSEMBLER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * How an instruction changes the flow of execution
+ */
+enum SM83FlowType : std::uint8_t {
+    /** Execution continues to the next instruction */
+    SM83_FLOW_NONE,
+
+    /** JP/JR to a known address */
+    SM83_FLOW_JUMP,
+
+    /** JP HL (the target is not known until it runs) */
+    SM83_FLOW_JUMP_HL,
+
+    /** CALL/RST */
+    SM83_FLOW_CALL,
+
+    /** RET/RETI */
+    SM83_FLOW_RETURN
+};
+
+/**
+ * Condition an instruction is taken on
+ */
+enum SM83Condition : std::uint8_t {
+    SM83_CONDITION_NONE,
+    SM83_CONDITION_NZ,
+    SM83_CONDITION_Z,
+    SM83_CONDITION_NC,
+    SM83_CONDITION_C
+};
+
+/**
+ * A single decoded instruction
+ */
+struct SM83Instruction {
+    /** Address of the instruction */
+    std::uint16_t address = 0;
+
+    /** Bank the address was mapped to when it was read */
+    std::uint16_t bank = 0;
+
+    /** Bytes of the instruction (only the first length bytes are used) */
+    std::uint8_t bytes[3] = {};
+
+    /** Number of bytes the instruction takes up */
+    std::uint8_t length = 1;
+
+    /** Mnemonic (e.g. "LD") */
+    const char *mnemonic = "";
+
+    /** Operands (e.g. "A, [$FF44]"), or an empty string if there are none */
+    char operands[16] = {};
+
+    /** How the instruction changes the flow of execution */
+    SM83FlowType flow = SM83_FLOW_NONE;
+
+    /** Condition the flow change depends on */
+    SM83Condition condition = SM83_CONDITION_NONE;
+
+    /** Address jumped/called to, if it is known without running the instruction */
+    std::optional<std::uint16_t> target;
+
+    /** Name of the symbol at the address, if any */
+    std::string symbol;
+
+    /** Name of the symbol at the target, if any */
+    std::string target_symbol;
+};
+
+/**
+ * Get the length of the instruction starting with the given opcode
+ *
+ * @param opcode first byte of the instruction
+ * @return       length in bytes (1-3)
+ */
+std::uint8_t get_sm83_instruction_length(std::uint8_t opcode) noexcept;
+
+/**
+ * Get how the instruction starting with the given opcode changes the flow of execution
+ *
+ * @param opcode first byte of the instruction
+ * @return       flow type
+ */
+SM83FlowType get_sm83_flow_type(std::uint8_t opcode) noexcept;
+
+/**
+ * Get the condition the instruction starting with the given opcode changes the flow of execution on
+ *
+ * @param opcode first byte of the instruction
+ * @return       condition
+ */
+SM83Condition get_sm83_condition(std::uint8_t opcode) noexcept;
+
+/**
+ * Decode an instruction. Symbols and the bank are left for the caller to fill in.
+ *
+ * @param address     address of the instruction
+ * @param bytes       three bytes starting at the address (bytes past the end of the instruction are ignored)
+ * @param instruction where to put the instruction
+ */
+void decode_sm83_instruction(std::uint16_t address, const std::uint8_t *bytes, SM83Instruction &instruction) noexcept;
+
+/**
+ * Format an instruction as text (e.g. "JP NZ, $0150")
+ *
+ * @param instruction instruction to format
+ * @return            text
+ */
+std::string format_sm83_instruction(const SM83Instruction &instruction);
+
+/**
+ * Check if an instruction's condition is met
+ *
+ * @param condition condition to check
+ * @param f         value of the F register
+ * @return          true if the condition is met (always true if there is no condition)
+ */
+bool is_sm83_condition_met(SM83Condition condition, std::uint8_t f) noexcept;
+
+#endif
@@ -0,0 +1,417 @@
+#include "sm83_expression.hpp"
+
+#include <cctype>
+#include <cstring>
+
+struct BinaryOperator {
+    const char *text;
+    int precedence;
+    SM83Expression::Op op;
+};
+
+// Longer operators come first so "<=" isn't read as "<"
+static const BinaryOperator BINARY_OPERATORS[] = {
+    { "||", 1, SM83Expression::OP_LOGICAL_OR },
+    { "&&", 2, SM83Expression::OP_LOGICAL_AND },
+    { "==", 6, SM83Expression::OP_EQUAL },
+    { "!=", 6, SM83Expression::OP_NOT_EQUAL },
+    { "<=", 7, SM83Expression::OP_LESS_EQUAL },
+    { ">=", 7, SM83Expression::OP_GREATER_EQUAL },
+    { "<<", 8, SM83Expression::OP_SHIFT_LEFT },
+    { ">>", 8, SM83Expression::OP_SHIFT_RIGHT },
+    { "|", 3, SM83Expression::OP_OR },
+    { "^", 4, SM83Expression::OP_XOR },
+    { "&", 5, SM83Expression::OP_AND },
+    { "<", 7, SM83Expression::OP_LESS },
+    { ">", 7, SM83Expression::OP_GREATER },
+    { "+", 9, SM83Expression::OP_ADD },
+    { "-", 9, SM83Expression::OP_SUBTRACT },
+    { "*", 10, SM83Expression::OP_MULTIPLY },
+    { "/", 10, SM83Expression::OP_DIVIDE },
+    { "%", 10, SM83Expression::OP_MODULO }
+};
+
+static const char *const REGISTER_NAMES[] = { "a", "f", "b", "c", "d", "e", "h", "l", "af", "bc", "de", "hl", "sp", "pc" };
+
+static std::uint16_t apply_unary(SM83Expression::Op op, std::uint16_t a) noexcept {
+    switch(op) {
+        case SM83Expression::OP_NEGATE:
+            return static_cast<std::uint16_t>(-a);
+        case SM83Expression::OP_NOT:
+            return static_cast<std::uint16_t>(~a);
+        case SM83Expression::OP_LOGICAL_NOT:
+            return a == 0;
+        default:
+            return a;
+    }
+}
+
+static std::uint16_t apply_binary(SM83Expression::Op op, std::uint16_t a, std::uint16_t b) noexcept {
+    switch(op) {
+        case SM83Expression::OP_MULTIPLY:
+            return static_cast<std::uint16_t>(a * b);
+        case SM83Expression::OP_DIVIDE:
+            return b == 0 ? 0 : a / b;
+        case SM83Expression::OP_MODULO:
+            return b == 0 ? 0 : a % b;
+        case SM83Expression::OP_ADD:
+            return static_cast<std::uint16_t>(a + b);
+        case SM83Expression::OP_SUBTRACT:
+            return static_cast<std::uint16_t>(a - b);
+        case SM83Expression::OP_SHIFT_LEFT:
+            return b >= 16 ? 0 : static_cast<std::uint16_t>(a << b);
+        case SM83Expression::OP_SHIFT_RIGHT:
+            return b >= 16 ? 0 : a >> b;
+        case SM83Expression::OP_LESS:
+            return a < b;
+        case SM83Expression::OP_LESS_EQUAL:
+            return a <= b;
+        case SM83Expression::OP_GREATER:
+            return a > b;
+        case SM83Expression::OP_GREATER_EQUAL:
+            return a >= b;
+        case SM83Expression::OP_EQUAL:
+            return a == b;
+        case SM83Expression::OP_NOT_EQUAL:
+            return a != b;
+        case SM83Expression::OP_AND:
+            return a & b;
+        case SM83Expression::OP_XOR:
+            return a ^ b;
+        case SM83Expression::OP_OR:
+            return a | b;
+        case SM83Expression::OP_LOGICAL_AND:
+            return a != 0 && b != 0;
+        case SM83Expression::OP_LOGICAL_OR:
+            return a != 0 || b != 0;
+        default:
+            return a;
+    }
+}
+
+// Binds tighter than any binary operator
+static constexpr const int UNARY_PRECEDENCE = 11;
+
+// Maximum depth of parentheses, brackets, and unary operators
+static constexpr const std::size_t MAX_NESTING = 256;
+
+// Recursive descent parser that emits bytecode as it goes, folding constants along the way
+class SM83ExpressionCompiler {
+public:
+    SM83ExpressionCompiler(const std::string &text, std::string &error, const SM83Expression::ResolveSymbol &resolve) : text(text), error(error), resolve(resolve) {}
+
+    bool compile(SM83Expression &expression) {
+        if(!this->parse_binary(1)) {
+            return false;
+        }
+
+        this->skip_whitespace();
+        if(this->position != this->text.size()) {
+            return this->fail("Unexpected '" + this->text.substr(this->position, 1) + "'");
+        }
+
+        expression.text = this->text;
+        expression.code = std::move(this->code);
+        return true;
+    }
+
+private:
+    const std::string &text;
+    std::string &error;
+    const SM83Expression::ResolveSymbol &resolve;
+    std::size_t position = 0;
+    std::size_t depth = 0;
+    std::size_t nesting = 0;
+    std::vector<SM83Expression::Instruction> code;
+
+    bool fail(const std::string &message) {
+        this->error = message + " at position " + std::to_string(this->position + 1);
+        return false;
+    }
+
+    void skip_whitespace() noexcept {
+        while(this->position < this->text.size() && std::isspace(static_cast<unsigned char>(this->text[this->position]))) {
+            this->position++;
+        }
+    }
+
+    bool accept(const char *what) noexcept {
+        this->skip_whitespace();
+        auto length = std::strlen(what);
+        if(this->text.compare(this->position, length, what) == 0) {
+            this->position += length;
+            return true;
+        }
+        return false;
+    }
+
+    bool push(SM83Expression::Op op, std::uint16_t operand = 0) {
+        if(++this->depth > SM83Expression::MAX_STACK) {
+            return this->fail("Expression is too complex");
+        }
+        this->code.push_back({ op, operand });
+        return true;
+    }
+
+    void emit_unary(SM83Expression::Op op) {
+        auto &last = this->code.back();
+        if(last.op == SM83Expression::OP_PUSH) {
+            last.operand = apply_unary(op, last.operand);
+        }
+        else {
+            this->code.push_back({ op, 0 });
+        }
+    }
+
+    void emit_binary(SM83Expression::Op op) {
+        this->depth--;
+
+        auto size = this->code.size();
+        if(this->code[size - 2].op == SM83Expression::OP_PUSH && this->code[size - 1].op == SM83Expression::OP_PUSH) {
+            this->code[size - 2].operand = apply_binary(op, this->code[size - 2].operand, this->code[size - 1].operand);
+            this->code.pop_back();
+        }
+        else {
+            this->code.push_back({ op, 0 });
+        }
+    }
+
+    const BinaryOperator *peek_binary_operator() noexcept {
+        this->skip_whitespace();
+        for(auto &o : BINARY_OPERATORS) {
+            if(this->text.compare(this->position, std::strlen(o.text), o.text) == 0) {
+                return &o;
+            }
+        }
+        return nullptr;
+    }
+
+    bool parse_binary(int min_precedence) {
+        // Don't let something like "((((...))))" overflow our own stack
+        if(this->nesting >= MAX_NESTING) {
+            return this->fail("Expression is too complex");
+        }
+
+        this->nesting++;
+        bool success = this->parse_binary_nested(min_precedence);
+        this->nesting--;
+        return success;
+    }
+
+    bool parse_binary_nested(int min_precedence) {
+        if(!this->parse_unary()) {
+            return false;
+        }
+
+        while(auto *o = this->peek_binary_operator()) {
+            if(o->precedence < min_precedence) {
+                break;
+            }
+            this->position += std::strlen(o->text);
+
+            // Everything here is left-associative
+            if(!this->parse_binary(o->precedence + 1)) {
+                return false;
+            }
+            this->emit_binary(o->op);
+        }
+
+        return true;
+    }
+
+    bool parse_unary() {
+        // Don't mistake "!=" for "!"
+        this->skip_whitespace();
+        SM83Expression::Op op;
+        if(this->accept("-")) {
+            op = SM83Expression::OP_NEGATE;
+        }
+        else if(this->accept("~")) {
+            op = SM83Expression::OP_NOT;
+        }
+        else if(this->text.compare(this->position, 2, "!=") != 0 && this->accept("!")) {
+            op = SM83Expression::OP_LOGICAL_NOT;
+        }
+        else {
+            return this->parse_primary();
+        }
+
+        if(!this->parse_binary(UNARY_PRECEDENCE)) {
+            return false;
+        }
+        this->emit_unary(op);
+        return true;
+    }
+
+    bool parse_memory(const char *close, SM83Expression::Op op) {
+        if(!this->parse_binary(1)) {
+            return false;
+        }
+        if(!this->accept(close)) {
+            return this->fail(std::string("Expected '") + close + "'");
+        }
+        this->code.push_back({ op, 0 });
+        return true;
+    }
+
+    bool parse_primary() {
+        this->skip_whitespace();
+        if(this->position >= this->text.size()) {
+            return this->fail("Unexpected end of expression");
+        }
+
+        if(this->accept("(")) {
+            if(!this->parse_binary(1)) {
+                return false;
+            }
+            return this->accept(")") ? true : this->fail("Expected ')'");
+        }
+        if(this->accept("[")) {
+            return this->parse_memory("]", SM83Expression::OP_READ_8);
+        }
+        if(this->accept("{")) {
+            return this->parse_memory("}", SM83Expression::OP_READ_16);
+        }
+
+        char c = this->text[this->position];
+        if(c == '$' || std::isdigit(static_cast<unsigned char>(c))) {
+            return this->parse_number();
+        }
+        if(std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '.') {
+            return this->parse_name();
+        }
+
+        return this->fail(std::string("Unexpected '") + c + "'");
+    }
+
+    bool parse_number() {
+        auto start = this->position;
+        int base = 10;
+        if(this->accept("$")) {
+            base = 16;
+        }
+        else if(this->text.compare(this->position, 2, "0x") == 0 || this->text.compare(this->position, 2, "0X") == 0) {
+            base = 16;
+            this->position += 2;
+        }
+        else if(this->text.compare(this->position, 2, "0b") == 0 || this->text.compare(this->position, 2, "0B") == 0) {
+            base = 2;
+            this->position += 2;
+        }
+
+        std::uint32_t value = 0;
+        std::size_t digits = 0;
+        while(this->position < this->text.size()) {
+            char c = static_cast<char>(std::tolower(static_cast<unsigned char>(this->text[this->position])));
+            int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'z') ? c - 'a' + 10 : base;
+            if(digit >= base) {
+                break;
+            }
+            value = value * base + digit;
+            if(value > UINT16_MAX) {
+                this->position = start;
+                return this->fail("Number is too big");
+            }
+            this->position++;
+            digits++;
+        }
+
+        if(digits == 0) {
+            this->position = start;
+            return this->fail("Expected a number");
+        }
+
+        return this->push(SM83Expression::OP_PUSH, static_cast<std::uint16_t>(value));
+    }
+
+    bool parse_name() {
+        auto start = this->position;
+        while(this->position < this->text.size()) {
+            char c = this->text[this->position];
+            if(!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.') {
+                break;
+            }
+            this->position++;
+        }
+
+        auto name = this->text.substr(start, this->position - start);
+        std::string lowercase = name;
+        for(auto &c : lowercase) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        for(std::size_t r = 0; r < sizeof(REGISTER_NAMES) / sizeof(REGISTER_NAMES[0]); r++) {
+            if(lowercase == REGISTER_NAMES[r]) {
+                return this->push(SM83Expression::OP_REGISTER, static_cast<std::uint16_t>(r));
+            }
+        }
+
+        std::optional<std::uint16_t> value;
+        if(this->resolve) {
+            value = this->resolve(name);
+        }
+        if(!value.has_value()) {
+            this->position = start;
+            return this->fail("Unknown symbol '" + name + "'");
+        }
+
+        return this->push(SM83Expression::OP_PUSH, *value);
+    }
+};
+
+std::optional<SM83Expression> SM83Expression::compile(const std::string &text, std::string &error, const ResolveSymbol &resolve) {
+    SM83Expression expression;
+    SM83ExpressionCompiler compiler(text, error, resolve);
+    if(!compiler.compile(expression)) {
+        return std::nullopt;
+    }
+    return expression;
+}
+
+std::uint16_t SM83Expression::evaluate(const SM83ExpressionState &state, ReadMemory read, void *user_data) const noexcept {
+    std::uint16_t stack[MAX_STACK];
+    std::size_t top = 0;
+
+    for(auto &i : this->code) {
+        switch(i.op) {
+            case OP_PUSH:
+                stack[top++] = i.operand;
+                break;
+            case OP_REGISTER:
+                switch(i.operand) {
+                    case REG_A: stack[top++] = state.af >> 8; break;
+                    case REG_F: stack[top++] = state.af & 0xFF; break;
+                    case REG_B: stack[top++] = state.bc >> 8; break;
+                    case REG_C: stack[top++] = state.bc & 0xFF; break;
+                    case REG_D: stack[top++] = state.de >> 8; break;
+                    case REG_E: stack[top++] = state.de & 0xFF; break;
+                    case REG_H: stack[top++] = state.hl >> 8; break;
+                    case REG_L: stack[top++] = state.hl & 0xFF; break;
+                    case REG_AF: stack[top++] = state.af; break;
+                    case REG_BC: stack[top++] = state.bc; break;
+                    case REG_DE: stack[top++] = state.de; break;
+                    case REG_HL: stack[top++] = state.hl; break;
+                    case REG_SP: stack[top++] = state.sp; break;
+                    default: stack[top++] = state.pc; break;
+                }
+                break;
+            case OP_READ_8:
+                stack[top - 1] = read(user_data, stack[top - 1]);
+                break;
+            case OP_READ_16:
+                stack[top - 1] = read(user_data, stack[top - 1]) | (read(user_data, static_cast<std::uint16_t>(stack[top - 1] + 1)) << 8);
+                break;
+            case OP_NEGATE:
+            case OP_NOT:
+            case OP_LOGICAL_NOT:
+                stack[top - 1] = apply_unary(i.op, stack[top - 1]);
+                break;
+            default:
+                top--;
+                stack[top - 1] = apply_binary(i.op, stack[top - 1], stack[top]);
+                break;
+        }
+    }
+
+    return top == 0 ? 0 : stack[top - 1];
+}
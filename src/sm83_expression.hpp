@@ -0,0 +1,117 @@
+#ifndef SM83_EXPRESSION_HPP
+#define SM83_EXPRESSION_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+
+/**
+ * CPU registers an expression can read
+ */
+struct SM83ExpressionState {
+    std::uint16_t af, bc, de, hl, sp, pc;
+};
+
+/**
+ * An expression compiled to bytecode so it can be checked many times without parsing it again.
+ *
+ * Expressions use C operators and precedence (unary - ! ~, * / %, + -, << >>, < <= > >=, == !=, &, ^, |, &&, ||) and
+ * parentheses. Operands are registers (a, f, b, c, d, e, h, l, af, bc, de, hl, sp, pc), numbers ($1F or 0x1F for hex,
+ * 0b101 for binary, decimal otherwise), symbols, [address] to read a byte, and {address} to read a little endian word.
+ * Everything is 16-bit like SameBoy's own expressions; comparisons give 1 or 0, and dividing by zero gives 0.
+ *
+ * Symbols are looked up when compiling, so an expression has to be compiled again if symbols change.
+ */
+class SM83Expression {
+public:
+    using ReadMemory = std::uint8_t (*)(void *user_data, std::uint16_t address);
+    using ResolveSymbol = std::function<std::optional<std::uint16_t> (const std::string &name)>;
+
+    /**
+     * Compile an expression
+     *
+     * @param text    expression to compile
+     * @param error   set to what went wrong if it fails
+     * @param resolve function to look up symbols (or nullptr to not allow symbols)
+     * @return        expression, or nullopt if it could not be compiled
+     */
+    static std::optional<SM83Expression> compile(const std::string &text, std::string &error, const ResolveSymbol &resolve = nullptr);
+
+    /**
+     * Evaluate the expression
+     *
+     * @param state     registers
+     * @param read      function to read memory
+     * @param user_data passed to read
+     * @return          result
+     */
+    std::uint16_t evaluate(const SM83ExpressionState &state, ReadMemory read, void *user_data) const noexcept;
+
+    /**
+     * Get the text the expression was compiled from
+     *
+     * @return text
+     */
+    const std::string &get_text() const noexcept { return this->text; }
+
+    /**
+     * Get whether or not the expression always gives the same result (e.g. it has no registers or memory in it)
+     *
+     * @return true if constant
+     */
+    bool is_constant() const noexcept { return this->code.size() == 1 && this->code[0].op == OP_PUSH; }
+
+    enum Op : std::uint8_t {
+        OP_PUSH,
+        OP_REGISTER,
+        OP_READ_8,
+        OP_READ_16,
+
+        OP_NEGATE,
+        OP_NOT,
+        OP_LOGICAL_NOT,
+
+        OP_MULTIPLY,
+        OP_DIVIDE,
+        OP_MODULO,
+        OP_ADD,
+        OP_SUBTRACT,
+        OP_SHIFT_LEFT,
+        OP_SHIFT_RIGHT,
+        OP_LESS,
+        OP_LESS_EQUAL,
+        OP_GREATER,
+        OP_GREATER_EQUAL,
+        OP_EQUAL,
+        OP_NOT_EQUAL,
+        OP_AND,
+        OP_XOR,
+        OP_OR,
+        OP_LOGICAL_AND,
+        OP_LOGICAL_OR
+    };
+
+    enum Register : std::uint8_t {
+        REG_A, REG_F, REG_B, REG_C, REG_D, REG_E, REG_H, REG_L,
+        REG_AF, REG_BC, REG_DE, REG_HL, REG_SP, REG_PC
+    };
+
+    struct Instruction {
+        Op op;
+        std::uint16_t operand;
+    };
+
+    /** Deepest the stack can get */
+    static constexpr const std::size_t MAX_STACK = 32;
+
+private:
+    std::string text;
+    std::vector<Instruction> code;
+
+    SM83Expression() = default;
+    friend class SM83ExpressionCompiler;
+};
+
+#endif
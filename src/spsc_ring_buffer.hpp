@@ -0,0 +1,110 @@
+#ifndef SPSC_RING_BUFFER_HPP
+#define SPSC_RING_BUFFER_HPP
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+/**
+ * Lock-free ring buffer for exactly one producer thread and one consumer thread.
+ *
+ * Neither side ever blocks or allocates after construction, so this is safe to push into from the emulation thread.
+ */
+template<typename T> class SPSCRingBuffer {
+public:
+    /**
+     * Instantiate a ring buffer
+     *
+     * @param capacity minimum number of elements (rounded up to a power of two)
+     */
+    SPSCRingBuffer(std::size_t capacity) {
+        std::size_t actual_capacity = 1;
+        while(actual_capacity < capacity) {
+            actual_capacity <<= 1;
+        }
+        this->buffer.resize(actual_capacity);
+        this->mask = actual_capacity - 1;
+    }
+
+    /**
+     * Push as many elements as will fit (producer only)
+     *
+     * @param data  elements to push
+     * @param count number of elements
+     * @return      number of elements pushed
+     */
+    std::size_t push(const T *data, std::size_t count) noexcept {
+        auto head = this->head.load(std::memory_order_relaxed);
+        auto tail = this->tail.load(std::memory_order_acquire);
+        auto to_push = std::min(count, this->buffer.size() - (head - tail));
+        for(std::size_t i = 0; i < to_push; i++) {
+            this->buffer[(head + i) & this->mask] = data[i];
+        }
+        this->head.store(head + to_push, std::memory_order_release);
+        return to_push;
+    }
+
+    /**
+     * Push a single element (producer only)
+     *
+     * @param data element to push
+     * @return     true if pushed, false if full
+     */
+    bool push(const T &data) noexcept {
+        return this->push(&data, 1) == 1;
+    }
+
+    /**
+     * Pop up to the given number of elements (consumer only)
+     *
+     * @param destination where to pop to
+     * @param count       maximum number of elements to pop
+     * @return            number of elements popped
+     */
+    std::size_t pop(T *destination, std::size_t count) noexcept {
+        auto tail = this->tail.load(std::memory_order_relaxed);
+        auto head = this->head.load(std::memory_order_acquire);
+        auto to_pop = std::min(count, head - tail);
+        for(std::size_t i = 0; i < to_pop; i++) {
+            destination[i] = this->buffer[(tail + i) & this->mask];
+        }
+        this->tail.store(tail + to_pop, std::memory_order_release);
+        return to_pop;
+    }
+
+    /**
+     * Get the number of elements currently held (approximate if called while the other side is active)
+     *
+     * @return number of elements
+     */
+    std::size_t size() const noexcept {
+        return this->head.load(std::memory_order_acquire) - this->tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Get the maximum number of elements
+     *
+     * @return capacity
+     */
+    std::size_t capacity() const noexcept {
+        return this->buffer.size();
+    }
+
+    /**
+     * Discard everything (consumer only)
+     */
+    void clear() noexcept {
+        this->tail.store(this->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::vector<T> buffer;
+    std::size_t mask;
+
+    // Keep these on separate cache lines so the producer and consumer don't fight over them
+    alignas(64) std::atomic<std::size_t> head = 0;
+    alignas(64) std::atomic<std::size_t> tail = 0;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "sram_flusher.hpp"
+#include "game_instance.hpp"
+#include "background_io.hpp"
+#include "file_io.hpp"
+#include "hash.hpp"
+
+void SRAMFlusher::reset(GameInstance &instance, const std::filesystem::path &path) {
+    this->path = path;
+    this->attached = true;
+    this->last_write_failed = false;
+
+    auto stall = instance.create_sram_snapshot(this->snapshot);
+    this->record_stall(std::chrono::duration_cast<std::chrono::microseconds>(stall).count());
+    this->last_hash = fnv1a_64(this->snapshot.data(), this->snapshot.size());
+    this->last_size = this->snapshot.size();
+}
+
+bool SRAMFlusher::flush(GameInstance &instance, BackgroundIO &io, bool force) {
+    if(!this->attached) {
+        return false;
+    }
+
+    auto stall = instance.create_sram_snapshot(this->snapshot);
+    this->record_stall(std::chrono::duration_cast<std::chrono::microseconds>(stall).count());
+    this->checks.fetch_add(1, std::memory_order_relaxed);
+
+    // No battery, so nothing to save
+    if(this->snapshot.empty()) {
+        return true;
+    }
+
+    auto hash = fnv1a_64(this->snapshot.data(), this->snapshot.size());
+    bool changed = hash != this->last_hash || this->snapshot.size() != this->last_size || this->last_write_failed.exchange(false);
+    if(!changed && !force) {
+        this->unchanged.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    this->last_hash = hash;
+    this->last_size = this->snapshot.size();
+
+    io.enqueue([this, force, path = this->path, sram = this->snapshot]() {
+        BackgroundIO::Completion completion;
+        completion.success = write_file_atomically(path, sram.data(), sram.size());
+
+        if(completion.success) {
+            this->writes.fetch_add(1, std::memory_order_relaxed);
+            this->bytes_written.fetch_add(sram.size(), std::memory_order_relaxed);
+            if(force) {
+                completion.message = "SRAM saved";
+            }
+        }
+        else {
+            this->failed_writes.fetch_add(1, std::memory_order_relaxed);
+            this->last_write_failed = true;
+            completion.message = "Failed to save " + path.filename().string();
+        }
+
+        return completion;
+    });
+
+    return true;
+}
+
+SRAMFlusher::Statistics SRAMFlusher::get_statistics() const noexcept {
+    Statistics statistics;
+    statistics.checks = this->checks.load(std::memory_order_relaxed);
+    statistics.unchanged = this->unchanged.load(std::memory_order_relaxed);
+    statistics.writes = this->writes.load(std::memory_order_relaxed);
+    statistics.failed_writes = this->failed_writes.load(std::memory_order_relaxed);
+    statistics.bytes_written = this->bytes_written.load(std::memory_order_relaxed);
+    statistics.last_stall_ms = this->last_stall_us.load(std::memory_order_relaxed) / 1000.0;
+    statistics.max_stall_ms = this->max_stall_us.load(std::memory_order_relaxed) / 1000.0;
+    return statistics;
+}
+
+void SRAMFlusher::record_stall(std::uint64_t stall_us) noexcept {
+    this->last_stall_us.store(stall_us, std::memory_order_relaxed);
+    if(stall_us > this->max_stall_us.load(std::memory_order_relaxed)) {
+        this->max_stall_us.store(stall_us, std::memory_order_relaxed);
+    }
+}
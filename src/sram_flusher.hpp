@@ -0,0 +1,89 @@
+#ifndef SRAM_FLUSHER_HPP
+#define SRAM_FLUSHER_HPP
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <filesystem>
+
+class GameInstance;
+class BackgroundIO;
+
+/**
+ * Writes the battery save in the background whenever it changes.
+ *
+ * Each check only holds up emulation long enough to copy the SRAM. The copy is hashed and compared with what was last
+ * written, and it is only written (atomically, on the background I/O thread) if it differs.
+ */
+class SRAMFlusher {
+public:
+    struct Statistics {
+        /** Number of times the SRAM was checked */
+        std::uint64_t checks;
+
+        /** Number of checks skipped because nothing changed */
+        std::uint64_t unchanged;
+
+        /** Number of successful writes */
+        std::uint64_t writes;
+
+        /** Number of failed writes */
+        std::uint64_t failed_writes;
+
+        /** Total bytes written */
+        std::uint64_t bytes_written;
+
+        /** Time emulation was blocked by the last check in milliseconds */
+        double last_stall_ms;
+
+        /** Longest time emulation was blocked by a check in milliseconds */
+        double max_stall_ms;
+    };
+
+    /**
+     * Start tracking a newly loaded ROM. Whatever is in SRAM now is considered saved.
+     *
+     * @param instance instance to read SRAM from
+     * @param path     path to the battery save
+     */
+    void reset(GameInstance &instance, const std::filesystem::path &path);
+
+    /**
+     * Stop tracking the current ROM so nothing is written until reset() is called again
+     */
+    void detach() noexcept { this->attached = false; }
+
+    /**
+     * Snapshot the SRAM and queue a write if it changed
+     *
+     * @param instance instance to read SRAM from
+     * @param io       where to queue the write
+     * @param force    write even if nothing changed, and report success to the user
+     * @return         true if the SRAM was written or queued to be written (or there is nothing to save)
+     */
+    bool flush(GameInstance &instance, BackgroundIO &io, bool force = false);
+
+    /**
+     * Get statistics
+     *
+     * @return statistics
+     */
+    Statistics get_statistics() const noexcept;
+
+private:
+    std::filesystem::path path;
+    bool attached = false;
+    std::uint64_t last_hash = 0;
+    std::size_t last_size = 0;
+    std::vector<std::uint8_t> snapshot;
+
+    // Set by the background thread if a write fails so the next check writes again even if nothing changed
+    std::atomic_bool last_write_failed = false;
+
+    std::atomic<std::uint64_t> checks = 0, unchanged = 0, writes = 0, failed_writes = 0, bytes_written = 0;
+    std::atomic<std::uint64_t> last_stall_us = 0, max_stall_us = 0;
+
+    void record_stall(std::uint64_t stall_us) noexcept;
+};
+
+#endif
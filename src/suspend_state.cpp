@@ -0,0 +1,106 @@
+#include "suspend_state.hpp"
+
+#include <cstring>
+
+#ifndef SAMEBOY_SOURCE_HASH
+#define SAMEBOY_SOURCE_HASH "unknown"
+#endif
+
+static constexpr const char SUSPEND_MAGIC[4] = { 'S', 'D', 'X', 'S' };
+static constexpr const std::uint32_t SUSPEND_VERSION = 1;
+
+template<typename T> static void write_le(std::vector<std::uint8_t> &output, T value) {
+    auto v = static_cast<std::uint64_t>(value);
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        output.emplace_back(static_cast<std::uint8_t>(v >> (i * 8)));
+    }
+}
+
+template<typename T> static bool read_le(const std::vector<std::uint8_t> &input, std::size_t &position, T &value) {
+    if(input.size() - position < sizeof(T)) {
+        return false;
+    }
+    std::uint64_t v = 0;
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        v |= static_cast<std::uint64_t>(input[position + i]) << (i * 8);
+    }
+    position += sizeof(T);
+    value = static_cast<T>(v);
+    return true;
+}
+
+std::filesystem::path get_suspend_state_path(const std::filesystem::path &save_path) {
+    return std::filesystem::path(save_path).replace_extension(".suspend");
+}
+
+std::vector<std::uint8_t> encode_suspend_state(std::uint64_t rom_hash, std::uint32_t model, std::uint64_t play_time_ms, const std::uint8_t *state, std::size_t state_size) {
+    static constexpr const char core[] = SAMEBOY_SOURCE_HASH;
+
+    std::vector<std::uint8_t> output(SUSPEND_MAGIC, SUSPEND_MAGIC + sizeof(SUSPEND_MAGIC));
+    output.reserve(64 + sizeof(core) + state_size);
+    write_le(output, SUSPEND_VERSION);
+    write_le(output, rom_hash);
+    write_le(output, model);
+    write_le(output, play_time_ms);
+    write_le(output, static_cast<std::uint16_t>(sizeof(core) - 1));
+    output.insert(output.end(), core, core + sizeof(core) - 1);
+    write_le(output, static_cast<std::uint64_t>(state_size));
+    output.insert(output.end(), state, state + state_size);
+    return output;
+}
+
+SuspendStateResult decode_suspend_state(const std::vector<std::uint8_t> &data, std::uint64_t rom_hash, std::uint32_t model, std::uint64_t &play_time_ms, std::vector<std::uint8_t> &state) {
+    std::size_t position = sizeof(SUSPEND_MAGIC);
+    if(data.size() < position || std::memcmp(data.data(), SUSPEND_MAGIC, sizeof(SUSPEND_MAGIC)) != 0) {
+        return SUSPEND_STATE_INVALID;
+    }
+
+    std::uint32_t version, state_model;
+    std::uint64_t state_rom_hash;
+    std::uint16_t core_length;
+    if(!read_le(data, position, version) || version != SUSPEND_VERSION ||
+       !read_le(data, position, state_rom_hash) ||
+       !read_le(data, position, state_model) ||
+       !read_le(data, position, play_time_ms) ||
+       !read_le(data, position, core_length) ||
+       data.size() - position < core_length) {
+        return SUSPEND_STATE_INVALID;
+    }
+
+    // Check the cheap things before copying anything
+    if(state_rom_hash != rom_hash) {
+        return SUSPEND_STATE_WRONG_ROM;
+    }
+    if(state_model != model) {
+        return SUSPEND_STATE_WRONG_MODEL;
+    }
+    auto *core = reinterpret_cast<const char *>(data.data() + position);
+    if(core_length != std::strlen(SAMEBOY_SOURCE_HASH) || std::memcmp(core, SAMEBOY_SOURCE_HASH, core_length) != 0) {
+        return SUSPEND_STATE_WRONG_CORE;
+    }
+    position += core_length;
+
+    std::uint64_t state_size;
+    if(!read_le(data, position, state_size) || data.size() - position != state_size) {
+        return SUSPEND_STATE_INVALID;
+    }
+
+    state.assign(data.begin() + position, data.end());
+    return SUSPEND_STATE_OK;
+}
+
+const char *describe_suspend_state_result(SuspendStateResult result) noexcept {
+    switch(result) {
+        case SUSPEND_STATE_OK:
+            return "OK";
+        case SUSPEND_STATE_INVALID:
+            return "not a valid suspend state";
+        case SUSPEND_STATE_WRONG_ROM:
+            return "made for a different ROM";
+        case SUSPEND_STATE_WRONG_MODEL:
+            return "made with a different model";
+        case SUSPEND_STATE_WRONG_CORE:
+            return "made with a different version of SameBoy";
+    }
+    return "unknown";
+}
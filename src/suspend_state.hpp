@@ -0,0 +1,72 @@
+#ifndef SUSPEND_STATE_HPP
+#define SUSPEND_STATE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+/**
+ * Save state written when closing so the ROM can pick up where it left off next time instead of booting again.
+ *
+ * The state is stored with a header identifying the ROM, the model, and the SameBoy build that made it, since a save
+ * state from a different ROM or core would either fail to load or load into something broken.
+ */
+enum SuspendStateResult {
+    /** Suspend state matches and was read */
+    SUSPEND_STATE_OK,
+
+    /** Not a suspend state, or it is truncated */
+    SUSPEND_STATE_INVALID,
+
+    /** Made for a different ROM */
+    SUSPEND_STATE_WRONG_ROM,
+
+    /** Made with a different model */
+    SUSPEND_STATE_WRONG_MODEL,
+
+    /** Made by a different build of SameBoy */
+    SUSPEND_STATE_WRONG_CORE
+};
+
+/**
+ * Get the path of the suspend state that goes with a save file
+ *
+ * @param save_path path to the ROM's save file
+ * @return          path to the suspend state
+ */
+std::filesystem::path get_suspend_state_path(const std::filesystem::path &save_path);
+
+/**
+ * Encode a suspend state
+ *
+ * @param rom_hash     hash of the ROM (see hash.hpp)
+ * @param model        model the state was made with
+ * @param play_time_ms play time so far
+ * @param state        save state
+ * @param state_size   size of the save state
+ * @return             encoded suspend state
+ */
+std::vector<std::uint8_t> encode_suspend_state(std::uint64_t rom_hash, std::uint32_t model, std::uint64_t play_time_ms, const std::uint8_t *state, std::size_t state_size);
+
+/**
+ * Decode a suspend state, checking that it was made for this ROM and model by this build of SameBoy
+ *
+ * @param data         encoded suspend state
+ * @param rom_hash     hash of the ROM being loaded
+ * @param model        model being used
+ * @param play_time_ms where to put the play time
+ * @param state        where to put the save state
+ * @return             SUSPEND_STATE_OK if the state can be used, otherwise why not
+ */
+SuspendStateResult decode_suspend_state(const std::vector<std::uint8_t> &data, std::uint64_t rom_hash, std::uint32_t model, std::uint64_t &play_time_ms, std::vector<std::uint8_t> &state);
+
+/**
+ * Describe the result of decode_suspend_state()
+ *
+ * @param result result
+ * @return       description
+ */
+const char *describe_suspend_state_result(SuspendStateResult result) noexcept;
+
+#endif
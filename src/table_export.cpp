@@ -0,0 +1,96 @@
+#include "table_export.hpp"
+
+#include <cstdio>
+
+// Update progress this often so whoever is watching doesn't hammer the atomic
+static constexpr const std::uint64_t PROGRESS_INTERVAL = 4096;
+
+static void append_field(std::string &line, const std::string &field, char separator) {
+    if(separator == '\t') {
+        for(auto c : field) {
+            line += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+        }
+        return;
+    }
+
+    if(field.find_first_of(std::string(1, separator) + "\"\n\r") == std::string::npos) {
+        line += field;
+        return;
+    }
+
+    line += '"';
+    for(auto c : field) {
+        if(c == '"') {
+            line += '"';
+        }
+        line += c;
+    }
+    line += '"';
+}
+
+static void append_row(std::string &line, const std::vector<std::string> &fields, char separator) {
+    for(std::size_t i = 0; i < fields.size(); i++) {
+        if(i > 0) {
+            line += separator;
+        }
+        append_field(line, fields[i], separator);
+    }
+    line += '\n';
+}
+
+bool export_delimited_table(const std::filesystem::path &path,
+                            char separator,
+                            const std::vector<std::string> &header,
+                            std::uint64_t row_count,
+                            const std::function<void (std::uint64_t row, std::vector<std::string> &fields)> &get_row,
+                            std::atomic<std::uint64_t> &progress,
+                            const std::atomic_bool &cancel) {
+    progress = 0;
+
+    std::FILE *f = std::fopen(path.string().c_str(), "wb");
+    if(f == nullptr) {
+        return false;
+    }
+
+    std::string buffer;
+    std::vector<std::string> fields(header.size());
+    append_row(buffer, header, separator);
+
+    bool success = true;
+    std::uint64_t row = 0;
+    for(; row < row_count; row++) {
+        get_row(row, fields);
+        append_row(buffer, fields, separator);
+
+        // Write in big chunks rather than a line at a time
+        if(buffer.size() >= 1024 * 1024) {
+            success = std::fwrite(buffer.data(), buffer.size(), 1, f) == 1;
+            buffer.clear();
+        }
+
+        if(row % PROGRESS_INTERVAL == 0) {
+            progress = row;
+            if(cancel) {
+                success = false;
+            }
+        }
+
+        if(!success) {
+            break;
+        }
+    }
+
+    if(success && !buffer.empty()) {
+        success = std::fwrite(buffer.data(), buffer.size(), 1, f) == 1;
+    }
+    success = std::fclose(f) == 0 && success;
+
+    if(!success) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+
+    progress = row_count;
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef TABLE_EXPORT_HPP
+#define TABLE_EXPORT_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+
+/**
+ * Write a table as comma- or tab-separated values. This is meant to be run on a worker thread while another thread watches
+ * progress and sets cancel if the user gives up; a cancelled or failed export deletes the partial file.
+ *
+ * Fields are quoted as needed for CSV. TSV has no quoting, so tabs and newlines in fields are replaced with spaces.
+ *
+ * @param path      path to write to
+ * @param separator ',' or '\t'
+ * @param header    column names
+ * @param row_count number of rows
+ * @param get_row   function to set the fields of a row (one per column; called in order from the calling thread)
+ * @param progress  set to the number of rows written so far
+ * @param cancel    stop early if set
+ * @return          true if every row was written
+ */
+bool export_delimited_table(const std::filesystem::path &path,
+                            char separator,
+                            const std::vector<std::string> &header,
+                            std::uint64_t row_count,
+                            const std::function<void (std::uint64_t row, std::vector<std::string> &fields)> &get_row,
+                            std::atomic<std::uint64_t> &progress,
+                            const std::atomic_bool &cancel);
+
+#endif
@@ -0,0 +1,28 @@
+#include "trace_buffer.hpp"
+
+#include <algorithm>
+
+void TraceBuffer::reset(std::size_t capacity) {
+    // Don't hold onto a huge buffer from a previous trace if we only need a small one
+    if(this->records.capacity() > capacity) {
+        this->records = std::vector<TraceRecord>();
+    }
+    this->records.resize(capacity);
+    this->head = 0;
+    this->total = 0;
+}
+
+void TraceBuffer::take(std::vector<TraceRecord> &output) {
+    // If we wrapped around, the oldest record is at the head
+    if(this->total > this->records.size()) {
+        std::rotate(this->records.begin(), this->records.begin() + this->head, this->records.end());
+    }
+    else {
+        this->records.resize(static_cast<std::size_t>(this->total));
+    }
+
+    output = std::move(this->records);
+    this->records = std::vector<TraceRecord>();
+    this->head = 0;
+    this->total = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef TRACE_BUFFER_HPP
+#define TRACE_BUFFER_HPP
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * CPU state right before an instruction ran.
+ *
+ * This is kept small and fixed-size so millions of them can be recorded from the emulation thread without allocating.
+ * The instruction itself is decoded when it's displayed (see GameInstance::decode_trace()).
+ */
+struct TraceRecord {
+    /** Cycles (in 8 MiHz ticks) since the instance started */
+    std::uint64_t cycle;
+
+    /** Program counter */
+    std::uint16_t pc;
+
+    /** Stack pointer */
+    std::uint16_t sp;
+
+    /** Bank mapped to the program counter */
+    std::uint16_t bank;
+
+    /** 8-bit registers */
+    std::uint8_t a, f, b, c, d, e, h, l;
+
+    /** First byte of the instruction */
+    std::uint8_t opcode;
+
+    /** TRACE_RECORD_* flags */
+    std::uint8_t flags;
+};
+static_assert(sizeof(TraceRecord) == 24);
+
+enum TraceRecordFlags : std::uint8_t {
+    /** Calls were being stepped over when this was recorded */
+    TRACE_RECORD_STEP_OVER = 1 << 0,
+
+    /** The boot ROM was mapped when this was recorded */
+    TRACE_RECORD_BOOT_ROM = 1 << 1
+};
+
+/**
+ * Preallocated ring of trace records. Once it's full, the oldest records are overwritten.
+ *
+ * This is not thread-safe; the owner has to synchronize access.
+ */
+class TraceBuffer {
+public:
+    /**
+     * Allocate room for the given number of records and remove anything recorded
+     *
+     * @param capacity maximum number of records to hold
+     */
+    void reset(std::size_t capacity);
+
+    /**
+     * Add a record, overwriting the oldest one if full
+     *
+     * @param record record to add
+     */
+    void push(const TraceRecord &record) noexcept {
+        if(this->records.empty()) {
+            return;
+        }
+
+        this->records[this->head] = record;
+        this->head = this->head + 1 == this->records.size() ? 0 : this->head + 1;
+        this->total++;
+    }
+
+    /**
+     * Get the number of records held
+     *
+     * @return number of records
+     */
+    std::size_t size() const noexcept { return this->total < this->records.size() ? static_cast<std::size_t>(this->total) : this->records.size(); }
+
+    /**
+     * Get the number of records that were pushed, including ones that were overwritten
+     *
+     * @return number of records
+     */
+    std::uint64_t get_total() const noexcept { return this->total; }
+
+    /**
+     * Move everything out, oldest first, and free the buffer
+     *
+     * @param output where to put the records
+     */
+    void take(std::vector<TraceRecord> &output);
+
+private:
+    std::vector<TraceRecord> records;
+    std::size_t head = 0;
+    std::uint64_t total = 0;
+};
+
+#endif
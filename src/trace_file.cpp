@@ -0,0 +1,260 @@
+#include "trace_file.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static constexpr const char TRACE_MAGIC[4] = { 'S', 'D', 'X', 'T' };
+static constexpr const std::uint32_t TRACE_VERSION = 2;
+
+// Version 1 didn't have the ROM hash or dropped record count
+static constexpr const std::size_t VERSION_1_HEADER_SIZE = 32;
+
+// Enough for a few frames' worth of instructions
+static constexpr const std::size_t RING_CAPACITY = 1 << 18;
+
+// Maximum records written per fwrite() call
+static constexpr const std::size_t WRITE_CHUNK = 8192;
+
+template<typename T> static void put_le(std::uint8_t *&output, T value) {
+    auto v = static_cast<std::uint64_t>(value);
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        *(output++) = static_cast<std::uint8_t>(v >> (i * 8));
+    }
+}
+
+template<typename T> static void get_le(const std::uint8_t *&input, T &value) {
+    std::uint64_t v = 0;
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        v |= static_cast<std::uint64_t>(*(input++)) << (i * 8);
+    }
+    value = static_cast<T>(v);
+}
+
+void TraceFile::encode_record(const TraceRecord &record, std::uint8_t *output) noexcept {
+    put_le(output, record.cycle);
+    put_le(output, record.pc);
+    put_le(output, record.sp);
+    put_le(output, record.bank);
+    for(auto r : { record.a, record.f, record.b, record.c, record.d, record.e, record.h, record.l, record.opcode, record.flags }) {
+        put_le(output, r);
+    }
+}
+
+void TraceFile::decode_record(const std::uint8_t *input, TraceRecord &record) noexcept {
+    get_le(input, record.cycle);
+    get_le(input, record.pc);
+    get_le(input, record.sp);
+    get_le(input, record.bank);
+    for(auto *r : { &record.a, &record.f, &record.b, &record.c, &record.d, &record.e, &record.h, &record.l, &record.opcode, &record.flags }) {
+        get_le(input, *r);
+    }
+}
+
+TraceFileWriter::TraceFileWriter(const std::filesystem::path &path, std::uint64_t rom_hash) : path(path), rom_hash(rom_hash), ring(RING_CAPACITY) {
+    this->file = std::fopen(path.string().c_str(), "wb");
+    if(this->file == nullptr) {
+        std::fprintf(stderr, "Failed to open %s for tracing\n", path.string().c_str());
+        return;
+    }
+
+    // Write a placeholder header; the record count and index get filled in when we finish
+    if(!this->write_header(0, 0)) {
+        std::fclose(this->file);
+        this->file = nullptr;
+        return;
+    }
+
+    this->writer = std::thread(&TraceFileWriter::writer_loop, this);
+}
+
+TraceFileWriter::~TraceFileWriter() {
+    if(this->writer.joinable()) {
+        if(!this->finishing) {
+            this->finish({});
+        }
+        this->writer.join();
+    }
+}
+
+void TraceFileWriter::finish(TraceFile::Names names) {
+    if(!this->writer.joinable() || this->finishing) {
+        return;
+    }
+    this->names = std::move(names);
+    this->finishing = true;
+}
+
+bool TraceFileWriter::write_index_and_close() noexcept {
+    // Write the index sorted by bank and address
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> entries(this->counts.begin(), this->counts.end());
+    std::sort(entries.begin(), entries.end());
+
+    std::uint64_t index_offset = TraceFile::HEADER_SIZE + this->records_written * TraceFile::RECORD_SIZE;
+    std::vector<std::uint8_t> index(sizeof(std::uint32_t));
+    auto *o = index.data();
+    put_le(o, static_cast<std::uint32_t>(entries.size()));
+
+    for(auto &[key, count] : entries) {
+        auto bank = static_cast<std::uint16_t>(key >> 16);
+        auto address = static_cast<std::uint16_t>(key);
+
+        // Same as SameBoy: a symbol in the bank, or else one in bank 0
+        auto found = this->names.find(key);
+        if(found == this->names.end()) {
+            found = this->names.find(address);
+        }
+        std::string name = found != this->names.end() ? found->second : std::string();
+        name.resize(std::min<std::size_t>(name.size(), UINT16_MAX));
+
+        auto offset = index.size();
+        index.resize(offset + 14 + name.size());
+        o = index.data() + offset;
+        put_le(o, bank);
+        put_le(o, address);
+        put_le(o, count);
+        put_le(o, static_cast<std::uint16_t>(name.size()));
+        std::memcpy(o, name.data(), name.size());
+    }
+
+    bool success = !this->failed && std::fwrite(index.data(), index.size(), 1, this->file) == 1 && this->write_header(this->records_written, index_offset);
+    success = std::fclose(this->file) == 0 && success;
+    this->file = nullptr;
+
+    if(!success) {
+        std::fprintf(stderr, "Failed to write trace file %s\n", this->path.string().c_str());
+    }
+    return success;
+}
+
+bool TraceFileWriter::write_header(std::uint64_t record_count, std::uint64_t index_offset) noexcept {
+    std::uint8_t header[TraceFile::HEADER_SIZE];
+    auto *o = header;
+    std::memcpy(o, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    o += sizeof(TRACE_MAGIC);
+    put_le(o, TRACE_VERSION);
+    put_le(o, static_cast<std::uint32_t>(TraceFile::RECORD_SIZE));
+    put_le(o, static_cast<std::uint32_t>(0));
+    put_le(o, record_count);
+    put_le(o, index_offset);
+    put_le(o, this->rom_hash);
+    put_le(o, this->records_dropped.load(std::memory_order_relaxed));
+
+    return std::fseek(this->file, 0, SEEK_SET) == 0 && std::fwrite(header, sizeof(header), 1, this->file) == 1 && std::fseek(this->file, 0, SEEK_END) == 0;
+}
+
+void TraceFileWriter::writer_loop() noexcept {
+    std::vector<TraceRecord> scratch(WRITE_CHUNK);
+    std::vector<std::uint8_t> encoded(WRITE_CHUNK * TraceFile::RECORD_SIZE);
+
+    while(!this->finishing) {
+        if(this->flush_pending(scratch, encoded) == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Get whatever was pushed before we were told to stop, then finish up
+    while(this->flush_pending(scratch, encoded) > 0) {}
+    if(!this->write_index_and_close()) {
+        this->failed = true;
+    }
+    this->finished = true;
+}
+
+std::size_t TraceFileWriter::flush_pending(std::vector<TraceRecord> &scratch, std::vector<std::uint8_t> &encoded) noexcept {
+    std::size_t total = 0;
+
+    while(true) {
+        auto count = this->ring.pop(scratch.data(), scratch.size());
+        if(count == 0) {
+            break;
+        }
+
+        for(std::size_t i = 0; i < count; i++) {
+            auto &r = scratch[i];
+            TraceFile::encode_record(r, encoded.data() + i * TraceFile::RECORD_SIZE);
+            this->counts[(static_cast<std::uint32_t>(r.bank) << 16) | r.pc]++;
+        }
+
+        if(std::fwrite(encoded.data(), TraceFile::RECORD_SIZE, count, this->file) != count) {
+            this->failed = true;
+        }
+
+        total += count;
+        this->records_written += count;
+    }
+
+    return total;
+}
+
+TraceFileReader::TraceFileReader(const std::filesystem::path &path) : file(path) {
+    const auto *data = this->file.data();
+    auto size = this->file.size();
+    if(data == nullptr || size < VERSION_1_HEADER_SIZE || std::memcmp(data, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+        return;
+    }
+
+    std::uint32_t version, record_size, reserved;
+    std::uint64_t record_count, index_offset;
+    const auto *i = data + sizeof(TRACE_MAGIC);
+    get_le(i, version);
+    get_le(i, record_size);
+    get_le(i, reserved);
+    get_le(i, record_count);
+    get_le(i, index_offset);
+
+    if(version < 1 || version > TRACE_VERSION || record_size != TraceFile::RECORD_SIZE) {
+        return;
+    }
+
+    if(version >= 2) {
+        if(size < TraceFile::HEADER_SIZE) {
+            return;
+        }
+        std::uint64_t rom_hash;
+        get_le(i, rom_hash);
+        get_le(i, this->records_dropped);
+        this->rom_hash = rom_hash;
+    }
+    else {
+        this->header_size = VERSION_1_HEADER_SIZE;
+    }
+
+    auto records_that_fit = (size - this->header_size) / TraceFile::RECORD_SIZE;
+
+    // If it was never finished, take whatever records made it to the disk
+    if(index_offset == 0) {
+        this->record_count = records_that_fit;
+        this->valid = true;
+        return;
+    }
+
+    if(record_count > records_that_fit || index_offset != this->header_size + record_count * TraceFile::RECORD_SIZE || size - index_offset < sizeof(std::uint32_t)) {
+        return;
+    }
+    this->record_count = record_count;
+
+    // Read the index, stopping (but keeping the records) if it's cut off
+    const auto *end = data + size;
+    i = data + index_offset;
+    std::uint32_t entry_count;
+    get_le(i, entry_count);
+
+    for(std::uint32_t e = 0; e < entry_count && end - i >= 14; e++) {
+        auto &entry = this->index.emplace_back();
+        std::uint16_t name_length;
+        get_le(i, entry.bank);
+        get_le(i, entry.address);
+        get_le(i, entry.count);
+        get_le(i, name_length);
+
+        if(end - i < name_length) {
+            this->index.pop_back();
+            break;
+        }
+        entry.name.assign(reinterpret_cast<const char *>(i), name_length);
+        i += name_length;
+    }
+
+    this->valid = true;
+}
@@ -0,0 +1,257 @@
+#ifndef TRACE_FILE_HPP
+#define TRACE_FILE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <optional>
+#include <unordered_map>
+
+#include "trace_buffer.hpp"
+#include "spsc_ring_buffer.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * Trace files hold TraceRecords in the order they were recorded so traces can be bigger than memory.
+ *
+ * The file starts with a 48-byte header ("SDXT", version, record size, reserved, record count, index offset, hash of the
+ * ROM, records dropped), followed by the records (fixed size, little endian), followed by the index. The index lists
+ * every (bank, address) that was traced, how many times, and the symbol name there (if any). The header is written again
+ * once the trace finishes, so a file that was never finished has a record count of 0; readers go by the file size in
+ * that case.
+ *
+ * Records only hold the opcode, so the rest of each instruction has to come from the ROM it was traced with. Version 1
+ * files (32-byte header without the last two fields) don't say which ROM that was.
+ */
+namespace TraceFile {
+    /** Size of the header in bytes */
+    static constexpr const std::size_t HEADER_SIZE = 48;
+
+    /** Size of each record in bytes */
+    static constexpr const std::size_t RECORD_SIZE = 24;
+
+    struct IndexEntry {
+        /** Bank */
+        std::uint16_t bank;
+
+        /** Address */
+        std::uint16_t address;
+
+        /** Number of records at this bank and address */
+        std::uint64_t count;
+
+        /** Symbol name, or empty if there isn't one */
+        std::string name;
+    };
+
+    /** Symbol names to put in the index, keyed by bank << 16 | address */
+    using Names = std::unordered_map<std::uint32_t, std::string>;
+
+    /**
+     * Encode a record
+     *
+     * @param record record to encode
+     * @param output where to put RECORD_SIZE bytes
+     */
+    void encode_record(const TraceRecord &record, std::uint8_t *output) noexcept;
+
+    /**
+     * Decode a record
+     *
+     * @param input  RECORD_SIZE bytes
+     * @param record where to put the record
+     */
+    void decode_record(const std::uint8_t *input, TraceRecord &record) noexcept;
+}
+
+/**
+ * Streams trace records to a file on a background thread.
+ *
+ * Records are handed off through a lock-free ring buffer. The emulation thread can't wait on the disk (it holds the
+ * instance's mutex while it runs), so if the writer falls behind, records are dropped and counted in the header.
+ * Finishing happens on the writer thread too, so nothing has to wait for the last records to be written.
+ */
+class TraceFileWriter {
+public:
+    /**
+     * Open a trace file for writing. Check is_open() to see if it worked.
+     *
+     * @param path     path to the file
+     * @param rom_hash hash of the ROM being traced
+     */
+    TraceFileWriter(const std::filesystem::path &path, std::uint64_t rom_hash);
+
+    /**
+     * Finish the file without any symbol names if finish() wasn't called, and wait for it to be written
+     */
+    ~TraceFileWriter();
+
+    /**
+     * Get whether or not the file was opened
+     *
+     * @return true if open
+     */
+    bool is_open() const noexcept { return this->writer.joinable(); }
+
+    /**
+     * Get the path of the file
+     *
+     * @return path
+     */
+    const std::filesystem::path &get_path() const noexcept { return this->path; }
+
+    /**
+     * Queue a record to be written. Call this from one thread only.
+     *
+     * @param record record to write
+     */
+    void push(const TraceRecord &record) noexcept {
+        if(!this->ring.push(record)) {
+            this->records_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Have the writer write everything still queued, then the index and the final header, and close the file. This
+     * returns right away; check is_finished() to find out when it's done. Nothing else can be pushed afterwards.
+     *
+     * @param names symbol names to put in the index (an address without one in its bank falls back to bank 0)
+     */
+    void finish(TraceFile::Names names);
+
+    /**
+     * Get whether or not the file was finished and closed
+     *
+     * @return true if finished
+     */
+    bool is_finished() const noexcept { return this->finished; }
+
+    /**
+     * Get whether or not everything was written (only meaningful once is_finished() is true)
+     *
+     * @return true if successful
+     */
+    bool succeeded() const noexcept { return !this->failed; }
+
+    /**
+     * Get the number of records written so far
+     *
+     * @return records written
+     */
+    std::uint64_t get_records_written() const noexcept { return this->records_written; }
+
+    /**
+     * Get the number of records dropped because the writer could not keep up
+     *
+     * @return records dropped
+     */
+    std::uint64_t get_records_dropped() const noexcept { return this->records_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::filesystem::path path;
+    std::uint64_t rom_hash;
+    std::FILE *file = nullptr;
+    SPSCRingBuffer<TraceRecord> ring;
+
+    // Set before finishing is, so the writer sees them once it does
+    TraceFile::Names names;
+
+    std::atomic_bool finishing = false;
+    std::atomic_bool finished = false;
+    std::atomic_bool failed = false;
+    std::atomic<std::uint64_t> records_written = 0;
+    std::atomic<std::uint64_t> records_dropped = 0;
+    std::thread writer;
+
+    // Only touched by the writer thread
+    std::unordered_map<std::uint32_t, std::uint64_t> counts;
+
+    // Drain the ring buffer until we're told to finish, then finish the file
+    void writer_loop() noexcept;
+
+    // Write whatever is in the ring buffer right now; returns number of records written
+    std::size_t flush_pending(std::vector<TraceRecord> &scratch, std::vector<std::uint8_t> &encoded) noexcept;
+
+    // Write the index and final header, and close the file
+    bool write_index_and_close() noexcept;
+
+    // Write the header
+    bool write_header(std::uint64_t record_count, std::uint64_t index_offset) noexcept;
+};
+
+/**
+ * Reads a trace file through a memory mapping, so only the parts being looked at have to be in memory.
+ *
+ * This is safe to use from multiple threads at once.
+ */
+class TraceFileReader {
+public:
+    /**
+     * Open a trace file. Check is_open() to see if it worked.
+     *
+     * @param path path to the file
+     */
+    TraceFileReader(const std::filesystem::path &path);
+
+    /**
+     * Get whether or not the file was opened and has a valid header
+     *
+     * @return true if open
+     */
+    bool is_open() const noexcept { return this->valid; }
+
+    /**
+     * Get the number of records
+     *
+     * @return number of records
+     */
+    std::uint64_t size() const noexcept { return this->record_count; }
+
+    /**
+     * Get a record
+     *
+     * @param index index of the record (must be less than size())
+     * @return      record
+     */
+    TraceRecord get(std::uint64_t index) const noexcept {
+        TraceRecord record;
+        TraceFile::decode_record(this->file.data() + this->header_size + index * TraceFile::RECORD_SIZE, record);
+        return record;
+    }
+
+    /**
+     * Get the index (empty if the trace was never finished)
+     *
+     * @return index
+     */
+    const std::vector<TraceFile::IndexEntry> &get_index() const noexcept { return this->index; }
+
+    /**
+     * Get the hash of the ROM that was traced
+     *
+     * @return hash, or nullopt if the file is too old to say
+     */
+    std::optional<std::uint64_t> get_rom_hash() const noexcept { return this->rom_hash; }
+
+    /**
+     * Get the number of records that were dropped while tracing because the writer could not keep up
+     *
+     * @return records dropped
+     */
+    std::uint64_t get_records_dropped() const noexcept { return this->records_dropped; }
+
+private:
+    MappedFile file;
+    bool valid = false;
+    std::size_t header_size = TraceFile::HEADER_SIZE;
+    std::uint64_t record_count = 0;
+    std::optional<std::uint64_t> rom_hash;
+    std::uint64_t records_dropped = 0;
+    std::vector<TraceFile::IndexEntry> index;
+};
+
+#endif
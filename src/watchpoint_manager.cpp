@@ -0,0 +1,60 @@
+#include "watchpoint_manager.hpp"
+
+#include <utility>
+
+WatchpointManager::WatchpointManager(std::size_t log_capacity) : log_ring(log_capacity) {}
+
+void WatchpointManager::add(const Watchpoint &watchpoint) {
+    auto &w = this->watchpoints.emplace_back(watchpoint);
+    if(w.start > w.end) {
+        std::swap(w.start, w.end);
+    }
+    this->rebuild_actions();
+}
+
+void WatchpointManager::remove(std::size_t index) {
+    if(index < this->watchpoints.size()) {
+        this->watchpoints.erase(this->watchpoints.begin() + index);
+        this->rebuild_actions();
+    }
+}
+
+void WatchpointManager::clear() noexcept {
+    this->watchpoints.clear();
+    this->rebuild_actions();
+}
+
+void WatchpointManager::rebuild_actions() noexcept {
+    this->actions.fill(0);
+    this->all_flags = 0;
+
+    for(auto &w : this->watchpoints) {
+        std::uint8_t actions = w.flags & (WATCHPOINT_BREAK | WATCHPOINT_LOG);
+        std::uint8_t mask = ((w.flags & WATCHPOINT_READ) ? actions : 0) | ((w.flags & WATCHPOINT_WRITE) ? actions << 4 : 0);
+        if(mask == 0) {
+            continue;
+        }
+
+        for(std::uint32_t a = w.start; a <= w.end; a++) {
+            this->actions[a] |= mask;
+        }
+        this->all_flags |= w.flags;
+    }
+}
+
+std::size_t WatchpointManager::drain_log(std::vector<MemoryAccess> &output) {
+    auto old_size = output.size();
+
+    while(true) {
+        auto available = this->log_ring.size();
+        if(available == 0) {
+            break;
+        }
+
+        auto offset = output.size();
+        output.resize(offset + available);
+        output.resize(offset + this->log_ring.pop(output.data() + offset, available));
+    }
+
+    return output.size() - old_size;
+}
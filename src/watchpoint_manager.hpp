@@ -0,0 +1,158 @@
+#ifndef WATCHPOINT_MANAGER_HPP
+#define WATCHPOINT_MANAGER_HPP
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "spsc_ring_buffer.hpp"
+
+enum WatchpointFlags : std::uint8_t {
+    /** Watch reads */
+    WATCHPOINT_READ = 1 << 0,
+
+    /** Watch writes */
+    WATCHPOINT_WRITE = 1 << 1,
+
+    /** Break when accessed */
+    WATCHPOINT_BREAK = 1 << 2,
+
+    /** Log every access */
+    WATCHPOINT_LOG = 1 << 3
+};
+
+struct Watchpoint {
+    /** First address */
+    std::uint16_t start;
+
+    /** Last address (inclusive) */
+    std::uint16_t end;
+
+    /** WATCHPOINT_* flags */
+    std::uint8_t flags;
+};
+
+/**
+ * A logged memory access
+ */
+struct MemoryAccess {
+    /** Cycles (in 8 MiHz ticks) since the instance started */
+    std::uint64_t cycle;
+
+    /** Address of the instruction that made the access */
+    std::uint16_t pc;
+
+    /** Address accessed */
+    std::uint16_t address;
+
+    /** Value read or written */
+    std::uint8_t value;
+
+    /** WATCHPOINT_READ or WATCHPOINT_WRITE */
+    std::uint8_t type;
+};
+
+/**
+ * Holds memory watchpoints as a set of actions for every address, so the memory callbacks can check an access with a single lookup
+ * no matter how many watchpoints there are.
+ *
+ * Logged accesses go into a lock-free ring buffer. The emulation thread pushes into it and one other thread drains it; if
+ * it isn't drained in time, new accesses are dropped and counted.
+ *
+ * Apart from log() and drain_log(), this is not thread-safe; the owner has to synchronize access.
+ */
+class WatchpointManager {
+public:
+    /**
+     * Instantiate a watchpoint manager
+     *
+     * @param log_capacity number of accesses the log can hold before it's drained
+     */
+    WatchpointManager(std::size_t log_capacity = 1 << 16);
+
+    /**
+     * Add a watchpoint
+     *
+     * @param watchpoint watchpoint to add
+     */
+    void add(const Watchpoint &watchpoint);
+
+    /**
+     * Remove a watchpoint
+     *
+     * @param index index of the watchpoint
+     */
+    void remove(std::size_t index);
+
+    /**
+     * Remove every watchpoint
+     */
+    void clear() noexcept;
+
+    /**
+     * Get all watchpoints in the order they were added
+     *
+     * @return watchpoints
+     */
+    const std::vector<Watchpoint> &get_watchpoints() const noexcept { return this->watchpoints; }
+
+    /**
+     * Get what to do when an address is accessed
+     *
+     * @param address address
+     * @param type    WATCHPOINT_READ or WATCHPOINT_WRITE
+     * @return        WATCHPOINT_BREAK and/or WATCHPOINT_LOG, or 0 if nothing is watching it
+     */
+    std::uint8_t get_actions(std::uint16_t address, std::uint8_t type) const noexcept {
+        return (this->actions[address] >> (type == WATCHPOINT_WRITE ? 4 : 0)) & (WATCHPOINT_BREAK | WATCHPOINT_LOG);
+    }
+
+    /**
+     * Get the combined flags of every watchpoint that breaks or logs
+     *
+     * @return WATCHPOINT_* flags
+     */
+    std::uint8_t get_all_flags() const noexcept { return this->all_flags; }
+
+    /**
+     * Log an access. Call this from one thread only.
+     *
+     * @param access access to log
+     */
+    void log(const MemoryAccess &access) noexcept {
+        if(!this->log_ring.push(access)) {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Move every logged access to the end of output. Call this from one thread only.
+     *
+     * @param output where to put the accesses
+     * @return       number of accesses added
+     */
+    std::size_t drain_log(std::vector<MemoryAccess> &output);
+
+    /**
+     * Get the number of accesses dropped because the log was full
+     *
+     * @return number of dropped accesses
+     */
+    std::uint64_t get_dropped() const noexcept { return this->dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<Watchpoint> watchpoints;
+    std::uint8_t all_flags = 0;
+
+    // Actions for reads in the low nibble and writes in the high nibble for every address
+    std::array<std::uint8_t, 0x10000> actions = {};
+
+    SPSCRingBuffer<MemoryAccess> log_ring;
+    std::atomic<std::uint64_t> dropped = 0;
+
+    // Recalculate actions from the watchpoints
+    void rebuild_actions() noexcept;
+};
+
+#endif